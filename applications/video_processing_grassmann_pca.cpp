@@ -29,6 +29,7 @@
 #include <boost/program_options/parsers.hpp>
 
 #include <boost/iterator/iterator_facade.hpp>
+#include <boost/cstdint.hpp>
 
 #include <string>
 #include <fstream>
@@ -372,12 +373,15 @@ int main(int argc, char *argv[])
   // type of the scalars manipulated by the algorithm
   typedef float input_array_type;
 
+  // type of the copy of the data kept by the algorithm: the pixels are stored on 8 bits
+  typedef boost::uint8_t storage_type;
+
 
   // Allocate data
   std::cout << "=== Allocate ===" << std::endl;
   std::cout << "  Number of images: " << num_frames << std::endl;
   std::cout << "  Image size:       " << cols << "x" << rows << " (RGB)" << std::endl;
-  std::cout << "  Data size:        " << (num_frames*rows*cols * 3 * sizeof(input_array_type)) / (1024 * 1024) << " MB" << std::endl;
+  std::cout << "  Data size:        " << (num_frames*rows*cols * 3 * sizeof(storage_type)) / (1024 * 1024) << " MB" << std::endl;
     
   iterator_on_image_files<float> iterator_file_begin(1);
   iterator_on_image_files<float> iterator_file_end(num_frames + 1);
@@ -388,7 +392,7 @@ int main(int argc, char *argv[])
   // type of the observer
   typedef grassmann_pca_observer<data_t> observer_t;
   // type of the em-pca algorithm
-  typedef grassmann_pca< data_t, observer_t > grassmann_pca_t;
+  typedef grassmann_pca< data_t, observer_t, details::norm2, storage_type > grassmann_pca_t;
 
   // main instance
   grassmann_pca_t instance;
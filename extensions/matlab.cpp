@@ -56,6 +56,32 @@ output_type get_matlab_array_value(mxArray const* array_, size_t index_row, size
 }
 
 
+// The workers are kept between the calls to the mex function, and released when the mex file is cleared.
+static grassmann_averages_pca::thread_pool *p_mex_thread_pool = 0;
+
+static void release_mex_thread_pool()
+{
+  delete p_mex_thread_pool;
+  p_mex_thread_pool = 0;
+}
+
+//! Returns the pool of workers of the mex function, recreated if the number of workers changes.
+static grassmann_averages_pca::thread_pool* get_mex_thread_pool(size_t nb_processors)
+{
+  if(p_mex_thread_pool && p_mex_thread_pool->nb_threads() != nb_processors)
+  {
+    release_mex_thread_pool();
+  }
+
+  if(!p_mex_thread_pool)
+  {
+    p_mex_thread_pool = new grassmann_averages_pca::thread_pool(nb_processors);
+    mexAtExit(release_mex_thread_pool);
+  }
+  return p_mex_thread_pool;
+}
+
+
 struct s_algorithm_configuration
 {
   size_t rows;
@@ -128,6 +154,7 @@ bool grassmann_pca_dispatch(
       mexWarnMsgIdAndTxt("GrassmannAveragesPCA:configuration", "Incorrect number of processors. Please consult the documentation.");
       return false;
     }
+    instance.set_thread_pool(get_mex_thread_pool(algorithm_configuration.nb_processors));
   }
 
   if(algorithm_configuration.max_chunk_size > 0)
@@ -231,6 +258,7 @@ bool grassmann_pca_trimming_dispatch(
       mexWarnMsgIdAndTxt("GrassmannAveragesPCA:configuration", "Incorrect number of processors. Please consult the documentation.");
       return false;
     }
+    instance.set_thread_pool(get_mex_thread_pool(algorithm_configuration.nb_processors));
   }
 
   if(algorithm_configuration.max_chunk_size > 0)
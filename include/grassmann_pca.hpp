@@ -13,6 +13,9 @@
  */
 
 #include <vector>
+#include <numeric>
+#include <limits>
+#include <cmath>
 
 
 #include <boost/numeric/ublas/vector_expression.hpp>
@@ -27,6 +30,9 @@
 
 // utilities
 #include <include/private/utilities.hpp>
+#include <include/private/numa_thread_pool.hpp>
+#include <include/private/simd_kernels.hpp>
+#include <include/private/row_ranges_scheduler.hpp>
 
 
 namespace grassmann_averages_pca
@@ -67,12 +73,24 @@ namespace grassmann_averages_pca
    * @tparam data_t type of vectors used for the computation. 
    * @tparam observer_t an observer type following the signature of the class grassmann_trivial_callback.
    * @tparam norm_mu_t norm used to normalize the eigen-vector and project them onto the unit circle.
+   * @tparam storage_t type used for storing the copy of the data in each chunk. A compact type such as @c boost::uint8_t
+   *   or @c boost::uint16_t divides the memory footprint and bandwidth of the copy. The signed sums are then computed 
+   *   exactly with integer accumulators, and the centering and the projections onto the orthogonal subspaces are applied 
+   *   implicitly in the inner products and the accumulations, since the stored data cannot be modified. The values 
+   *   of the data should then be integers in the range of the storage type, and the chunks small enough for the exact 
+   *   accumulators (see set_max_chunk_size), otherwise batch_process returns false.
+   * @tparam accumulation_t accumulation of the rows in the chunks and of the results of the chunks, which gives the scalar 
+   *   type of the accumulators (details::plain_accumulation, details::pairwise_accumulation or details::kahan_accumulation). 
+   *   For @c float vectors, @c details::pairwise_accumulation<double> keeps the bandwidth of the @c float data while the 
+   *   accumulations have the accuracy of the @c double ones.
    *
    * @author Soren Hauberg, Raffi Enficiaud
    */
   template <class data_t, 
             class observer_t = grassmann_trivial_callback<data_t>,
-            class norm_mu_t = details::norm2>
+            class norm_mu_t = details::norm2,
+            class storage_t = typename data_t::value_type,
+            class accumulation_t = details::plain_accumulation<typename data_t::value_type> >
   struct grassmann_pca
   {
   private:
@@ -95,9 +113,48 @@ namespace grassmann_averages_pca
     //! to the computation of the PCA or the trimmed grassmann average.
     bool need_centering;
 
+    //! Indicates that the data is never modified: the centering and the deflation are applied implicitly.
+    bool implicit_deflation;
+
+    //! Number of basis vectors computed together (1 by default).
+    size_t block_size;
+
+    //! Indicates that the workers and the chunks are placed on the NUMA nodes (see set_numa_placement).
+    bool numa_placement;
+
+    //! Indicates that the idle workers steal rows from the busy chunks during the iterations (see set_work_stealing).
+    bool work_stealing;
+
+    //! Indicates that the rows for which the sign cannot change are skipped by the updates (see set_margin_pruning).
+    bool margin_pruning;
+
+    //! Fraction of sign flips below which the iterations stop, negative if disabled (see set_sign_flips_convergence).
+    double sign_flips_fraction;
+
+    //! Indicates that the iterations stop on a cycle of the signs (see set_cycle_detection).
+    bool cycle_detection;
+
+    //! Indicates that the iterations may be distributed by tiles of rows and dimensions (see set_dimension_tiling).
+    bool dimension_tiling;
+
+    //! Pool of workers set by the caller (see set_thread_pool).
+    thread_pool *p_thread_pool;
+
     //! An instance observing the steps of the algorithm
     observer_t *observer;    
 
+    //! Number of sign flips per iteration, for each computed basis vector.
+    std::vector< std::vector<size_t> > v_sign_flips;
+
+    //! Number of rows skipped by the margin pruning per iteration, for each computed basis vector.
+    std::vector< std::vector<size_t> > v_skipped_rows;
+
+    //! Scalar type of the accumulations of the chunks and of their merge (see accumulation_t).
+    typedef typename accumulation_t::value_type accumulation_scalar_t;
+
+    //! Type of the accumulators of the chunks and of the merged results.
+    typedef boost::numeric::ublas::vector<accumulation_scalar_t> accumulator_vector_t;
+
     //!@internal
     //!@brief Contains the logic for processing part of the accumulator
     struct asynchronous_chunks_processor
@@ -106,6 +163,18 @@ namespace grassmann_averages_pca
       //! Type of the elements contained in the vectors
       typedef typename data_t::value_type scalar_t;
 
+      //! Type of the exact accumulators of the storage type
+      typedef typename details::simd::storage_accumulator<storage_t>::type accumulator_t;
+
+      //! Indicates if the data is stored with the scalar type, in which case the centering and the
+      //! deflation may be applied directly to the copy of the data.
+      typedef boost::is_same<storage_t, scalar_t> native_storage_t;
+
+      //! Indicates that the rows are summed directly in the accumulator, which is the case for the plain accumulations
+      //! in the scalar type. Otherwise the rows are summed by blocks (see accumulation_t).
+      typedef boost::integral_constant<bool, 
+        !accumulation_t::blocked && boost::is_same<accumulation_scalar_t, scalar_t>::value> direct_accumulation_t;
+
       //! Number of vectors contained in this chunk.
       size_t nb_elements;
 
@@ -114,428 +183,2781 @@ namespace grassmann_averages_pca
 
       //! Internal accumulator.
       //! Should live beyond the scope of update and init, as required by the merger.
-      data_t accumulator;
+      accumulator_vector_t accumulator;
+
+      //! Compensations of the rounding errors of the accumulator, for the compensated accumulations.
+      accumulator_vector_t compensation;
+
+      //! Signs stored for decreasing the number of updates.
+      //! The signs are packed by words of 64 bits, the bit i of the word k being the sign of the row 64*k + i.
+      std::vector<boost::uint64_t> v_signs;
+
+      //! Number of signs that changed during the last update.
+      size_t nb_sign_flips;
 
-      //! Signs stored for decreasing the number of updates
-      std::vector<bool> v_signs;
+      //! Change of the hash of the signs during the last update (see details::signs_word_hash).
+      boost::uint64_t signs_hash_change;
+
+      //! Position of the first word of signs of the chunk in the bitmap of all the signs, for the hashes.
+      boost::uint64_t signs_hash_offset;
       
       // this is to send an update of the value of mu to one listener
       // the connexion should be managed externally
-      typedef boost::function<void (data_t const*)> connector_accumulator_t;
+      typedef boost::function<void (accumulator_vector_t const*)> connector_accumulator_t;
       connector_accumulator_t signal_acc;
 
       typedef boost::function<void ()> connector_counter_t;
       connector_counter_t signal_counter;
 
       //! The matrix containing a copy of the data.
-      //! The vectors are stored per row in this matrix.
-      scalar_t *p_c_matrix;
+      //! The vectors are stored per row in this matrix. This is 0 if the data is borrowed.
+      storage_t *p_c_matrix;
+
+      //! The rows of the data, either the copy or the data borrowed from the caller.
+      storage_t const *p_rows;
       
       //! Padding for one line of the matrix
       size_t data_padding;
 
-      //! "Optimized" inner product.
-      //! This one has the particularity to be more cache/memory bandwidth friendly. More efficient
-      //! implementations may be used, but it turned out that the memory bandwidth is saturated when
-      //! many threads are processing different data.
-      scalar_t inner_product(scalar_t const* p_mu, scalar_t const* current_line) const
+      //! Kernels (inner product, accumulations) for the instruction set of the processor.
+      details::simd::kernels<scalar_t> kernels_op;
+
+      //! Kernels operating on the rows of the matrix.
+      details::simd::storage_kernels<storage_t, scalar_t> storage_op;
+
+    public:
+      //! Rows selected for an accumulation, and the buffers of the accumulation. Each thread accumulating
+      //! rows of the chunk has its own selection.
+      struct rows_selection
+      {
+        //! Rows selected for the next accumulation (eg. rows for which the sign flipped).
+        std::vector<storage_t const*> v_selected_rows;
+
+        //! Indices of the selected rows.
+        std::vector<size_t> v_selected_indices;
+
+        //! Weights of the selected rows in the accumulation.
+        std::vector<scalar_t> v_selected_coefficients;
+
+        //! Signs of the selected rows for the exact integer accumulations.
+        std::vector<accumulator_t> v_sign_masks;
+
+        //! Exact accumulator for the integer storage types.
+        std::vector<accumulator_t> integer_accumulator;
+
+        //! Sum of the selected rows, added afterwards to the accumulator (blocked accumulations).
+        std::vector<scalar_t> rows_sum;
+      };
+
+    private:
+      //! Selection of the task of the chunk.
+      rows_selection selection;
+
+      //! Mu of the current update, read by the workers stealing rows of the chunk.
+      scalar_t const *p_current_mu;
+
+      //! Indicates that the centering and the deflation are not applied to the copy of the data, but implicitly in
+      //! the inner products and the accumulations. This is always the case for the compact storage types.
+      bool implicit_transformations;
+
+      //! Mean of the data in case of implicit centering, 0 if the data is not centered.
+      data_t const *p_mean;
+
+      //! Basis vectors against which the data is deflated, in case of implicit deflation.
+      std::vector<data_t> const *p_deflation_basis;
+
+      //! Coefficients of the rows on the basis vectors: the element j contains the coefficients of all the rows 
+      //! on the basis vector j, computed at the time the basis vector j was found.
+      std::vector< std::vector<scalar_t> > v_deflation_coefficients;
+
+      //! Offsets of the inner products between each row and the current @f$\mu@f$, coming from the implicit transformations.
+      std::vector<scalar_t> v_offsets;
+
+      //! Signs of the rows for each vector of the frame (block computation), packed as v_signs. The words
+      //! of the vector @c c start at @c c*v_signs.size().
+      std::vector<boost::uint64_t> v_block_signs;
+
+      //! Number of signs that changed for each vector of the frame during the last block update.
+      std::vector<size_t> v_block_sign_flips;
+
+      //! Offsets of the implicit transformations for each vector of the frame, the offsets of the vector @c c
+      //! starting at @c c*nb_elements.
+      std::vector<scalar_t> v_block_offsets;
+
+      //! Indicates that the rows for which the sign cannot change are skipped by the updates (see grassmann_pca::set_margin_pruning).
+      bool margin_pruning;
+
+      //! Squared norms of the rows after the centering, before the deflation. In case of explicit transformations, 
+      //! these are the squared norms of the rows of the copy.
+      std::vector<double> v_centered_squared_norms;
+
+      //! Upper bounds of the norms of the rows after the centering and the deflation.
+      std::vector<scalar_t> v_rows_norms;
+
+      //! Thresholds of the rows: the sign of a row cannot change as long as mu_drift stays below its threshold.
+      //! A threshold is the margin @f$|\langle x, \mu\rangle| / \|x\|@f$ at the last evaluation of the row, plus the drift at this time.
+      std::vector<scalar_t> v_margins;
+
+      //! Cumulated norms of the changes of mu since the margins were reset.
+      scalar_t mu_drift;
+
+      //! Mu of the previous update, for the drift.
+      data_t previous_mu;
+
+      //! Validity of the pruning states, reset when the data or the signs are changed outside of the updates.
+      bool centered_norms_valid, rows_norms_valid, margins_valid;
+
+      //! Number of rows skipped during the last update.
+      size_t nb_skipped_rows;
+
+      //! Indicates that the storage type represents the values of the copied data exactly.
+      bool representable_data;
+
+
+      //! Selects a row for the next accumulation.
+      void select_row(rows_selection &current, size_t row, scalar_t coefficient) const
+      {
+        current.v_selected_rows.push_back(p_rows + row * data_padding);
+        current.v_selected_indices.push_back(row);
+        current.v_selected_coefficients.push_back(coefficient);
+      }
+
+      //! Selects a row for the next accumulation of the task of the chunk.
+      void select_row(size_t row, scalar_t coefficient)
       {
-        scalar_t const * const current_line_end = current_line + data_dimension;
+        select_row(selection, row, coefficient);
+      }
+
+      //! The rows are summed directly in the accumulator.
+      scalar_t* rows_sum_target(rows_selection &, accumulation_scalar_t *p_acc, boost::true_type) const
+      {
+        return p_acc;
+      }
 
-        const int _64_elements = static_cast<int>(data_dimension >> 6);
-        scalar_t acc(0);
+      //! The rows are summed in the buffer of the selection (blocked accumulations).
+      scalar_t* rows_sum_target(rows_selection &current, accumulation_scalar_t *, boost::false_type) const
+      {
+        current.rows_sum.assign(data_dimension, scalar_t(0));
+        return &current.rows_sum[0];
+      }
+
+      void add_rows_sum(rows_selection &, accumulation_scalar_t *, accumulation_scalar_t *, boost::true_type) const
+      {}
 
-        for(int j = 0; j < _64_elements; j++, current_line += 64, p_mu += 64)
+      //! Adds the sum of the selected rows to the accumulator, with the compensation of the rounding errors if 
+      //! @c p_compensation is not 0.
+      void add_rows_sum(rows_selection &current, accumulation_scalar_t *p_acc, accumulation_scalar_t *p_compensation, boost::false_type) const
+      {
+        scalar_t const * const p_sum = &current.rows_sum[0];
+        if(p_compensation)
+        {
+          details::simd::generic::compensated_add(p_acc, p_compensation, p_sum, data_dimension);
+        }
+        else
         {
-          for(int i = 0; i < 64; i++)
+          for(size_t d = 0; d < data_dimension; d++)
           {
-            acc += current_line[i] * p_mu[i];
+            p_acc[d] += accumulation_scalar_t(p_sum[d]);
           }
         }
-        for(; current_line < current_line_end; current_line++, p_mu++)
+      }
+
+      /*!@brief Adds the selected rows, weighted by their coefficients, to the accumulator.
+       *
+       * The rows are added in one blocked matrix-vector product. If @c signed_rows is true, the coefficients are
+       * all of the same magnitude and only their sign matters: the integer data is then summed exactly.
+       * For the blocked accumulations, the rows are summed in the scalar type of the data and their sum is then added 
+       * to the accumulator (compensated if @c p_compensation is not 0). The selection is cleared afterwards.
+       */
+      void accumulate_selected_rows(
+        rows_selection &current, 
+        accumulation_scalar_t *p_acc_out, 
+        accumulation_scalar_t *p_compensation, 
+        bool signed_rows) const
+      {
+        const size_t nb_selected = current.v_selected_rows.size();
+        if(nb_selected)
         {
-          acc += (*current_line) * (*p_mu);
+          scalar_t * const p_acc = rows_sum_target(current, p_acc_out, direct_accumulation_t());
+          if(signed_rows && std::numeric_limits<storage_t>::is_integer)
+          {
+            const scalar_t scale = std::abs(current.v_selected_coefficients[0]);
+            current.v_sign_masks.resize(nb_selected);
+            for(size_t r = 0; r < nb_selected; r++)
+            {
+              current.v_sign_masks[r] = current.v_selected_coefficients[r] < 0 ? accumulator_t(-1) : accumulator_t(0);
+            }
+
+            current.integer_accumulator.assign(data_dimension, accumulator_t(0));
+            storage_op.signed_rows_sum(&current.integer_accumulator[0], &current.v_selected_rows[0], &current.v_sign_masks[0], nb_selected, data_dimension);
+            for(size_t d = 0; d < data_dimension; d++)
+            {
+              p_acc[d] += scale * scalar_t(current.integer_accumulator[d]);
+            }
+          }
+          else
+          {
+            storage_op.weighted_rows_sum(p_acc, &current.v_selected_rows[0], &current.v_selected_coefficients[0], nb_selected, data_dimension);
+          }
+
+          if(implicit_transformations)
+          {
+            // the selected rows are x - m - sum_j c_j u_j: the mean and the basis vectors are
+            // subtracted with the sum of the coefficients of the rows
+            if(p_mean)
+            {
+              const scalar_t coefficients_sum = std::accumulate(current.v_selected_coefficients.begin(), current.v_selected_coefficients.end(), scalar_t(0));
+              kernels_op.axpy(p_acc, -coefficients_sum, &p_mean->data()[0], data_dimension);
+            }
+
+            for(size_t j = 0; j < v_deflation_coefficients.size(); j++)
+            {
+              scalar_t const * const p_coefficients = &v_deflation_coefficients[j][0];
+              scalar_t weight(0);
+              for(size_t r = 0; r < nb_selected; r++)
+              {
+                weight += current.v_selected_coefficients[r] * p_coefficients[current.v_selected_indices[r]];
+              }
+              kernels_op.axpy(p_acc, -weight, &(*p_deflation_basis)[j].data()[0], data_dimension);
+            }
+          }
+
+          add_rows_sum(current, p_acc_out, p_compensation, direct_accumulation_t());
         }
-        return acc;
+
+        current.v_selected_rows.clear();
+        current.v_selected_indices.clear();
+        current.v_selected_coefficients.clear();
       }
 
-      //! "Optimized" inner product
-      scalar_t inner_product(scalar_t const* p_mu, size_t element_index) const
+      //! Accumulation of the selection of the task of the chunk.
+      void accumulate_selected_rows(accumulation_scalar_t *p_acc, accumulation_scalar_t *p_compensation, bool signed_rows)
       {
-        return inner_product(p_mu, p_c_matrix + element_index * data_padding);
+        accumulate_selected_rows(selection, p_acc, p_compensation, signed_rows);
       }
 
-
-
-    public:
-      asynchronous_chunks_processor() : nb_elements(0), data_dimension(0), p_c_matrix(0), data_padding(0)
+      //! Resets the accumulator (and its compensations) to a null vector of the given size.
+      void reset_accumulator(size_t size)
       {
+        accumulator = accumulator_vector_t(size, 0);
+        if(accumulation_t::compensated)
+        {
+          compensation = accumulator_vector_t(size, 0);
+        }
       }
-      
-      ~asynchronous_chunks_processor()
+
+      //! Compensations of the element @c offset of the accumulator, 0 if the accumulations are not compensated.
+      accumulation_scalar_t* compensation_data(size_t offset = 0)
       {
-        delete [] p_c_matrix;
+        return accumulation_t::compensated ? &compensation.data()[0] + offset : 0;
       }
 
+      //! Posts the accumulator to the listeners, the compensations being applied first.
+      void publish_accumulator()
+      {
+        if(accumulation_t::compensated)
+        {
+          accumulator -= compensation;
+        }
+        signal_acc(&accumulator);
+      }
 
-      //! Sets the data range
-      template <class container_iterator_t>
-      void set_data_range(container_iterator_t const &b, container_iterator_t const& e)
+      //! Number of consecutive rows that fit in the L2 cache (256KB).
+      size_t rows_per_cache_block() const
       {
-        nb_elements = std::distance(b, e);
-        assert(nb_elements > 0);
-        v_signs.resize(nb_elements);
+        return std::max<size_t>(1, (256 * 1024) / (data_padding * sizeof(storage_t)));
+      }
 
-        // aligning on 32 bytes = 1 << 5
-        data_padding = (data_dimension*sizeof(scalar_t) + (1<<5) - 1) & (~((1<<5)-1));
-        data_padding /= sizeof(scalar_t);
-        
-        delete [] p_c_matrix;
-        p_c_matrix = new scalar_t[data_padding*nb_elements];
-        
-        container_iterator_t bb(b);
+      //! Computes the offsets of the inner products of all rows with mu, in case of implicit transformations.
+      void compute_offsets(scalar_t const* p_mu)
+      {
+        if(!implicit_transformations)
+        {
+          return;
+        }
 
-        scalar_t *current_line = p_c_matrix;
-        for(int line = 0; line < nb_elements; line ++, current_line += data_padding, ++bb)
-        {         
-          for(int column = 0; column < data_dimension; column++)
-          {
-            current_line[column] = (*bb)(column);
-          }
+        const scalar_t mean_offset = p_mean ? kernels_op.inner_product(&p_mean->data()[0], p_mu, data_dimension) : scalar_t(0);
+        v_offsets.assign(nb_elements, mean_offset);
+        for(size_t j = 0; j < v_deflation_coefficients.size(); j++)
+        {
+          const scalar_t basis_offset = kernels_op.inner_product(&(*p_deflation_basis)[j].data()[0], p_mu, data_dimension);
+          kernels_op.axpy(&v_offsets[0], basis_offset, &v_deflation_coefficients[j][0], nb_elements);
         }
-        
-        signal_counter();
       }
 
-      //! Sets the dimension of each vectors
-      //! @pre data_dimensions_ strictly positive
-      void set_data_dimensions(size_t data_dimensions_)
+      //! "Optimized" inner product between mu and a row.
+      //! The version of the kernel is selected at runtime (see details::simd::get_kernels). The generic
+      //! version is more cache/memory bandwidth friendly.
+      //! @pre compute_offsets has been called for mu.
+      scalar_t inner_product(scalar_t const* p_mu, size_t row) const
       {
-        data_dimension = data_dimensions_;
-        assert(data_dimension > 0);
+        scalar_t result = storage_op.inner_product(p_rows + row * data_padding, p_mu, data_dimension);
+        if(implicit_transformations)
+        {
+          result -= v_offsets[row];
+        }
+        return result;
       }
 
-      //! Returns the callback object that will be called to signal an updated accumulator.
-      connector_accumulator_t& connector_accumulator()
+      //! Computes the signs of the inner products between mu and the rows [first_row, first_row + nb_rows[.
+      //! The bit i of the returned word is set if the sign of the row first_row + i is positive.
+      //! @pre nb_rows <= 64
+      boost::uint64_t compute_signs(scalar_t const* p_mu, size_t first_row, size_t nb_rows) const
       {
-        return signal_acc;
+        scalar_t inner_products[64];
+        for(size_t i = 0; i < nb_rows; i++)
+        {
+          inner_products[i] = inner_product(p_mu, first_row + i);
+        }
+        return kernels_op.positive_mask(inner_products, nb_rows);
       }
 
-      //! Returns the callback object that will be called to signal the end of the current computation.
-      connector_counter_t& connector_counter()
+      //! Relative rounding error allowed on the margins: a row is skipped only if its sign is not changing by a 
+      //! margin larger than the rounding of the inner products.
+      scalar_t margin_rounding() const
       {
-        return signal_counter;
+        return 8 * std::sqrt(scalar_t(data_dimension)) * std::numeric_limits<scalar_t>::epsilon();
       }
 
+      //! Invalidates the states of the margin pruning after a transformation of the data.
+      void invalidate_rows_norms()
+      {
+        centered_norms_valid = centered_norms_valid && implicit_transformations;
+        rows_norms_valid = false;
+        margins_valid = false;
+      }
 
-      //! Centering the data in case it was not possible to do it beforehand
-      void data_centering_first_phase(size_t full_dataset_size)
+      /*!@brief Computes upper bounds of the norms of the rows after the centering and the deflation.
+       *
+       * In case of implicit transformations, the norm of the deflated row is obtained from the norm of the centered row
+       * and the coefficients of the row on the orthonormal basis vectors.
+       */
+      void compute_rows_norms()
       {
-        scalar_t const * current_line = p_c_matrix;
-        accumulator = data_t(data_dimension, 0);
-        scalar_t * const p_acc_begin = &accumulator(0);
-        scalar_t const * const p_acc_end = p_acc_begin + data_dimension;
-        
-        
-        for(size_t current_element = 0; 
-            current_element < nb_elements; 
-            current_element++, current_line+= data_padding - data_dimension)
+        if(!centered_norms_valid)
         {
-          scalar_t * p_acc = p_acc_begin;
-          for(; p_acc < p_acc_end; p_acc++, current_line++)
+          v_centered_squared_norms.resize(nb_elements);
+          scalar_t const * const p_mean_data = implicit_transformations && p_mean ? &p_mean->data()[0] : 0;
+          for(size_t row = 0; row < nb_elements; row++)
           {
-            *p_acc += *current_line;
+            storage_t const * const current_line = p_rows + row * data_padding;
+            double squared_norm = 0;
+            for(size_t d = 0; d < data_dimension; d++)
+            {
+              const double value = double(current_line[d]) - (p_mean_data ? double(p_mean_data[d]) : 0.);
+              squared_norm += value * value;
+            }
+            v_centered_squared_norms[row] = squared_norm;
           }
+          centered_norms_valid = true;
         }
 
-
-        for(scalar_t * p_acc = p_acc_begin; p_acc < p_acc_end; p_acc++)
+        // the cancellation in the deflated norm is bounded relatively to the centered norm
+        const double rounding = margin_rounding();
+        v_rows_norms.resize(nb_elements);
+        for(size_t row = 0; row < nb_elements; row++)
         {
-          *p_acc /= full_dataset_size;
+          double squared_norm = v_centered_squared_norms[row];
+          if(implicit_transformations)
+          {
+            for(size_t j = 0; j < v_deflation_coefficients.size(); j++)
+            {
+              const double coefficient = v_deflation_coefficients[j][row];
+              squared_norm -= coefficient * coefficient;
+            }
+          }
+          squared_norm = std::max(squared_norm, 0.) + rounding * v_centered_squared_norms[row];
+          v_rows_norms[row] = static_cast<scalar_t>(std::sqrt(squared_norm) * (1 + rounding));
         }
+        rows_norms_valid = true;
+      }
 
+      //! Updates the drift of mu before an update, and resets the margins if needed.
+      void prepare_margin_pruning(data_t const& mu)
+      {
+        if(!margin_pruning)
+        {
+          return;
+        }
 
-        // posts the new value to the listeners for the current dimension
-        signal_acc(&accumulator);
-        signal_counter();
+        if(!rows_norms_valid)
+        {
+          compute_rows_norms();
+        }
 
+        if(!margins_valid)
+        {
+          // all the rows are evaluated during the first update
+          v_margins.assign(nb_elements, scalar_t(-1));
+          mu_drift = 0;
+          margins_valid = true;
+        }
+        else
+        {
+          scalar_t squared_norm(0);
+          for(size_t d = 0; d < data_dimension; d++)
+          {
+            const scalar_t difference = mu(d) - previous_mu(d);
+            squared_norm += difference * difference;
+          }
+          mu_drift += std::sqrt(squared_norm) * (1 + margin_rounding());
+        }
+        previous_mu = mu;
       }
 
-      //! Project the data onto the orthogonal subspace of the provided vector
-      void data_centering_second_phase(data_t const &mean_value)
+      /*!@brief Signs of the rows of a word, skipping the rows for which the sign cannot have changed.
+       *
+       * The change of the inner product of a row since its last evaluation is bounded by the norm of the row times
+       * the drift of mu (Cauchy-Schwarz), so the sign is kept if the margin of the row is above the drift.
+       * The margins of the evaluated rows are updated.
+       */
+      boost::uint64_t compute_pruned_signs(scalar_t const* p_mu, size_t word, size_t first_row, size_t nb_rows, size_t &nb_skipped)
       {
-        scalar_t * current_line = p_c_matrix;
-        scalar_t const * const p_mean_begin = &mean_value(0);
-        scalar_t const * const p_mean_end = p_mean_begin + data_dimension;
-        
-        
-        for(size_t current_element = 0; 
-            current_element < nb_elements; 
-            current_element++, current_line+= data_padding - data_dimension)
+        const boost::uint64_t previous_signs = v_signs[word];
+        boost::uint64_t signs = 0, to_evaluate = 0;
+        for(size_t i = 0; i < nb_rows; i++)
         {
-          const scalar_t * p_mean = p_mean_begin;
-          for(; p_mean < p_mean_end; p_mean++, current_line++)
+          if(v_margins[first_row + i] <= mu_drift)
           {
-            *current_line -= *p_mean;
+            to_evaluate |= boost::uint64_t(1) << i;
           }
         }
+        signs = previous_signs & ~to_evaluate;
+        nb_skipped += nb_rows - details::simd::popcount(to_evaluate);
 
-        // posts the new value to the listeners for the current dimension
-        signal_counter();
+        const scalar_t rounding = margin_rounding();
+        for(; to_evaluate; to_evaluate &= to_evaluate - 1)
+        {
+          const size_t bit = details::simd::count_trailing_zeros(to_evaluate);
+          const size_t row = first_row + bit;
+          const scalar_t ip = inner_product(p_mu, row);
+          if(ip >= 0)
+          {
+            signs |= boost::uint64_t(1) << bit;
+          }
+
+          // a row with a null norm never changes its sign
+          v_margins[row] = v_rows_norms[row] > 0 ? 
+            std::abs(ip) / v_rows_norms[row] - rounding + mu_drift : 
+            std::numeric_limits<scalar_t>::max();
+        }
+        return signs;
+      }
+
+      //! Adds @f$\alpha v@f$ to all rows (explicit transformation of the data).
+      void add_to_rows(scalar_t alpha, scalar_t const* p_vector, boost::true_type)
+      {
+        scalar_t * current_line = p_c_matrix;
+        for(size_t row = 0; row < nb_elements; row++, current_line += data_padding)
+        {
+          kernels_op.axpy(current_line, alpha, p_vector, data_dimension);
+        }
+      }
 
+      //! The compact storage types cannot be transformed explicitly.
+      void add_to_rows(scalar_t, scalar_t const*, boost::false_type)
+      {
+        assert(false);
       }
 
+      //! Adds @f$\alpha v@f$ to one row (explicit transformation of the data).
+      void add_to_row(scalar_t *current_line, scalar_t alpha, scalar_t const* p_vector, boost::true_type)
+      {
+        kernels_op.axpy(current_line, alpha, p_vector, data_dimension);
+      }
 
-      //! PCA steps
-      void pca_accumulation(data_t const &mu)
+      //! The compact storage types cannot be transformed explicitly.
+      void add_to_row(storage_t *, scalar_t, scalar_t const*, boost::false_type)
       {
-        accumulator = data_t(data_dimension, 0);
-        scalar_t const * const p_mu = &mu.data()[0];
-        scalar_t * const p_acc = &accumulator.data()[0];
-                
-        scalar_t const * current_line = p_c_matrix;
+        assert(false);
+      }
 
-        for(size_t s = 0; s < nb_elements; s++, current_line += data_padding)
+      //! Projects the rows onto the orthogonal subspace of mu (explicit transformation of the data).
+      void deflate_rows(scalar_t const* p_mu, boost::true_type)
+      {
+        scalar_t * current_line = p_c_matrix;
+        for(size_t row = 0; row < nb_elements; row++, current_line += data_padding)
         {
-          const scalar_t inner_prod = inner_product(p_mu, current_line);
-          for(size_t d = 0; d < data_dimension; d++)
-          {
-            p_acc[d] += inner_prod * current_line[d];
-          }
+          scalar_t const inner_prod = inner_product(p_mu, row);
+          kernels_op.axpy(current_line, -inner_prod, p_mu, data_dimension);
         }
+      }
 
-        // posts the new value to the listeners
-        signal_acc(&accumulator);
-        signal_counter();
+      //! The compact storage types cannot be transformed explicitly.
+      void deflate_rows(scalar_t const*, boost::false_type)
+      {
+        assert(false);
       }
 
 
 
-      //! Initialises the accumulator and the signs vector from the first mu
-      void initial_accumulation(data_t const &mu)
+      //! Type of the accumulation performed on a frame (block computation).
+      enum e_block_accumulation
       {
-        accumulator = data_t(data_dimension, 0);
-        std::vector<bool>::iterator itb(v_signs.begin());
+        block_pca,      //!< each row weighted by its inner product (see pca_accumulation)
+        block_initial,  //!< signed sum of the rows, the signs being stored (see initial_accumulation)
+        block_update    //!< update of the signed sum from the rows for which the sign changed (see update_accumulation)
+      };
 
-        scalar_t const * const p_mu = &mu.data()[0];
-        scalar_t * const p_acc = &accumulator.data()[0];
+      /*!@brief Accumulation for all the vectors of a frame in one sweep over the data.
+       *
+       * The rows are processed by blocks that stay in the L2 cache: the inner products of each row with all the vectors 
+       * of the frame are computed first, and then the rows of the block are accumulated for each vector. 
+       * The accumulator contains the accumulations of all the vectors of the frame, concatenated.
+       */
+      void block_accumulation(std::vector<data_t> const &frame, e_block_accumulation mode)
+      {
+        const size_t nb_vectors = frame.size();
+        const size_t nb_words = v_signs.size();
+        assert(nb_vectors > 0);
 
-        // first iteration, we store the signs
-        for(size_t s = 0; s < nb_elements; ++itb, s++)
+        reset_accumulator(nb_vectors * data_dimension);
+        accumulation_scalar_t * const p_acc = &accumulator.data()[0];
+
+        std::vector<scalar_t const*> v_frame(nb_vectors);
+        for(size_t c = 0; c < nb_vectors; c++)
         {
-          bool sign = inner_product(p_mu, s) >= 0;
+          v_frame[c] = &frame[c].data()[0];
+        }
 
-          *itb = sign;
-          scalar_t *p(p_acc);
-          scalar_t const * current_line = p_c_matrix + s * data_padding;
-          scalar_t const * const current_line_end = current_line + data_dimension;
-          if(sign)
-          {
-            for(; current_line < current_line_end; ++current_line, ++p)
-            {
-              *p += *current_line;              
-            }
-          }
-          else 
+        if(implicit_transformations)
+        {
+          v_block_offsets.resize(nb_vectors * nb_elements);
+          for(size_t c = 0; c < nb_vectors; c++)
           {
-            for(; current_line < current_line_end; ++current_line, ++p)
-            {
-              *p -= *current_line;              
-            }
+            compute_offsets(v_frame[c]);
+            std::copy(v_offsets.begin(), v_offsets.end(), v_block_offsets.begin() + c * nb_elements);
           }
         }
 
+        if(mode != block_update)
+        {
+          v_block_signs.assign(nb_vectors * nb_words, 0);
+        }
+        v_block_sign_flips.assign(nb_vectors, 0);
 
-        // posts the new value to the listeners
-        signal_acc(&accumulator);
-        signal_counter();
-      }
-
-
-      //! Update the accumulator and the signs vector from an upated mu
-      void update_accumulation(data_t const& mu)
-      {
-        accumulator = data_t(data_dimension, 0);
-
-        bool update = false;
-
-        scalar_t const * const p_mu = &mu.data()[0];
-        scalar_t * const p_acc = &accumulator.data()[0];
-        scalar_t const * current_line = p_c_matrix;
-
+        const size_t rows_per_block = std::min<size_t>(64, rows_per_cache_block());
+        std::vector<scalar_t> v_inner_products(nb_vectors * 64);
+        std::vector<boost::uint64_t> v_new_signs(nb_vectors);
 
-        std::vector<bool>::iterator itb(v_signs.begin());
-        for(size_t s = 0; s < nb_elements; ++itb, s++, current_line += data_padding)
+        for(size_t word = 0, first_row = 0; first_row < nb_elements; word++, first_row += 64)
         {
-          bool sign = inner_product(p_mu, current_line) >= 0;
-          if(sign != *itb)
+          const size_t nb_rows = std::min<size_t>(64, nb_elements - first_row);
+          std::fill(v_new_signs.begin(), v_new_signs.end(), boost::uint64_t(0));
+
+          for(size_t block_begin = 0; block_begin < nb_rows; block_begin += rows_per_block)
           {
-            update = true;
+            const size_t block_end = std::min(nb_rows, block_begin + rows_per_block);
 
-            // update the value of the accumulator according to sign change
-            *itb = sign;
-            
-            scalar_t *p(p_acc);
-            scalar_t const * current_line_copy= current_line;
-            scalar_t const * const current_line_end = current_line + data_dimension;
-            
-            if(sign)
+            // inner products of the rows of the block with all the vectors of the frame
+            for(size_t i = block_begin; i < block_end; i++)
             {
-              for(; current_line_copy < current_line_end; ++current_line_copy, ++p)
+              const size_t row = first_row + i;
+              storage_t const * const current_line = p_rows + row * data_padding;
+              for(size_t c = 0; c < nb_vectors; c++)
               {
-                *p += *current_line_copy;
+                scalar_t ip = storage_op.inner_product(current_line, v_frame[c], data_dimension);
+                if(implicit_transformations)
+                {
+                  ip -= v_block_offsets[c * nb_elements + row];
+                }
+                v_inner_products[c * 64 + i] = ip;
               }
             }
-            else 
+
+            // accumulation of the rows of the block (still in the cache) for each vector
+            for(size_t c = 0; c < nb_vectors; c++)
             {
-              for(; current_line_copy < current_line_end; ++current_line_copy, ++p)
+              const boost::uint64_t previous_signs = v_block_signs[c * nb_words + word];
+              for(size_t i = block_begin; i < block_end; i++)
               {
-                *p -= *current_line_copy;
+                const scalar_t ip = v_inner_products[c * 64 + i];
+                if(mode == block_pca)
+                {
+                  select_row(first_row + i, ip);
+                  continue;
+                }
+
+                const boost::uint64_t positive = ip >= 0 ? 1 : 0;
+                v_new_signs[c] |= positive << i;
+                if(mode == block_initial)
+                {
+                  select_row(first_row + i, positive ? scalar_t(1) : scalar_t(-1));
+                }
+                else if(positive != ((previous_signs >> i) & 1))
+                {
+                  v_block_sign_flips[c]++;
+                  select_row(first_row + i, positive ? scalar_t(2) : scalar_t(-2));
+                }
               }
+              accumulate_selected_rows(p_acc + c * data_dimension, compensation_data(c * data_dimension), mode != block_pca);
             }
           }
-        }
 
-        // posts the new value to the listeners
-        if(update)
-        {
-          scalar_t *p(p_acc);
-          for(size_t d = 0; d < data_dimension; d++, ++p)
+          if(mode != block_pca)
           {
-            *p *= 2;
-          }          
-          signal_acc(&accumulator);
+            for(size_t c = 0; c < nb_vectors; c++)
+            {
+              v_block_signs[c * nb_words + word] = v_new_signs[c];
+            }
+          }
+        }
+      }
+
+    public:
+      asynchronous_chunks_processor() : 
+        nb_elements(0), 
+        data_dimension(0), 
+        nb_sign_flips(0),
+        signs_hash_change(0),
+        signs_hash_offset(0),
+        p_c_matrix(0), 
+        p_rows(0),
+        data_padding(0), 
+        kernels_op(details::simd::get_kernels<scalar_t>()),
+        storage_op(details::simd::get_storage_kernels<storage_t, scalar_t>()),
+        p_current_mu(0),
+        implicit_transformations(!native_storage_t::value),
+        p_mean(0),
+        p_deflation_basis(0),
+        margin_pruning(false),
+        mu_drift(0),
+        centered_norms_valid(false),
+        rows_norms_valid(false),
+        margins_valid(false),
+        nb_skipped_rows(0),
+        representable_data(true)
+      {
+      }
+      
+      ~asynchronous_chunks_processor()
+      {
+        details::simd::aligned_free(p_c_matrix);
+      }
+
+
+      //! Allocates the states attached to the rows
+      void allocate_rows_states()
+      {
+        assert(nb_elements > 0);
+
+        // the exact accumulators of the signed sums of the rows should not overflow (checked by batch_process)
+        assert(details::storage_conversion<storage_t>::exact_accumulation(nb_elements));
+
+        v_signs.resize((nb_elements + 63) / 64);
+        centered_norms_valid = rows_norms_valid = margins_valid = false;
+        selection.v_selected_rows.reserve(nb_elements);
+        selection.v_selected_indices.reserve(nb_elements);
+        selection.v_selected_coefficients.reserve(nb_elements);
+      }
+
+      //! Sets the data range
+      template <class container_iterator_t>
+      void set_data_range(container_iterator_t const &b, container_iterator_t const& e)
+      {
+        nb_elements = std::distance(b, e);
+        allocate_rows_states();
+
+        // aligning each line on the width of the vector registers (at least 32 bytes)
+        const size_t alignment = details::simd::row_alignment();
+        data_padding = details::simd::padded_size<storage_t>(data_dimension, alignment);
+        
+        details::simd::aligned_free(p_c_matrix);
+        p_c_matrix = 0;
+        p_c_matrix = details::simd::aligned_allocate<storage_t>(data_padding*nb_elements, alignment);
+        
+        container_iterator_t bb(b);
+
+        storage_t *current_line = p_c_matrix;
+        representable_data = true;
+        for(int line = 0; line < nb_elements; line ++, current_line += data_padding, ++bb)
+        {         
+          for(int column = 0; column < data_dimension; column++)
+          {
+            if(!details::storage_conversion<storage_t>::convert((*bb)(column), current_line[column]))
+            {
+              representable_data = false;
+            }
+          }
+
+          // zeroing the padding, so that the full padded line holds defined values
+          std::fill(current_line + data_dimension, current_line + data_padding, storage_t(0));
         }
+        p_rows = p_c_matrix;
+        
         signal_counter();
       }
 
-      //! Project the data onto the orthogonal subspace of the provided vector
-	    template <class vector_t>
-      void project_onto_orthogonal_subspace(vector_t const &mu)
+      //! Returns false if some values of the copied data are not represented exactly by the storage type.
+      bool has_representable_data() const
       {
-        // update of vectors in the orthogonal space, and update of the norms at the same time. 
-		    std::vector<typename vector_t::value_type> v(mu.begin(), mu.end()); // some issues with VC2015
-        scalar_t const * const p_mu = &v[0];
-        scalar_t * current_line = p_c_matrix;
+        return representable_data;
+      }
+
+      /*!@brief Sets the rows from data owned by the caller, which is read in place and never modified. 
+       *
+       * @param[in] p_rows_ pointer on the first row.
+       * @param[in] nb_rows number of rows.
+       * @param[in] row_stride number of elements between the beginning of two consecutive rows.
+       * @pre set_data_dimensions has been called, and @c row_stride >= data dimension.
+       */
+      void set_borrowed_data(storage_t const *p_rows_, size_t nb_rows, size_t row_stride)
+      {
+        assert(row_stride >= data_dimension);
+        nb_elements = nb_rows;
+        allocate_rows_states();
+
+        details::simd::aligned_free(p_c_matrix);
+        p_c_matrix = 0;
+        p_rows = p_rows_;
+        data_padding = row_stride;
+        implicit_transformations = true;
+      }
+
+      /*!@brief Sets the implicit transformations of the data (see grassmann_pca::set_implicit_deflation).
+       *
+       * The transformations are always implicit for the compact storage types and the borrowed data.
+       * @pre no transformation has been applied to the data yet.
+       */
+      void set_implicit_transformations(bool implicit)
+      {
+        implicit_transformations = implicit || !native_storage_t::value || !p_c_matrix;
+      }
+
+      //! Returns the number of signs that changed during the last call to update_accumulation.
+      size_t get_nb_sign_flips() const
+      {
+        return nb_sign_flips;
+      }
+
+      //! Returns the number of rows skipped during the last call to update_accumulation.
+      size_t get_nb_skipped_rows() const
+      {
+        return nb_skipped_rows;
+      }
+
+      //! Returns the change of the hash of the signs during the last call to update_accumulation.
+      boost::uint64_t get_signs_hash_change() const
+      {
+        return signs_hash_change;
+      }
+
+      //! Sets the index of the chunk, which positions its signs in the hash of all the signs.
+      void set_chunk_index(size_t chunk)
+      {
+        signs_hash_offset = boost::uint64_t(chunk) << 40;
+      }
+
+      //! Sets the margin pruning of the updates (see grassmann_pca::set_margin_pruning).
+      void set_margin_pruning(bool margin_pruning_)
+      {
+        margin_pruning = margin_pruning_;
+      }
+
+      //! Sets the dimension of each vectors
+      //! @pre data_dimensions_ strictly positive
+      void set_data_dimensions(size_t data_dimensions_)
+      {
+        data_dimension = data_dimensions_;
+        assert(data_dimension > 0);
+      }
+
+      /*!@brief Sets the container of the basis vectors used for the implicit deflation.
+       *
+       * The container should not be modified while a task of this processor is running. The basis vector
+       * @c j should be appended to the container before the call to project_onto_orthogonal_subspace for this
+       * vector.
+       */
+      void set_deflation_basis(std::vector<data_t> const *p_deflation_basis_)
+      {
+        p_deflation_basis = p_deflation_basis_;
+      }
+
+      //! Returns the callback object that will be called to signal an updated accumulator.
+      connector_accumulator_t& connector_accumulator()
+      {
+        return signal_acc;
+      }
+
+      //! Returns the callback object that will be called to signal the end of the current computation.
+      connector_counter_t& connector_counter()
+      {
+        return signal_counter;
+      }
+
+
+      //! Centering the data in case it was not possible to do it beforehand
+      void data_centering_first_phase(size_t full_dataset_size)
+      {
+        reset_accumulator(data_dimension);
+        accumulation_scalar_t * const p_acc_begin = &accumulator(0);
+        accumulation_scalar_t const * const p_acc_end = p_acc_begin + data_dimension;
         
-        for(size_t line = 0; line < nb_elements; line ++, current_line += data_padding)
+        for(size_t row = 0; row < nb_elements; row++)
         {
-          scalar_t const inner_prod = inner_product(p_mu, current_line);
-          for(int column = 0; column < data_dimension; column++)
+          select_row(row, scalar_t(1));
+        }
+        accumulate_selected_rows(p_acc_begin, compensation_data(), true);
+        if(accumulation_t::compensated)
+        {
+          accumulator -= compensation;
+          compensation.clear();
+        }
+
+        for(accumulation_scalar_t * p_acc = p_acc_begin; p_acc < p_acc_end; p_acc++)
+        {
+          *p_acc /= full_dataset_size;
+        }
+
+
+        // posts the new value to the listeners for the current dimension
+        signal_acc(&accumulator);
+        signal_counter();
+
+      }
+
+      //! Project the data onto the orthogonal subspace of the provided vector
+      //! In case of implicit transformations, the mean should live until the end of the computations.
+      void data_centering_second_phase(data_t const &mean_value)
+      {
+        if(implicit_transformations)
+        {
+          p_mean = &mean_value;
+        }
+        else
+        {
+          add_to_rows(scalar_t(-1), &mean_value.data()[0], native_storage_t());
+        }
+        centered_norms_valid = false;
+        invalidate_rows_norms();
+
+        // posts the new value to the listeners for the current dimension
+        signal_counter();
+
+      }
+
+
+      //! PCA steps
+      void pca_accumulation(data_t const &mu)
+      {
+        reset_accumulator(data_dimension);
+        scalar_t const * const p_mu = &mu.data()[0];
+        accumulation_scalar_t * const p_acc = &accumulator.data()[0];
+
+        compute_offsets(p_mu);
+        for(size_t s = 0; s < nb_elements; s++)
+        {
+          select_row(s, inner_product(p_mu, s));
+        }
+        accumulate_selected_rows(p_acc, compensation_data(), false);
+
+        // posts the new value to the listeners
+        publish_accumulator();
+        signal_counter();
+      }
+
+
+
+      //! Initialises the accumulator and the signs vector from the first mu
+      void initial_accumulation(data_t const &mu)
+      {
+        reset_accumulator(data_dimension);
+
+        scalar_t const * const p_mu = &mu.data()[0];
+        accumulation_scalar_t * const p_acc = &accumulator.data()[0];
+
+        compute_offsets(p_mu);
+
+        // first iteration, we store the signs
+        for(size_t word = 0, first_row = 0; first_row < nb_elements; word++, first_row += 64)
+        {
+          const size_t nb_rows = std::min<size_t>(64, nb_elements - first_row);
+          const boost::uint64_t signs = compute_signs(p_mu, first_row, nb_rows);
+          v_signs[word] = signs;
+
+          for(size_t i = 0; i < nb_rows; i++)
           {
-            current_line[column] -= inner_prod * p_mu[column];
-          }               
+            select_row(first_row + i, (signs >> i) & 1 ? scalar_t(1) : scalar_t(-1));
+          }
         }
-  
+        accumulate_selected_rows(p_acc, compensation_data(), true);
+        margins_valid = false;
+
+
+        // posts the new value to the listeners
+        publish_accumulator();
         signal_counter();
       }
 
-    };
 
+      /*!@brief Updates the accumulator and the signs for the rows of the words [first_word, last_word[ (see update_accumulation).
+       *
+       * The words of rows are disjoint between the threads working on the chunk, so the signs (and the margins) can be 
+       * updated without synchronisation.
+       * @pre compute_offsets and prepare_margin_pruning have been called for mu.
+       * @return true if some rows were accumulated.
+       */
+      bool update_rows(
+        scalar_t const *p_mu,
+        size_t first_word, size_t last_word,
+        rows_selection &current,
+        accumulation_scalar_t *p_acc,
+        accumulation_scalar_t *p_compensation,
+        size_t &nb_flips,
+        size_t &nb_skipped,
+        boost::uint64_t &hash_change)
+      {
+        for(size_t word = first_word, first_row = 64 * first_word; word < last_word; word++, first_row += 64)
+        {
+          const size_t nb_rows = std::min<size_t>(64, nb_elements - first_row);
+          const boost::uint64_t signs = margin_pruning ? 
+            compute_pruned_signs(p_mu, word, first_row, nb_rows, nb_skipped) :
+            compute_signs(p_mu, first_row, nb_rows);
+          boost::uint64_t flips = signs ^ v_signs[word];
+          if(!flips)
+          {
+            continue;
+          }
 
-    /*!@internal
-     * @brief Accumulation gathering the result of all workers.
-     *
-     * The purpose of this class is to add the computed accumulator of each thread to the final result
-     * which contains the sum of all accumulators. 
-     *
-     */
-    struct asynchronous_results_merger : 
-      details::threading::asynchronous_results_merger<
-        data_t,
-        details::threading::merger_addition<data_t>,
-        details::threading::initialisation_vector_specific_dimension<data_t>
-        >
-    {
-    private:
-      typedef details::threading::initialisation_vector_specific_dimension<data_t> data_init_type;
-      typedef details::threading::merger_addition<data_t> merger_type;
-      typedef details::threading::asynchronous_results_merger<data_t, merger_type, data_init_type> parent_type;
-    
-    public:
+          hash_change ^= 
+            details::signs_word_hash(signs_hash_offset + word, v_signs[word]) ^ 
+            details::signs_word_hash(signs_hash_offset + word, signs);
+          v_signs[word] = signs;
+          nb_flips += details::simd::popcount(flips);
+
+          // the flipped rows are selected for the update of the accumulator: the contribution of a row
+          // changes from -x to +x (or the opposite), hence the factor 2
+          for(; flips; flips &= flips - 1)
+          {
+            const size_t bit = details::simd::count_trailing_zeros(flips);
+            select_row(current, first_row + bit, (signs >> bit) & 1 ? scalar_t(2) : scalar_t(-2));
+          }
+        }
+
+        if(current.v_selected_rows.empty())
+        {
+          return false;
+        }
+        accumulate_selected_rows(current, p_acc, p_compensation, true);
+        return true;
+      }
+
+      //! Update the accumulator and the signs vector from an upated mu
+      void update_accumulation(data_t const& mu)
+      {
+        reset_accumulator(data_dimension);
+
+        scalar_t const * const p_mu = &mu.data()[0];
+        accumulation_scalar_t * const p_acc = &accumulator.data()[0];
+
+        compute_offsets(p_mu);
+        prepare_margin_pruning(mu);
 
-      /*!Constructor
+        nb_sign_flips = 0;
+        nb_skipped_rows = 0;
+        signs_hash_change = 0;
+
+        // posts the new value to the listeners
+        if(update_rows(p_mu, 0, v_signs.size(), selection, p_acc, compensation_data(), nb_sign_flips, nb_skipped_rows, signs_hash_change))
+        {
+          publish_accumulator();
+        }
+        signal_counter();
+      }
+
+      /*!@brief Update of the accumulator and the signs, the rows of the chunk being shared with the idle workers.
        *
-       * @param dimension_ the number of dimensions of the vector to accumulate
+       * The task of the chunk claims ranges of rows from the scheduler, while the other workers may steal the remaining
+       * ranges (see steal_update_rows). The stolen rows are accumulated and their sign flips counted by the stealing workers.
+       * The duration of the task is given to the scheduler.
        */
-      asynchronous_results_merger(size_t data_dimension_) : parent_type(data_init_type(data_dimension_))
-      {}
+      void update_accumulation_shared(data_t const& mu, details::threading::row_ranges_scheduler *scheduler, size_t chunk)
+      {
+        const boost::chrono::steady_clock::time_point start = boost::chrono::steady_clock::now();
 
+        reset_accumulator(data_dimension);
 
-    };
+        p_current_mu = &mu.data()[0];
+        accumulation_scalar_t * const p_acc = &accumulator.data()[0];
+
+        compute_offsets(p_current_mu);
+        prepare_margin_pruning(mu);
+        nb_sign_flips = 0;
+        nb_skipped_rows = 0;
+        signs_hash_change = 0;
+        scheduler->open(chunk);
+
+        bool accumulated = false;
+        size_t first_word, last_word, nb_words = 0;
+        while(scheduler->claim(chunk, first_word, last_word))
+        {
+          accumulated |= update_rows(p_current_mu, first_word, last_word, selection, p_acc, compensation_data(), nb_sign_flips, nb_skipped_rows, signs_hash_change);
+          nb_words += last_word - first_word;
+        }
 
+        scheduler->set_owner_duration(
+          chunk, 
+          boost::chrono::duration<double>(boost::chrono::steady_clock::now() - start).count(), 
+          nb_words);
 
+        // posts the new value to the listeners
+        if(accumulated)
+        {
+          publish_accumulator();
+        }
+        signal_counter();
+      }
 
+      /*!@brief Processes a range of rows stolen by another worker during update_accumulation_shared.
+       *
+       * @param[in, out] current the selection of the stealing worker.
+       * @param[in, out] p_acc the accumulator of the stealing worker.
+       * @param[in, out] p_compensation the compensations of the accumulator of the stealing worker, 0 if not compensated.
+       * @param[in, out] nb_flips the number of sign flips counted by the stealing worker.
+       * @param[in, out] nb_skipped the number of skipped rows counted by the stealing worker.
+       * @param[in, out] hash_change the change of the hash of the signs computed by the stealing worker.
+       * @return true if some rows were accumulated.
+       * @pre the chunk is opened in the scheduler.
+       */
+      bool steal_update_rows(
+        details::threading::row_ranges_scheduler &scheduler, 
+        size_t chunk,
+        rows_selection &current, 
+        accumulation_scalar_t *p_acc, 
+        accumulation_scalar_t *p_compensation, 
+        size_t &nb_flips,
+        size_t &nb_skipped,
+        boost::uint64_t &hash_change)
+      {
+        size_t first_word, last_word;
+        if(!scheduler.claim(chunk, first_word, last_word))
+        {
+          return false;
+        }
+        return update_rows(p_current_mu, first_word, last_word, current, p_acc, p_compensation, nb_flips, nb_skipped, hash_change);
+      }
 
+      //! Number of words of 64 rows of the chunk.
+      size_t nb_row_words() const
+      {
+        return v_signs.size();
+      }
 
+      //! Number of vectors of the chunk.
+      size_t get_nb_elements() const
+      {
+        return nb_elements;
+      }
 
+      //! Indicates that the centering and the deflation are applied implicitly (see set_implicit_transformations).
+      bool has_implicit_transformations() const
+      {
+        return implicit_transformations;
+      }
 
-  public:
+      //! Returns the row @c row of the copy of the data, for the computations by tiles (see dimension_tiles_processor).
+      //! @pre the data is stored with the scalar type and the transformations are explicit.
+      scalar_t* native_row(size_t row)
+      {
+        return native_row(row, native_storage_t());
+      }
+
+      scalar_t* native_row(size_t row, boost::true_type)
+      {
+        assert(p_c_matrix);
+        return p_c_matrix + row * data_padding;
+      }
+
+      scalar_t* native_row(size_t, boost::false_type)
+      {
+        assert(false);
+        return 0;
+      }
+
+      //! Project the data onto the orthogonal subspace of the provided vector
+      //! In case of implicit deflation, only the coefficients of the rows on the vector are stored.
+	    template <class vector_t>
+      void project_onto_orthogonal_subspace(vector_t const &mu)
+      {
+        // update of vectors in the orthogonal space, and update of the norms at the same time. 
+		    std::vector<typename vector_t::value_type> v(mu.begin(), mu.end()); // some issues with VC2015
+        scalar_t const * const p_mu = &v[0];
+
+        compute_offsets(p_mu);
+        if(implicit_transformations)
+        {
+          assert(p_deflation_basis && p_deflation_basis->size() > v_deflation_coefficients.size());
+
+          std::vector<scalar_t> coefficients(nb_elements);
+          for(size_t row = 0; row < nb_elements; row++)
+          {
+            coefficients[row] = inner_product(p_mu, row);
+          }
+          v_deflation_coefficients.push_back(std::vector<scalar_t>());
+          v_deflation_coefficients.back().swap(coefficients);
+        }
+        else
+        {
+          deflate_rows(p_mu, native_storage_t());
+        }
+        invalidate_rows_norms();
+  
+        signal_counter();
+      }
+
+
+      //! Returns the number of signs that changed for each vector of the frame during the last call to block_update_accumulation.
+      std::vector<size_t> const& get_block_sign_flips() const
+      {
+        return v_block_sign_flips;
+      }
+
+      //! PCA steps for all the vectors of a frame (see pca_accumulation).
+      void block_pca_accumulation(std::vector<data_t> const &frame)
+      {
+        block_accumulation(frame, block_pca);
+        publish_accumulator();
+        signal_counter();
+      }
+
+      //! Initialises the accumulators and the signs for all the vectors of a frame (see initial_accumulation).
+      void block_initial_accumulation(std::vector<data_t> const &frame)
+      {
+        block_accumulation(frame, block_initial);
+        publish_accumulator();
+        signal_counter();
+      }
+
+      //! Updates the accumulators and the signs for all the vectors of a frame (see update_accumulation).
+      void block_update_accumulation(std::vector<data_t> const &frame)
+      {
+        block_accumulation(frame, block_update);
+        publish_accumulator();
+        signal_counter();
+      }
+
+      /*!@brief Projects the data onto the orthogonal subspace of all the vectors of a frame, in one sweep over the data.
+       *
+       * The vectors of the frame are applied sequentially, as successive calls to project_onto_orthogonal_subspace
+       * would do: the coefficient of a row on the vector @c c is corrected by the coefficients on the previous vectors 
+       * of the frame and their inner products with the vector @c c.
+       */
+      void project_onto_orthogonal_frame(std::vector<data_t> const &frame)
+      {
+        const size_t nb_vectors = frame.size();
+
+        // inner products between the vectors of the frame
+        std::vector<scalar_t> v_gram(nb_vectors * nb_vectors);
+        for(size_t c = 0; c < nb_vectors; c++)
+        {
+          for(size_t c2 = 0; c2 < c; c2++)
+          {
+            v_gram[c2 * nb_vectors + c] = kernels_op.inner_product(&frame[c2].data()[0], &frame[c].data()[0], data_dimension);
+          }
+        }
+
+        if(implicit_transformations)
+        {
+          v_block_offsets.resize(nb_vectors * nb_elements);
+          for(size_t c = 0; c < nb_vectors; c++)
+          {
+            compute_offsets(&frame[c].data()[0]);
+            std::copy(v_offsets.begin(), v_offsets.end(), v_block_offsets.begin() + c * nb_elements);
+          }
+
+          assert(p_deflation_basis && p_deflation_basis->size() >= v_deflation_coefficients.size() + nb_vectors);
+          v_deflation_coefficients.resize(v_deflation_coefficients.size() + nb_vectors, std::vector<scalar_t>(nb_elements));
+        }
+
+        const size_t first_coefficients = v_deflation_coefficients.size() - (implicit_transformations ? nb_vectors : 0);
+        std::vector<scalar_t> v_coefficients(nb_vectors);
+        for(size_t row = 0; row < nb_elements; row++)
+        {
+          storage_t const * const current_line = p_rows + row * data_padding;
+          for(size_t c = 0; c < nb_vectors; c++)
+          {
+            scalar_t ip = storage_op.inner_product(current_line, &frame[c].data()[0], data_dimension);
+            if(implicit_transformations)
+            {
+              ip -= v_block_offsets[c * nb_elements + row];
+            }
+            for(size_t c2 = 0; c2 < c; c2++)
+            {
+              ip -= v_coefficients[c2] * v_gram[c2 * nb_vectors + c];
+            }
+            v_coefficients[c] = ip;
+          }
+
+          if(implicit_transformations)
+          {
+            for(size_t c = 0; c < nb_vectors; c++)
+            {
+              v_deflation_coefficients[first_coefficients + c][row] = v_coefficients[c];
+            }
+          }
+          else
+          {
+            for(size_t c = 0; c < nb_vectors; c++)
+            {
+              add_to_row(p_c_matrix + row * data_padding, -v_coefficients[c], &frame[c].data()[0], native_storage_t());
+            }
+          }
+        }
+
+        invalidate_rows_norms();
+
+        signal_counter();
+      }
+
+      /*!@brief Projects the data onto the orthogonal subspace of the basis vector u, and starts the computation of the 
+       * next basis vector from @f$\mu@f$ in the same sweep over the data.
+       *
+       * Each row is deflated and its contribution to the accumulator of @f$\mu@f$ is added while the row is still 
+       * in the cache. The inner products with u and @f$\mu@f$ are computed in one pass over the row, since 
+       * @f$\langle x - \langle x, u\rangle u, \mu\rangle = \langle x, \mu\rangle - \langle x, u\rangle\langle u, \mu\rangle@f$.
+       *
+       * @param[in] u the basis vector against which the data is deflated
+       * @param[in] mu the initial value of the next basis vector
+       * @param[in] pca_step if true, the accumulation is the one of pca_accumulation, otherwise the one of initial_accumulation.
+       */
+      template <class vector_t>
+      void project_and_accumulate(vector_t const &u, data_t const &mu, bool pca_step)
+      {
+        std::vector<scalar_t> v(u.begin(), u.end());
+        scalar_t const * const p_u = &v[0];
+        scalar_t const * const p_mu = &mu.data()[0];
+        const scalar_t u_mu = kernels_op.inner_product(p_u, p_mu, data_dimension);
+
+        reset_accumulator(data_dimension);
+        accumulation_scalar_t * const p_acc = &accumulator.data()[0];
+
+        // offsets of the implicit transformations before the deflation against u
+        std::vector<scalar_t> v_offsets_u;
+        compute_offsets(p_u);
+        v_offsets_u.swap(v_offsets);
+        compute_offsets(p_mu);
+
+        // the coefficients on u are needed for the accumulation of the selected rows
+        scalar_t *p_coefficients = 0;
+        if(implicit_transformations)
+        {
+          assert(p_deflation_basis && p_deflation_basis->size() > v_deflation_coefficients.size());
+          v_deflation_coefficients.push_back(std::vector<scalar_t>(nb_elements));
+          p_coefficients = &v_deflation_coefficients.back()[0];
+        }
+
+        // rows accumulated while they are still in the L2 cache
+        const size_t rows_per_block = rows_per_cache_block();
+
+        for(size_t word = 0, first_row = 0; first_row < nb_elements; word++, first_row += 64)
+        {
+          const size_t nb_rows = std::min<size_t>(64, nb_elements - first_row);
+          boost::uint64_t signs = 0;
+          for(size_t i = 0; i < nb_rows; i++)
+          {
+            const size_t row = first_row + i;
+            storage_t const * const current_line = p_rows + row * data_padding;
+
+            scalar_t ip_mu;
+            scalar_t ip_u = storage_op.dual_inner_product(current_line, p_u, p_mu, data_dimension, &ip_mu);
+            if(implicit_transformations)
+            {
+              ip_u -= v_offsets_u[row];
+              ip_mu -= v_offsets[row];
+              p_coefficients[row] = ip_u;
+            }
+            else
+            {
+              add_to_row(p_c_matrix + row * data_padding, -ip_u, p_u, native_storage_t());
+            }
+            ip_mu -= ip_u * u_mu;
+
+            if(pca_step)
+            {
+              select_row(row, ip_mu);
+            }
+            else
+            {
+              const bool positive = ip_mu >= 0;
+              signs |= boost::uint64_t(positive) << i;
+              select_row(row, positive ? scalar_t(1) : scalar_t(-1));
+            }
+
+            if(selection.v_selected_rows.size() >= rows_per_block)
+            {
+              accumulate_selected_rows(p_acc, compensation_data(), !pca_step);
+            }
+          }
+          v_signs[word] = signs;
+        }
+        accumulate_selected_rows(p_acc, compensation_data(), !pca_step);
+        invalidate_rows_norms();
+
+        // posts the new value to the listeners
+        publish_accumulator();
+        signal_counter();
+      }
+
+    };
+
+
+    //!@internal
+    //!@brief Task of an idle worker, stealing rows from the busy chunks during an update (see set_work_stealing).
+    //!
+    //! The rows stolen are accumulated in the accumulator of the stealer, which is merged as the ones of the chunks.
+    struct chunks_stealer
+    {
+    private:
+      typedef typename data_t::value_type scalar_t;
+
+      //! Accumulator of the stolen rows.
+      //! Should live beyond the scope of steal_update, as required by the merger.
+      accumulator_vector_t accumulator;
+
+      //! Compensations of the rounding errors of the accumulator, for the compensated accumulations.
+      accumulator_vector_t compensation;
+
+      //! Number of signs of the stolen rows that changed during the last update.
+      size_t nb_sign_flips;
+
+      //! Number of stolen rows skipped during the last update (see set_margin_pruning).
+      size_t nb_skipped_rows;
+
+      //! Change of the hash of the signs of the stolen rows during the last update.
+      boost::uint64_t signs_hash_change;
+
+      //! Selection of the stolen rows.
+      typename asynchronous_chunks_processor::rows_selection selection;
+
+      typedef boost::function<void (accumulator_vector_t const*)> connector_accumulator_t;
+      connector_accumulator_t signal_acc;
+
+      typedef boost::function<void ()> connector_counter_t;
+      connector_counter_t signal_counter;
+
+    public:
+      chunks_stealer() : nb_sign_flips(0), nb_skipped_rows(0), signs_hash_change(0)
+      {}
+
+      //! Returns the callback object that will be called to signal an updated accumulator.
+      connector_accumulator_t& connector_accumulator()
+      {
+        return signal_acc;
+      }
+
+      //! Returns the callback object that will be called to signal the end of the current computation.
+      connector_counter_t& connector_counter()
+      {
+        return signal_counter;
+      }
+
+      //! Returns the number of signs of the stolen rows that changed during the last call to steal_update.
+      size_t get_nb_sign_flips() const
+      {
+        return nb_sign_flips;
+      }
+
+      //! Returns the number of stolen rows skipped during the last call to steal_update.
+      size_t get_nb_skipped_rows() const
+      {
+        return nb_skipped_rows;
+      }
+
+      //! Returns the change of the hash of the signs of the stolen rows during the last call to steal_update.
+      boost::uint64_t get_signs_hash_change() const
+      {
+        return signs_hash_change;
+      }
+
+      /*!@brief Steals rows from the opened chunks until all the rows are claimed.
+       *
+       * @param[in] p_processors the processors of the chunks.
+       * @param[in] scheduler the scheduler of the rows of the current update.
+       * @param[in] node node of the worker, the chunks of this node are stolen first.
+       * @param[in] data_dimension dimension of the data.
+       */
+      void steal_update(
+        std::vector<asynchronous_chunks_processor> *p_processors,
+        details::threading::row_ranges_scheduler *scheduler,
+        size_t node,
+        size_t data_dimension)
+      {
+        nb_sign_flips = 0;
+        nb_skipped_rows = 0;
+        signs_hash_change = 0;
+
+        bool accumulated = false;
+        size_t chunk;
+        for(bool first = true; scheduler->select_victim(node, chunk); first = false)
+        {
+          if(first)
+          {
+            accumulator = accumulator_vector_t(data_dimension, 0);
+            if(accumulation_t::compensated)
+            {
+              compensation = accumulator_vector_t(data_dimension, 0);
+            }
+          }
+          accumulated |= (*p_processors)[chunk].steal_update_rows(
+            *scheduler, chunk, selection, 
+            &accumulator.data()[0], accumulation_t::compensated ? &compensation.data()[0] : 0, 
+            nb_sign_flips, nb_skipped_rows, signs_hash_change);
+        }
+
+        // posts the new value to the listeners
+        if(accumulated)
+        {
+          if(accumulation_t::compensated)
+          {
+            accumulator -= compensation;
+          }
+          signal_acc(&accumulator);
+        }
+        signal_counter();
+      }
+    };
+
+
+    //!@internal
+    /*!@brief Iterations distributed by tiles of rows and dimensions, for the datasets of few high dimensional vectors
+     * (see set_dimension_tiling).
+     *
+     * With few vectors per chunk, the cost of an iteration is dominated by the accumulators of size D of the chunks and
+     * by their merge. The tasks here own tiles of rows and dimensions instead:
+     * - the inner products of the rows of a tile with @f$\mu@f$ are computed on the dimensions of the tile, and the
+     *   partial inner products of each row are added over the tiles of dimensions afterwards, which costs
+     *   @f$N@f$ scalars per tile of dimensions;
+     * - the selected rows are accumulated by tiles of dimensions, each task writing its own range of the accumulator:
+     *   there is no partial accumulator and no merge along the dimensions.
+     *
+     * The signs and the selections of the rows are computed by the calling thread between the two phases, in
+     * @f$O(N)@f$. The projection onto the orthogonal subspace of a basis vector is fused with the first accumulation
+     * of the next one, as for the chunks. The rows are the copies of the chunks, which should be stored with the
+     * scalar type and transformed explicitly.
+     */
+    struct dimension_tiles_processor
+    {
+    public:
+      //! Minimal number of dimensions of a tile.
+      static const size_t min_tile_dimensions = 512;
+
+    private:
+      typedef typename data_t::value_type scalar_t;
+
+      //! Rows of all the chunks, in the order of the chunks.
+      std::vector<scalar_t*> v_rows;
+
+      //! Number of vectors.
+      size_t nb_elements;
+
+      //! Dimension of the vectors.
+      size_t data_dimension;
+
+      //! Partition of the rows and of the dimensions.
+      size_t nb_row_tiles, rows_per_tile, nb_dimension_tiles, dimensions_per_tile;
+
+      //! Partial inner products of the tiles: the products with @f$\mu@f$ of the tile of dimensions @c t start at @c 2*t*nb_elements, 
+      //! followed by the products with the vector against which the data is deflated.
+      std::vector<scalar_t> v_partial_products;
+
+      //! Inner products of all the rows with @f$\mu@f$.
+      std::vector<scalar_t> v_inner_products;
+
+      //! Coefficients of all the rows on the vector against which the data is deflated.
+      std::vector<scalar_t> v_deflation_coefficients;
+
+      //! Signs of all the rows, packed by words of 64 bits (see asynchronous_chunks_processor).
+      std::vector<boost::uint64_t> v_signs;
+
+      //! Rows selected for the next accumulation, and their weights.
+      std::vector<scalar_t const*> v_selected_rows;
+      std::vector<scalar_t> v_selected_coefficients;
+
+      //! Accumulator of all the rows, updated in place by the tiles of dimensions.
+      data_t accumulator;
+
+      //! Squared norms of the accumulator on each tile of dimensions, computed by the accumulations.
+      std::vector<double> v_tiles_squared_norms;
+
+      //! Number of signs that changed during the last update, and the change of the hash of the signs.
+      size_t nb_sign_flips;
+      boost::uint64_t signs_hash_change;
+
+      details::simd::kernels<scalar_t> kernels_op;
+
+      //! Notifications of the tasks (barrier).
+      details::threading::notification_counter counter;
+
+      //! Inner products of the rows of a tile with @f$\mu@f$, and with @c p_u if not 0.
+      void inner_products_task(size_t row_tile, size_t dimension_tile, scalar_t const *p_mu, scalar_t const *p_u)
+      {
+        const size_t first_row = row_tile * rows_per_tile;
+        const size_t nb_rows = std::min(rows_per_tile, nb_elements - first_row);
+        const size_t first_dimension = dimension_tile * dimensions_per_tile;
+        const size_t nb_dimensions = std::min(dimensions_per_tile, data_dimension - first_dimension);
+
+        std::vector<scalar_t const*> v_tile_rows(nb_rows);
+        for(size_t r = 0; r < nb_rows; r++)
+        {
+          v_tile_rows[r] = v_rows[first_row + r] + first_dimension;
+        }
+
+        scalar_t * const p_out = &v_partial_products[2 * dimension_tile * nb_elements + first_row];
+        std::fill(p_out, p_out + nb_rows, scalar_t(0));
+        kernels_op.rows_inner_products(p_out, &v_tile_rows[0], p_mu + first_dimension, nb_rows, nb_dimensions);
+        if(p_u)
+        {
+          scalar_t * const p_out_u = p_out + nb_elements;
+          std::fill(p_out_u, p_out_u + nb_rows, scalar_t(0));
+          kernels_op.rows_inner_products(p_out_u, &v_tile_rows[0], p_u + first_dimension, nb_rows, nb_dimensions);
+        }
+        counter.notify();
+      }
+
+      //! Accumulation of the selected rows on the dimensions of a tile, after the deflation of all the rows against
+      //! @c p_u if not 0.
+      void accumulation_task(size_t dimension_tile, scalar_t const *p_u, bool reset)
+      {
+        const size_t first_dimension = dimension_tile * dimensions_per_tile;
+        const size_t nb_dimensions = std::min(dimensions_per_tile, data_dimension - first_dimension);
+        scalar_t * const p_acc = &accumulator.data()[0] + first_dimension;
+
+        if(p_u)
+        {
+          for(size_t row = 0; row < nb_elements; row++)
+          {
+            kernels_op.axpy(v_rows[row] + first_dimension, -v_deflation_coefficients[row], p_u + first_dimension, nb_dimensions);
+          }
+        }
+
+        if(reset)
+        {
+          std::fill(p_acc, p_acc + nb_dimensions, scalar_t(0));
+        }
+
+        const size_t nb_selected = v_selected_rows.size();
+        if(nb_selected)
+        {
+          std::vector<scalar_t const*> v_tile_rows(nb_selected);
+          for(size_t r = 0; r < nb_selected; r++)
+          {
+            v_tile_rows[r] = v_selected_rows[r] + first_dimension;
+          }
+          kernels_op.weighted_rows_sum(p_acc, &v_tile_rows[0], &v_selected_coefficients[0], nb_selected, nb_dimensions);
+        }
+        v_tiles_squared_norms[dimension_tile] = kernels_op.inner_product(p_acc, p_acc, nb_dimensions);
+        counter.notify();
+      }
+
+      void select_row(size_t row, scalar_t coefficient)
+      {
+        v_selected_rows.push_back(v_rows[row]);
+        v_selected_coefficients.push_back(coefficient);
+      }
+
+    public:
+      dimension_tiles_processor() :
+        nb_elements(0),
+        data_dimension(0),
+        nb_row_tiles(0),
+        rows_per_tile(0),
+        nb_dimension_tiles(0),
+        dimensions_per_tile(0),
+        nb_sign_flips(0),
+        signs_hash_change(0),
+        kernels_op(details::simd::get_kernels<scalar_t>())
+      {}
+
+      /*!@brief Sets the rows from the copies of the chunks, and the partition of the tiles.
+       *
+       * The dimensions are split in up to @c nb_tasks tiles of at least min_tile_dimensions dimensions, aligned on the 
+       * cache lines. The rows are then split such that there are about @c nb_tasks tiles for the inner products.
+       */
+      void set_data(std::vector<asynchronous_chunks_processor> &v_chunks, size_t data_dimension_, size_t nb_tasks)
+      {
+        data_dimension = data_dimension_;
+        v_rows.clear();
+        for(size_t i = 0; i < v_chunks.size(); i++)
+        {
+          for(size_t row = 0; row < v_chunks[i].get_nb_elements(); row++)
+          {
+            v_rows.push_back(v_chunks[i].native_row(row));
+          }
+        }
+        nb_elements = v_rows.size();
+
+        const size_t line_size = std::max(size_t(64) / sizeof(scalar_t), size_t(1));
+        nb_dimension_tiles = std::max(size_t(1), std::min(nb_tasks, data_dimension / size_t(min_tile_dimensions)));
+        dimensions_per_tile = (data_dimension + nb_dimension_tiles - 1) / nb_dimension_tiles;
+        dimensions_per_tile = (dimensions_per_tile + line_size - 1) / line_size * line_size;
+        nb_dimension_tiles = (data_dimension + dimensions_per_tile - 1) / dimensions_per_tile;
+
+        nb_row_tiles = std::min((nb_tasks + nb_dimension_tiles - 1) / nb_dimension_tiles, nb_elements);
+        rows_per_tile = (nb_elements + nb_row_tiles - 1) / nb_row_tiles;
+        nb_row_tiles = (nb_elements + rows_per_tile - 1) / rows_per_tile;
+
+        v_partial_products.assign(2 * nb_dimension_tiles * nb_elements, scalar_t(0));
+        v_inner_products.assign(nb_elements, scalar_t(0));
+        v_deflation_coefficients.assign(nb_elements, scalar_t(0));
+        v_signs.assign((nb_elements + 63) / 64, 0);
+        accumulator = data_t(data_dimension, 0);
+        v_tiles_squared_norms.assign(nb_dimension_tiles, 0.);
+      }
+
+      /*!@brief Computes the inner products of all the rows with @f$\mu@f$.
+       *
+       * If @c p_u is not 0, the inner products are the ones of the rows projected onto the orthogonal subspace of @c p_u,
+       * and the coefficients of the rows on @c p_u are kept for the deflation made by the next accumulation.
+       */
+      void compute_inner_products(details::threading::numa_thread_pool &pool, data_t const &mu, scalar_t const *p_u = 0)
+      {
+        scalar_t const * const p_mu = &mu.data()[0];
+        counter.reset();
+        for(size_t dimension_tile = 0, task = 0; dimension_tile < nb_dimension_tiles; dimension_tile++)
+        {
+          for(size_t row_tile = 0; row_tile < nb_row_tiles; row_tile++, task++)
+          {
+            pool.post(task % pool.nb_nodes(),
+              boost::bind(&dimension_tiles_processor::inner_products_task, this, row_tile, dimension_tile, p_mu, p_u));
+          }
+        }
+        counter.wait(nb_dimension_tiles * nb_row_tiles);
+
+        // the partial products are added in the order of the tiles
+        std::fill(v_inner_products.begin(), v_inner_products.end(), scalar_t(0));
+        std::fill(v_deflation_coefficients.begin(), v_deflation_coefficients.end(), scalar_t(0));
+        for(size_t dimension_tile = 0; dimension_tile < nb_dimension_tiles; dimension_tile++)
+        {
+          kernels_op.add(&v_inner_products[0], &v_partial_products[2 * dimension_tile * nb_elements], nb_elements);
+          if(p_u)
+          {
+            kernels_op.add(&v_deflation_coefficients[0], &v_partial_products[(2 * dimension_tile + 1) * nb_elements], nb_elements);
+          }
+        }
+
+        if(p_u)
+        {
+          const scalar_t u_mu = kernels_op.inner_product(p_u, p_mu, data_dimension);
+          kernels_op.axpy(&v_inner_products[0], -u_mu, &v_deflation_coefficients[0], nb_elements);
+        }
+      }
+
+      //! Selects all the rows, weighted by their inner products for a PCA step, or by their signs for the initial 
+      //! accumulation of the Grassmann average, in which case the signs are stored.
+      void select_all(bool pca_step)
+      {
+        v_selected_rows.clear();
+        v_selected_coefficients.clear();
+        for(size_t word = 0, first_row = 0; first_row < nb_elements; word++, first_row += 64)
+        {
+          const size_t nb_rows = std::min<size_t>(64, nb_elements - first_row);
+          const boost::uint64_t signs = kernels_op.positive_mask(&v_inner_products[first_row], nb_rows);
+          v_signs[word] = signs;
+          for(size_t i = 0; i < nb_rows; i++)
+          {
+            select_row(first_row + i, pca_step ? v_inner_products[first_row + i] : ((signs >> i) & 1 ? scalar_t(1) : scalar_t(-1)));
+          }
+        }
+      }
+
+      //! Selects the rows for which the sign flipped, and updates the signs (see asynchronous_chunks_processor::update_rows).
+      void select_flips()
+      {
+        v_selected_rows.clear();
+        v_selected_coefficients.clear();
+        nb_sign_flips = 0;
+        signs_hash_change = 0;
+        for(size_t word = 0, first_row = 0; first_row < nb_elements; word++, first_row += 64)
+        {
+          const size_t nb_rows = std::min<size_t>(64, nb_elements - first_row);
+          const boost::uint64_t signs = kernels_op.positive_mask(&v_inner_products[first_row], nb_rows);
+          boost::uint64_t flips = signs ^ v_signs[word];
+          if(!flips)
+          {
+            continue;
+          }
+
+          signs_hash_change ^= details::signs_word_hash(word, v_signs[word]) ^ details::signs_word_hash(word, signs);
+          v_signs[word] = signs;
+          nb_sign_flips += details::simd::popcount(flips);
+          for(; flips; flips &= flips - 1)
+          {
+            const size_t bit = details::simd::count_trailing_zeros(flips);
+            select_row(first_row + bit, (signs >> bit) & 1 ? scalar_t(2) : scalar_t(-2));
+          }
+        }
+      }
+
+      /*!@brief Accumulates the selected rows by tiles of dimensions.
+       *
+       * @param[in] reset if true, the accumulator is reset before the accumulation, otherwise the selected rows are added
+       *   to the current accumulator.
+       * @param[in] p_u if not 0, all the rows are first projected onto the orthogonal subspace of @c p_u, with the coefficients
+       *   of the last call to compute_inner_products.
+       */
+      void accumulate(details::threading::numa_thread_pool &pool, bool reset, scalar_t const *p_u = 0)
+      {
+        if(!reset && !p_u && v_selected_rows.empty())
+        {
+          return;
+        }
+
+        counter.reset();
+        for(size_t dimension_tile = 0; dimension_tile < nb_dimension_tiles; dimension_tile++)
+        {
+          pool.post(dimension_tile % pool.nb_nodes(),
+            boost::bind(&dimension_tiles_processor::accumulation_task, this, dimension_tile, p_u, reset));
+        }
+        counter.wait(nb_dimension_tiles);
+      }
+
+      //! Returns the accumulator of all the rows.
+      data_t const& get_accumulator() const
+      {
+        return accumulator;
+      }
+
+      //! Returns the squared @f$\ell_2@f$ norm of the accumulator, computed by the last accumulation.
+      double get_squared_norm() const
+      {
+        return std::accumulate(v_tiles_squared_norms.begin(), v_tiles_squared_norms.end(), 0.);
+      }
+
+      //! Returns the number of signs that changed during the last call to select_flips.
+      size_t get_nb_sign_flips() const
+      {
+        return nb_sign_flips;
+      }
+
+      //! Returns the change of the hash of the signs during the last call to select_flips.
+      boost::uint64_t get_signs_hash_change() const
+      {
+        return signs_hash_change;
+      }
+    };
+
+
+    //!@internal
+    //! Type of the processors of the chunks.
+    typedef asynchronous_chunks_processor async_processor_t;
+
+    //!@internal
+    //! Type of the reduction of the partial accumulators of the chunks.
+    typedef details::threading::partial_results_reducer<accumulator_vector_t> results_reducer_t;
+
+    //!@internal
+    //! Number of tasks stealing rows during the updates, one per worker. The accumulators of the stealing tasks follow
+    //! the ones of the chunks in the reduction.
+    size_t nb_stealers(details::threading::numa_thread_pool const &pool) const
+    {
+      return work_stealing && pool.nb_threads() > 1 ? pool.nb_threads() : 0;
+    }
+
+    //!@internal
+    //! Connects each processor to its own slot in the reduction.
+    void connect_processors(
+      std::vector<async_processor_t> &v_individual_accumulators, 
+      results_reducer_t &async_merger)
+    {
+      for(size_t i = 0; i < v_individual_accumulators.size(); i++)
+      {
+        v_individual_accumulators[i].connector_accumulator() = boost::bind(&results_reducer_t::update, &async_merger, i, _1);
+        v_individual_accumulators[i].connector_counter() = boost::bind(&results_reducer_t::notify, &async_merger);
+      }
+    }
+
+    //!@internal
+    //! Operations of the calling thread on the vectors of the dimension of the data, run by ranges on the pool.
+    typedef details::threading::dimension_ranges_operations<data_t> ranges_operations_t;
+
+    //!@internal
+    //! Indicates that mu is normalised with the @f$\ell_2@f$ norm, which is computed together with the merge of the accumulators.
+    typedef boost::is_same<norm_mu_t, details::norm2> fused_norm_t;
+
+    //!@internal
+    //! Norm of a result, the squared @f$\ell_2@f$ norm of which was computed along with the result.
+    template <class vector_t>
+    double result_norm(vector_t const &, double squared_norm, boost::true_type) const
+    {
+      return std::sqrt(squared_norm);
+    }
+
+    template <class vector_t>
+    double result_norm(vector_t const &v, double, boost::false_type) const
+    {
+      return norm_op(v);
+    }
+
+    template <class vector_t>
+    double result_norm(vector_t const &v, double squared_norm) const
+    {
+      return result_norm(v, squared_norm, fused_norm_t());
+    }
+
+    //!@internal
+    //! Sets mu to the initial guess @c index, or to a random vector if no guess is provided.
+    void set_initial_guess(ranges_operations_t &ranges_op, std::vector<data_t> const *initial_guess, size_t index, data_t &mu) const
+    {
+      if(initial_guess != 0)
+      {
+        ranges_op.scaled_copy((*initial_guess)[index], typename data_t::value_type(1), mu);
+      }
+      else
+      {
+        ranges_op.random_vector(random_init_op, mu);
+      }
+    }
+
+    //!@internal
+    //! Minimal number of rows of the chunks below which the iterations are distributed by tiles (see set_dimension_tiling).
+    static const size_t min_rows_per_chunk = 64;
+
+    //!@internal
+    //! Indicates that the iterations are distributed by tiles of rows and dimensions (see set_dimension_tiling): the chunks 
+    //! have few rows, the dimension gives a tile to each worker, and the tiles support the storage and the accumulations.
+    bool use_dimension_tiles(
+      std::vector<async_processor_t> const &v_individual_accumulators,
+      const size_t size_data,
+      const size_t number_of_dimensions,
+      details::threading::numa_thread_pool const &pool) const
+    {
+      const size_t nb_chunks = v_individual_accumulators.size();
+      return dimension_tiling 
+        && block_size == 1
+        && boost::is_same<storage_t, typename data_t::value_type>::value
+        && boost::is_same<accumulation_scalar_t, typename data_t::value_type>::value
+        && !accumulation_t::blocked
+        && !v_individual_accumulators[0].has_implicit_transformations()
+        && nb_chunks > 1
+        && size_data < min_rows_per_chunk * nb_chunks
+        && number_of_dimensions >= dimension_tiles_processor::min_tile_dimensions * pool.nb_threads();
+    }
+
+    /*!@internal
+     * @brief Computes the basis vectors with the iterations distributed by tiles of rows and dimensions (see set_dimension_tiling).
+     *
+     * The steps are the ones of process_chunks, the data being already copied and centered by the chunks.
+     */
+    template <class it_o_basisvectors_t>
+    bool process_tiles(
+      const size_t max_iterations,
+      const size_t max_dimension_to_compute,
+      const size_t size_data,
+      const size_t number_of_dimensions,
+      details::threading::numa_thread_pool &pool,
+      ranges_operations_t &ranges_op,
+      std::vector<async_processor_t> &v_individual_accumulators,
+      data_t mu,
+      it_o_basisvectors_t it_basisvectors,
+      std::vector<data_t> const * initial_guess)
+    {
+      typedef typename data_t::value_type scalar_t;
+
+      dimension_tiles_processor tiles;
+      tiles.set_data(v_individual_accumulators, number_of_dimensions, 2 * pool.nb_threads());
+
+      details::sign_flips_convergence_check signs_convergence_op(size_data, sign_flips_fraction, cycle_detection);
+      const double convergence_epsilon = details::convergence_check<data_t>::default_epsilon();
+
+      // basis vector against which the data is projected, together with the first accumulation of the next one
+      data_t u(number_of_dimensions);
+
+      for(size_t current_subspace_index = 0; 
+          current_subspace_index < max_dimension_to_compute; 
+          current_subspace_index++, ++it_basisvectors)
+      {
+        // the workers poll their queue during the iterations of the component
+        details::threading::hot_workers_scope hot_workers(pool);
+
+        scalar_t const *p_u = current_subspace_index > 0 ? &u.data()[0] : 0;
+
+        // PCA like initial steps
+        for(size_t pca_it = 0; pca_it < nb_steps_pca; pca_it++)
+        {
+          tiles.compute_inner_products(pool, mu, p_u);
+          tiles.select_all(true);
+          tiles.accumulate(pool, true, p_u);
+          p_u = 0;
+
+          const double norm_mu = result_norm(tiles.get_accumulator(), tiles.get_squared_norm());
+          if(norm_mu < 1E-12)
+          {
+            if(observer)
+            {
+              std::ostringstream o;
+              o << "The result of the PCA is null for subspace " << current_subspace_index;
+              observer->log_error_message(o.str().c_str());
+            }
+            return false;
+          }
+          ranges_op.scaled_copy(tiles.get_accumulator(), scalar_t(1./norm_mu), mu);
+        }
+
+        if(nb_steps_pca && observer)
+        {
+          observer->signal_pca(mu, current_subspace_index);
+        }
+
+        tiles.compute_inner_products(pool, mu, p_u);
+        tiles.select_all(false);
+        tiles.accumulate(pool, true, p_u);
+
+        // the changes of mu are checked as by details::convergence_check, together with its normalisation
+        double mu_change = ranges_op.scaled_copy(
+          tiles.get_accumulator(), 
+          scalar_t(1./result_norm(tiles.get_accumulator(), tiles.get_squared_norm())), 
+          mu);
+        signs_convergence_op.start();
+
+        bool signs_converged = false;
+        for(size_t iterations = 1; !signs_converged && !(mu_change < convergence_epsilon) && iterations < max_iterations; iterations++)
+        {
+          tiles.compute_inner_products(pool, mu);
+          tiles.select_flips();
+          tiles.accumulate(pool, false);
+
+          v_sign_flips[current_subspace_index].push_back(tiles.get_nb_sign_flips());
+          v_skipped_rows[current_subspace_index].push_back(0);
+          signs_converged = signs_convergence_op(tiles.get_nb_sign_flips(), tiles.get_signs_hash_change());
+
+          mu_change = ranges_op.scaled_copy(
+            tiles.get_accumulator(), 
+            scalar_t(1./result_norm(tiles.get_accumulator(), tiles.get_squared_norm())), 
+            mu);
+
+          if(observer)
+          {
+            observer->signal_intermediate_result(mu, current_subspace_index, iterations);
+          }
+        }
+
+        *it_basisvectors = mu;
+        if(observer)
+        {
+          observer->signal_eigenvector(*it_basisvectors, current_subspace_index);
+        }
+
+        if(current_subspace_index < max_dimension_to_compute - 1)
+        {
+          u.swap(mu);
+          set_initial_guess(ranges_op, initial_guess, current_subspace_index + 1, mu);
+        }
+      }
+
+      return true;
+    }
+
+    /*!@internal
+     * @brief Extracts the frame from the concatenated accumulations, and orthonormalises it (thin QR by Gram-Schmidt).
+     *
+     * @returns false if one of the accumulations is null.
+     */
+    bool orthonormalise_frame(accumulator_vector_t const &accumulations, std::vector<data_t> &frame, size_t first_index)
+    {
+      const size_t number_of_dimensions = frame[0].size();
+      for(size_t c = 0; c < frame.size(); c++)
+      {
+        std::copy(accumulations.begin() + c * number_of_dimensions, accumulations.begin() + (c + 1) * number_of_dimensions, frame[c].begin());
+        for(size_t c2 = 0; c2 < c; c2++)
+        {
+          frame[c] -= ub::inner_prod(frame[c], frame[c2]) * frame[c2];
+        }
+
+        double norm_mu = norm_op(frame[c]);
+        if(norm_mu < 1E-12)
+        {
+          if(observer)
+          {
+            std::ostringstream o;
+            o << "The result of the accumulation is null for subspace " << first_index + c;
+            observer->log_error_message(o.str().c_str());
+          }
+          return false;
+        }
+        frame[c] *= typename data_t::value_type(1./norm_mu);
+      }
+      return true;
+    }
+
+    /*!@internal
+     * @brief Computes the basis vectors by blocks of block_size vectors (see set_block_size).
+     */
+    template <class it_o_basisvectors_t>
+    bool process_blocks(
+      const size_t max_iterations,
+      const size_t max_dimension_to_compute,
+      const size_t number_of_dimensions,
+      details::threading::numa_thread_pool &pool,
+      std::vector<async_processor_t> &v_individual_accumulators,
+      std::vector<data_t> &deflation_basis,
+      it_o_basisvectors_t it_basisvectors,
+      std::vector<data_t> const * initial_guess)
+    {
+      const size_t nb_chunks = v_individual_accumulators.size();
+
+      for(size_t first_index = 0; first_index < max_dimension_to_compute; first_index += block_size)
+      {
+        const size_t nb_vectors = std::min(block_size, max_dimension_to_compute - first_index);
+
+        // the accumulations of all the vectors of the frame are merged together
+        results_reducer_t async_merger(pool, nb_chunks, nb_vectors * number_of_dimensions, accumulation_t::compensated);
+        async_merger.init_notifications();
+        connect_processors(v_individual_accumulators, async_merger);
+
+        std::vector<data_t> frame(nb_vectors);
+        for(size_t c = 0; c < nb_vectors; c++)
+        {
+          frame[c] = initial_guess != 0 ? (*initial_guess)[first_index + c] : random_init_op(data_t(number_of_dimensions));
+        }
+        details::gram_schmidt_orthonormalisation(frame.begin(), frame.end(), frame.begin(), norm_op);
+
+        // the workers poll their queue during the iterations of the block
+        details::threading::hot_workers_scope hot_workers(pool);
+
+        // PCA like initial steps
+        for(size_t pca_it = 0; pca_it < nb_steps_pca; pca_it++)
+        {
+          async_merger.init();
+          for(int i = 0; i < nb_chunks; i++)
+          {
+            pool.post(pool.node_of_chunk(i, v_individual_accumulators.size()),
+              boost::bind(
+                &async_processor_t::block_pca_accumulation, 
+                boost::ref(v_individual_accumulators[i]), 
+                boost::cref(frame)));
+          }
+          async_merger.wait_notifications(nb_chunks);
+
+          if(!orthonormalise_frame(async_merger.get_merged_result(), frame, first_index))
+          {
+            return false;
+          }
+        }
+
+        if(nb_steps_pca && observer)
+        {
+          for(size_t c = 0; c < nb_vectors; c++)
+          {
+            observer->signal_pca(frame[c], first_index + c);
+          }
+        }
+
+
+        std::vector< details::convergence_check<data_t> > v_convergence_op;
+        for(size_t c = 0; c < nb_vectors; c++)
+        {
+          v_convergence_op.push_back(details::convergence_check<data_t>(frame[c]));
+        }
+
+        async_merger.init();
+        for(int i = 0; i < nb_chunks; i++)
+        {
+          pool.post(pool.node_of_chunk(i, v_individual_accumulators.size()),
+            boost::bind(
+              &async_processor_t::block_initial_accumulation, 
+              boost::ref(v_individual_accumulators[i]), 
+              boost::cref(frame)));
+        }
+        async_merger.wait_notifications(nb_chunks);
+
+        if(!orthonormalise_frame(async_merger.get_merged_result(), frame, first_index))
+        {
+          return false;
+        }
+
+
+        for(size_t iterations = 1; iterations < max_iterations; iterations++)
+        {
+          // the frame has converged when all its vectors have converged
+          bool converged = true;
+          for(size_t c = 0; c < nb_vectors; c++)
+          {
+            converged = v_convergence_op[c](frame[c]) && converged;
+          }
+          if(converged)
+          {
+            break;
+          }
+
+          // the merged accumulations are updated with the rows for which the signs changed
+          async_merger.init_notifications();
+          for(int i = 0; i < nb_chunks; i++)
+          {
+            pool.post(pool.node_of_chunk(i, v_individual_accumulators.size()),
+              boost::bind(
+                &async_processor_t::block_update_accumulation, 
+                boost::ref(v_individual_accumulators[i]), 
+                boost::cref(frame)));
+          }
+          async_merger.wait_notifications(nb_chunks);
+
+          for(size_t c = 0; c < nb_vectors; c++)
+          {
+            size_t nb_sign_flips = 0;
+            for(int i = 0; i < nb_chunks; i++)
+            {
+              nb_sign_flips += v_individual_accumulators[i].get_block_sign_flips()[c];
+            }
+            v_sign_flips[first_index + c].push_back(nb_sign_flips);
+          }
+
+          if(!orthonormalise_frame(async_merger.get_merged_result(), frame, first_index))
+          {
+            return false;
+          }
+
+          if(observer)
+          {
+            for(size_t c = 0; c < nb_vectors; c++)
+            {
+              observer->signal_intermediate_result(frame[c], first_index + c, iterations);
+            }
+          }
+        }
+
+
+        // the frame contains the basis vectors of the current block
+        for(size_t c = 0; c < nb_vectors; c++, ++it_basisvectors)
+        {
+          *it_basisvectors = frame[c];
+          if(observer)
+          {
+            observer->signal_eigenvector(*it_basisvectors, first_index + c);
+          }
+        }
+
+        // projection onto the orthogonal subspace of the frame
+        if(first_index + nb_vectors < max_dimension_to_compute)
+        {
+          async_merger.init_notifications();
+
+          // the basis vectors should be available to the processors in case of implicit deflation
+          deflation_basis.insert(deflation_basis.end(), frame.begin(), frame.end());
+
+          for(int i = 0; i < nb_chunks; i++)
+          {
+            pool.post(pool.node_of_chunk(i, v_individual_accumulators.size()),
+              boost::bind(
+                &async_processor_t::project_onto_orthogonal_frame, 
+                boost::ref(v_individual_accumulators[i]), 
+                boost::cref(frame)));
+          }
+          async_merger.wait_notifications(nb_chunks);
+        }
+      }
+
+      return true;
+    }
+
+
+    /*!@internal
+     * @brief Computes the basis vectors from the chunks, once the data has been assigned to them.
+     *
+     * This is the part of the algorithm common to all the ways the data is provided (copied from the input
+     * iterators or borrowed from the caller). The workers of @c pool are running and the processors
+     * are connected to @c async_merger.
+     */
+    template <class it_o_basisvectors_t>
+    bool process_chunks(
+      const size_t max_iterations,
+      size_t max_dimension_to_compute,
+      const size_t size_data,
+      const size_t number_of_dimensions,
+      details::threading::numa_thread_pool &pool,
+      std::vector<async_processor_t> &v_individual_accumulators,
+      results_reducer_t &async_merger,
+      it_o_basisvectors_t it_basisvectors,
+      std::vector<data_t> const * initial_guess)
+    {
+      typedef typename data_t::value_type scalar_t;
+
+      // the operations on mu are run by ranges of dimensions on the pool
+      ranges_operations_t ranges_op(pool, number_of_dimensions);
+      const double convergence_epsilon = details::convergence_check<data_t>::default_epsilon();
+
+      // the size of the data is needed for generating the initial guess
+      data_t mu(number_of_dimensions);
+      set_initial_guess(ranges_op, initial_guess, 0, mu);
+      ranges_op.scaled_copy(mu, scalar_t(1./result_norm(mu, ranges_op.squared_norm(mu))), mu); // normalizing
+      assert(mu.size() == number_of_dimensions);
+
+      max_dimension_to_compute = std::min(max_dimension_to_compute, number_of_dimensions);
+      
+      size_t iterations = 0;
+
+      v_sign_flips.assign(max_dimension_to_compute, std::vector<size_t>());
+      v_skipped_rows.assign(max_dimension_to_compute, std::vector<size_t>());
+
+      // mean and basis vectors used by the processors in case of implicit transformations of the data.
+      // The basis is reserved beforehand since the processors keep a pointer to its elements.
+      data_t mean_vector;
+      std::vector<data_t> deflation_basis;
+      deflation_basis.reserve(max_dimension_to_compute);
+
+      for(int i = 0; i < v_individual_accumulators.size(); i++)
+      {
+        v_individual_accumulators[i].set_deflation_basis(&deflation_basis);
+        v_individual_accumulators[i].set_implicit_transformations(implicit_deflation);
+        v_individual_accumulators[i].set_margin_pruning(margin_pruning);
+        v_individual_accumulators[i].set_chunk_index(i);
+      }
+
+      // convergence from the flips and the patterns of the signs
+      details::sign_flips_convergence_check signs_convergence_op(size_data, sign_flips_fraction, cycle_detection);
+
+      // tasks of the idle workers stealing rows from the busy chunks during the updates
+      const size_t nb_chunks = v_individual_accumulators.size();
+      std::vector<chunks_stealer> v_stealers(nb_stealers(pool));
+      details::threading::row_ranges_scheduler scheduler(nb_chunks);
+      for(size_t i = 0; i < nb_chunks; i++)
+      {
+        scheduler.set_chunk(i, v_individual_accumulators[i].nb_row_words(), pool.node_of_chunk(i, nb_chunks));
+      }
+      for(size_t s = 0; s < v_stealers.size(); s++)
+      {
+        v_stealers[s].connector_accumulator() = boost::bind(&results_reducer_t::update, &async_merger, nb_chunks + s, _1);
+        v_stealers[s].connector_counter() = boost::bind(&results_reducer_t::notify, &async_merger);
+      }
+
+
+      // Centering the data if needed: 
+      // - first run the accumulation and gather all results in a multithreaded manner
+      // - second center the data with the collected mean
+      if(need_centering)
+      {
+        // Computing the accumulation
+        async_merger.init();
+
+        for(int i = 0; i < v_individual_accumulators.size(); i++)
+        {
+          pool.post(pool.node_of_chunk(i, v_individual_accumulators.size()),
+            boost::bind(
+              &async_processor_t::data_centering_first_phase, 
+              boost::ref(v_individual_accumulators[i]),
+              size_data)); // size of the dataset to perform division and avoid doing accumulation over big numerical values
+        }
+
+        // waiting for completion (barrier)
+        async_merger.wait_notifications(v_individual_accumulators.size());
+
+        // gathering the accumulated, already divided by the size 
+        mean_vector = async_merger.get_merged_result();
+
+        // sending result to observer
+        if(observer)
+        {
+          observer->signal_mean(mean_vector);
+        }
+
+
+        // centering the data
+        async_merger.init();
+
+        for(int i = 0; i < v_individual_accumulators.size(); i++)
+        {
+          pool.post(pool.node_of_chunk(i, v_individual_accumulators.size()),
+            boost::bind(
+              &async_processor_t::data_centering_second_phase, 
+              boost::ref(v_individual_accumulators[i]),
+              boost::cref(mean_vector)
+              ));
+        }
+
+        // waiting for completion (barrier)
+        async_merger.wait_notifications(v_individual_accumulators.size());
+
+
+      }
+
+
+
+
+
+      if(block_size > 1)
+      {
+        return process_blocks(
+          max_iterations, 
+          max_dimension_to_compute, 
+          number_of_dimensions, 
+          pool, 
+          v_individual_accumulators, 
+          deflation_basis, 
+          it_basisvectors, 
+          initial_guess);
+      }
+
+      if(use_dimension_tiles(v_individual_accumulators, size_data, number_of_dimensions, pool))
+      {
+        return process_tiles(
+          max_iterations, 
+          max_dimension_to_compute, 
+          size_data, 
+          number_of_dimensions, 
+          pool, 
+          ranges_op,
+          v_individual_accumulators, 
+          mu, 
+          it_basisvectors, 
+          initial_guess);
+      }
+
+      // indicates that the first accumulation of the current basis vector has already been computed
+      // together with the projection onto the orthogonal subspace of the previous one.
+      bool first_accumulation_done = false;
+
+      // for each dimension
+      for(size_t current_subspace_index = 0; 
+          current_subspace_index < max_dimension_to_compute; 
+          current_subspace_index++, ++it_basisvectors)
+      {
+        // the workers poll their queue during the iterations of the component
+        details::threading::hot_workers_scope hot_workers(pool);
+
+        // PCA like initial steps
+        if(nb_steps_pca)
+        {
+          for(size_t pca_it = 0; pca_it < nb_steps_pca; pca_it++)
+          {
+            if(first_accumulation_done)
+            {
+              first_accumulation_done = false;
+            }
+            else
+            {
+              // reseting the final accumulator
+              async_merger.init();
+
+              // pushing the initialisation of the mu and sign vectors to the pool
+              for(int i = 0; i < v_individual_accumulators.size(); i++)
+              {
+                pool.post(pool.node_of_chunk(i, v_individual_accumulators.size()),
+                  boost::bind(
+                    &async_processor_t::pca_accumulation, 
+                    boost::ref(v_individual_accumulators[i]), 
+                    boost::cref(mu)));
+              }
+
+              // waiting for completion (barrier)
+              async_merger.wait_notifications(v_individual_accumulators.size());
+            }
+
+            // gathering the first mu, the norm being computed by the merge
+            const double norm_mu = result_norm(async_merger.get_merged_result(), async_merger.get_squared_norm());
+            if(norm_mu < 1E-12)
+            {
+              if(observer)
+              {
+                std::ostringstream o;
+                o << "The result of the PCA is null for subspace " << current_subspace_index;
+                observer->log_error_message(o.str().c_str());
+              }
+              return false;
+            }            
+            
+            ranges_op.scaled_copy(async_merger.get_merged_result(), scalar_t(1./norm_mu), mu);
+          }
+          
+          // sending result to observer
+          if(observer)
+          {
+            observer->signal_pca(mu, current_subspace_index);
+          }          
+        }
+
+
+
+        if(first_accumulation_done)
+        {
+          first_accumulation_done = false;
+        }
+        else
+        {
+          // reseting the accumulator and the notifications
+          async_merger.init();
+
+          // pushing the initialisation of the mu and sign vectors to the pool
+          for(int i = 0; i < v_individual_accumulators.size(); i++)
+          {
+            pool.post(pool.node_of_chunk(i, v_individual_accumulators.size()),
+              boost::bind(
+                &async_processor_t::initial_accumulation, 
+                boost::ref(v_individual_accumulators[i]), 
+                boost::cref(mu)));
+          }
+
+          
+          // waiting for completion (barrier)
+          async_merger.wait_notifications(v_individual_accumulators.size());
+        }
+
+        // gathering the first mu: the changes of mu are checked as by details::convergence_check, together 
+        // with its normalisation
+        double mu_change = ranges_op.scaled_copy(
+          async_merger.get_merged_result(), 
+          scalar_t(1./result_norm(async_merger.get_merged_result(), async_merger.get_squared_norm())), 
+          mu);
+        signs_convergence_op.start();
+
+
+        // other iterations as usual
+        bool signs_converged = false;
+        for(iterations = 1; !signs_converged && !(mu_change < convergence_epsilon) && iterations < max_iterations; iterations++)
+        {
+
+          // reseting the final accumulator
+          async_merger.init_notifications();
+          //async_merger.init();
+          //async_merger.get_merged_result() = mu_no_norm;
+
+          // pushing the update of the mu (and signs)
+          if(v_stealers.empty())
+          {
+            for(int i = 0; i < v_individual_accumulators.size(); i++)
+            {
+              pool.post(pool.node_of_chunk(i, v_individual_accumulators.size()), boost::bind(&async_processor_t::update_accumulation, boost::ref(v_individual_accumulators[i]), boost::cref(mu)));
+            }
+          }
+          else
+          {
+            // the longest chunks of the previous iterations are started first
+            scheduler.reset();
+            std::vector<size_t> const chunks_order = scheduler.chunks_order();
+            for(size_t k = 0; k < nb_chunks; k++)
+            {
+              const size_t i = chunks_order[k];
+              pool.post(
+                pool.node_of_chunk(i, nb_chunks), 
+                boost::bind(
+                  &async_processor_t::update_accumulation_shared, 
+                  boost::ref(v_individual_accumulators[i]), 
+                  boost::cref(mu), 
+                  &scheduler, 
+                  i));
+            }
+
+            // the stealing tasks are queued after the ones of the chunks: they are run by the workers that are idle
+            for(size_t s = 0; s < v_stealers.size(); s++)
+            {
+              pool.post(
+                s % pool.nb_nodes(), 
+                boost::bind(
+                  &chunks_stealer::steal_update, 
+                  boost::ref(v_stealers[s]), 
+                  &v_individual_accumulators, 
+                  &scheduler, 
+                  s % pool.nb_nodes(), 
+                  number_of_dimensions));
+            }
+          }
+
+          // waiting for completion (barrier)
+          async_merger.wait_notifications(v_individual_accumulators.size() + v_stealers.size());
+
+          size_t nb_sign_flips = 0, nb_skipped_rows = 0;
+          boost::uint64_t signs_hash_change = 0;
+          for(int i = 0; i < v_individual_accumulators.size(); i++)
+          {
+            nb_sign_flips += v_individual_accumulators[i].get_nb_sign_flips();
+            nb_skipped_rows += v_individual_accumulators[i].get_nb_skipped_rows();
+            signs_hash_change ^= v_individual_accumulators[i].get_signs_hash_change();
+          }
+          for(size_t s = 0; s < v_stealers.size(); s++)
+          {
+            nb_sign_flips += v_stealers[s].get_nb_sign_flips();
+            nb_skipped_rows += v_stealers[s].get_nb_skipped_rows();
+            signs_hash_change ^= v_stealers[s].get_signs_hash_change();
+          }
+          v_sign_flips[current_subspace_index].push_back(nb_sign_flips);
+          v_skipped_rows[current_subspace_index].push_back(nb_skipped_rows);
+          signs_converged = signs_convergence_op(nb_sign_flips, signs_hash_change);
+
+          // gathering the mus
+          mu_change = ranges_op.scaled_copy(
+            async_merger.get_merged_result(), 
+            scalar_t(1./result_norm(async_merger.get_merged_result(), async_merger.get_squared_norm())), 
+            mu);
+
+          // sending result to observer
+          if(observer)
+          {
+            observer->signal_intermediate_result(mu, current_subspace_index, iterations);
+          }
+        }
+
+        // mu is the eigenvector of the current dimension, we store it in the output vector
+        *it_basisvectors = mu;
+
+        // sending result to observer
+        if(observer)
+        {
+          observer->signal_eigenvector(*it_basisvectors, current_subspace_index);
+        }   
+
+        // projection onto the orthogonal subspace
+        if(current_subspace_index < max_dimension_to_compute - 1)
+        {
+
+          // the projection is fused with the first accumulation of the next basis vector (PCA step or 
+          // initial accumulation), which saves a full sweep over the data
+          async_merger.init();
+
+          // the basis vector should be available to the processors in case of implicit deflation
+          deflation_basis.push_back(mu);
+
+          set_initial_guess(ranges_op, initial_guess, current_subspace_index + 1, mu);
+
+          for(int i = 0; i < v_individual_accumulators.size(); i++)
+          {
+            pool.post(pool.node_of_chunk(i, v_individual_accumulators.size()),
+              boost::bind(
+                &async_processor_t::template project_and_accumulate<typename it_o_basisvectors_t::value_type>,
+                boost::ref(v_individual_accumulators[i]), 
+                *it_basisvectors, // this is not mu, since we are changing it before the process ends here
+                boost::cref(mu),
+                nb_steps_pca > 0));
+          }
+
+          async_merger.wait_notifications(v_individual_accumulators.size());
+          first_accumulation_done = true;
+
+        }
+        
+      }
+
+
+      return true;
+    }
+
+
+  public:
+
+    /*!@brief Constructor
+     * 
+     * @note By default the number of processors used for computation is set to 1.
+     * The maximum size of the chunks is "infinite": each chunk will receive in that case the size of the data
+     * divided by the number of running threads.
+     */
+    grassmann_pca() : 
+      random_init_op(details::fVerySmallButStillComputable, details::fVeryBigButStillComputable), 
+      nb_processors(1),
+      max_chunk_size(std::numeric_limits<size_t>::max()),
+      nb_steps_pca(3),
+      need_centering(false),
+      implicit_deflation(false),
+      block_size(1),
+      numa_placement(true),
+      work_stealing(true),
+      margin_pruning(false),
+      sign_flips_fraction(-1),
+      cycle_detection(false),
+      dimension_tiling(true),
+      p_thread_pool(0),
+      observer(0)
+    {}
+
+    //! Sets the observer of the algorithm. 
+    //!
+    //! The lifetime of the observer is not managed by this class. Set to 0 to disable
+    //! observation.
+    bool set_observer(observer_t* observer_)
+    {
+      observer = observer_;
+      return true;
+    }
+
+    //! Sets the number of parallel tasks used for computing.
+    bool set_nb_processors(size_t nb_processors_)
+    {
+      nb_processors = nb_processors_;
+      return true;
+    }
+
+    /*!@brief Sets the maximum chunk size. 
+     *
+     * By default, the chunk size is the size of the data divided by the number of processing threads.
+     * Lowering the chunk size should provid better granularity in the overall processing time at the end 
+     * of the processing.
+     */
+    bool set_max_chunk_size(size_t chunk_size)
+    {
+      if(chunk_size == 0)
+      {
+        return false;
+      }
+      max_chunk_size = chunk_size;
+      return true;
+    }
+
+    //! Sets the number of iterations for the "regular PCA" algorithm. 
+    bool set_nb_steps_pca(size_t nb_steps)
+    {
+      nb_steps_pca = nb_steps;
+      return true;
+    }
+
+    //! Sets the centering flags.
+    //!
+    //! If set to true, a centering will be performed before applying any computation (PCA and Grassmann averages). 
+    bool set_centering(bool need_centering_)
+    {
+      need_centering = need_centering_;
+      return true;
+    }
+
+    /*!@brief Sets the implicit deflation mode.
+     *
+     * If set to true, the copy of the data is never modified: the projections onto the orthogonal subspaces of the 
+     * basis vectors already computed (and the centering) are applied on the fly, from the coefficients of each vector 
+     * on the previous basis vectors. This removes the write pass over the data after each basis vector, at the 
+     * price of @c nb_elements scalars per computed basis vector.
+     * This mode is always active for the compact storage types and for batch_process_borrowed_data.
+     */
+    bool set_implicit_deflation(bool implicit_deflation_)
+    {
+      implicit_deflation = implicit_deflation_;
+      return true;
+    }
+
+    /*!@brief Sets the number of basis vectors computed together.
+     *
+     * If greater than 1, the basis vectors are computed by blocks: an orthonormal frame of @c block_size_ vectors is 
+     * iterated at once, each vector having its own signs, and the frame is orthonormalised (thin QR) after each sweep 
+     * over the data. Each sweep computes the inner products of a row with all the vectors of the frame while the row is in the 
+     * cache, instead of one sweep per basis vector. The first vector of each frame follows the regular algorithm, the 
+     * following ones are constrained to the orthogonal subspace of the previous ones during the iterations.
+     */
+    bool set_block_size(size_t block_size_)
+    {
+      if(block_size_ == 0)
+      {
+        return false;
+      }
+      block_size = block_size_;
+      return true;
+    }
+
+    /*!@brief Sets the pool of workers used by the computations.
+     *
+     * The lifetime of the pool is not managed by this class, and the pool should outlive the calls to batch_process. 
+     * The number of chunks is still given by set_nb_processors and set_max_chunk_size, and the NUMA placement
+     * is the one of the pool. Set to 0 to create a pool for each computation (default).
+     */
+    bool set_thread_pool(thread_pool *p_thread_pool_)
+    {
+      p_thread_pool = p_thread_pool_;
+      return true;
+    }
 
-    /*!@brief Constructor
-     * 
-     * @note By default the number of processors used for computation is set to 1.
-     * The maximum size of the chunks is "infinite": each chunk will receive in that case the size of the data
-     * divided by the number of running threads.
+    /*!@brief Sets the placement of the workers and of the data on the NUMA nodes (true by default).
+     *
+     * If set to true, the workers are distributed over the NUMA nodes and pinned to the CPUs of their node. Each chunk
+     * is assigned to a node: its copy is made and all its computations are run by the workers of this node, which keeps 
+     * the memory traffic local to the node. The accumulations of the chunks of a node are merged before the merge 
+     * of the nodes. This has no effect on the systems with only one node.
      */
-    grassmann_pca() : 
-      random_init_op(details::fVerySmallButStillComputable, details::fVeryBigButStillComputable), 
-      nb_processors(1),
-      max_chunk_size(std::numeric_limits<size_t>::max()),
-      nb_steps_pca(3),
-      need_centering(false),
-      observer(0)
-    {}
+    bool set_numa_placement(bool numa_placement_)
+    {
+      numa_placement = numa_placement_;
+      return true;
+    }
 
-    //! Sets the observer of the algorithm. 
-    //!
-    //! The lifetime of the observer is not managed by this class. Set to 0 to disable
-    //! observation.
-    bool set_observer(observer_t* observer_)
+    /*!@brief Sets the sharing of the rows of the chunks between the workers during the iterations (true by default).
+     *
+     * If set to true, the workers that are idle during an iteration steal ranges of rows from the chunks still being 
+     * processed, so that an iteration does not wait for the slowest chunk (eg. on shared or hybrid processors). 
+     * Each chunk keeps its rows and claims them from the beginning, the chunks that were the longest in the previous 
+     * iterations being started first. This has no effect with only one worker, nor on the block computations.
+     */
+    bool set_work_stealing(bool work_stealing_)
     {
-      observer = observer_;
+      work_stealing = work_stealing_;
       return true;
     }
 
-    //! Sets the number of parallel tasks used for computing.
-    bool set_nb_processors(size_t nb_processors_)
+    /*!@brief Skips the rows for which the sign provably cannot change in the iterations (false by default).
+     *
+     * The norm of each row and the margin @f$|\langle x, \mu\rangle| / \|x\|@f$ at its last evaluation are kept. 
+     * By Cauchy-Schwarz, the inner product of the row cannot change its sign as long as the cumulated changes of 
+     * @f$\mu@f$ since this evaluation stay below the margin, in which case the inner product is not computed. The 
+     * results are the same as without the pruning, up to the rounding of the inner products, and the late iterations 
+     * only evaluate the rows close to the hyperplane orthogonal to @f$\mu@f$. See get_skipped_rows_statistics.
+     * The states take two scalars per input vector. This has no effect on the block computations.
+     */
+    bool set_margin_pruning(bool margin_pruning_)
     {
-      nb_processors = nb_processors_;
+      margin_pruning = margin_pruning_;
       return true;
     }
 
-    /*!@brief Sets the maximum chunk size. 
+    /*!@brief Stops the iterations when the number of sign flips is below a fraction of the number of vectors.
      *
-     * By default, the chunk size is the size of the data divided by the number of processing threads.
-     * Lowering the chunk size should provid better granularity in the overall processing time at the end 
-     * of the processing.
+     * The next @f$\mu@f$ depends only on the signs of the inner products of the vectors with the current one, hence 
+     * the iterations reached a steady point as soon as no sign changes. With a fraction of 0, the iterations stop on the 
+     * first iteration without any flip, independently of the tolerance on the changes of @f$\mu@f$. A positive 
+     * fraction trades some accuracy for fewer iterations. A negative fraction disables the criterion (default). 
+     * The usual check on the changes of @f$\mu@f$ applies in all cases. This has no effect on the block computations.
      */
-    bool set_max_chunk_size(size_t chunk_size)
+    bool set_sign_flips_convergence(double max_flips_fraction)
     {
-      if(chunk_size == 0)
+      if(max_flips_fraction >= 1)
       {
         return false;
       }
-      max_chunk_size = chunk_size;
+      sign_flips_fraction = max_flips_fraction;
       return true;
     }
 
-    //! Sets the number of iterations for the "regular PCA" algorithm. 
-    bool set_nb_steps_pca(size_t nb_steps)
+    /*!@brief Stops the iterations when the signs of the inner products repeat a previous pattern (false by default).
+     *
+     * A repeated pattern of signs means that the iterations are periodic and would run until the maximum number of
+     * iterations without converging. The patterns are compared by a hash of the signs, which is updated from the 
+     * changed signs only. This has no effect on the block computations.
+     */
+    bool set_cycle_detection(bool cycle_detection_)
     {
-      nb_steps_pca = nb_steps;
+      cycle_detection = cycle_detection_;
       return true;
     }
 
-    //! Sets the centering flags.
-    //!
-    //! If set to true, a centering will be performed before applying any computation (PCA and Grassmann averages). 
-    bool set_centering(bool need_centering_)
+    /*!@brief Distributes the iterations by tiles of rows and dimensions for the datasets of few high dimensional vectors
+     * (true by default).
+     *
+     * The chunks split the rows only: with few vectors per chunk (eg. 500 frames over 32 workers), each chunk still
+     * allocates and publishes an accumulator of the size of the dimension, and the merge of these accumulators 
+     * dominates the iterations. If set to true, the iterations are then run on tiles of rows and dimensions: the partial
+     * inner products are added per row over the tiles of dimensions, and each task accumulates the rows on its own 
+     * range of dimensions, without merge. The tiles are selected automatically when the chunks have less than 64 rows and the 
+     * dimension gives at least 512 dimensions to each worker, for the data stored with the scalar type, the explicit 
+     * transformations and the plain accumulations. The margin pruning and the work stealing have no effect in this case, 
+     * and the copy and the centering of the data are still made by the chunks. This has no effect on the block computations.
+     */
+    bool set_dimension_tiling(bool dimension_tiling_)
     {
-      need_centering = need_centering_;
+      dimension_tiling = dimension_tiling_;
       return true;
     }
 
+    /*!@brief Returns the number of sign flips of each iteration of the last call to batch_process.
+     *
+     * The element @c k of the returned vector contains, for the basis vector @c k, the number of input vectors for which
+     * the sign of the inner product with @f$\mu@f$ changed, for each iteration following the initial one.
+     */
+    std::vector< std::vector<size_t> > const& get_sign_flips_statistics() const
+    {
+      return v_sign_flips;
+    }
+
+    /*!@brief Returns the number of rows skipped by the margin pruning for each iteration of the last call to batch_process.
+     *
+     * The element @c k of the returned vector contains, for the basis vector @c k and for each iteration following the 
+     * initial one, the number of input vectors for which the inner product with @f$\mu@f$ was not computed 
+     * (see set_margin_pruning). The skip rate of an iteration is this number divided by the number of input vectors.
+     */
+    std::vector< std::vector<size_t> > const& get_skipped_rows_statistics() const
+    {
+      return v_skipped_rows;
+    }
+
 
 
     /*!@brief Performs the computation of the eigen-vectors of the provided dataset.
@@ -575,19 +2997,9 @@ namespace grassmann_averages_pca
 
       // preparing the thread pool, to avoid individual thread creation/deletion at each step.
       // we perform the init here because it might take some time for the thread to really start.
-      boost::asio::io_service ioService;
-      boost::thread_group threadpool;
-
-
-      // in case of non clean exit (or even in case of clean one).
-      details::threading::safe_stop worker_lock_guard(ioService, threadpool);
-
-      // this is exactly the number of processors
-      boost::asio::io_service::work work(ioService);
-      for(int i = 0; i < nb_processors; i++)
-      {
-        threadpool.create_thread(boost::bind(&boost::asio::io_service::run, &ioService));
-      }
+      // The workers are stopped in case of non clean exit (or even in case of clean one).
+      details::threading::thread_pool_holder pool_holder(p_thread_pool, nb_processors, numa_placement);
+      details::threading::numa_thread_pool &pool = pool_holder.get();
 
       // contains the number of elements. In case the iterator is random access, could be deduced simply 
       // by a call to distance.
@@ -599,27 +3011,29 @@ namespace grassmann_averages_pca
 
       // number of dimensions of the data vectors
       const size_t number_of_dimensions = it->size();
-      
-
-      // the first element is used for the init guess because for dynamic std::vector like element, the size is needed.
-      data_t mu(initial_guess != 0 ? (*initial_guess)[0] : random_init_op(*it));
-      mu *= typename data_t::value_type(1./norm_op(mu)); // normalizing
-      assert(mu.size() == number_of_dimensions);
 
-      max_dimension_to_compute = std::min(max_dimension_to_compute, number_of_dimensions);
-      
-      size_t iterations = 0;
+      // the signed sums of the rows of a chunk should not overflow the exact accumulators of the compact storage types
+      if(!details::storage_conversion<storage_t>::exact_accumulation(chunks_size))
+      {
+        if(observer)
+        {
+          std::ostringstream o;
+          o << "The sums of the chunks of " << chunks_size << " rows may overflow the accumulators of the storage type";
+          observer->log_error_message(o.str().c_str());
+        }
+        return false;
+      }
 
 
       // preparing the ranges on which each processing thread will run.
       // the number of objects can be much more than the current number of processors, in order to
       // avoid waiting too long for a thread (better granularity) but involving a slight overhead in memory and
       // processing at the synchronization point.
-      typedef asynchronous_chunks_processor async_processor_t;
       std::vector<async_processor_t> v_individual_accumulators(nb_chunks);
 
-      asynchronous_results_merger async_merger(number_of_dimensions);
+      results_reducer_t async_merger(pool, nb_chunks + nb_stealers(pool), number_of_dimensions, accumulation_t::compensated);
       async_merger.init_notifications();
+      connect_processors(v_individual_accumulators, async_merger);
 
       {
         it_t it_current_begin(it);
@@ -640,15 +3054,11 @@ namespace grassmann_averages_pca
 
           async_processor_t &current_acc_object = v_individual_accumulators[i];
 
-          // attaching the update object callbacks
-          current_acc_object.connector_accumulator() = boost::bind(&asynchronous_results_merger::update, &async_merger, _1);
-          current_acc_object.connector_counter() = boost::bind(&asynchronous_results_merger::notify, &async_merger);
-
           // updating the dimension of the problem
           current_acc_object.set_data_dimensions(number_of_dimensions);
 
-          // pushing the asynchronous copy
-          ioService.post(
+          // pushing the asynchronous copy, made by the workers of the node of the chunk (first touch)
+          pool.post(pool.node_of_chunk(i, v_individual_accumulators.size()),
             boost::bind(
               &async_processor_t::template set_data_range<it_t>, 
               boost::ref(v_individual_accumulators[i]), 
@@ -670,208 +3080,116 @@ namespace grassmann_averages_pca
         
       }
 
-
-      // Centering the data if needed: 
-      // - first run the accumulation and gather all results in a multithreaded manner
-      // - second center the data with the collected mean
-      if(need_centering)
-      {
-        // Computing the accumulation
-        async_merger.init();
-
-        for(int i = 0; i < v_individual_accumulators.size(); i++)
-        {
-          ioService.post(
-            boost::bind(
-              &async_processor_t::data_centering_first_phase, 
-              boost::ref(v_individual_accumulators[i]),
-              size_data)); // size of the dataset to perform division and avoid doing accumulation over big numerical values
-        }
-
-        // waiting for completion (barrier)
-        async_merger.wait_notifications(v_individual_accumulators.size());
-
-        // gathering the accumulated, already divided by the size 
-        data_t mean_vector = async_merger.get_merged_result();
-
-        // sending result to observer
-        if(observer)
-        {
-          observer->signal_mean(mean_vector);
-        }
-
-
-        // centering the data
-        async_merger.init();
-
-        for(int i = 0; i < v_individual_accumulators.size(); i++)
-        {
-          ioService.post(
-            boost::bind(
-              &async_processor_t::data_centering_second_phase, 
-              boost::ref(v_individual_accumulators[i]),
-              boost::cref(mean_vector)
-              ));
-        }
-
-        // waiting for completion (barrier)
-        async_merger.wait_notifications(v_individual_accumulators.size());
-
-
-      }
-
-
-
-
-
-      // for each dimension
-      for(size_t current_subspace_index = 0; 
-          current_subspace_index < max_dimension_to_compute; 
-          current_subspace_index++, ++it_basisvectors)
+      // the values should be integers in the range of the compact storage types
+      for(size_t i = 0; i < v_individual_accumulators.size(); i++)
       {
-
-
-        // PCA like initial steps
-        if(nb_steps_pca)
+        if(!v_individual_accumulators[i].has_representable_data())
         {
-          for(size_t pca_it = 0; pca_it < nb_steps_pca; pca_it++)
-          {
-            // reseting the final accumulator
-            async_merger.init();
-
-            // pushing the initialisation of the mu and sign vectors to the pool
-            for(int i = 0; i < v_individual_accumulators.size(); i++)
-            {
-              ioService.post(
-                boost::bind(
-                  &async_processor_t::pca_accumulation, 
-                  boost::ref(v_individual_accumulators[i]), 
-                  boost::cref(mu)));
-            }
-
-            // waiting for completion (barrier)
-            async_merger.wait_notifications(v_individual_accumulators.size());
-
-            // gathering the first mu
-            mu = async_merger.get_merged_result();
-            
-            double norm_mu = norm_op(mu);
-            if(norm_mu < 1E-12)
-            {
-              if(observer)
-              {
-                std::ostringstream o;
-                o << "The result of the PCA is null for subspace " << current_subspace_index;
-                observer->log_error_message(o.str().c_str());
-              }
-              return false;
-            }            
-            
-            mu *= typename data_t::value_type(1./norm_mu);
-          }
-          
-          // sending result to observer
           if(observer)
           {
-            observer->signal_pca(mu, current_subspace_index);
-          }          
-        }
-
-
-
-        details::convergence_check<data_t> convergence_op(mu);
-
-        // reseting the accumulator and the notifications
-        async_merger.init();
-
-        // pushing the initialisation of the mu and sign vectors to the pool
-        for(int i = 0; i < v_individual_accumulators.size(); i++)
-        {
-          ioService.post(
-            boost::bind(
-              &async_processor_t::initial_accumulation, 
-              boost::ref(v_individual_accumulators[i]), 
-              boost::cref(mu)));
+            observer->log_error_message("The data cannot be represented by the storage type");
+          }
+          return false;
         }
+      }
 
-        
-        // waiting for completion (barrier)
-        async_merger.wait_notifications(v_individual_accumulators.size());
-
-        // gathering the first mu
-        mu = async_merger.get_merged_result();
-        mu *= typename data_t::value_type(1./norm_op(mu));
-
-
-        // other iterations as usual
-        for(iterations = 1; !convergence_op(mu) && iterations < max_iterations; iterations++)
-        {
-
-          // reseting the final accumulator
-          async_merger.init_notifications();
-          //async_merger.init();
-          //async_merger.get_merged_result() = mu_no_norm;
 
-          // pushing the update of the mu (and signs)
-          for(int i = 0; i < v_individual_accumulators.size(); i++)
-          {
-            ioService.post(boost::bind(&async_processor_t::update_accumulation, boost::ref(v_individual_accumulators[i]), boost::cref(mu)));
-          }
+      // stopping the pool is done in its destruction
+      return process_chunks(
+        max_iterations, 
+        max_dimension_to_compute, 
+        size_data, 
+        number_of_dimensions,
+        pool, 
+        v_individual_accumulators, 
+        async_merger, 
+        it_basisvectors, 
+        initial_guess);
+    }
 
-          // waiting for completion (barrier)
-          async_merger.wait_notifications(v_individual_accumulators.size());
 
-          // gathering the mus
-          //mu_no_norm = async_merger.get_merged_result();
-          mu = async_merger.get_merged_result();
-          mu *= typename data_t::value_type(1./norm_op(mu));
+    /*!@brief Performs the computation of the eigen-vectors of a dataset owned by the caller.
+     *
+     * The data is read in place and is never modified: no copy is made, and the centering and the projections onto
+     * the orthogonal subspaces are applied implicitly (see set_implicit_deflation). The same data (eg. memory mapped 
+     * or already loaded) may then be shared by several computations running concurrently.
+     *
+     * @param[in] max_iterations the maximum number of iterations in order to compute each eigen-vector. 
+     * @param[in] max_dimension_to_compute the maximum number of eigen-vectors to compute.
+     * @param[in] p_data pointer on the first element of the first vector. The vectors are stored per row.
+     * @param[in] nb_rows the number of vectors.
+     * @param[in] number_of_dimensions the dimension of the vectors.
+     * @param[in] row_stride the number of elements between the beginning of two consecutive vectors.
+     * @param[out] it_basisvectors an iterator on the beginning of the area where the computed eigen-vectors will be stored. The space should be at least @c max_dimension_to_compute.
+     * @param[in] initial_guess if provided, the initial vectors will be initialized to this value. The size of the pointed container should be at least @c max_dimension_to_compute.
+     *
+     * @returns true on success, false otherwise
+     * @pre the data should not be modified before the function returns.
+     */
+    template <class it_o_basisvectors_t>
+    bool batch_process_borrowed_data(
+      const size_t max_iterations,
+      size_t max_dimension_to_compute,
+      storage_t const *p_data,
+      const size_t nb_rows,
+      const size_t number_of_dimensions,
+      const size_t row_stride,
+      it_o_basisvectors_t it_basisvectors,
+      std::vector<data_t> const * initial_guess = 0)
+    {
+      if(p_data == 0 || nb_rows == 0 || number_of_dimensions == 0 || row_stride < number_of_dimensions)
+      {
+        return false;
+      }
 
-          // sending result to observer
-          if(observer)
-          {
-            observer->signal_intermediate_result(mu, current_subspace_index, iterations);
-          }
-        }
+      // preparing the thread pool
+      details::threading::thread_pool_holder pool_holder(p_thread_pool, nb_processors, numa_placement);
+      details::threading::numa_thread_pool &pool = pool_holder.get();
 
-        // mu is the eigenvector of the current dimension, we store it in the output vector
-        *it_basisvectors = mu;
+      // size of the chunks.
+      const size_t chunks_size = std::min(max_chunk_size, static_cast<size_t>(ceil(double(nb_rows)/nb_processors)));
+      const size_t nb_chunks = (nb_rows + chunks_size - 1) / chunks_size;
 
-        // sending result to observer
+      // the signed sums of the rows of a chunk should not overflow the exact accumulators of the compact storage types
+      if(!details::storage_conversion<storage_t>::exact_accumulation(chunks_size))
+      {
         if(observer)
         {
-          observer->signal_eigenvector(*it_basisvectors, current_subspace_index);
-        }   
-
-        // projection onto the orthogonal subspace
-        if(current_subspace_index < max_dimension_to_compute - 1)
-        {
-
-          async_merger.init_notifications();
-
-          // pushing the update of the mu (and signs)
-          for(int i = 0; i < v_individual_accumulators.size(); i++)
-          {
-            ioService.post(
-              boost::bind(
-                &async_processor_t::template project_onto_orthogonal_subspace<typename it_o_basisvectors_t::value_type>,
-                boost::ref(v_individual_accumulators[i]), 
-                *it_basisvectors)); // this is not mu, since we are changing it before the process ends here
-          }
-
-          mu = initial_guess != 0 ? (*initial_guess)[current_subspace_index+1] : random_init_op(*it);
-
-          async_merger.wait_notifications(v_individual_accumulators.size());
-
+          std::ostringstream o;
+          o << "The sums of the chunks of " << chunks_size << " rows may overflow the accumulators of the storage type";
+          observer->log_error_message(o.str().c_str());
         }
-        
+        return false;
       }
 
+      std::vector<async_processor_t> v_individual_accumulators(nb_chunks);
 
-      // stopping the pool is done in the destruction of worker_lock_guard
-
+      results_reducer_t async_merger(pool, nb_chunks + nb_stealers(pool), number_of_dimensions, accumulation_t::compensated);
+      async_merger.init_notifications();
+      connect_processors(v_individual_accumulators, async_merger);
 
+      for(int i = 0; i < nb_chunks; i++)
+      {
+        async_processor_t &current_acc_object = v_individual_accumulators[i];
+
+        // the rows are used in place, the last chunk taking the remainder
+        current_acc_object.set_data_dimensions(number_of_dimensions);
+        current_acc_object.set_borrowed_data(
+          p_data + i * chunks_size * row_stride,
+          i == nb_chunks - 1 ? nb_rows - chunks_size*(nb_chunks - 1) : chunks_size,
+          row_stride);
+      }
 
-      return true;
+      return process_chunks(
+        max_iterations, 
+        max_dimension_to_compute, 
+        nb_rows, 
+        number_of_dimensions,
+        pool, 
+        v_individual_accumulators, 
+        async_merger, 
+        it_basisvectors, 
+        initial_guess);
     }
   };
 
@@ -0,0 +1,920 @@
+// Copyright 2014, Max Planck Society.
+// Distributed under the BSD 3-Clause license.
+// (See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/BSD-3-Clause)
+
+#ifndef GRASSMANN_AVERAGES_PCA_DUAL_HPP__
+#define GRASSMANN_AVERAGES_PCA_DUAL_HPP__
+
+
+
+/*!@file
+ * Grassmann averages for robust PCA functions, following the paper of Soren Hauberg.
+ *
+ * This file contains the implementation of the dual form, on the Gram matrix of the data, for the datasets having
+ * much fewer vectors than dimensions.
+ */
+
+
+// for the thread pools
+#include <boost/asio/io_service.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <boost/scoped_array.hpp>
+#include <boost/function.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/is_same.hpp>
+
+// utilities
+#include <include/private/utilities.hpp>
+#include <include/private/numa_thread_pool.hpp>
+#include <include/private/simd_kernels.hpp>
+
+#include <vector>
+#include <numeric>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <new>
+
+
+namespace grassmann_averages_pca
+{
+
+  /*!@brief Grassmann Average algorithm for robust PCA computation, in the dual form on the Gram matrix of the data.
+   *
+   * This class computes the same basis vectors as grassmann_pca, for datasets @f$\mathbf{X} = \{X_i\}_{i < N}@f$ having
+   * much fewer vectors than dimensions (eg. a few thousand frames of several millions of pixels). The current
+   * @f$\mu@f$ always lies in the span of the data, @f$\mu = \mathbf{X}^T a@f$, and the inner products of all the
+   * vectors with @f$\mu@f$ are given by the Gram matrix @f$G = \mathbf{X}\mathbf{X}^T@f$ of size @f$N \times N@f$:
+   * - an iteration of the Grassmann average with the signs @f$s@f$ of the inner products gives
+   *   @f$a = s / \sqrt{s^T G s}@f$, and the inner products with the new @f$\mu@f$ are @f$G a@f$;
+   * - the projection of the data onto the orthogonal subspace of the basis vector @f$u = \mathbf{X}^T a@f$ is the
+   *   rank one update @f$G \leftarrow G - c c^T@f$, where @f$c = G a@f$ contains the coefficients of the vectors on @f$u@f$.
+   *
+   * The Gram matrix is computed once, in @f$O(N^2 D)@f$, by blocks of rows distributed over the workers. The blocks are
+   * accumulated by panels of dimensions that stay in the cache, 4 rows at a time with the vectorised kernels. The
+   * iterations and the projections then cost @f$O(N^2)@f$ each, and the basis vectors are expanded to the
+   * @f$D@f$ dimensions only once, at the end, in a single sweep over the data. The Gram matrix takes
+   * @f$N^2@f$ scalars in memory, in addition to the copy of the data, and the number of vectors is limited
+   * accordingly (see set_max_gram_size).
+   *
+   * The initial guesses are projected onto the data once, and their components along the previous basis vectors
+   * are removed in the dual form. The iterations stop when the signs do not change, which is the exact fixed point
+   * of the iterations, or after @c max_iterations iterations.
+   *
+   * @note
+   * The intermediate results are not expanded to the @f$D@f$ dimensions: the observer receives the mean of the data
+   * and the basis vectors, but not the results of the PCA steps and of the iterations.
+   *
+   * @tparam data_t type of vectors used for the computation.
+   * @tparam observer_t an observer type following the signature of the class grassmann_trivial_callback
+   * @tparam norm_mu_t norm used to normalize the basis vectors and project them onto the unit circle. The iterations
+   *         and the projections of the Gram matrix are in the Euclidean norm, which is the only one supported.
+   */
+  template <class data_t,
+            class observer_t = grassmann_trivial_callback<data_t>,
+            class norm_mu_t = details::norm2>
+  struct grassmann_pca_dual
+  {
+  private:
+    //! The norm of mu is given by the Gram matrix in the Euclidean norm only.
+    BOOST_STATIC_ASSERT((boost::is_same<norm_mu_t, details::norm2>::value));
+
+    //! Random generator for initialising @f$\mu@f$ at each dimension.
+    details::random_data_generator<data_t> random_init_op;
+
+    //! Norm used for normalizing @f$\mu@f$.
+    norm_mu_t norm_op;
+
+    //! Number of parallel tasks that will be used for computing.
+    size_t nb_processors;
+
+    //! Maximal size of a chunk (infinity by default).
+    size_t max_chunk_size;
+
+    //! Maximal number of vectors of the data, the Gram matrix having the square of this number of elements.
+    size_t max_gram_size;
+
+    //! Number of steps for the initial PCA like algorithm (defaults to 3).
+    size_t nb_steps_pca;
+
+    //! Indicates that the incoming data is not centered and a centering should be performed prior
+    //! to the computation of the PCA or the grassmann average.
+    bool need_centering;
+
+    //! Indicates that the workers and the chunks are placed on the NUMA nodes (see set_numa_placement).
+    bool numa_placement;
+
+    //! Number of sign flips per iteration, for each computed basis vector.
+    std::vector< std::vector<size_t> > v_sign_flips;
+
+    //! Pool of workers set by the caller (see set_thread_pool).
+    thread_pool *p_thread_pool;
+
+    //! An instance observing the steps of the algorithm
+    observer_t *observer;
+
+    //! Type of the element of data_t.
+    typedef typename data_t::value_type scalar_t;
+
+    //! Number of rows of the blocks of the Gram matrix computed by each task.
+    static const size_t gram_block_rows = 64;
+
+    //! Number of dimensions of the panels of the blocks of the Gram matrix: the panels of the rows of a block stay in the
+    //! L2 cache while the panels of the other rows are streamed.
+    static const size_t gram_panel_size = 512;
+
+    //! Number of dimensions of the basis vectors expanded by each task.
+    static const size_t expansion_range_size = 512;
+
+
+    //!@internal
+    //!@brief Copy of a chunk of the data, one vector per row.
+    struct s_dual_chunk_processor
+    {
+    private:
+      //! Number of vectors contained in this chunk.
+      size_t nb_elements;
+
+      //! Dimension of the vectors.
+      size_t data_dimension;
+
+      //! Number of scalars between the beginning of two consecutive rows.
+      size_t data_padding;
+
+      //! The matrix containing a copy of the data, the vectors being stored per row.
+      scalar_t *p_c_matrix;
+
+      //! Internal accumulator, which should live until the result is merged.
+      data_t accumulator;
+
+      typedef boost::function<void (data_t const*)> connector_accumulator_t;
+      connector_accumulator_t signal_acc;
+
+      typedef boost::function<void ()> connector_counter_t;
+      connector_counter_t signal_counter;
+
+      //! Kernels for the operations on the rows.
+      details::simd::kernels<scalar_t> kernels_op;
+
+    public:
+      s_dual_chunk_processor() :
+        nb_elements(0),
+        data_dimension(0),
+        data_padding(0),
+        p_c_matrix(0),
+        kernels_op(details::simd::get_kernels<scalar_t>())
+      {}
+
+      ~s_dual_chunk_processor()
+      {
+        details::simd::aligned_free(p_c_matrix);
+      }
+
+      //! Sets the dimension of each vectors
+      //! @pre data_dimensions_ strictly positive
+      void set_data_dimensions(size_t data_dimensions_)
+      {
+        data_dimension = data_dimensions_;
+        assert(data_dimension > 0);
+      }
+
+      //! Returns the callback object that will be called to signal an updated accumulator.
+      connector_accumulator_t& connector_accumulator()
+      {
+        return signal_acc;
+      }
+
+      //! Returns the callback object that will be called to signal the end of the current computation.
+      connector_counter_t& connector_counter()
+      {
+        return signal_counter;
+      }
+
+      //! Sets the data range. The rows are aligned on 64 bytes.
+      template <class container_iterator_t>
+      void set_data_range(container_iterator_t const &b, container_iterator_t const& e)
+      {
+        nb_elements = std::distance(b, e);
+        assert(nb_elements > 0);
+
+        const size_t alignment = 64;
+        data_padding = ((data_dimension * sizeof(scalar_t) + alignment - 1) & ~(alignment - 1)) / sizeof(scalar_t);
+
+        details::simd::aligned_free(p_c_matrix);
+        p_c_matrix = 0;
+        p_c_matrix = details::simd::aligned_allocate<scalar_t>(data_padding * nb_elements, alignment);
+
+        container_iterator_t bb(b);
+        scalar_t *current_line = p_c_matrix;
+        for(size_t line = 0; line < nb_elements; line++, current_line += data_padding, ++bb)
+        {
+          for(size_t column = 0; column < data_dimension; column++)
+          {
+            current_line[column] = (*bb)(column);
+          }
+        }
+
+        signal_counter();
+      }
+
+      //! Number of vectors of the chunk.
+      size_t get_nb_elements() const
+      {
+        return nb_elements;
+      }
+
+      //! Beginning of the vector @c element of the chunk.
+      scalar_t const* row(size_t element) const
+      {
+        return p_c_matrix + element * data_padding;
+      }
+
+      //! Centering the data in case it was not possible to do it beforehand
+      void data_centering_first_phase(size_t full_dataset_size)
+      {
+        accumulator = data_t(data_dimension, 0);
+        scalar_t * const p_acc = &accumulator.data()[0];
+        for(size_t element = 0; element < nb_elements; element++)
+        {
+          kernels_op.add(p_acc, row(element), data_dimension);
+        }
+
+        for(size_t d = 0; d < data_dimension; d++)
+        {
+          p_acc[d] /= full_dataset_size;
+        }
+
+        signal_acc(&accumulator);
+        signal_counter();
+      }
+
+      //! Subtracts the mean from the vectors of the chunk.
+      void data_centering_second_phase(data_t const &mean_value)
+      {
+        scalar_t const * const p_mean = &mean_value.data()[0];
+        for(size_t element = 0; element < nb_elements; element++)
+        {
+          kernels_op.sub(p_c_matrix + element * data_padding, p_mean, data_dimension);
+        }
+
+        signal_counter();
+      }
+    };
+
+
+    //!@internal
+    //!@brief Operations on the Gram matrix and on all the rows of the data, by ranges of rows or of dimensions.
+    struct s_dual_operations
+    {
+      //! Beginning of all the vectors of the data, in the order of the chunks.
+      std::vector<scalar_t const*> v_rows;
+
+      //! Number of vectors of the data.
+      size_t nb_elements;
+
+      //! Dimension of the vectors.
+      size_t data_dimension;
+
+      //! Gram matrix of the data, of size nb_elements x nb_elements (row major).
+      scalar_t *p_gram;
+
+      //! Kernels for the operations on the rows.
+      details::simd::kernels<scalar_t> kernels_op;
+
+      typedef boost::function<void ()> connector_counter_t;
+      connector_counter_t signal_counter;
+
+      s_dual_operations() :
+        nb_elements(0),
+        data_dimension(0),
+        p_gram(0),
+        kernels_op(details::simd::get_kernels<scalar_t>())
+      {}
+
+      /*!@brief Computes the rows @c first_row to @c first_row+nb_rows of the lower triangle of the Gram matrix, and their
+       *        symmetric elements.
+       *
+       * The inner products are accumulated by panels of dimensions: the panels of the rows of the block stay in the cache
+       * while the panels of the previous rows are streamed, each of them being multiplied by 4 rows of the block at a time.
+       */
+      void gram_rows(size_t first_row, size_t nb_rows) const
+      {
+        const size_t nb_columns = first_row + nb_rows;
+        std::vector<scalar_t> v_block(nb_columns * nb_rows, scalar_t(0));
+        std::vector<scalar_t const*> v_block_rows(nb_rows);
+        for(size_t panel = 0; panel < data_dimension; panel += gram_panel_size)
+        {
+          const size_t panel_size = std::min(size_t(gram_panel_size), data_dimension - panel);
+          for(size_t r = 0; r < nb_rows; r++)
+          {
+            v_block_rows[r] = v_rows[first_row + r] + panel;
+          }
+          for(size_t column = 0; column < nb_columns; column++)
+          {
+            kernels_op.rows_inner_products(&v_block[column * nb_rows], &v_block_rows[0], v_rows[column] + panel, nb_rows, panel_size);
+          }
+        }
+
+        // the elements above the diagonal of the block are computed by the other row
+        for(size_t r = 0; r < nb_rows; r++)
+        {
+          const size_t row = first_row + r;
+          for(size_t column = 0; column <= row; column++)
+          {
+            p_gram[row * nb_elements + column] = p_gram[column * nb_elements + row] = v_block[column * nb_rows + r];
+          }
+        }
+
+        signal_counter();
+      }
+
+      //! Computes the elements @c first_row to @c first_row+nb_rows of the product of the Gram matrix with a vector.
+      void gram_product(size_t first_row, size_t nb_rows, scalar_t const *p_vector, scalar_t *p_out) const
+      {
+        for(size_t row = first_row; row < first_row + nb_rows; row++)
+        {
+          p_out[row] = kernels_op.inner_product(p_gram + row * nb_elements, p_vector, nb_elements);
+        }
+        signal_counter();
+      }
+
+      //! Projects the rows @c first_row to @c first_row+nb_rows of the Gram matrix onto the orthogonal subspace of a basis
+      //! vector, from the coefficients @c p_coefficients of all the vectors on the basis vector: @f$G \leftarrow G - c c^T@f$.
+      void deflate_gram(size_t first_row, size_t nb_rows, scalar_t const *p_coefficients) const
+      {
+        for(size_t row = first_row; row < first_row + nb_rows; row++)
+        {
+          kernels_op.axpy(p_gram + row * nb_elements, -p_coefficients[row], p_coefficients, nb_elements);
+        }
+        signal_counter();
+      }
+
+      //! Computes the inner products of the vectors @c first_row to @c first_row+nb_rows with each of the provided vectors.
+      //! The inner products with the vector @c k are stored starting at @c p_out+k*nb_elements.
+      void project_rows(size_t first_row, size_t nb_rows, std::vector<data_t> const *p_vectors, scalar_t *p_out) const
+      {
+        for(size_t k = 0; k < p_vectors->size(); k++)
+        {
+          scalar_t * const p_current = p_out + k * nb_elements + first_row;
+          std::fill(p_current, p_current + nb_rows, scalar_t(0));
+          kernels_op.rows_inner_products(p_current, &v_rows[first_row], &(*p_vectors)[k].data()[0], nb_rows, data_dimension);
+        }
+        signal_counter();
+      }
+
+      //! Computes the dimensions @c first_dimension to @c first_dimension+nb_dimensions of the basis vectors @f$X^T b_k@f$,
+      //! from the coefficients @f$b_k@f$ of the basis vector @c k stored starting at @c p_coefficients+k*nb_elements.
+      void expand(size_t first_dimension, size_t nb_dimensions, scalar_t const *p_coefficients, std::vector<data_t> *p_basis) const
+      {
+        std::vector<scalar_t const*> v_range_rows(nb_elements);
+        for(size_t row = 0; row < nb_elements; row++)
+        {
+          v_range_rows[row] = v_rows[row] + first_dimension;
+        }
+
+        for(size_t k = 0; k < p_basis->size(); k++)
+        {
+          scalar_t * const p_out = &(*p_basis)[k].data()[0] + first_dimension;
+          std::fill(p_out, p_out + nb_dimensions, scalar_t(0));
+          kernels_op.weighted_rows_sum(p_out, &v_range_rows[0], p_coefficients + k * nb_elements, nb_elements, nb_dimensions);
+        }
+        signal_counter();
+      }
+    };
+
+
+    //!@internal
+    //! Type of the reduction of the partial accumulators of the chunks.
+    typedef details::threading::partial_results_reducer<data_t> results_reducer_t;
+
+
+    /*!@internal
+     * @brief Computes the product of the Gram matrix with a vector, by ranges of rows distributed over the workers.
+     */
+    static void gram_product(
+      details::threading::numa_thread_pool &pool,
+      details::threading::notification_counter &counter,
+      s_dual_operations const &operations,
+      size_t rows_per_range,
+      scalar_t const *p_vector,
+      scalar_t *p_out)
+    {
+      counter.reset();
+      size_t nb_ranges = 0;
+      for(size_t first_row = 0; first_row < operations.nb_elements; first_row += rows_per_range, nb_ranges++)
+      {
+        pool.post(nb_ranges % pool.nb_nodes(),
+          boost::bind(
+            &s_dual_operations::gram_product,
+            boost::cref(operations),
+            first_row,
+            std::min(rows_per_range, operations.nb_elements - first_row),
+            p_vector,
+            p_out));
+      }
+      counter.wait(nb_ranges);
+    }
+
+    //!@internal
+    //! Logs the failure of a computation.
+    bool log_failure(std::string const& message) const
+    {
+      if(observer)
+      {
+        observer->log_error_message(message.c_str());
+      }
+      return false;
+    }
+
+    //!@internal
+    //! Logs the null result of a computation.
+    bool log_null_result(char const* computation, size_t current_subspace_index) const
+    {
+      std::ostringstream o;
+      o << "The result of the " << computation << " is null for subspace " << current_subspace_index;
+      return log_failure(o.str());
+    }
+
+
+  public:
+    /*!@brief Constructor
+     *
+     * @note By default the number of processors used for computation is set to 1.
+     * The maximum size of the chunks is "infinite": each chunk will receive in that case the size of the data
+     * divided by the number of running threads.
+     */
+    grassmann_pca_dual() :
+      random_init_op(details::fVerySmallButStillComputable, details::fVeryBigButStillComputable),
+      nb_processors(1),
+      max_chunk_size(std::numeric_limits<size_t>::max()),
+      max_gram_size(32768),
+      nb_steps_pca(3),
+      need_centering(false),
+      numa_placement(true),
+      p_thread_pool(0),
+      observer(0)
+    {}
+
+    //! Sets the observer of the algorithm.
+    //!
+    //! The lifetime of the observer is not managed by this class. Set to 0 to disable
+    //! observation.
+    bool set_observer(observer_t* observer_)
+    {
+      observer = observer_;
+      return true;
+    }
+
+    //! Sets the number of parallel tasks used for computing.
+    bool set_nb_processors(size_t nb_processors_)
+    {
+      assert(nb_processors_ >= 1);
+      nb_processors = nb_processors_;
+      return true;
+    }
+
+    /*!@brief Sets the maximum chunk size.
+     *
+     * By default, the chunk size is the size of the data divided by the number of processing threads. The chunks are
+     * only used for the copy and the centering of the data, the other computations being distributed by ranges of rows.
+     */
+    bool set_max_chunk_size(size_t chunk_size)
+    {
+      if(chunk_size == 0)
+      {
+        return false;
+      }
+      max_chunk_size = chunk_size;
+      return true;
+    }
+
+    /*!@brief Sets the maximum number of vectors of the data (32768 by default).
+     *
+     * The Gram matrix of @f$N@f$ vectors takes @f$N^2@f$ scalars in memory (8GB for the default size and double
+     * precision). The computations on more vectors fail, the primal form grassmann_pca being more appropriate.
+     */
+    bool set_max_gram_size(size_t nb_vectors)
+    {
+      if(nb_vectors == 0 || nb_vectors > static_cast<size_t>(std::sqrt(double(std::numeric_limits<size_t>::max() / sizeof(scalar_t)))))
+      {
+        return false;
+      }
+      max_gram_size = nb_vectors;
+      return true;
+    }
+
+    //! Sets the number of iterations for the initial PCA like algorithm.
+    bool set_nb_steps_pca(size_t nb_steps)
+    {
+      nb_steps_pca = nb_steps;
+      return true;
+    }
+
+    //! Sets the centering flags.
+    //!
+    //! If set to true, a centering will be performed before applying any computation (PCA and Grassmann averages).
+    bool set_centering(bool need_centering_)
+    {
+      need_centering = need_centering_;
+      return true;
+    }
+
+    /*!@brief Sets the pool of workers used by the computations.
+     *
+     * The lifetime of the pool is not managed by this class, and the pool should outlive the calls to batch_process.
+     * Set to 0 to create a pool for each computation (default).
+     */
+    bool set_thread_pool(thread_pool *p_thread_pool_)
+    {
+      p_thread_pool = p_thread_pool_;
+      return true;
+    }
+
+    //! Sets the placement of the workers and of the chunks on the NUMA nodes (true by default, see
+    //! grassmann_pca::set_numa_placement).
+    bool set_numa_placement(bool numa_placement_)
+    {
+      numa_placement = numa_placement_;
+      return true;
+    }
+
+    /*!@brief Returns the number of sign flips of each iteration of the last call to batch_process.
+     *
+     * The element @c k of the returned vector contains, for the basis vector @c k, the number of input vectors for which
+     * the sign of the inner product with @f$\mu@f$ changed, for each iteration following the initial one.
+     */
+    std::vector< std::vector<size_t> > const& get_sign_flips_statistics() const
+    {
+      return v_sign_flips;
+    }
+
+
+
+    /*!@brief Performs the computation of the current subspace on the elements given by the two iterators.
+     *
+     * @tparam it_t an input forward iterator to input vectors points. Each element pointed by the underlying iterator should be iterable and
+     *   should provide a vector point.
+     * @tparam it_o_basisvectors_t an output iterator for storing the computed basis vectors. This iterator should model a forward output iterator.
+     *
+     * @param[in] max_iterations the maximum number of iterations at each dimension.
+     * @param[in] max_dimension_to_compute the maximum number of data_dimension to compute in the PCA (only the first max_dimension_to_compute will be
+     *            computed). The Gram matrix gives at most as many basis vectors as the minimum of the number of vectors and the 
+     *            number of dimensions.
+     * @param[in] it input iterator at the beginning of the data
+     * @param[in] ite input iterator at the end of the data
+     * @param[in] initial_guess if provided, the initial vectors will be initialized to this value.
+     * @param[out] it_basisvectors an iterator on the beginning of the area where the detected basis vectors will be stored. The space should be at least max_dimension_to_compute.
+     *
+     * @returns true on success, false otherwise
+     * @pre
+     * - @c !(it >= ite)
+     * - @c max_dimension_to_compute should not exceed the number of vectors nor the number of dimensions.
+     * - the number of vectors should not exceed the maximum size of the Gram matrix (see set_max_gram_size).
+     * - all the vectors given by the iterators pair should be of the same size (no check is performed).
+     */
+    template <class it_t, class it_o_basisvectors_t>
+    bool batch_process(
+      const size_t max_iterations,
+      const size_t max_dimension_to_compute,
+      it_t const it,
+      it_t const ite,
+      it_o_basisvectors_t it_basisvectors,
+      std::vector<data_t> const * initial_guess = 0)
+    {
+      if(it >= ite)
+      {
+        return log_failure("The range of the data is empty");
+      }
+
+      // preparing the thread pool, to avoid individual thread creation/deletion at each step.
+      details::threading::thread_pool_holder pool_holder(p_thread_pool, nb_processors, numa_placement);
+      details::threading::numa_thread_pool &pool = pool_holder.get();
+
+      // contains the number of elements. In case the iterator is random access, could be deduced simply
+      // by a call to distance.
+      const size_t size_data(std::distance(it, ite));
+      if(size_data > max_gram_size)
+      {
+        std::ostringstream o;
+        o << "The Gram matrix of " << size_data << " vectors exceeds the maximum size of " << max_gram_size << " vectors";
+        return log_failure(o.str());
+      }
+
+      // size of the chunks.
+      const size_t chunks_size = std::min(max_chunk_size, static_cast<size_t>(ceil(double(size_data)/nb_processors)));
+      const size_t nb_chunks = (size_data + chunks_size - 1) / chunks_size;
+
+      // number of dimensions of the data vectors
+      const size_t number_of_dimensions = it->size();
+      if(max_dimension_to_compute > std::min(number_of_dimensions, size_data))
+      {
+        std::ostringstream o;
+        o << "The Gram matrix of " << size_data << " vectors of dimension " << number_of_dimensions 
+          << " cannot give " << max_dimension_to_compute << " basis vectors";
+        return log_failure(o.str());
+      }
+      v_sign_flips.assign(max_dimension_to_compute, std::vector<size_t>());
+
+      // the initial guesses
+      std::vector<data_t> v_initial_guesses(max_dimension_to_compute);
+      for(size_t i = 0; i < max_dimension_to_compute; i++)
+      {
+        v_initial_guesses[i] = initial_guess != 0 ? (*initial_guess)[i] : random_init_op(data_t(number_of_dimensions));
+      }
+
+
+      // copy of the data by chunks
+      std::vector<s_dual_chunk_processor> v_chunks(nb_chunks);
+      results_reducer_t async_merger(pool, nb_chunks, number_of_dimensions);
+      async_merger.init_notifications();
+      {
+        it_t it_current_begin(it);
+        for(size_t i = 0; i < nb_chunks; i++)
+        {
+          // the last chunk takes the remaining elements
+          it_t it_current_end = it_current_begin;
+          std::advance(it_current_end, i == nb_chunks - 1 ? size_data - chunks_size*(nb_chunks - 1) : chunks_size);
+
+          s_dual_chunk_processor &current_chunk = v_chunks[i];
+          current_chunk.set_data_dimensions(number_of_dimensions);
+          current_chunk.connector_accumulator() = boost::bind(&results_reducer_t::update, &async_merger, i, _1);
+          current_chunk.connector_counter() = boost::bind(&results_reducer_t::notify, &async_merger);
+
+          // the copy is made by the workers of the node of the chunk (first touch)
+          pool.post(pool.node_of_chunk(i, nb_chunks),
+            boost::bind(
+              &s_dual_chunk_processor::template set_data_range<it_t>,
+              boost::ref(current_chunk),
+              it_current_begin, it_current_end));
+
+          it_current_begin = it_current_end;
+        }
+
+        // waiting for completion (barrier)
+        async_merger.wait_notifications(nb_chunks);
+      }
+
+
+      // Centering the data if needed, the mean being computed by the chunks
+      data_t mean_vector;
+      if(need_centering)
+      {
+        async_merger.init();
+        for(size_t i = 0; i < nb_chunks; i++)
+        {
+          pool.post(pool.node_of_chunk(i, nb_chunks),
+            boost::bind(
+              &s_dual_chunk_processor::data_centering_first_phase,
+              boost::ref(v_chunks[i]),
+              size_data));
+        }
+        async_merger.wait_notifications(nb_chunks);
+        mean_vector = async_merger.get_merged_result();
+
+        if(observer)
+        {
+          observer->signal_mean(mean_vector);
+        }
+
+        async_merger.init_notifications();
+        for(size_t i = 0; i < nb_chunks; i++)
+        {
+          pool.post(pool.node_of_chunk(i, nb_chunks),
+            boost::bind(
+              &s_dual_chunk_processor::data_centering_second_phase,
+              boost::ref(v_chunks[i]),
+              boost::cref(mean_vector)));
+        }
+        async_merger.wait_notifications(nb_chunks);
+      }
+
+
+      // the operations on all the rows are notified to a counter
+      details::threading::notification_counter counter;
+      s_dual_operations operations;
+      operations.nb_elements = size_data;
+      operations.data_dimension = number_of_dimensions;
+      operations.signal_counter = boost::bind(&details::threading::notification_counter::notify, &counter);
+      operations.v_rows.reserve(size_data);
+      for(size_t i = 0; i < nb_chunks; i++)
+      {
+        for(size_t element = 0; element < v_chunks[i].get_nb_elements(); element++)
+        {
+          operations.v_rows.push_back(v_chunks[i].row(element));
+        }
+      }
+
+      const size_t N = size_data;
+      const size_t rows_per_range = std::max<size_t>(16, N / (4 * std::max<size_t>(1, pool.nb_threads())));
+
+
+      // Gram matrix, the largest blocks of rows being posted first
+      boost::scoped_array<scalar_t> gram(new (std::nothrow) scalar_t[N * N]);
+      if(!gram)
+      {
+        std::ostringstream o;
+        o << "The Gram matrix of " << N << " vectors cannot be allocated";
+        return log_failure(o.str());
+      }
+      operations.p_gram = gram.get();
+      {
+        counter.reset();
+        const size_t nb_blocks = (N + gram_block_rows - 1) / gram_block_rows;
+        for(size_t block = nb_blocks; block > 0; block--)
+        {
+          const size_t first_row = (block - 1) * gram_block_rows;
+          pool.post((block - 1) % pool.nb_nodes(),
+            boost::bind(
+              &s_dual_operations::gram_rows,
+              boost::cref(operations),
+              first_row,
+              std::min(size_t(gram_block_rows), N - first_row)));
+        }
+        counter.wait(nb_blocks);
+      }
+
+
+      // inner products of the data with the initial guesses
+      std::vector<scalar_t> v_initial_projections(max_dimension_to_compute * N);
+      {
+        counter.reset();
+        size_t nb_ranges = 0;
+        for(size_t first_row = 0; first_row < N; first_row += rows_per_range, nb_ranges++)
+        {
+          pool.post(nb_ranges % pool.nb_nodes(),
+            boost::bind(
+              &s_dual_operations::project_rows,
+              boost::cref(operations),
+              first_row,
+              std::min(rows_per_range, N - first_row),
+              &v_initial_guesses,
+              &v_initial_projections[0]));
+        }
+        counter.wait(nb_ranges);
+      }
+
+
+      // coefficients of the basis vectors on the data (u_k = X^T b_k), and of the data on the basis vectors (c_k = X u_k)
+      std::vector<scalar_t> v_basis_coefficients(max_dimension_to_compute * N, scalar_t(0));
+      std::vector<scalar_t> v_data_coefficients(max_dimension_to_compute * N, scalar_t(0));
+
+      // inner products of the data with the current mu, coefficients of mu and signs
+      std::vector<scalar_t> v_projections(N), v_coefficients(N), v_product(N), v_signs(N);
+
+      for(size_t current_subspace_index = 0; current_subspace_index < max_dimension_to_compute; current_subspace_index++)
+      {
+        // the workers poll their queue during the iterations of the component
+        details::threading::hot_workers_scope hot_workers(pool);
+
+        // inner products with the initial guess, projected onto the orthogonal subspace of the previous basis vectors:
+        // the inner product with u_j of the initial guess is b_j^T X mu_0
+        scalar_t const * const p_initial_projections = &v_initial_projections[current_subspace_index * N];
+        std::copy(p_initial_projections, p_initial_projections + N, v_projections.begin());
+        for(size_t j = 0; j < current_subspace_index; j++)
+        {
+          const scalar_t coefficient = std::inner_product(p_initial_projections, p_initial_projections + N, &v_basis_coefficients[j * N], scalar_t(0));
+          for(size_t i = 0; i < N; i++)
+          {
+            v_projections[i] -= coefficient * v_data_coefficients[j * N + i];
+          }
+        }
+
+        // PCA like initial steps: mu = X^T p / |X^T p|, the inner products of which are G p / |X^T p|
+        for(size_t pca_it = 0; pca_it < nb_steps_pca; pca_it++)
+        {
+          gram_product(pool, counter, operations, rows_per_range, &v_projections[0], &v_product[0]);
+          const double norm_mu = std::sqrt(std::max(0., double(std::inner_product(v_projections.begin(), v_projections.end(), v_product.begin(), scalar_t(0)))));
+          if(norm_mu < 1E-12)
+          {
+            return log_null_result("PCA", current_subspace_index);
+          }
+          for(size_t i = 0; i < N; i++)
+          {
+            v_projections[i] = v_product[i] / scalar_t(norm_mu);
+          }
+        }
+
+        // Grassmann average iterations, mu = X^T s / |X^T s|
+        for(size_t i = 0; i < N; i++)
+        {
+          v_signs[i] = v_projections[i] >= 0 ? scalar_t(1) : scalar_t(-1);
+        }
+
+        for(size_t iterations = 0; ; )
+        {
+          gram_product(pool, counter, operations, rows_per_range, &v_signs[0], &v_product[0]);
+          const double norm_mu = std::sqrt(std::max(0., double(std::inner_product(v_signs.begin(), v_signs.end(), v_product.begin(), scalar_t(0)))));
+          if(norm_mu < 1E-12)
+          {
+            return log_null_result("accumulation", current_subspace_index);
+          }
+          for(size_t i = 0; i < N; i++)
+          {
+            v_coefficients[i] = v_signs[i] / scalar_t(norm_mu);
+            v_projections[i] = v_product[i] / scalar_t(norm_mu);
+          }
+
+          // the same signs give the same mu
+          size_t nb_sign_flips = 0;
+          for(size_t i = 0; i < N; i++)
+          {
+            const scalar_t sign = v_projections[i] >= 0 ? scalar_t(1) : scalar_t(-1);
+            if(sign != v_signs[i])
+            {
+              v_signs[i] = sign;
+              nb_sign_flips++;
+            }
+          }
+
+          // the last count is recorded as well, as in grassmann_pca
+          v_sign_flips[current_subspace_index].push_back(nb_sign_flips);
+          if(++iterations >= max_iterations || nb_sign_flips == 0)
+          {
+            break;
+          }
+        }
+
+
+        // the coefficients of the data on the basis vector, and the coefficients of the basis vector on the data before
+        // the projections: X_k^T a = X^T (a - sum_j b_j c_j^T a)
+        scalar_t * const p_data_coefficients = &v_data_coefficients[current_subspace_index * N];
+        scalar_t * const p_basis_coefficients = &v_basis_coefficients[current_subspace_index * N];
+        std::copy(v_projections.begin(), v_projections.end(), p_data_coefficients);
+        std::copy(v_coefficients.begin(), v_coefficients.end(), p_basis_coefficients);
+        for(size_t j = 0; j < current_subspace_index; j++)
+        {
+          const scalar_t coefficient = std::inner_product(v_coefficients.begin(), v_coefficients.end(), &v_data_coefficients[j * N], scalar_t(0));
+          for(size_t i = 0; i < N; i++)
+          {
+            p_basis_coefficients[i] -= coefficient * v_basis_coefficients[j * N + i];
+          }
+        }
+
+        // projection of the Gram matrix onto the orthogonal subspace of the basis vector
+        if(current_subspace_index < max_dimension_to_compute - 1)
+        {
+          counter.reset();
+          size_t nb_ranges = 0;
+          for(size_t first_row = 0; first_row < N; first_row += rows_per_range, nb_ranges++)
+          {
+            pool.post(nb_ranges % pool.nb_nodes(),
+              boost::bind(
+                &s_dual_operations::deflate_gram,
+                boost::cref(operations),
+                first_row,
+                std::min(rows_per_range, N - first_row),
+                p_data_coefficients));
+          }
+          counter.wait(nb_ranges);
+        }
+      }
+
+
+      // expansion of the basis vectors to the full dimension, in one sweep over the data
+      std::vector<data_t> v_basis(max_dimension_to_compute, data_t(number_of_dimensions));
+      {
+        counter.reset();
+        size_t nb_ranges = 0;
+        for(size_t first_dimension = 0; first_dimension < number_of_dimensions; first_dimension += expansion_range_size, nb_ranges++)
+        {
+          pool.post(nb_ranges % pool.nb_nodes(),
+            boost::bind(
+              &s_dual_operations::expand,
+              boost::cref(operations),
+              first_dimension,
+              std::min(size_t(expansion_range_size), number_of_dimensions - first_dimension),
+              &v_basis_coefficients[0],
+              &v_basis));
+        }
+        counter.wait(nb_ranges);
+      }
+
+      for(size_t current_subspace_index = 0; current_subspace_index < max_dimension_to_compute; current_subspace_index++, ++it_basisvectors)
+      {
+        // the basis vectors are unitary up to the rounding errors
+        data_t &mu = v_basis[current_subspace_index];
+        const double norm_mu = norm_op(mu);
+        if(norm_mu < 1E-12)
+        {
+          return log_null_result("subspace computation", current_subspace_index);
+        }
+        mu *= scalar_t(1./norm_mu);
+
+        *it_basisvectors = mu;
+        if(observer)
+        {
+          observer->signal_eigenvector(*it_basisvectors, current_subspace_index);
+        }
+      }
+
+      return true;
+    }
+  };
+
+}
+
+
+#endif /* GRASSMANN_AVERAGES_PCA_DUAL_HPP__ */
@@ -25,6 +25,12 @@
 
 // utilities
 #include <include/private/utilities.hpp>
+#include <include/private/numa_thread_pool.hpp>
+#include <include/private/simd_kernels.hpp>
+
+#include <vector>
+#include <numeric>
+#include <limits>
 
 
 namespace grassmann_averages_pca
@@ -59,6 +65,36 @@ namespace grassmann_averages_pca
         return true;
       }
     };
+
+    //!@internal
+    //!Helper object for the updates of a range of consecutive dimensions
+    template <class scalar_t>
+    struct s_dimension_range_update
+    {
+      size_t first_dimension;   //!< First updated dimension
+      size_t nb_dimensions;     //!< Number of updated dimensions
+      scalar_t const *values;   //!< Values of the updated dimensions, which should live until the update is merged
+    };
+
+    /*!@internal
+     * @brief Counterpart of merger_update_specific_dimension for a range of dimensions.
+     *
+     * A range of dimensions is merged under a single lock of the merger, instead of one lock per dimension.
+     */
+    template <class data_t>
+    struct merger_update_dimension_range
+    {
+      typedef data_t input_t;
+      bool operator()(input_t &current_state, s_dimension_range_update<typename data_t::value_type> const& update_value) const
+      {
+        assert(update_value.first_dimension + update_value.nb_dimensions <= current_state.size());
+        simd::get_kernels<typename data_t::value_type>().add(
+          &current_state.data()[0] + update_value.first_dimension, 
+          update_value.values, 
+          update_value.nb_dimensions);
+        return true;
+      }
+    };
     
   }
 
@@ -94,7 +130,10 @@ namespace grassmann_averages_pca
    * - to split the computation of @f$\sum_j s_{j, t} X_j@f$ among several independant chunks. This computation involves the inner product and the sign. Each chunk addresses 
    *   a subset of the data @f$\{X_j\}@f$ without any overlap with other chunks. The maximal size of a chunk can be configured through the function grassmann_pca::set_max_chunk_size.
    *   By default, the size of the chunk would be the size of the data divided by the number of threads.
-   * - to compute the @f$\frac{K}{2}@f$ extremal points along each dimension in parallel
+   * - to compute the @f$\frac{K}{2}@f$ extremal points along each dimension in parallel, from the extremal points kept by each chunk for small trimmings
+   *   (see grassmann_pca_with_trimming::set_streaming_trimming), or from the histograms of the stored values for the integer storage types
+   *   (see grassmann_pca_with_trimming::set_histogram_trimming). The extremal points may also be estimated from samples of the chunks
+   *   (see grassmann_pca_with_trimming::set_approximate_trimming)
    * - to split the computation of the projection onto the orthogonal subspace of @f$\mu_{k}@f$.
    * - to split the computation of the regular PCA algorithm (if any) into several independant chunks.
    *
@@ -108,12 +147,16 @@ namespace grassmann_averages_pca
    * @tparam data_t type of vectors used for the computation. 
    * @tparam norm_mu_t norm used to normalize the basis vectors and project them onto the unit circle.
    * @tparam observer_t an observer type following the signature of the class grassmann_trivial_callback
+   * @tparam storage_t type used for storing the copy of the data in each chunk (see grassmann_pca). For the compact 
+   *   types, the centering and the projections onto the orthogonal subspaces are applied implicitly, and batch_process
+   *   returns false if the values of the data are not integers in the range of the storage type.
    *
    * @author Soren Hauberg, Raffi Enficiaud
    */
   template <class data_t, 
             class observer_t = grassmann_trivial_callback<data_t>,
-            class norm_mu_t = details::norm2 >
+            class norm_mu_t = details::norm2,
+            class storage_t = typename data_t::value_type>
   struct grassmann_pca_with_trimming
   {
   private:
@@ -149,6 +192,36 @@ namespace grassmann_averages_pca
     bool need_centering;
 
 
+    //! Number of basis vectors computed together (see set_block_size).
+    size_t block_size;
+
+    //! Indicates that the workers and the chunks are placed on the NUMA nodes (see set_numa_placement).
+    bool numa_placement;
+
+    //! Fraction of sign flips below which the iterations stop, negative if disabled (see set_sign_flips_convergence).
+    double sign_flips_fraction;
+
+    //! Indicates that the iterations stop on a cycle of the signs (see set_cycle_detection).
+    bool cycle_detection;
+
+    //! Indicates that the trimmed averages may be computed without a signed copy of the data (see set_streaming_trimming).
+    bool streaming_trimming;
+
+    //! Maximal number of values of the integer storage types for the histogram trimming, 0 if disabled (see set_histogram_trimming).
+    size_t max_histogram_bins;
+
+    //! Number of elements sampled for the estimation of the bounds of the trimmed means, 0 if exact (see set_approximate_trimming).
+    size_t approximate_trimming_sample_size;
+
+    //! Number of sign flips per iteration, for each computed basis vector.
+    std::vector< std::vector<size_t> > v_sign_flips;
+
+    //! Maximal rank error of the estimated bounds per iteration, for each computed basis vector (see set_approximate_trimming).
+    std::vector< std::vector<size_t> > v_trimming_rank_errors;
+
+    //! Pool of workers set by the caller (see set_thread_pool).
+    thread_pool *p_thread_pool;
+
     //! An instance observing the steps of the algorithm
     observer_t *observer;
 
@@ -161,7 +234,14 @@ namespace grassmann_averages_pca
       //! Scalar type of the data
       typedef typename data_t::value_type scalar_t;
       
-      typedef details::s_dimension_update<scalar_t> accumulator_element_t;
+      typedef details::s_dimension_range_update<scalar_t> accumulator_element_t;
+
+      //! Type of the exact accumulators of the storage type
+      typedef typename details::simd::storage_accumulator<storage_t>::type accumulator_t;
+
+      //! Indicates if the data is stored with the scalar type, in which case the centering and the
+      //! deflation may be applied directly to the copy of the data.
+      typedef boost::is_same<storage_t, scalar_t> native_storage_t;
 
       
       size_t nb_elements;                 //!< The size of the current dataset
@@ -174,37 +254,374 @@ namespace grassmann_averages_pca
       typedef boost::function<void (accumulator_element_t const*)> connector_accumulator_dimension_t;
       connector_accumulator_dimension_t signal_acc_dimension;
 
-      std::vector<accumulator_element_t> v_accumulated_per_dimension;
+      //! Results of each dimension, posted to the merger by ranges of dimensions (see signal_dimensions).
+      std::vector<scalar_t> v_accumulated_per_dimension;
+
+      //! Bounds of the trimmed elements of the last trimmed averages, for each index of v_accumulated_per_dimension.
+      std::vector< details::trimming_bounds<scalar_t> > v_trimming_bounds;
 
  
       //! The matrix containing a copy of the data
-      scalar_t *p_c_matrix;
+      storage_t *p_c_matrix;
+
+      //! Beginning of each line of the copy of the data, for the kernels summing rows.
+      std::vector<storage_t const*> v_lines;
       
       //! The result of the inner products
       std::vector<scalar_t> inner_prod_results;
+
+      //! Signs of the inner products of the last iteration, packed by words of 64 bits (the bit i of the word k being
+      //! the sign of the element 64*k + i).
+      std::vector<boost::uint64_t> v_signs;
+
+      //! Number of signs that changed during the last call to compute_data_matrix.
+      size_t nb_sign_flips;
+
+      //! Change of the hash of the signs during the last call to compute_data_matrix (see details::signs_word_hash).
+      boost::uint64_t signs_hash_change;
+
+      //! Position of the first word of signs of the chunk in the bitmap of all the signs, for the hashes.
+      boost::uint64_t signs_hash_offset;
+
+      //! Kernels for the operations on the scalar vectors.
+      details::simd::kernels<scalar_t> kernels_op;
+
+      //! Kernels operating on the lines of the matrix.
+      details::simd::storage_kernels<storage_t, scalar_t> storage_op;
+
+      //! Indicates that the centering and the deflation are not applied to the copy of the data, but implicitly in
+      //! the inner products and the accumulations. This is always the case for the compact storage types.
+      bool implicit_transformations;
+
+      //! Mean of the data in case of implicit centering, 0 if the data is not centered.
+      data_t const *p_mean;
+
+      //! Basis vectors against which the data is deflated, in case of implicit deflation.
+      std::vector<data_t> const *p_deflation_basis;
+
+      //! Coefficients of the elements on the basis vectors, in case of implicit deflation: the element j 
+      //! contains the coefficients of all the elements on the basis vector j.
+      std::vector< std::vector<scalar_t> > v_deflation_coefficients;
   
+      //! Signs and inner products of the elements with each vector of the frame (block computation). The
+      //! inner products with the vector @c c start at @c c*nb_elements.
+      std::vector<scalar_t> v_block_inner_products;
+
+      //! Number of elements of a line processed at once for all the vectors of a frame (fits in the L1 cache).
+      static const size_t block_tile_size = 2048;
+
+      //! Sums of the signed lines (streaming trimming).
+      std::vector<scalar_t> v_lines_sums;
+
+      //! Heaps of the largest and smallest elements of the signed lines (streaming trimming), nb_extremal_elements per line.
+      std::vector<scalar_t> v_largest_elements, v_smallest_elements;
+
+      //! Number of extremal elements kept on each side of a signed line, at most the number of elements of the chunk.
+      size_t nb_extremal_elements;
+
+      //! Signed line being processed (streaming trimming).
+      std::vector<scalar_t> v_signed_line;
+
+      //! Tile of a line on which the implicit transformations are applied, before the signs.
+      std::vector<scalar_t> v_transformed_tile;
+
+      //! Packed signs of the inner products with a vector of the frame (block computation), as v_signs.
+      std::vector<boost::uint64_t> v_block_signs;
+
+      //! Size in bytes of the signed copies of the data above which they are written with non-temporal stores: the 
+      //! copy does not fit in the last level cache and is not read before its end is written.
+      static const size_t non_temporal_copy_size = size_t(32) << 20;
+
+      //! Range of the stored values, for the integer storage types (histogram trimming).
+      boost::int64_t min_stored_value, max_stored_value;
+
+      //! Indicates that the storage type represents the values of the copied data exactly.
+      bool representable_data;
+
+      //! Rank errors of the estimated bounds of the last approximate trimmed means, for each dimension (approximate trimming).
+      std::vector<size_t> v_rank_errors;
+
+      //! Posts the results of a range of dimensions to the listeners, under a single lock of the merger.
+      void signal_dimensions(size_t first_dimension, size_t nb_dimensions)
+      {
+        accumulator_element_t update;
+        update.first_dimension = first_dimension;
+        update.nb_dimensions = nb_dimensions;
+        update.values = &v_accumulated_per_dimension[first_dimension];
+        signal_acc_dimension(&update);
+      }
+
+      //! Initialises the inner products with the offsets of the implicit transformations, or 0.
+      void initialise_inner_products(scalar_t *out, scalar_t const *p_mu) const
+      {
+        if(implicit_transformations)
+        {
+          // the elements are x - m - sum_j c_j u_j
+          const scalar_t mean_offset = p_mean ? kernels_op.inner_product(&p_mean->data()[0], p_mu, data_dimension) : scalar_t(0);
+          std::fill(out, out + nb_elements, -mean_offset);
+          for(size_t j = 0; j < v_deflation_coefficients.size(); j++)
+          {
+            const scalar_t basis_offset = kernels_op.inner_product(&(*p_deflation_basis)[j].data()[0], p_mu, data_dimension);
+            kernels_op.axpy(out, -basis_offset, &v_deflation_coefficients[j][0], nb_elements);
+          }
+        }
+        else
+        {
+          std::fill(out, out + nb_elements, scalar_t(0));
+        }
+      }
+
       void compute_inner_products(data_t const &mu)
       {
         scalar_t *out = &inner_prod_results[0];
-        scalar_t mu_element = mu(0);
-        scalar_t const * current_line = p_c_matrix;
+        scalar_t const * const p_mu = &mu.data()[0];
+
+        initialise_inner_products(out, p_mu);
+
+        // the inner products are accumulated by panels that stay in the L1 cache, 4 lines at a time
+        storage_op.weighted_rows_sum(out, &v_lines[0], p_mu, data_dimension, nb_elements);
+      }
+
+      /*!@brief Computes the inner products of the elements with all the vectors of the frame in one sweep over the data.
+       *
+       * The lines are processed by tiles of elements: the tile of each line is used for all the vectors of the frame
+       * while it is in the cache.
+       */
+      void compute_block_inner_products(std::vector<data_t> const &frame)
+      {
+        const size_t nb_vectors = frame.size();
+        v_block_inner_products.resize(nb_vectors * nb_elements);
+        for(size_t c = 0; c < nb_vectors; c++)
+        {
+          initialise_inner_products(&v_block_inner_products[c * nb_elements], &frame[c].data()[0]);
+        }
+
+        for(size_t tile = 0; tile < nb_elements; tile += block_tile_size)
+        {
+          const size_t tile_size = std::min(size_t(block_tile_size), nb_elements - tile);
+          storage_t const * current_line = p_c_matrix + tile;
+          for(size_t line = 0; line < data_dimension; line ++, current_line += nb_elements)
+          {
+            for(size_t c = 0; c < nb_vectors; c++)
+            {
+              storage_op.axpy(&v_block_inner_products[c * nb_elements + tile], frame[c](line), current_line, tile_size);
+            }
+          }
+        }
+      }
+
+      //! Packs the signs of the inner products, and counts and hashes the ones that changed since the previous call.
+      void update_signs()
+      {
+        nb_sign_flips = 0;
+        signs_hash_change = 0;
+        for(size_t word = 0, first = 0; first < nb_elements; word++, first += 64)
+        {
+          const size_t nb = std::min<size_t>(64, nb_elements - first);
+          const boost::uint64_t signs = kernels_op.positive_mask(&inner_prod_results[first], nb);
+
+          const boost::uint64_t flips = signs ^ v_signs[word];
+          if(flips)
+          {
+            nb_sign_flips += details::simd::popcount(flips);
+            signs_hash_change ^= 
+              details::signs_word_hash(signs_hash_offset + word, v_signs[word]) ^ 
+              details::signs_word_hash(signs_hash_offset + word, signs);
+            v_signs[word] = signs;
+          }
+        }
+      }
+
+      //! Packs the signs of the provided inner products (the bit i of the word k being set if the element 64*k + i is positive).
+      void pack_signs(scalar_t const *p_inner_products, std::vector<boost::uint64_t> &v_packed) const
+      {
+        v_packed.resize((nb_elements + 63) / 64);
+        for(size_t word = 0, first = 0; first < nb_elements; word++, first += 64)
+        {
+          v_packed[word] = kernels_op.positive_mask(p_inner_products + first, std::min<size_t>(64, nb_elements - first));
+        }
+      }
+
+      //! Copies a line of the data with the provided signs (explicit transformation of the data).
+      void signed_copy_line(storage_t const *current_line, boost::uint64_t const *p_signs, scalar_t* p_out, bool non_temporal, boost::true_type) const
+      {
+        kernels_op.signed_copy(p_out, current_line, p_signs, 0, nb_elements, non_temporal);
+      }
+
+      //! The compact storage types are always transformed implicitly.
+      void signed_copy_line(storage_t const *, boost::uint64_t const *, scalar_t*, bool, boost::false_type) const
+      {
+        assert(false);
+      }
+
+      /*!@brief Fills a line with the data of a dimension multiplied by the packed signs (see v_signs).
+       *
+       * The signs are applied by flipping the sign bits of the elements. The implicit transformations are applied by tiles 
+       * that stay in the L1 cache before the signs, in @c v_tile.
+       */
+      void fill_signed_line(
+        size_t current_dimension, 
+        boost::uint64_t const *p_signs, 
+        scalar_t* p_out, 
+        bool non_temporal, 
+        std::vector<scalar_t> &v_tile) const
+      {
+        // the current line is spans a particular dimension
+        storage_t const * const current_line = p_c_matrix + current_dimension*nb_elements;
+
+        if(!implicit_transformations)
+        {
+          signed_copy_line(current_line, p_signs, p_out, non_temporal, native_storage_t());
+          return;
+        }
+
+        // the transformations are applied to the tile
+        const scalar_t mean_element = p_mean ? (*p_mean)(current_dimension) : scalar_t(0);
+        v_tile.resize(std::min(size_t(block_tile_size), nb_elements));
+        scalar_t * const p_tile = &v_tile[0];
+        for(size_t tile = 0; tile < nb_elements; tile += block_tile_size)
+        {
+          const size_t tile_size = std::min(size_t(block_tile_size), nb_elements - tile);
+          for(size_t element(0); element < tile_size; element++)
+          {
+            p_tile[element] = scalar_t(current_line[tile + element]) - mean_element;
+          }
+          for(size_t j = 0; j < v_deflation_coefficients.size(); j++)
+          {
+            kernels_op.axpy(p_tile, -(*p_deflation_basis)[j](current_dimension), &v_deflation_coefficients[j][tile], tile_size);
+          }
+          kernels_op.signed_copy(p_out + tile, p_tile, p_signs, tile, tile_size, non_temporal);
+        }
+      }
+
+      //! Fills the output matrix with the data multiplied by the packed signs. The large outputs are written with
+      //! non-temporal stores.
+      void fill_data_matrix(boost::uint64_t const *p_signs, scalar_t* p_out, size_t padding)
+      {
+        const bool non_temporal = data_dimension * padding * sizeof(scalar_t) >= non_temporal_copy_size;
+        for(size_t current_dimension = 0; current_dimension < data_dimension; current_dimension++, p_out+= padding)
+        {
+          fill_signed_line(current_dimension, p_signs, p_out, non_temporal, v_transformed_tile);
+        }
+      }
+
+      //! Keeps the sum and the extremal elements of each line of the data multiplied by the packed signs 
+      //! (streaming trimming).
+      void fill_extremal_elements(boost::uint64_t const *p_signs)
+      {
+        nb_extremal_elements = std::min(k_first_last, nb_elements);
+        v_signed_line.resize(nb_elements);
+        v_lines_sums.resize(data_dimension);
+        v_largest_elements.resize(data_dimension * nb_extremal_elements);
+        v_smallest_elements.resize(data_dimension * nb_extremal_elements);
+
+        scalar_t * const p_largest = v_largest_elements.empty() ? 0 : &v_largest_elements[0];
+        scalar_t * const p_smallest = v_smallest_elements.empty() ? 0 : &v_smallest_elements[0];
+        for(size_t current_dimension = 0; current_dimension < data_dimension; current_dimension++)
+        {
+          fill_signed_line(current_dimension, p_signs, &v_signed_line[0], false, v_transformed_tile);
+          v_lines_sums[current_dimension] = details::accumulate_extremal_elements(
+            &v_signed_line[0], 
+            nb_elements, 
+            k_first_last, 
+            p_largest + current_dimension * nb_extremal_elements, 
+            p_smallest + current_dimension * nb_extremal_elements);
+        }
+      }
+
+      /*!@brief Appends the elements of a dimension multiplied by the packed signs (see v_signs) at the positions
+       *        @c stride/2 + @c i*stride to the sample (approximate trimming).
+       *
+       * The implicit transformations are applied to the sampled elements only.
+       */
+      void sample_signed_line(size_t current_dimension, size_t stride, std::vector<scalar_t> &v_sample) const
+      {
+        storage_t const * const current_line = p_c_matrix + current_dimension*nb_elements;
+        boost::uint64_t const * const p_signs = &v_signs[0];
+        const scalar_t mean_element = implicit_transformations && p_mean ? (*p_mean)(current_dimension) : scalar_t(0);
+        for(size_t element = stride / 2; element < nb_elements; element += stride)
+        {
+          scalar_t value = scalar_t(current_line[element]) - mean_element;
+          if(implicit_transformations)
+          {
+            for(size_t j = 0; j < v_deflation_coefficients.size(); j++)
+            {
+              value -= (*p_deflation_basis)[j](current_dimension) * v_deflation_coefficients[j][element];
+            }
+          }
+          v_sample.push_back(((p_signs[element / 64] >> (element % 64)) & 1) ? value : -value);
+        }
+      }
+
+      //! Subtracts the mean from the lines (explicit transformation of the data).
+      void subtract_from_lines(data_t const &mean_value, boost::true_type)
+      {
+        scalar_t *current_element_ptr = p_c_matrix;
         
-        for(int column = 0; column < nb_elements; column++)
+        for(int line = 0; line < data_dimension; line++)
         {
-          out[column] = mu_element * current_line[column];
+          const scalar_t scalar = mean_value(line);   
+          scalar_t * const current_line_end = current_element_ptr + nb_elements;
+          for(; current_element_ptr < current_line_end; current_element_ptr++)
+          {
+            *current_element_ptr -= scalar;
+          }               
         }
-        current_line += nb_elements;
+      }
+
+      //! The compact storage types cannot be transformed explicitly.
+      void subtract_from_lines(data_t const &, boost::false_type)
+      {
+        assert(false);
+      }
+
+      //! Projects the data onto the orthogonal subspace of mu, the inner products being already computed 
+      //! (explicit transformation of the data).
+      template <class vector_t>
+      void deflate_lines(vector_t const &mu, boost::true_type)
+      {
+        scalar_t *current_line = p_c_matrix;
         
-        for(int line = 1; line < data_dimension; line ++, current_line += nb_elements)
+        for(int line = 0; line < data_dimension; line ++, current_line += nb_elements)
         {
-          mu_element = mu(line);    
+          scalar_t mu_element = mu(line);    
           for(int column = 0; column < nb_elements; column++)
           {
-            out[column] += mu_element * current_line[column];
+            current_line[column] -= mu_element * inner_prod_results[column];
           }               
         }
-        
-      }                    
+      }
+
+      //! The compact storage types cannot be transformed explicitly.
+      template <class vector_t>
+      void deflate_lines(vector_t const &, boost::false_type)
+      {
+        assert(false);
+      }
+
+      //! Projects the data onto the orthogonal subspace of the frame, the coefficients being already computed 
+      //! (explicit transformation of the data).
+      void deflate_lines_frame(std::vector<data_t> const &frame, boost::true_type)
+      {
+        for(size_t tile = 0; tile < nb_elements; tile += block_tile_size)
+        {
+          const size_t tile_size = std::min(size_t(block_tile_size), nb_elements - tile);
+          scalar_t *current_line = p_c_matrix + tile;
+          for(size_t line = 0; line < data_dimension; line ++, current_line += nb_elements)
+          {
+            for(size_t c = 0; c < frame.size(); c++)
+            {
+              kernels_op.axpy(current_line, -frame[c](line), &v_block_inner_products[c * nb_elements + tile], tile_size);
+            }
+          }
+        }
+      }
+
+      //! The compact storage types cannot be transformed explicitly.
+      void deflate_lines_frame(std::vector<data_t> const &, boost::false_type)
+      {
+        assert(false);
+      }
 
 
     public:
@@ -212,7 +629,19 @@ namespace grassmann_averages_pca
         nb_elements(0), 
         data_dimension(0), 
         k_first_last(0),
-        p_c_matrix(0)
+        p_c_matrix(0),
+        nb_sign_flips(0),
+        signs_hash_change(0),
+        signs_hash_offset(0),
+        kernels_op(details::simd::get_kernels<scalar_t>()),
+        storage_op(details::simd::get_storage_kernels<storage_t, scalar_t>()),
+        implicit_transformations(!native_storage_t::value),
+        p_mean(0),
+        p_deflation_basis(0),
+        nb_extremal_elements(0),
+        min_stored_value(0),
+        max_stored_value(0),
+        representable_data(true)
       {
       }
 
@@ -233,6 +662,12 @@ namespace grassmann_averages_pca
         return signal_acc_dimension;
       }
       
+      //! Returns false if some values of the copied data are not represented exactly by the storage type.
+      bool has_representable_data() const
+      {
+        return representable_data;
+      }
+
       //! Sets the data range
       template <class container_iterator_t>
       bool set_data_range(container_iterator_t const &b, container_iterator_t const& e)
@@ -246,28 +681,84 @@ namespace grassmann_averages_pca
 
         assert(data_dimension > 0);
         assert(nb_elements > 0);
+
+        // the exact accumulators should not overflow (checked by batch_process)
+        assert(details::storage_conversion<storage_t>::exact_accumulation(nb_elements));
         
         delete [] p_c_matrix;
-        p_c_matrix = new scalar_t[nb_elements*data_dimension];
+        p_c_matrix = new storage_t[nb_elements*data_dimension];
         
         container_iterator_t bb(b);
         
+        representable_data = true;
         for(int column = 0; column < nb_elements; column++, ++bb)
         {
-          scalar_t* current_line = p_c_matrix + column;
+          storage_t* current_line = p_c_matrix + column;
           for(int line = 0; line < data_dimension; line ++, current_line += nb_elements)
           {         
-            *current_line = (*bb)(line);
+            if(!details::storage_conversion<storage_t>::convert((*bb)(line), *current_line))
+            {
+              representable_data = false;
+            }
           }
           
         }
+
+        if(std::numeric_limits<storage_t>::is_integer)
+        {
+          min_stored_value = static_cast<boost::int64_t>(*std::min_element(p_c_matrix, p_c_matrix + nb_elements*data_dimension));
+          max_stored_value = static_cast<boost::int64_t>(*std::max_element(p_c_matrix, p_c_matrix + nb_elements*data_dimension));
+        }
         
+        v_lines.resize(data_dimension);
+        for(size_t line = 0; line < data_dimension; line++)
+        {
+          v_lines[line] = p_c_matrix + line * nb_elements;
+        }
+
         inner_prod_results.resize(nb_elements);
+        v_signs.assign((nb_elements + 63) / 64, 0);
         
         signal_counter();
         return true;
       }
 
+      //! Sets the index of the chunk, which positions its signs in the hash of all the signs.
+      void set_chunk_index(size_t chunk)
+      {
+        signs_hash_offset = boost::uint64_t(chunk) << 40;
+      }
+
+      //! Returns the number of signs that changed during the last call to compute_data_matrix.
+      size_t get_nb_sign_flips() const
+      {
+        return nb_sign_flips;
+      }
+
+      //! Returns the smallest stored value, for the integer storage types.
+      boost::int64_t get_min_stored_value() const
+      {
+        return min_stored_value;
+      }
+
+      //! Returns the largest stored value, for the integer storage types.
+      boost::int64_t get_max_stored_value() const
+      {
+        return max_stored_value;
+      }
+
+      //! Returns the rank errors of the bounds of each dimension of the last call to approximate_trimmed_means.
+      std::vector<size_t> const& get_rank_errors() const
+      {
+        return v_rank_errors;
+      }
+
+      //! Returns the change of the hash of the signs during the last call to compute_data_matrix.
+      boost::uint64_t get_signs_hash_change() const
+      {
+        return signs_hash_change;
+      }
+
       //! Sets the dimension of the data vectors
       //! @pre data_dimensions_ is strictly positive
       void set_data_dimensions(size_t data_dimensions_)
@@ -275,6 +766,8 @@ namespace grassmann_averages_pca
         assert(data_dimensions_ > 0);
         data_dimension = data_dimensions_;
         v_accumulated_per_dimension.resize(data_dimension);
+        v_trimming_bounds.resize(data_dimension);
+        v_rank_errors.resize(data_dimension);
       }
 
       //! Sets the number of element to remove in the upper and lower distributions.
@@ -284,43 +777,51 @@ namespace grassmann_averages_pca
         k_first_last = k_first_last_;
       }
 
+      /*!@brief Sets the container of the basis vectors used for the implicit deflation.
+       *
+       * The container should not be modified while a task of this processor is running. The basis vector
+       * @c j should be appended to the container before the call to project_onto_orthogonal_subspace for this
+       * vector.
+       */
+      void set_deflation_basis(std::vector<data_t> const *p_deflation_basis_)
+      {
+        p_deflation_basis = p_deflation_basis_;
+      }
+
 
       //! Centering the data in case it was not possible to do it beforehand
       void data_centering_first_phase(size_t full_dataset_size)
       {
-        scalar_t const * current_line = p_c_matrix;
+        storage_t const * current_line = p_c_matrix;
         for(size_t dimension = 0; dimension < data_dimension; dimension++)
         {
-          scalar_t acc = 0;
+          // exact for the integer storage types
+          accumulator_t acc = 0;
           for(size_t s = 0; s < nb_elements; s++)
           {
             acc += *current_line++;
           }
 
-          // posts the new value to the listeners for the current dimension
-          accumulator_element_t &result = v_accumulated_per_dimension[dimension];
-          result.dimension = dimension;
-          result.value = acc / full_dataset_size;
-          signal_acc_dimension(&result);
+          v_accumulated_per_dimension[dimension] = scalar_t(acc) / full_dataset_size;
         }
 
+        // posts the new values to the listeners
+        signal_dimensions(0, data_dimension);
         signal_counter();
 
       }
 
       //! Project the data onto the orthogonal subspace of the provided vector
+      //! In case of implicit transformations, the mean should live until the end of the computations.
       void data_centering_second_phase(data_t const &mean_value)
       {
-        scalar_t *current_element_ptr = p_c_matrix;
-        
-        for(int line = 0; line < data_dimension; line++)
+        if(implicit_transformations)
         {
-          const scalar_t scalar = mean_value(line);   
-          scalar_t * const current_line_end = current_element_ptr + nb_elements;
-          for(; current_element_ptr < current_line_end; current_element_ptr++)
-          {
-            *current_element_ptr -= scalar;
-          }               
+          p_mean = &mean_value;
+        }
+        else
+        {
+          subtract_from_lines(mean_value, native_storage_t());
         }
 
         signal_counter();
@@ -334,22 +835,40 @@ namespace grassmann_averages_pca
                
         scalar_t const * const p_inner_product = &inner_prod_results[0];
 
+        // corrections of the implicit transformations, common to all dimensions
+        scalar_t inner_products_sum(0);
+        std::vector<scalar_t> v_coefficients_inner_products(v_deflation_coefficients.size());
+        if(implicit_transformations)
+        {
+          inner_products_sum = std::accumulate(inner_prod_results.begin(), inner_prod_results.end(), scalar_t(0));
+          for(size_t j = 0; j < v_deflation_coefficients.size(); j++)
+          {
+            v_coefficients_inner_products[j] = kernels_op.inner_product(p_inner_product, &v_deflation_coefficients[j][0], nb_elements);
+          }
+        }
+
         for(size_t dimension = 0; dimension < data_dimension; dimension++)
         {
-          scalar_t const * const current_line = p_c_matrix + dimension*nb_elements;
-          scalar_t acc = 0;
-          for(size_t s = 0; s < nb_elements; s++)
+          storage_t const * const current_line = p_c_matrix + dimension*nb_elements;
+          scalar_t acc = storage_op.inner_product(current_line, p_inner_product, nb_elements);
+
+          if(implicit_transformations)
           {
-            acc += p_inner_product[s] * current_line[s];
+            if(p_mean)
+            {
+              acc -= (*p_mean)(dimension) * inner_products_sum;
+            }
+            for(size_t j = 0; j < v_deflation_coefficients.size(); j++)
+            {
+              acc -= (*p_deflation_basis)[j](dimension) * v_coefficients_inner_products[j];
+            }
           }
 
-          // posts the new value to the listeners for the current dimension
-          accumulator_element_t &result = v_accumulated_per_dimension[dimension];
-          result.dimension = dimension;
-          result.value = acc;
-          signal_acc_dimension(&result);
+          v_accumulated_per_dimension[dimension] = acc;
         }
 
+        // posts the new values to the listeners
+        signal_dimensions(0, data_dimension);
         signal_counter();
       }
 
@@ -359,114 +878,728 @@ namespace grassmann_averages_pca
       {
         // updates the internal inner products
         compute_inner_products(mu);
+        update_signs();
+        fill_data_matrix(&v_signs[0], p_out, padding);
         
-        // the current line is spans a particular dimension
-        scalar_t *current_line = p_c_matrix;
+        // signals the main merger
+        signal_counter();
+      }
+
+      //! Computes the inner products, and keeps the sums and the extremal elements of the signed lines instead of storing
+      //! them (streaming trimming, see merge_extremal_elements).
+      void compute_extremal_elements(data_t const &mu)
+      {
+        compute_inner_products(mu);
+        update_signs();
+        fill_extremal_elements(&v_signs[0]);
 
-        // this spans the inner product results for all dimensions
+        signal_counter();
+      }
+
+      //! Computes the inner products and updates the signs only, the signed lines being histogrammed or sampled from the 
+      //! stored data (histogram trimming, see merge_histograms, or approximate trimming, see approximate_trimmed_means).
+      void compute_signs(data_t const &mu)
+      {
+        compute_inner_products(mu);
+        update_signs();
+
+        signal_counter();
+      }
 
-        std::vector<int> v_mult(nb_elements);
-        for(size_t element(0); element < nb_elements; element++)
+      //! Computes the inner products of the elements with all the vectors of a frame (block computation).
+      void block_inner_products(std::vector<data_t> const &frame)
+      {
+        compute_block_inner_products(frame);
+
+        // each dimension of each vector of the frame has its own update
+        if(v_accumulated_per_dimension.size() < frame.size() * data_dimension)
         {
-          v_mult[element] = inner_prod_results[element] >= 0 ? 1 : -1;
+          v_accumulated_per_dimension.resize(frame.size() * data_dimension);
+          v_trimming_bounds.resize(frame.size() * data_dimension);
         }
-        int const * const out = &v_mult[0];
+        signal_counter();
+      }
 
-        for(size_t current_dimension = 0; 
-            current_dimension < data_dimension; 
-            current_dimension++, current_line += nb_elements, p_out+= padding)
-        {
-          for(size_t element(0); element < nb_elements; element++)
+      //! Stores the data multiplied by the signs of its inner products with the vector @c c of the frame.
+      //! @pre block_inner_products has been called for the frame.
+      void compute_block_data_matrix(size_t c, scalar_t* p_out, size_t padding)
+      {
+        pack_signs(&v_block_inner_products[c * nb_elements], v_block_signs);
+        fill_data_matrix(&v_block_signs[0], p_out, padding);
+        signal_counter();
+      }
+
+      //! Keeps the sums and the extremal elements of the signed lines for the vector @c c of the frame (streaming trimming).
+      //! @pre block_inner_products has been called for the frame.
+      void compute_block_extremal_elements(size_t c)
+      {
+        pack_signs(&v_block_inner_products[c * nb_elements], v_block_signs);
+        fill_extremal_elements(&v_block_signs[0]);
+        signal_counter();
+      }
+
+      /*!@brief PCA steps for all the vectors of a frame.
+       *
+       * The result for the dimension @c d of the vector @c c is posted at the index @c c*data_dimension+d.
+       */
+      void block_pca_accumulation(std::vector<data_t> const &frame)
+      {
+        const size_t nb_vectors = frame.size();
+        compute_block_inner_products(frame);
+        if(v_accumulated_per_dimension.size() < nb_vectors * data_dimension)
+        {
+          v_accumulated_per_dimension.resize(nb_vectors * data_dimension);
+          v_trimming_bounds.resize(nb_vectors * data_dimension);
+        }
+
+        // corrections of the implicit transformations, common to all dimensions
+        std::vector<scalar_t> v_inner_products_sum(nb_vectors);
+        std::vector<scalar_t> v_coefficients_inner_products(nb_vectors * v_deflation_coefficients.size());
+        if(implicit_transformations)
+        {
+          for(size_t c = 0; c < nb_vectors; c++)
+          {
+            scalar_t const * const p_inner_product = &v_block_inner_products[c * nb_elements];
+            v_inner_products_sum[c] = std::accumulate(p_inner_product, p_inner_product + nb_elements, scalar_t(0));
+            for(size_t j = 0; j < v_deflation_coefficients.size(); j++)
+            {
+              v_coefficients_inner_products[c * v_deflation_coefficients.size() + j] = 
+                kernels_op.inner_product(p_inner_product, &v_deflation_coefficients[j][0], nb_elements);
+            }
+          }
+        }
+
+        for(size_t dimension = 0; dimension < data_dimension; dimension++)
+        {
+          storage_t const * const current_line = p_c_matrix + dimension*nb_elements;
+          for(size_t c = 0; c < nb_vectors; c++)
+          {
+            scalar_t acc = storage_op.inner_product(current_line, &v_block_inner_products[c * nb_elements], nb_elements);
+
+            if(implicit_transformations)
+            {
+              if(p_mean)
+              {
+                acc -= (*p_mean)(dimension) * v_inner_products_sum[c];
+              }
+              for(size_t j = 0; j < v_deflation_coefficients.size(); j++)
+              {
+                acc -= (*p_deflation_basis)[j](dimension) * v_coefficients_inner_products[c * v_deflation_coefficients.size() + j];
+              }
+            }
+
+            v_accumulated_per_dimension[c * data_dimension + dimension] = acc;
+          }
+        }
+
+        signal_dimensions(0, nb_vectors * data_dimension);
+        signal_counter();
+      }
+
+      /*!@brief Projects the data onto the orthogonal subspace of all the vectors of a frame, in one sweep over the data.
+       *
+       * The vectors are applied sequentially, as successive calls to project_onto_orthogonal_subspace would do.
+       */
+      void project_onto_orthogonal_frame(std::vector<data_t> const &frame)
+      {
+        const size_t nb_vectors = frame.size();
+        compute_block_inner_products(frame);
+
+        // coefficients on the vector c, corrected by the coefficients on the previous vectors of the frame
+        for(size_t c = 0; c < nb_vectors; c++)
+        {
+          for(size_t c2 = 0; c2 < c; c2++)
+          {
+            const scalar_t gram = kernels_op.inner_product(&frame[c2].data()[0], &frame[c].data()[0], data_dimension);
+            kernels_op.axpy(&v_block_inner_products[c * nb_elements], -gram, &v_block_inner_products[c2 * nb_elements], nb_elements);
+          }
+        }
+
+        if(implicit_transformations)
+        {
+          assert(p_deflation_basis && p_deflation_basis->size() >= v_deflation_coefficients.size() + nb_vectors);
+          for(size_t c = 0; c < nb_vectors; c++)
+          {
+            v_deflation_coefficients.push_back(
+              std::vector<scalar_t>(v_block_inner_products.begin() + c * nb_elements, v_block_inner_products.begin() + (c + 1) * nb_elements));
+          }
+        }
+        else
+        {
+          deflate_lines_frame(frame, native_storage_t());
+        }
+
+        signal_counter();
+      }
+      
+      /*!@brief Computes the mean on the subset of the data where the k first and last elements are removed, for a range 
+       *        of dimensions.
+       *
+       * The signed lines of the dimensions are consecutive in @c p_data, each of @c nb_total_elements elements, and their 
+       * results are posted at the indices starting at @c first_result_index. The bounds of the trimmed elements of the 
+       * previous call for the same result index are used as pivots if at most @c max_changes elements changed since then 
+       * (see details::compute_mean_within_bounds_warm_start).
+       */
+      void compute_bounded_accumulation(
+        size_t first_result_index, 
+        size_t nb_dimensions, 
+        size_t nb_total_elements, 
+        size_t max_changes, 
+        scalar_t* p_data)
+      {
+        for(size_t i = 0; i < nb_dimensions; i++, p_data += nb_total_elements)
+        {
+          v_accumulated_per_dimension[first_result_index + i] = details::compute_mean_within_bounds_warm_start(
+            p_data, nb_total_elements, k_first_last, max_changes, v_trimming_bounds[first_result_index + i]);
+        }
+
+        // signals the update
+        signal_dimensions(first_result_index, nb_dimensions);
+        // signals the main merger
+        signal_counter();
+      }
+      
+      /*!@brief Computes the trimmed means of a range of dimensions from the sums and the extremal elements of the signed 
+       *        lines of all the chunks (streaming trimming).
+       *
+       * The k largest and smallest elements of the signed dimension over the full dataset are among the extremal elements kept 
+       * by the chunks, and are subtracted from the sum of the dimension. The results of the dimensions starting at 
+       * @c first_dimension are posted at the indices starting at @c first_result_index.
+       *
+       * @pre @c compute_extremal_elements or @c compute_block_extremal_elements has been called on all the processors, and 
+       *      @f$2k < \text{nb_total_elements}@f$.
+       */
+      void merge_extremal_elements(
+        size_t first_dimension, 
+        size_t first_result_index, 
+        size_t nb_dimensions,
+        std::vector<s_grassmann_averages_trimmed_processor_inner_products> const *p_processors,
+        size_t nb_total_elements)
+      {
+        assert(2*k_first_last < nb_total_elements);
+
+        std::vector<scalar_t> v_largest, v_smallest;
+        v_largest.reserve(p_processors->size() * k_first_last);
+        v_smallest.reserve(p_processors->size() * k_first_last);
+        for(size_t dimension = first_dimension; dimension < first_dimension + nb_dimensions; dimension++)
+        {
+          scalar_t acc(0);
+          v_largest.clear();
+          v_smallest.clear();
+          for(size_t i = 0; i < p_processors->size(); i++)
+          {
+            s_grassmann_averages_trimmed_processor_inner_products const &current = (*p_processors)[i];
+            const size_t nb_kept = current.nb_extremal_elements;
+            acc += current.v_lines_sums[dimension];
+            v_largest.insert(
+              v_largest.end(), 
+              current.v_largest_elements.begin() + dimension * nb_kept, 
+              current.v_largest_elements.begin() + (dimension + 1) * nb_kept);
+            v_smallest.insert(
+              v_smallest.end(), 
+              current.v_smallest_elements.begin() + dimension * nb_kept, 
+              current.v_smallest_elements.begin() + (dimension + 1) * nb_kept);
+          }
+
+          if(k_first_last > 0)
+          {
+            acc -= details::sum_of_extremal_elements(&v_largest[0], v_largest.size(), k_first_last, std::greater<scalar_t>());
+            acc -= details::sum_of_extremal_elements(&v_smallest[0], v_smallest.size(), k_first_last, std::less<scalar_t>());
+          }
+
+          v_accumulated_per_dimension[first_result_index + dimension - first_dimension] = acc / (nb_total_elements - 2*k_first_last);
+        }
+
+        // signals the update
+        signal_dimensions(first_result_index, nb_dimensions);
+        // signals the main merger
+        signal_counter();
+      }
+      
+      /*!@brief Computes the trimmed means of a range of dimensions from the histograms of the stored integer values of all 
+       *        the chunks, split by the signs of the last call to @c compute_signs (histogram trimming).
+       *
+       * The signed elements are @f$\pm(x - m)@f$ where @f$x@f$ is a stored value in 
+       * @f$[\text{min_value}, \text{min_value} + \text{nb_bins})@f$ and @f$m@f$ the mean of the dimension, which makes the 
+       * trimmed mean exact without any selection (see details::compute_mean_within_bounds_histogram).
+       *
+       * @pre the data is not deflated (implicitly or explicitly), and @c compute_signs has been called on all the processors.
+       */
+      void merge_histograms(
+        size_t first_dimension, 
+        size_t nb_dimensions,
+        std::vector<s_grassmann_averages_trimmed_processor_inner_products> const *p_processors,
+        boost::int64_t min_value,
+        size_t nb_bins)
+      {
+        assert(std::numeric_limits<storage_t>::is_integer && v_deflation_coefficients.empty());
+
+        // the negative elements are counted in the second half
+        std::vector<size_t> v_counts(2 * nb_bins);
+        size_t * const p_counts = &v_counts[0];
+        for(size_t dimension = first_dimension; dimension < first_dimension + nb_dimensions; dimension++)
+        {
+          std::fill(v_counts.begin(), v_counts.end(), size_t(0));
+          for(size_t i = 0; i < p_processors->size(); i++)
+          {
+            s_grassmann_averages_trimmed_processor_inner_products const &current = (*p_processors)[i];
+            storage_t const * const current_line = current.p_c_matrix + dimension * current.nb_elements;
+            boost::uint64_t const * const p_signs = &current.v_signs[0];
+            for(size_t element = 0; element < current.nb_elements; element++)
+            {
+              const size_t negative = 1 - static_cast<size_t>((p_signs[element / 64] >> (element % 64)) & 1);
+              p_counts[negative * nb_bins + static_cast<size_t>(static_cast<boost::int64_t>(current_line[element]) - min_value)]++;
+            }
+          }
+
+          v_accumulated_per_dimension[dimension] = details::compute_mean_within_bounds_histogram(
+            p_counts, 
+            p_counts + nb_bins, 
+            nb_bins, 
+            min_value, 
+            p_mean ? (*p_mean)(dimension) : scalar_t(0), 
+            k_first_last);
+        }
+
+        // signals the update
+        signal_dimensions(first_dimension, nb_dimensions);
+        // signals the main merger
+        signal_counter();
+      }
+      
+      /*!@brief Computes approximate trimmed means of a range of dimensions from the stored data of all the chunks, with
+       *        the signs of the last call to @c compute_signs (approximate trimming).
+       *
+       * The chunks are sampled at the same rate of one element every @c sample_stride, and the bounds of the kept elements 
+       * of each dimension are estimated from the merged samples (see details::estimate_trimming_bounds). The signed lines of 
+       * the chunks are then computed one after the other and accumulated between the bounds in a single pass (see 
+       * details::bounded_accumulation). The rank error of the bounds of each dimension is stored (see get_rank_errors).
+       *
+       * @pre @c compute_signs has been called on all the processors.
+       */
+      void approximate_trimmed_means(
+        size_t first_dimension, 
+        size_t nb_dimensions,
+        std::vector<s_grassmann_averages_trimmed_processor_inner_products> const *p_processors,
+        size_t nb_total_elements,
+        size_t sample_stride)
+      {
+        assert(sample_stride > 0);
+
+        std::vector<scalar_t> v_sample, v_line, v_tile;
+        v_sample.reserve(nb_total_elements / sample_stride + p_processors->size());
+        for(size_t dimension = first_dimension; dimension < first_dimension + nb_dimensions; dimension++)
+        {
+          v_sample.clear();
+          for(size_t i = 0; i < p_processors->size(); i++)
+          {
+            (*p_processors)[i].sample_signed_line(dimension, sample_stride, v_sample);
+          }
+
+          scalar_t low, high;
+          details::estimate_trimming_bounds(
+            v_sample.empty() ? 0 : &v_sample[0], v_sample.size(), nb_total_elements, k_first_last, low, high);
+
+          details::bounded_accumulation<scalar_t> accumulation(low, high);
+          for(size_t i = 0; i < p_processors->size(); i++)
+          {
+            s_grassmann_averages_trimmed_processor_inner_products const &current = (*p_processors)[i];
+            v_line.resize(current.nb_elements);
+            current.fill_signed_line(dimension, &current.v_signs[0], &v_line[0], false, v_tile);
+            accumulation.add(&v_line[0], current.nb_elements);
+          }
+
+          v_accumulated_per_dimension[dimension] = accumulation.mean(k_first_last);
+          v_rank_errors[dimension] = accumulation.rank_error(k_first_last);
+        }
+
+        // signals the update
+        signal_dimensions(first_dimension, nb_dimensions);
+        // signals the main merger
+        signal_counter();
+      }
+      
+      //! Project the data onto the orthogonal subspace of the provided vector
+      //! In case of implicit deflation, only the coefficients of the elements on the vector are stored.
+	    template <class vector_t>
+      void project_onto_orthogonal_subspace(vector_t const &mu)
+      {
+        compute_inner_products(mu);
+
+        if(implicit_transformations)
+        {
+          assert(p_deflation_basis && p_deflation_basis->size() > v_deflation_coefficients.size());
+          v_deflation_coefficients.push_back(inner_prod_results);
+        }
+        else
+        {
+          deflate_lines(mu, native_storage_t());
+        }
+
+        signal_counter();
+      }
+
+    };
+
+
+    /*!@internal
+     * @brief Merges the result of all workers and signals the results to the main thread.
+     *
+     * The purpose of this class is to add the computed accumulator of each thread to the final result
+     * which contains the sum of all accumulators. 
+     *
+     */
+    struct asynchronous_results_merger : 
+      details::threading::asynchronous_results_merger<
+        data_t,
+        details::merger_update_dimension_range<data_t>,
+        details::threading::initialisation_vector_specific_dimension<data_t>,
+        details::s_dimension_range_update<typename data_t::value_type>
+      >
+    {
+    public:
+      typedef data_t result_t;
+
+    private:
+      typedef details::threading::initialisation_vector_specific_dimension<data_t> data_init_type;
+      typedef details::merger_update_dimension_range<data_t> merger_type;
+
+
+      const size_t data_dimension;
+      
+    public:
+      typedef details::threading::asynchronous_results_merger<
+        result_t,
+        merger_type, 
+        data_init_type,
+        details::s_dimension_range_update<typename data_t::value_type>
+      > parent_type;
+      typedef typename parent_type::lock_t lock_t;
+
+      /*!Constructor
+       *
+       * @param dimension_ the number of dimensions of the vector to accumulate
+       */
+      asynchronous_results_merger(size_t data_dimension_) : 
+        parent_type(data_init_type(data_dimension_)),
+        data_dimension(data_dimension_)
+      {}
+
+    };
+
+    //! Type of the processors of the chunks.
+    typedef s_grassmann_averages_trimmed_processor_inner_products async_processor_t;
+
+    //! Maximal number of dimensions of the tasks of the trimmed averages (the results of a task fit in the L1 cache).
+    static const size_t max_dimensions_per_range = 1024;
+
+    //! Number of consecutive dimensions computed by each task of the trimmed averages, such that each worker receives
+    //! several tasks.
+    static size_t get_dimensions_per_range(size_t number_of_dimensions, size_t nb_threads)
+    {
+      return std::max<size_t>(1, std::min<size_t>(size_t(max_dimensions_per_range), number_of_dimensions / (4 * std::max<size_t>(1, nb_threads))));
+    }
+
+    //!@internal
+    //! Operations of the calling thread on the vectors of the dimension of the data, run by ranges on the pool.
+    typedef details::threading::dimension_ranges_operations<data_t> ranges_operations_t;
+
+    //!@internal
+    //! Norm of mu computed by ranges on the pool, for the @f$\ell_2@f$ norm. The trimmed averages are merged
+    //! by ranges of dimensions without a reduction step, so the norm is not fused with the merge.
+    double vector_norm(ranges_operations_t &ranges_op, data_t const &v, boost::true_type) const
+    {
+      return std::sqrt(ranges_op.squared_norm(v));
+    }
+
+    double vector_norm(ranges_operations_t &, data_t const &v, boost::false_type) const
+    {
+      return norm_op(v);
+    }
+
+    double vector_norm(ranges_operations_t &ranges_op, data_t const &v) const
+    {
+      return vector_norm(ranges_op, v, boost::is_same<norm_mu_t, details::norm2>());
+    }
+
+    /*!@internal
+     * @brief Extracts the frame from the concatenated accumulations, and orthonormalises it (thin QR by Gram-Schmidt).
+     *
+     * @returns false if one of the accumulations is null.
+     */
+    bool orthonormalise_frame(data_t const &accumulations, std::vector<data_t> &frame, size_t first_index)
+    {
+      const size_t number_of_dimensions = frame[0].size();
+      for(size_t c = 0; c < frame.size(); c++)
+      {
+        std::copy(accumulations.begin() + c * number_of_dimensions, accumulations.begin() + (c + 1) * number_of_dimensions, frame[c].begin());
+        for(size_t c2 = 0; c2 < c; c2++)
+        {
+          frame[c] -= boost::numeric::ublas::inner_prod(frame[c], frame[c2]) * frame[c2];
+        }
+
+        double norm_mu = norm_op(frame[c]);
+        if(norm_mu < 1E-12)
+        {
+          if(observer)
+          {
+            std::ostringstream o;
+            o << "The result of the accumulation is null for subspace " << first_index + c;
+            observer->log_error_message(o.str().c_str());
+          }
+          return false;
+        }
+        frame[c] *= typename data_t::value_type(1./norm_mu);
+      }
+      return true;
+    }
+
+    /*!@internal
+     * @brief Computes the basis vectors by blocks of block_size vectors (see set_block_size).
+     *
+     * The output basis vectors contain the orthonormalised initial guesses. The trimmed averages of the vectors of 
+     * a frame are computed one after the other in @c matrix_temp, or from the extremal elements of the chunks if 
+     * @c matrix_temp is null (streaming trimming).
+     */
+    template <class it_o_basisvectors_t>
+    bool process_blocks(
+      const size_t max_iterations,
+      const size_t max_dimension_to_compute,
+      const size_t number_of_dimensions,
+      const size_t size_data,
+      const size_t chunks_size,
+      details::threading::numa_thread_pool &pool,
+      std::vector<async_processor_t> &v_individual_accumulators,
+      std::vector<data_t> &deflation_basis,
+      scalar_t *matrix_temp,
+      it_o_basisvectors_t const it_output_basis_vector_beginning,
+      it_o_basisvectors_t const it_output_basis_vector_end)
+    {
+      const size_t nb_chunks = v_individual_accumulators.size();
+      const size_t dimensions_per_range = get_dimensions_per_range(number_of_dimensions, pool.nb_threads());
+      it_o_basisvectors_t it_basisvectors(it_output_basis_vector_beginning);
+
+      for(size_t first_index = 0; first_index < max_dimension_to_compute; first_index += block_size)
+      {
+        const size_t nb_vectors = std::min(block_size, max_dimension_to_compute - first_index);
+
+        // the workers poll their queue during the iterations of the block
+        details::threading::hot_workers_scope hot_workers(pool);
+
+        // the trimmed averages of all the vectors of the frame are merged together
+        asynchronous_results_merger async_merger(nb_vectors * number_of_dimensions);
+        async_merger.init_notifications();
+        for(int i = 0; i < nb_chunks; i++)
+        {
+          v_individual_accumulators[i].connector_accumulator() = boost::bind(&asynchronous_results_merger::update, &async_merger, _1);
+          v_individual_accumulators[i].connector_counter() = boost::bind(&asynchronous_results_merger::notify, &async_merger);
+        }
+
+        std::vector<data_t> frame(nb_vectors);
+        {
+          it_o_basisvectors_t it_frame(it_basisvectors);
+          for(size_t c = 0; c < nb_vectors; c++, ++it_frame)
+          {
+            frame[c] = *it_frame;
+          }
+        }
+
+
+        // PCA like initial steps
+        for(size_t pca_it = 0; pca_it < nb_steps_pca; pca_it++)
+        {
+          async_merger.init();
+          for(int i = 0; i < nb_chunks; i++)
+          {
+            pool.post(pool.node_of_chunk(i, v_individual_accumulators.size()),
+              boost::bind(
+                &async_processor_t::block_pca_accumulation, 
+                boost::ref(v_individual_accumulators[i]), 
+                boost::cref(frame)));
+          }
+          async_merger.wait_notifications(nb_chunks);
+
+          if(!orthonormalise_frame(async_merger.get_merged_result(), frame, first_index))
+          {
+            return false;
+          }
+        }
+
+        if(nb_steps_pca && observer)
+        {
+          for(size_t c = 0; c < nb_vectors; c++)
+          {
+            observer->signal_pca(frame[c], first_index + c);
+          }
+        }
+
+
+        std::vector< details::convergence_check<data_t> > v_convergence_op;
+        for(size_t c = 0; c < nb_vectors; c++)
+        {
+          v_convergence_op.push_back(details::convergence_check<data_t>(frame[c]));
+        }
+
+        for(size_t iterations = 0; iterations < max_iterations; iterations++)
+        {
+          // the frame has converged when all its vectors have converged
+          bool converged = iterations > 0;
+          for(size_t c = 0; c < nb_vectors; c++)
+          {
+            converged = v_convergence_op[c](frame[c]) && converged;
+          }
+          if(converged)
+          {
+            break;
+          }
+
+          // inner products with all the vectors of the frame, in one sweep
+          async_merger.init();
+          for(int i = 0; i < nb_chunks; i++)
+          {
+            pool.post(pool.node_of_chunk(i, v_individual_accumulators.size()),
+              boost::bind(
+                &async_processor_t::block_inner_products, 
+                boost::ref(v_individual_accumulators[i]), 
+                boost::cref(frame)));
+          }
+          async_merger.wait_notifications(nb_chunks);
+
+          // trimmed averages, one vector of the frame at a time
+          for(size_t c = 0; c < nb_vectors; c++)
+          {
+            async_merger.init_notifications();
+            for(int i = 0; i < nb_chunks; i++)
+            {
+              if(!matrix_temp)
+              {
+                pool.post(pool.node_of_chunk(i, v_individual_accumulators.size()),
+                  boost::bind(
+                    &async_processor_t::compute_block_extremal_elements, 
+                    boost::ref(v_individual_accumulators[i]), 
+                    c));
+              }
+              else
+              {
+                pool.post(pool.node_of_chunk(i, v_individual_accumulators.size()),
+                  boost::bind(
+                    &async_processor_t::compute_block_data_matrix, 
+                    boost::ref(v_individual_accumulators[i]), 
+                    c,
+                    matrix_temp + i*chunks_size,
+                    size_data));
+              }
+            }
+            async_merger.wait_notifications(nb_chunks);
+
+            async_merger.init_notifications();
+            size_t nb_ranges = 0;
+            for(size_t first_dimension = 0; first_dimension < number_of_dimensions; first_dimension += dimensions_per_range, nb_ranges++)
+            {
+              const size_t nb_dimensions = std::min(dimensions_per_range, number_of_dimensions - first_dimension);
+              if(!matrix_temp)
+              {
+                pool.post(nb_ranges % pool.nb_nodes(),
+                  boost::bind(
+                    &async_processor_t::merge_extremal_elements, 
+                    boost::ref(v_individual_accumulators[0]), 
+                    first_dimension,
+                    c * number_of_dimensions + first_dimension,
+                    nb_dimensions,
+                    &v_individual_accumulators,
+                    size_data));
+              }
+              else
+              {
+                pool.post(nb_ranges % pool.nb_nodes(),
+                  boost::bind(
+                    &async_processor_t::compute_bounded_accumulation, 
+                    boost::ref(v_individual_accumulators[0]), 
+                    c * number_of_dimensions + first_dimension,
+                    nb_dimensions,
+                    size_data,
+                    size_data, // the sign flips are not counted per vector of the frame
+                    matrix_temp + first_dimension*size_data));
+              }
+            }
+            async_merger.wait_notifications(nb_ranges);
+          }
+
+          if(!orthonormalise_frame(async_merger.get_merged_result(), frame, first_index))
+          {
+            return false;
+          }
+
+          if(observer)
+          {
+            for(size_t c = 0; c < nb_vectors; c++)
+            {
+              observer->signal_intermediate_result(frame[c], first_index + c, iterations);
+            }
+          }
+        }
+
+
+        // orthogonalisation against previous basis vectors
+        if(!deflation_basis.empty())
+        {
+          data_t concatenated_frame(nb_vectors * number_of_dimensions);
+          for(size_t c = 0; c < nb_vectors; c++)
+          {
+            for(size_t j = 0; j < deflation_basis.size(); j++)
+            {
+              frame[c] -= boost::numeric::ublas::inner_prod(frame[c], deflation_basis[j]) * deflation_basis[j];
+            }
+            std::copy(frame[c].begin(), frame[c].end(), concatenated_frame.begin() + c * number_of_dimensions);
+          }
+          if(!orthonormalise_frame(concatenated_frame, frame, first_index))
           {
-            p_out[element] = out[element] * current_line[element];
+            return false;
           }
         }
-        
-        // signals the main merger
-        signal_counter();
-      }
-      
-      //! Computes the mean on the subset of the data where the k first and last elements are removed.
-      void compute_bounded_accumulation(size_t dimension, size_t nb_total_elements, scalar_t* p_data)
-      {
-        accumulator_element_t &result = v_accumulated_per_dimension[dimension];
-        result.dimension = dimension;
-        result.value = details::compute_mean_within_bounds(p_data, nb_total_elements, k_first_last);
 
-        // signals the update
-        signal_acc_dimension(&result);
-        // signals the main merger
-        signal_counter();
-      }
-      
-      //! Project the data onto the orthogonal subspace of the provided vector
-	    template <class vector_t>
-      void project_onto_orthogonal_subspace(vector_t const &mu)
-      {
-        compute_inner_products(mu);
-        scalar_t *current_line = p_c_matrix;
-        
-        for(int line = 0; line < data_dimension; line ++, current_line += nb_elements)
+
+        // the frame contains the basis vectors of the current block
+        for(size_t c = 0; c < nb_vectors; c++, ++it_basisvectors)
         {
-          scalar_t mu_element = mu(line);    
-          for(int column = 0; column < nb_elements; column++)
+          *it_basisvectors = frame[c];
+          if(observer)
           {
-            current_line[column] -= mu_element * inner_prod_results[column];
-          }               
+            observer->signal_eigenvector(*it_basisvectors, first_index + c);
+          }
         }
 
-        signal_counter();
-      }
-
-    };
-
-
-    /*!@internal
-     * @brief Merges the result of all workers and signals the results to the main thread.
-     *
-     * The purpose of this class is to add the computed accumulator of each thread to the final result
-     * which contains the sum of all accumulators. 
-     *
-     */
-    struct asynchronous_results_merger : 
-      details::threading::asynchronous_results_merger<
-        data_t,
-        details::merger_update_specific_dimension<data_t>,
-        details::threading::initialisation_vector_specific_dimension<data_t>,
-        details::s_dimension_update<typename data_t::value_type>
-      >
-    {
-    public:
-      typedef data_t result_t;
-
-    private:
-      typedef details::threading::initialisation_vector_specific_dimension<data_t> data_init_type;
-      typedef details::merger_update_specific_dimension<data_t> merger_type;
-
+        // projection onto the orthogonal subspace of the frame
+        if(first_index + nb_vectors < max_dimension_to_compute)
+        {
+          async_merger.init_notifications();
 
-      const size_t data_dimension;
-      
-    public:
-      typedef details::threading::asynchronous_results_merger<
-        result_t,
-        merger_type, 
-        data_init_type,
-        details::s_dimension_update<typename data_t::value_type>
-      > parent_type;
-      typedef typename parent_type::lock_t lock_t;
+          // the basis vectors should be available to the processors in case of implicit deflation
+          deflation_basis.insert(deflation_basis.end(), frame.begin(), frame.end());
 
-      /*!Constructor
-       *
-       * @param dimension_ the number of dimensions of the vector to accumulate
-       */
-      asynchronous_results_merger(size_t data_dimension_) : 
-        parent_type(data_init_type(data_dimension_)),
-        data_dimension(data_dimension_)
-      {}
+          for(int i = 0; i < nb_chunks; i++)
+          {
+            pool.post(pool.node_of_chunk(i, v_individual_accumulators.size()),
+              boost::bind(
+                &async_processor_t::project_onto_orthogonal_frame, 
+                boost::ref(v_individual_accumulators[i]), 
+                boost::cref(frame)));
+          }
 
-    };
+          // the initial guesses of the next frames are orthonormalised against the computed basis vectors
+          const bool orthonormalised = details::gram_schmidt_orthonormalisation(it_output_basis_vector_beginning, it_output_basis_vector_end, it_basisvectors, norm_op);
 
+          // the workers should be done with the processors before returning, even on failure
+          async_merger.wait_notifications(nb_chunks);
+          if(!orthonormalised)
+          {
+            return false;
+          }
+        }
+      }
 
+      return true;
+    }
 
 
 
@@ -487,6 +1620,14 @@ namespace grassmann_averages_pca
       max_chunk_size(std::numeric_limits<size_t>::max()),
       nb_steps_pca(3),
       need_centering(false),
+      block_size(1),
+      numa_placement(true),
+      sign_flips_fraction(-1),
+      cycle_detection(false),
+      streaming_trimming(true),
+      max_histogram_bins(4096),
+      approximate_trimming_sample_size(0),
+      p_thread_pool(0),
       observer(0)
     {
       assert(trimming_percentage_ >= 0 && trimming_percentage_ <= 1);
@@ -544,6 +1685,155 @@ namespace grassmann_averages_pca
       return true;
     }
 
+    /*!@brief Sets the pool of workers used by the computations.
+     *
+     * The lifetime of the pool is not managed by this class, and the pool should outlive the calls to batch_process. 
+     * The number of chunks is still given by set_nb_processors and set_max_chunk_size, and the NUMA placement
+     * is the one of the pool. Set to 0 to create a pool for each computation (default).
+     */
+    bool set_thread_pool(thread_pool *p_thread_pool_)
+    {
+      p_thread_pool = p_thread_pool_;
+      return true;
+    }
+
+    /*!@brief Sets the placement of the workers and of the data on the NUMA nodes (true by default).
+     *
+     * If set to true, the workers are distributed over the NUMA nodes and pinned to the CPUs of their node. Each chunk
+     * is copied, and its inner products and signed copies are computed, by the workers of its node. The trimmed averages of the 
+     * dimensions are distributed over all the nodes. This has no effect on the systems with only one node.
+     */
+    bool set_numa_placement(bool numa_placement_)
+    {
+      numa_placement = numa_placement_;
+      return true;
+    }
+
+    /*!@brief Sets the number of basis vectors computed together.
+     *
+     * If greater than 1, the basis vectors are computed by blocks: an orthonormal frame of @c block_size_ vectors is 
+     * iterated at once and orthonormalised (thin QR) after each iteration. The inner products of the data with all the vectors 
+     * of the frame are computed in one sweep over the data, the trimmed averages are then computed for each vector of the frame.
+     * The first vector of each frame follows the regular algorithm, the following ones are constrained to the orthogonal 
+     * subspace of the previous ones during the iterations.
+     */
+    bool set_block_size(size_t block_size_)
+    {
+      if(block_size_ == 0)
+      {
+        return false;
+      }
+      block_size = block_size_;
+      return true;
+    }
+
+    /*!@brief Stops the iterations when the number of sign flips is below a fraction of the number of vectors.
+     *
+     * The trimmed averages of an iteration depend only on the signs of the inner products of the vectors with the current 
+     * @f$\mu@f$. When the signs did not change since the previous iteration, the iterations stop before computing the trimmed 
+     * averages, which would give the same @f$\mu@f$. Otherwise, on a stop, the trimmed averages of the current signs are 
+     * computed before stopping. A fraction of 0 stops on zero flip only, a positive fraction trades some accuracy for fewer 
+     * iterations, a negative fraction disables the criterion (default). The usual check on the changes of @f$\mu@f$ 
+     * applies in all cases. This has no effect on the block computations.
+     */
+    bool set_sign_flips_convergence(double max_flips_fraction)
+    {
+      if(max_flips_fraction >= 1)
+      {
+        return false;
+      }
+      sign_flips_fraction = max_flips_fraction;
+      return true;
+    }
+
+    /*!@brief Stops the iterations when the signs of the inner products repeat a previous pattern (false by default).
+     *
+     * A repeated pattern of signs means that the iterations are periodic and would run until the maximum number of
+     * iterations without converging. The patterns are compared by a hash of the signs, and the trimmed averages of the 
+     * repeated signs are computed before stopping. This has no effect on the block computations.
+     */
+    bool set_cycle_detection(bool cycle_detection_)
+    {
+      cycle_detection = cycle_detection_;
+      return true;
+    }
+
+    /*!@brief Computes the trimmed averages without a signed copy of the data when the trimming is small (true by default).
+     *
+     * In the streaming mode, each chunk keeps, for each dimension, the sum of its signed elements and its @c K largest and 
+     * smallest signed elements in two bounded heaps, where @c K is the number of elements trimmed on each side. The extremal 
+     * elements of the chunks are then merged for each dimension, which gives the exact trimmed averages. This mode is 
+     * used when the extremal elements of all the chunks take less than half the size of the data, otherwise a signed 
+     * copy of the data of size @c D*N is allocated for the computation of the trimmed averages.
+     */
+    bool set_streaming_trimming(bool streaming_trimming_)
+    {
+      streaming_trimming = streaming_trimming_;
+      return true;
+    }
+
+    /*!@brief Computes the trimmed averages from the histograms of the stored values, for the integer storage types 
+     *        (at most 4096 different values by default).
+     *
+     * When the data is stored with an integer type (for instance @c boost::uint8_t for the pixels of videos) and the 
+     * stored values span at most @c max_bins different values, the signed elements of each dimension take at most 
+     * @c 2*max_bins different values, even after the centering. The trimmed average of a dimension is then computed 
+     * exactly from the histogram of the signed elements of all the chunks, without any selection and without a signed 
+     * copy of the data. Set @c max_bins to 0 to disable the histograms.
+     *
+     * @note This applies to the first basis vector only: the elements are not integer anymore after the deflation. The
+     * trimmed averages of the next basis vectors are computed as if the histograms were disabled, from the signed copy of
+     * the data or with the streaming or the approximate trimming when those are enabled, and the signed copy of the data 
+     * is then allocated as soon as more than one basis vector is computed.
+     */
+    bool set_histogram_trimming(size_t max_bins)
+    {
+      max_histogram_bins = max_bins;
+      return true;
+    }
+
+    /*!@brief Computes approximate trimmed averages from the bounds estimated on a sample of the data (disabled by default).
+     *
+     * In the approximate mode, the bounds of the elements kept by the trimmed average of each dimension are estimated
+     * from a uniform sample of about @c sample_size signed elements, taken at the same rate in each chunk: the samples of 
+     * the chunks are merged into a sample of the full dataset. The elements between the estimated bounds are then 
+     * averaged in a single pass over the stored data, which replaces the selection of the exact bounds and does not need 
+     * a signed copy of the data. The same pass counts the elements on each side of the estimated bounds, which gives the 
+     * exact rank error of the bounds (see get_trimming_rank_errors). The expected rank error is of the order of
+     * @f$N / \sqrt{\text{sample_size}}@f$ for @f$N@f$ elements. When the rank error is null, the ties at the bounds are 
+     * trimmed as in the exact trimmed averages, which are then obtained (eg. with a sample of all the elements).
+     *
+     * The histogram trimming, which is exact, is used instead when it applies (see set_histogram_trimming). This has no 
+     * effect on the block computations. Set @c sample_size to 0 for the exact trimmed averages (default).
+     */
+    bool set_approximate_trimming(size_t sample_size)
+    {
+      approximate_trimming_sample_size = sample_size;
+      return true;
+    }
+
+    /*!@brief Returns the rank errors of the approximate trimmed averages of the last call to batch_process.
+     *
+     * The element @c k of the returned vector contains, for the basis vector @c k and for each iteration computing approximate
+     * trimmed averages, the largest rank error of the estimated bounds over all the dimensions: the number of elements 
+     * by which the trimming of a side of a dimension differs from the exact trimming. The vectors are empty if the 
+     * approximate trimming is disabled (see set_approximate_trimming).
+     */
+    std::vector< std::vector<size_t> > const& get_trimming_rank_errors() const
+    {
+      return v_trimming_rank_errors;
+    }
+
+    /*!@brief Returns the number of sign flips of each iteration of the last call to batch_process.
+     *
+     * The element @c k of the returned vector contains, for the basis vector @c k, the number of input vectors for which
+     * the sign of the inner product with @f$\mu@f$ changed, for each iteration following the initial one.
+     */
+    std::vector< std::vector<size_t> > const& get_sign_flips_statistics() const
+    {
+      return v_sign_flips;
+    }
+
     
     
 
@@ -585,20 +1875,9 @@ namespace grassmann_averages_pca
 
       // preparing the thread pool, to avoid individual thread creation/deletion at each step.
       // we perform the init here because it might take some time for the thread to really start.
-      boost::asio::io_service ioService;
-      boost::thread_group threadpool;
-
-
-      // in case of non clean exit (or even in case of clean one).
-      details::threading::safe_stop worker_lock_guard(ioService, threadpool);
-
-
-      // this is exactly the number of processors
-      boost::asio::io_service::work work(ioService);
-      for(int i = 0; i < nb_processors; i++)
-      {
-        threadpool.create_thread(boost::bind(&boost::asio::io_service::run, &ioService));
-      }
+      // The workers are stopped in case of non clean exit (or even in case of clean one).
+      details::threading::thread_pool_holder pool_holder(p_thread_pool, nb_processors, numa_placement);
+      details::threading::numa_thread_pool &pool = pool_holder.get();
 
 
       // contains the number of elements. In case the iterator is random access, could be deduced simply 
@@ -610,9 +1889,24 @@ namespace grassmann_averages_pca
       const size_t nb_chunks = (size_data + chunks_size - 1) / chunks_size;
 
 
+      // the sums of the rows of a chunk should not overflow the exact accumulators of the compact storage types
+      if(!details::storage_conversion<storage_t>::exact_accumulation(chunks_size))
+      {
+        if(observer)
+        {
+          std::ostringstream o;
+          o << "The sums of the chunks of " << chunks_size << " rows may overflow the accumulators of the storage type";
+          observer->log_error_message(o.str().c_str());
+        }
+        return false;
+      }
+
+
       // number of dimensions of the data vectors
       const size_t number_of_dimensions = it->size();
       max_dimension_to_compute = std::min(max_dimension_to_compute, number_of_dimensions);
+      v_sign_flips.assign(max_dimension_to_compute, std::vector<size_t>());
+      v_trimming_rank_errors.assign(max_dimension_to_compute, std::vector<size_t>());
 
 
       // initial iterator on the output basis vectors
@@ -620,12 +1914,25 @@ namespace grassmann_averages_pca
       it_o_basisvectors_t it_output_basis_vector_end(it_output_basis_vector_beginning);
       std::advance(it_output_basis_vector_end, max_dimension_to_compute);
 
+      // vector operations of the main thread
+      ranges_operations_t ranges_op(pool, number_of_dimensions);
+      const double convergence_epsilon = details::convergence_check<data_t>::default_epsilon();
+
       // the initialisation of mus
       {
         it_o_basisvectors_t it_basis(it_output_basis_vector_beginning);
         for(int i = 0; it_basis != it_output_basis_vector_end; ++it_basis, ++i)
         {
-          *it_basis = initial_guess != 0 ? (*initial_guess)[i] : random_init_op(*it);
+          if(initial_guess != 0)
+          {
+            *it_basis = (*initial_guess)[i];
+          }
+          else
+          {
+            data_t guess(number_of_dimensions);
+            ranges_op.random_vector(random_init_op, guess);
+            *it_basis = guess;
+          }
         }
       }
       if(!details::gram_schmidt_orthonormalisation(it_output_basis_vector_beginning, it_output_basis_vector_end, it_output_basis_vector_beginning, norm_op))
@@ -653,6 +1960,11 @@ namespace grassmann_averages_pca
 
       asynchronous_results_merger async_merger(number_of_dimensions);
 
+      // mean and basis vectors used by the processors in case of implicit transformations of the data.
+      // The basis is reserved beforehand since the processors keep a pointer to its elements.
+      data_t mean_vector;
+      std::vector<data_t> deflation_basis;
+      deflation_basis.reserve(max_dimension_to_compute);
 
       {
         it_t it_current_begin(it);
@@ -680,6 +1992,12 @@ namespace grassmann_averages_pca
           // setting the number of elements to remove
           current_acc_object.set_nb_elements_to_remove(K_elements);
 
+          // basis used for the implicit deflation
+          current_acc_object.set_deflation_basis(&deflation_basis);
+
+          // position of the signs of the chunk in the hashes of the signs
+          current_acc_object.set_chunk_index(i);
+
           // attaching the update object callbacks
           current_acc_object.connector_accumulator() = boost::bind(
               &asynchronous_results_merger::update, 
@@ -696,8 +2014,8 @@ namespace grassmann_averages_pca
           //}
           
           // pushing the asynchronous copy, which saves a lot of time when loading 
-          // data lazily from disk
-          ioService.post(
+          // data lazily from disk. The copy is made by the workers of the node of the chunk (first touch).
+          pool.post(pool.node_of_chunk(i, v_individual_accumulators.size()),
             boost::bind(
               &async_processor_t::template set_data_range<it_t>, 
               boost::ref(v_individual_accumulators[i]), 
@@ -711,14 +2029,53 @@ namespace grassmann_averages_pca
         async_merger.wait_notifications(v_individual_accumulators.size());
       }
 
+      // the values should be integers in the range of the compact storage types
+      for(size_t i = 0; i < v_individual_accumulators.size(); i++)
+      {
+        if(!v_individual_accumulators[i].has_representable_data())
+        {
+          if(observer)
+          {
+            observer->log_error_message("The data cannot be represented by the storage type");
+          }
+          return false;
+        }
+      }
+
+
 
 
+      // the trimmed averages are computed from the extremal elements of the chunks when those are few (streaming).
+      // Otherwise this matrix is a copy of the data, storing the flipped vectors that will then be trimmed 
+      // and accumulated.
+      const bool streaming = streaming_trimming && 4 * size_t(K_elements) * nb_chunks <= size_data;
 
-      // this matrix is a copy of the data. It is a convenient structure for storing the 
-      // flipped vectors that will then be trimmed and accumulated. But this is a copy of the initial data:
-      // if the memory pressure is too big, then something else should be found (like a vector of vector, being
-      // potentially scattered in memory).
-      boost::scoped_array<scalar_t> matrix_temp(new scalar_t[number_of_dimensions*size_data]);
+      // the trimmed averages of the first basis vector are computed from the histograms of the stored values, when
+      // those are integers in a small range. 
+      boost::int64_t min_stored_value(0), max_stored_value(0);
+      if(std::numeric_limits<storage_t>::is_integer && !boost::is_same<storage_t, scalar_t>::value)
+      {
+        min_stored_value = v_individual_accumulators[0].get_min_stored_value();
+        max_stored_value = v_individual_accumulators[0].get_max_stored_value();
+        for(int i = 1; i < v_individual_accumulators.size(); i++)
+        {
+          min_stored_value = std::min(min_stored_value, v_individual_accumulators[i].get_min_stored_value());
+          max_stored_value = std::max(max_stored_value, v_individual_accumulators[i].get_max_stored_value());
+        }
+      }
+      const size_t nb_histogram_bins = static_cast<size_t>(max_stored_value - min_stored_value + 1);
+      const bool histogram = 
+        std::numeric_limits<storage_t>::is_integer && 
+        !boost::is_same<storage_t, scalar_t>::value && 
+        nb_histogram_bins <= max_histogram_bins &&
+        block_size <= 1;
+
+      // the bounds of the trimmed averages are estimated from samples of the chunks (approximate trimming).
+      const bool approximate = approximate_trimming_sample_size > 0 && block_size <= 1;
+      const size_t sample_stride = std::max<size_t>(1, size_data / std::max<size_t>(1, approximate_trimming_sample_size));
+
+      const bool signed_copy = !streaming && !approximate && !(histogram && max_dimension_to_compute == 1);
+      boost::scoped_array<scalar_t> matrix_temp(signed_copy ? new scalar_t[number_of_dimensions*size_data] : 0);
 
 
 
@@ -733,7 +2090,7 @@ namespace grassmann_averages_pca
 
         for(int i = 0; i < v_individual_accumulators.size(); i++)
         {
-          ioService.post(
+          pool.post(pool.node_of_chunk(i, v_individual_accumulators.size()),
             boost::bind(
               &async_processor_t::data_centering_first_phase, 
               boost::ref(v_individual_accumulators[i]),
@@ -744,7 +2101,7 @@ namespace grassmann_averages_pca
         async_merger.wait_notifications(v_individual_accumulators.size());
 
         // gathering the accumulated, already divided by the size 
-        data_t mean_vector = async_merger.get_merged_result();
+        mean_vector = async_merger.get_merged_result();
 
         // sending result to observer
         if(observer)
@@ -758,7 +2115,7 @@ namespace grassmann_averages_pca
 
         for(int i = 0; i < v_individual_accumulators.size(); i++)
         {
-          ioService.post(
+          pool.post(pool.node_of_chunk(i, v_individual_accumulators.size()),
             boost::bind(
               &async_processor_t::data_centering_second_phase, 
               boost::ref(v_individual_accumulators[i]),
@@ -776,10 +2133,33 @@ namespace grassmann_averages_pca
 
 
 
+      if(block_size > 1)
+      {
+        return process_blocks(
+          max_iterations,
+          max_dimension_to_compute,
+          number_of_dimensions,
+          size_data,
+          chunks_size,
+          pool,
+          v_individual_accumulators,
+          deflation_basis,
+          matrix_temp.get(),
+          it_output_basis_vector_beginning,
+          it_output_basis_vector_end);
+      }
+
+      // the trimmed averages are computed by ranges of consecutive dimensions
+      const size_t dimensions_per_range = get_dimensions_per_range(number_of_dimensions, pool.nb_threads());
+
+      // convergence from the flips and the patterns of the signs
+      details::sign_flips_convergence_check signs_convergence_op(size_data, sign_flips_fraction, cycle_detection);
+
       // for each requested subspace
       for(int current_subspace_index = 0; current_subspace_index < max_dimension_to_compute; current_subspace_index++, ++it_basisvectors)
       {
-
+        // the workers poll their queue during the iterations of the component
+        details::threading::hot_workers_scope hot_workers(pool);
 
         // PCA like initial steps
         if(nb_steps_pca)
@@ -792,7 +2172,7 @@ namespace grassmann_averages_pca
             // pushing the initialisation of the mu and sign vectors to the pool
             for(int i = 0; i < v_individual_accumulators.size(); i++)
             {
-              ioService.post(
+              pool.post(pool.node_of_chunk(i, v_individual_accumulators.size()),
                 boost::bind(
                   &async_processor_t::pca_accumulation, 
                   boost::ref(v_individual_accumulators[i]), 
@@ -803,8 +2183,7 @@ namespace grassmann_averages_pca
             async_merger.wait_notifications(v_individual_accumulators.size());
 
             // gathering the first mu
-            mu = async_merger.get_merged_result();
-            double norm_mu = norm_op(mu);
+            const double norm_mu = vector_norm(ranges_op, async_merger.get_merged_result());
             if(norm_mu < 1E-12)
             {
               if(observer)
@@ -815,7 +2194,7 @@ namespace grassmann_averages_pca
               }
               return false;
             }
-            mu *= typename data_t::value_type(1./norm_mu);
+            ranges_op.scaled_copy(async_merger.get_merged_result(), scalar_t(1./norm_mu), mu);
           }
 
           // sending result to observer
@@ -828,10 +2207,15 @@ namespace grassmann_averages_pca
 
 
 
-        details::convergence_check<data_t> convergence_op(mu);
+        // largest change of the coordinates of mu between two iterations
+        double mu_change = 0;
+
+        // the elements are integers until the first deflation
+        const bool histogram_iterations = histogram && current_subspace_index == 0;
+        const bool approximate_iterations = approximate && !histogram_iterations;
 
         int iterations = 0;
-        for(; (!convergence_op(mu) && iterations < max_iterations) || iterations == 0; iterations++)
+        for(; (!(mu_change < convergence_epsilon) && iterations < max_iterations) || iterations == 0; iterations++)
         {
 
           // reseting the merger object
@@ -840,44 +2224,143 @@ namespace grassmann_averages_pca
           // pushing the computation of the bounds
           for(int i = 0; i < v_individual_accumulators.size(); i++)
           {
-            ioService.post(
-              boost::bind(
-                &async_processor_t::compute_data_matrix, 
-                boost::ref(v_individual_accumulators[i]), 
-                boost::cref(mu),
-                matrix_temp.get() + i*chunks_size,
-                size_data));
+            if(histogram_iterations || approximate_iterations)
+            {
+              pool.post(pool.node_of_chunk(i, v_individual_accumulators.size()),
+                boost::bind(
+                  &async_processor_t::compute_signs, 
+                  boost::ref(v_individual_accumulators[i]), 
+                  boost::cref(mu)));
+            }
+            else if(streaming)
+            {
+              pool.post(pool.node_of_chunk(i, v_individual_accumulators.size()),
+                boost::bind(
+                  &async_processor_t::compute_extremal_elements, 
+                  boost::ref(v_individual_accumulators[i]), 
+                  boost::cref(mu)));
+            }
+            else
+            {
+              pool.post(pool.node_of_chunk(i, v_individual_accumulators.size()),
+                boost::bind(
+                  &async_processor_t::compute_data_matrix, 
+                  boost::ref(v_individual_accumulators[i]), 
+                  boost::cref(mu),
+                  matrix_temp.get() + i*chunks_size,
+                  size_data));
+            }
           }
 
 
           // waiting for completion (barrier)
           async_merger.wait_notifications(v_individual_accumulators.size());
 
+          // without any flip, the trimmed averages would give the current mu again and the iterations stop before
+          // computing them. Below a positive fraction of flips or on a repeated pattern, the signs are not those mu
+          // was computed from, and the iterations stop after the trimmed averages of the current signs.
+          // Only the signed elements of the flipped vectors changed since the previous iteration, all of them
+          // at the first iteration.
+          bool signs_converged = false;
+          size_t nb_sign_flips = size_data;
+          if(iterations == 0)
+          {
+            signs_convergence_op.start();
+          }
+          else
+          {
+            nb_sign_flips = 0;
+            boost::uint64_t signs_hash_change = 0;
+            for(int i = 0; i < v_individual_accumulators.size(); i++)
+            {
+              nb_sign_flips += v_individual_accumulators[i].get_nb_sign_flips();
+              signs_hash_change ^= v_individual_accumulators[i].get_signs_hash_change();
+            }
+            v_sign_flips[current_subspace_index].push_back(nb_sign_flips);
+            if(signs_convergence_op(nb_sign_flips, signs_hash_change))
+            {
+              if(nb_sign_flips == 0)
+              {
+                break;
+              }
+              signs_converged = true;
+            }
+          }
+
           // clearing the notifications
           async_merger.init_notifications();
 
-          // pushing the computation of the trimmed accumulation on each dimension
-          for(int dim_to_compute = 0; dim_to_compute < number_of_dimensions; dim_to_compute++)
+          // pushing the computation of the trimmed accumulation on each range of dimensions
+          size_t nb_ranges = 0;
+          for(size_t first_dimension = 0; first_dimension < number_of_dimensions; first_dimension += dimensions_per_range, nb_ranges++)
           {
-            ioService.post(
-              boost::bind(
-                &async_processor_t::compute_bounded_accumulation, 
-                boost::ref(v_individual_accumulators[0]), 
-                dim_to_compute,
-                size_data,
-                matrix_temp.get() + dim_to_compute*size_data));
+            const size_t nb_dimensions = std::min(dimensions_per_range, number_of_dimensions - first_dimension);
+            if(histogram_iterations)
+            {
+              pool.post(nb_ranges % pool.nb_nodes(),
+                boost::bind(
+                  &async_processor_t::merge_histograms, 
+                  boost::ref(v_individual_accumulators[0]), 
+                  first_dimension,
+                  nb_dimensions,
+                  &v_individual_accumulators,
+                  min_stored_value,
+                  nb_histogram_bins));
+            }
+            else if(approximate_iterations)
+            {
+              pool.post(nb_ranges % pool.nb_nodes(),
+                boost::bind(
+                  &async_processor_t::approximate_trimmed_means, 
+                  boost::ref(v_individual_accumulators[0]), 
+                  first_dimension,
+                  nb_dimensions,
+                  &v_individual_accumulators,
+                  size_data,
+                  sample_stride));
+            }
+            else if(streaming)
+            {
+              pool.post(nb_ranges % pool.nb_nodes(),
+                boost::bind(
+                  &async_processor_t::merge_extremal_elements, 
+                  boost::ref(v_individual_accumulators[0]), 
+                  first_dimension,
+                  first_dimension,
+                  nb_dimensions,
+                  &v_individual_accumulators,
+                  size_data));
+            }
+            else
+            {
+              pool.post(nb_ranges % pool.nb_nodes(),
+                boost::bind(
+                  &async_processor_t::compute_bounded_accumulation, 
+                  boost::ref(v_individual_accumulators[0]), 
+                  first_dimension,
+                  nb_dimensions,
+                  size_data,
+                  nb_sign_flips,
+                  matrix_temp.get() + first_dimension*size_data));
+            }
           }
 
 
           // waiting for completion (barrier)
-          async_merger.wait_notifications(number_of_dimensions);
-          
+          async_merger.wait_notifications(nb_ranges);
 
-          // gathering the mus
-          mu = async_merger.get_merged_result();
+          if(approximate_iterations)
+          {
+            std::vector<size_t> const &rank_errors = v_individual_accumulators[0].get_rank_errors();
+            v_trimming_rank_errors[current_subspace_index].push_back(*std::max_element(rank_errors.begin(), rank_errors.end()));
+          }
           
-          // normalize mu on the sphere
-          mu *= typename data_t::value_type(1./norm_op(mu));
+
+          // gathering the mus, normalized on the sphere, and the change since the previous iteration
+          mu_change = ranges_op.scaled_copy(
+            async_merger.get_merged_result(),
+            scalar_t(1./vector_norm(ranges_op, async_merger.get_merged_result())),
+            mu);
 
           // sending result to observer
           if(observer)
@@ -885,20 +2368,19 @@ namespace grassmann_averages_pca
             observer->signal_intermediate_result(mu, current_subspace_index, iterations);
           }
 
+          if(signs_converged)
+          {
+            break;
+          }
         }
 
 
 
-        // orthogonalisation against previous basis vectors
-        bool renormalise(false);
-        for(it_o_basisvectors_t it_mus(it_output_basis_vector_beginning); it_mus < it_basisvectors; ++it_mus)
-        {
-          mu -= boost::numeric::ublas::inner_prod(mu, *it_mus) * (*it_mus);
-          renormalise = true;
-        }
-        if(renormalise)
+        // orthogonalisation against previous basis vectors, which are those of the deflation
+        if(!deflation_basis.empty())
         {
-          double norm_mu = norm_op(mu);
+          const double squared_norm_mu = ranges_op.orthogonalise(mu, deflation_basis);
+          const double norm_mu = boost::is_same<norm_mu_t, details::norm2>::value ? std::sqrt(squared_norm_mu) : norm_op(mu);
           if(norm_mu < 1E-12)
           {
             if(observer)
@@ -910,7 +2392,7 @@ namespace grassmann_averages_pca
             return false;
           }
 
-          mu *= typename data_t::value_type(1./norm_mu);
+          ranges_op.scaled_copy(mu, scalar_t(1./norm_mu), mu);
         }
         
 
@@ -930,11 +2412,14 @@ namespace grassmann_averages_pca
         {
           async_merger.init_notifications();
 
+          // the basis vector should be available to the processors in case of implicit deflation
+          deflation_basis.push_back(*it_basisvectors);
+
           // pushing the update of the mu (and signs)
           for(int i = 0; i < v_individual_accumulators.size(); i++)
           {
 
-			      ioService.post(
+			      pool.post(pool.node_of_chunk(i, v_individual_accumulators.size()),
 				      boost::bind(
 					      &async_processor_t::template project_onto_orthogonal_subspace<typename it_o_basisvectors_t::value_type>,
 					      boost::ref(v_individual_accumulators[i]),
@@ -948,22 +2433,23 @@ namespace grassmann_averages_pca
           // 2. compute the projection on the orthogonal subspace of the remainder elements
           //
           // in order to be consistent with the matlab implementation, the second choice is implemented here
+          bool orthonormalised(true);
           if(current_subspace_index+1 < max_dimension_to_compute)
           {
             it_o_basisvectors_t remainder(it_basisvectors);
             ++remainder;
 
-            if(!details::gram_schmidt_orthonormalisation(it_output_basis_vector_beginning, it_output_basis_vector_end, remainder, norm_op))
-            {
-              return false;
-            }
-
+            orthonormalised = details::gram_schmidt_orthonormalisation(it_output_basis_vector_beginning, it_output_basis_vector_end, remainder, norm_op);
             mu = *remainder;
           }
 
 
-          // wait for the workers
+          // wait for the workers (the processors should not be in use on failure either)
           async_merger.wait_notifications(v_individual_accumulators.size());
+          if(!orthonormalised)
+          {
+            return false;
+          }
 
           
         }
@@ -98,6 +98,13 @@ namespace grassmann_averages_pca
           index++;
         }
 
+        void decrement()
+        {
+          assert(matrix);
+          assert(index > 0);
+          index--;
+        }
+
         bool equal(this_type const& other) const
         {
           assert(matrix == other.matrix);
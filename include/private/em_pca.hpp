@@ -26,6 +26,7 @@
 
 // utilities
 #include <include/private/utilities.hpp>
+#include <include/private/numa_thread_pool.hpp>
 
 
 namespace grassmann_averages_pca
@@ -89,6 +90,9 @@ namespace grassmann_averages_pca
     //! to the computation of the PCA.
     bool need_centering;
 
+    //! Pool of workers set by the caller (see set_thread_pool).
+    thread_pool *p_thread_pool;
+
     //! An instance observing the steps of the algorithm
     observer_t *observer;    
 
@@ -322,36 +326,9 @@ namespace grassmann_averages_pca
     };
 
 
-    /*!@internal
-     * @brief Accumulation gathering the result of all workers.
-     *
-     * The purpose of this class is to add the computed accumulator of each thread to the final result
-     * which contains the sum of all accumulators. 
-     *
-     */
-    struct asynchronous_results_merger : 
-      details::threading::asynchronous_results_merger<
-        data_t,
-        details::threading::merger_addition<data_t>,
-        details::threading::initialisation_vector_specific_dimension<data_t>
-        >
-    {
-    private:
-      typedef details::threading::initialisation_vector_specific_dimension<data_t> data_init_type;
-      typedef details::threading::merger_addition<data_t> merger_type;
-      typedef details::threading::asynchronous_results_merger<data_t, merger_type, data_init_type> parent_type;
-    
-    public:
-
-      /*!Constructor
-       *
-       * @param dimension_ the number of dimensions of the vector to accumulate
-       */
-      asynchronous_results_merger(size_t data_dimension_) : parent_type(data_init_type(data_dimension_))
-      {}
-
-
-    };
+    //!@internal
+    //! Type of the reduction of the partial accumulators of the chunks.
+    typedef details::threading::partial_results_reducer<data_t> results_reducer_t;
 
 
 
@@ -372,6 +349,7 @@ namespace grassmann_averages_pca
       nb_processors(1),
       max_chunk_size(std::numeric_limits<size_t>::max()),
       need_centering(false),
+      p_thread_pool(0),
       observer(0)
     {}
 
@@ -417,6 +395,17 @@ namespace grassmann_averages_pca
       return true;
     }
 
+    /*!@brief Sets the pool of workers used by the computations.
+     *
+     * The lifetime of the pool is not managed by this class, and the pool should outlive the calls to batch_process. 
+     * Set to 0 to create a pool for each computation (default).
+     */
+    bool set_thread_pool(thread_pool *p_thread_pool_)
+    {
+      p_thread_pool = p_thread_pool_;
+      return true;
+    }
+
 
 
     /*!@brief Performs the computation of the eigen-vectors of the provided dataset.
@@ -456,19 +445,9 @@ namespace grassmann_averages_pca
 
       // preparing the thread pool, to avoid individual thread creation/deletion at each step.
       // we perform the init here because it might take some time for the thread to really start.
-      boost::asio::io_service ioService;
-      boost::thread_group threadpool;
-
-
-      // in case of non clean exit (or even in case of clean one).
-      details::threading::safe_stop worker_lock_guard(ioService, threadpool);
-
-      // this is exactly the number of processors
-      boost::asio::io_service::work work(ioService);
-      for(int i = 0; i < nb_processors; i++)
-      {
-        threadpool.create_thread(boost::bind(&boost::asio::io_service::run, &ioService));
-      }
+      // The workers are stopped in case of non clean exit (or even in case of clean one).
+      details::threading::thread_pool_holder pool_holder(p_thread_pool, nb_processors, true);
+      details::threading::numa_thread_pool &pool = pool_holder.get();
 
       // contains the number of elements. In case the iterator is random access, could be deduced simply 
       // by a call to distance.
@@ -501,7 +480,7 @@ namespace grassmann_averages_pca
       typedef asynchronous_chunks_processor async_processor_t;
       std::vector<async_processor_t> v_individual_accumulators(nb_chunks);
 
-      asynchronous_results_merger async_merger(number_of_dimensions);
+      results_reducer_t async_merger(pool, nb_chunks, number_of_dimensions);
       async_merger.init_notifications();
 
       {
@@ -524,14 +503,14 @@ namespace grassmann_averages_pca
           async_processor_t &current_acc_object = v_individual_accumulators[i];
 
           // attaching the update object callbacks
-          current_acc_object.connector_accumulator() = boost::bind(&asynchronous_results_merger::update, &async_merger, _1);
-          current_acc_object.connector_counter() = boost::bind(&asynchronous_results_merger::notify, &async_merger);
+          current_acc_object.connector_accumulator() = boost::bind(&results_reducer_t::update, &async_merger, i, _1);
+          current_acc_object.connector_counter() = boost::bind(&results_reducer_t::notify, &async_merger);
 
           // updating the dimension of the problem
           current_acc_object.set_data_dimensions(number_of_dimensions);
 
           // pushing the asynchronous copy
-          ioService.post(
+          pool.post(pool.node_of_chunk(i, v_individual_accumulators.size()),
             boost::bind(
               &async_processor_t::template set_data_range<it_t>, 
               boost::ref(v_individual_accumulators[i]), 
@@ -564,7 +543,7 @@ namespace grassmann_averages_pca
 
         for(int i = 0; i < v_individual_accumulators.size(); i++)
         {
-          ioService.post(
+          pool.post(pool.node_of_chunk(i, v_individual_accumulators.size()),
             boost::bind(
               &async_processor_t::data_centering_first_phase, 
               boost::ref(v_individual_accumulators[i]),
@@ -589,7 +568,7 @@ namespace grassmann_averages_pca
 
         for(int i = 0; i < v_individual_accumulators.size(); i++)
         {
-          ioService.post(
+          pool.post(pool.node_of_chunk(i, v_individual_accumulators.size()),
             boost::bind(
               &async_processor_t::data_centering_second_phase, 
               boost::ref(v_individual_accumulators[i]),
@@ -609,6 +588,8 @@ namespace grassmann_averages_pca
           current_subspace_index < max_dimension_to_compute; 
           current_subspace_index++, ++it_basisvectors)
       {
+        // the workers poll their queue during the iterations of the component
+        details::threading::hot_workers_scope hot_workers(pool);
 
         details::convergence_check<data_t> convergence_op(mu);
 
@@ -621,7 +602,7 @@ namespace grassmann_averages_pca
           // pushing the initialisation of the mu and sign vectors to the pool
           for(int i = 0; i < v_individual_accumulators.size(); i++)
           {
-            ioService.post(
+            pool.post(pool.node_of_chunk(i, v_individual_accumulators.size()),
               boost::bind(
                 &async_processor_t::pca_accumulation, 
                 boost::ref(v_individual_accumulators[i]), 
@@ -677,7 +658,7 @@ namespace grassmann_averages_pca
           // pushing the update of the mu (and signs)
           for(int i = 0; i < v_individual_accumulators.size(); i++)
           {
-            ioService.post(
+            pool.post(pool.node_of_chunk(i, v_individual_accumulators.size()),
               boost::bind(
                 &async_processor_t::project_onto_orthogonal_subspace, 
                 boost::ref(v_individual_accumulators[i]), 
@@ -702,7 +683,7 @@ namespace grassmann_averages_pca
       }
 
 
-      // stopping the pool is done in the destruction of worker_lock_guard
+      // stopping the pool is done in the destruction of pool_holder
 
 
 
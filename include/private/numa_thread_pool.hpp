@@ -0,0 +1,966 @@
+// Copyright 2014, Max Planck Society.
+// Distributed under the BSD 3-Clause license.
+// (See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/BSD-3-Clause)
+
+#ifndef GRASSMANN_AVERAGES_PCA_NUMA_THREAD_POOL_HPP__
+#define GRASSMANN_AVERAGES_PCA_NUMA_THREAD_POOL_HPP__
+
+/*!@file
+ * Grassmann averages for robust PCA, placement of the workers and of the data on the NUMA nodes.
+ *
+ * The workers of each NUMA node have their own task queue and are pinned to the CPUs of the node. Each chunk of
+ * data is assigned to a node, and all the tasks of the chunk run on the workers of this node. In particular the copy
+ * of the data is made by those workers, and the memory of the chunk is placed on the node by the first touch policy
+ * of the system.
+ *
+ * The partial results of the chunks are reduced by the workers, node by node (see partial_results_reducer).
+ *
+ * The topology is read from the Linux sysfs. On the other systems, or if GRASSMANNPCA_WITHOUT_NUMA is defined, there is
+ * one node and the workers are not pinned.
+ */
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cassert>
+#include <algorithm>
+#include <numeric>
+#include <iterator>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/atomic.hpp>
+#include <boost/numeric/ublas/vector.hpp>
+
+#include <include/private/utilities.hpp>
+#include <include/private/simd_kernels.hpp>
+
+#if defined(__linux__) && !defined(GRASSMANNPCA_WITHOUT_NUMA)
+  #define GRASSMANNPCA_NUMA_LINUX
+  #include <pthread.h>
+  #include <sched.h>
+#endif
+
+namespace grassmann_averages_pca
+{
+  namespace details
+  {
+    namespace threading
+    {
+
+      //! Parses a list of CPUs or nodes in the format of the Linux sysfs (eg. "0-3,8-11").
+      inline std::vector<int> parse_cpu_list(std::string const& list)
+      {
+        std::vector<int> cpus;
+        std::istringstream stream(list);
+        std::string range;
+        while(std::getline(stream, range, ','))
+        {
+          int first(0), last(0);
+          const int nb_read = std::sscanf(range.c_str(), "%d-%d", &first, &last);
+          if(nb_read < 1)
+          {
+            continue;
+          }
+          if(nb_read == 1)
+          {
+            last = first;
+          }
+          for(int cpu = first; cpu <= last; cpu++)
+          {
+            cpus.push_back(cpu);
+          }
+        }
+        return cpus;
+      }
+
+      //! Returns the CPUs of the list that are also in the allowed CPUs. Both lists are sorted.
+      inline std::vector<int> intersect_cpu_lists(std::vector<int> const& cpus, std::vector<int> const& allowed_cpus)
+      {
+        std::vector<int> intersection;
+        std::set_intersection(
+          cpus.begin(), cpus.end(), 
+          allowed_cpus.begin(), allowed_cpus.end(), 
+          std::back_inserter(intersection));
+        return intersection;
+      }
+
+      //! Returns the CPUs the process may run on (eg. restricted by taskset, numactl or a cpuset), sorted. 
+      //! The list is empty if the affinity of the process is not available.
+      inline std::vector<int> get_process_cpus()
+      {
+        std::vector<int> cpus;
+#ifdef GRASSMANNPCA_NUMA_LINUX
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if(sched_getaffinity(0, sizeof(set), &set) == 0)
+        {
+          for(int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+          {
+            if(CPU_ISSET(cpu, &set))
+            {
+              cpus.push_back(cpu);
+            }
+          }
+        }
+#endif
+        return cpus;
+      }
+
+      //! Returns the number of processors the process may use, which may be less than the number of processors
+      //! of the machine.
+      inline size_t get_nb_process_processors()
+      {
+        const size_t nb_cpus = get_process_cpus().size();
+        return nb_cpus > 0 ? nb_cpus : boost::thread::hardware_concurrency();
+      }
+
+      //! Returns the CPUs of each NUMA node having CPUs the process may run on. 
+      //! A single node without CPU (meaning no pinning) is returned if the topology is not available.
+      inline std::vector< std::vector<int> > get_numa_nodes_cpus()
+      {
+        std::vector< std::vector<int> > nodes;
+#ifdef GRASSMANNPCA_NUMA_LINUX
+        std::vector<int> const process_cpus = get_process_cpus();
+        std::ifstream online("/sys/devices/system/node/online");
+        std::string online_list;
+        if(online && std::getline(online, online_list))
+        {
+          std::vector<int> const v_nodes = parse_cpu_list(online_list);
+          for(size_t i = 0; i < v_nodes.size(); i++)
+          {
+            std::ostringstream path;
+            path << "/sys/devices/system/node/node" << v_nodes[i] << "/cpulist";
+            std::ifstream file(path.str().c_str());
+            std::string list;
+            if(!file || !std::getline(file, list))
+            {
+              continue;
+            }
+
+            // the nodes having only memory, or only CPUs the process may not use, are skipped
+            std::vector<int> cpus = parse_cpu_list(list);
+            if(!process_cpus.empty())
+            {
+              std::sort(cpus.begin(), cpus.end());
+              cpus = intersect_cpu_lists(cpus, process_cpus);
+            }
+            if(!cpus.empty())
+            {
+              nodes.push_back(cpus);
+            }
+          }
+        }
+#endif
+        if(nodes.empty())
+        {
+          nodes.push_back(std::vector<int>());
+        }
+        return nodes;
+      }
+
+      //! Restricts the current thread to the provided CPUs. Returns false if the thread could not be pinned.
+      inline bool pin_current_thread(std::vector<int> const& cpus)
+      {
+#ifdef GRASSMANNPCA_NUMA_LINUX
+        if(cpus.empty())
+        {
+          return false;
+        }
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for(size_t i = 0; i < cpus.size(); i++)
+        {
+          if(cpus[i] < CPU_SETSIZE)
+          {
+            CPU_SET(cpus[i], &set);
+          }
+        }
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        return false;
+#endif
+      }
+
+
+      /*!@brief Pool of workers grouped by NUMA node.
+       *
+       * Each node has its own task queue, run by the workers pinned to the CPUs of the node. The threads are distributed
+       * in a round robin manner over the nodes, and the number of nodes used is at most the number of threads.
+       * The idle workers are blocked on their task queue. The pool may be used by several computations at the same time, 
+       * each computation waiting for its own tasks. 
+       *
+       * The workers may also be kept hot during a computation (see hot_workers_scope): instead of blocking on their queue, 
+       * they poll it, which removes the latency of their wake up at each iteration. This is done only if the process may 
+       * use more processors than workers (see get_nb_process_processors), the calling thread being not blocked either.
+       * The workers are stopped and joined at destruction, the pending tasks being discarded.
+       */
+      struct numa_thread_pool : boost::noncopyable
+      {
+      private:
+        typedef boost::shared_ptr<boost::asio::io_service> io_service_ptr_t;
+        typedef boost::shared_ptr<boost::asio::io_service::work> work_ptr_t;
+
+        std::vector< std::vector<int> > v_nodes_cpus;
+        std::vector<io_service_ptr_t> v_services;
+        std::vector<work_ptr_t> v_works;
+        boost::thread_group threadpool;
+        const size_t nb_workers;
+
+        //! Number of computations requesting the workers to be kept hot.
+        boost::atomic<int> nb_hot_requests;
+        bool hot_workers_enabled;
+
+        void run_worker(boost::asio::io_service *service, std::vector<int> const *cpus)
+        {
+          if(cpus)
+          {
+            pin_current_thread(*cpus);
+          }
+
+          size_t nb_empty_polls = 0;
+          while(!service->stopped())
+          {
+            if(nb_hot_requests.load(boost::memory_order_relaxed) > 0)
+            {
+              if(service->poll_one())
+              {
+                nb_empty_polls = 0;
+              }
+              else if(++nb_empty_polls % 64)
+              {
+                cpu_relax();
+              }
+              else
+              {
+                // leaves the processor from time to time, in case it is shared
+                boost::this_thread::yield();
+              }
+            }
+            else
+            {
+              service->run_one();
+            }
+          }
+        }
+
+      public:
+        /*!@brief Starts the workers.
+         *
+         * @param nb_threads the number of workers.
+         * @param numa_placement if false, all the workers share the same task queue and are not pinned.
+         */
+        numa_thread_pool(size_t nb_threads, bool numa_placement = true) :
+          v_nodes_cpus(numa_placement ? get_numa_nodes_cpus() : std::vector< std::vector<int> >(1)),
+          nb_workers(nb_threads),
+          nb_hot_requests(0),
+          hot_workers_enabled(nb_threads < get_nb_process_processors())
+        {
+          if(v_nodes_cpus.size() > std::max(nb_threads, size_t(1)))
+          {
+            v_nodes_cpus.resize(std::max(nb_threads, size_t(1)));
+          }
+
+          for(size_t node = 0; node < v_nodes_cpus.size(); node++)
+          {
+            v_services.push_back(io_service_ptr_t(new boost::asio::io_service()));
+            v_works.push_back(work_ptr_t(new boost::asio::io_service::work(*v_services.back())));
+          }
+
+          // the workers are pinned only if there is more than one node
+          for(size_t thread = 0; thread < nb_threads; thread++)
+          {
+            const size_t node = thread % v_services.size();
+            threadpool.create_thread(
+              boost::bind(
+                &numa_thread_pool::run_worker,
+                this,
+                v_services[node].get(),
+                v_services.size() > 1 ? &v_nodes_cpus[node] : 0));
+          }
+        }
+
+        ~numa_thread_pool()
+        {
+          for(size_t node = 0; node < v_services.size(); node++)
+          {
+            v_services[node]->stop();
+          }
+          threadpool.join_all();
+        }
+
+        //! Number of nodes used by the pool.
+        size_t nb_nodes() const
+        {
+          return v_services.size();
+        }
+
+        //! Number of workers of the pool.
+        size_t nb_threads() const
+        {
+          return nb_workers;
+        }
+
+        //! Node of a chunk: the chunks are assigned to the nodes by contiguous ranges.
+        size_t node_of_chunk(size_t chunk, size_t nb_chunks) const
+        {
+          assert(chunk < nb_chunks);
+          return chunk * nb_nodes() / nb_chunks;
+        }
+
+        //! Enables or disables the hot workers (see hot_workers_scope). By default, enabled only if the machine has more 
+        //! processors than workers.
+        void set_hot_workers(bool enable)
+        {
+          hot_workers_enabled = enable;
+        }
+
+        //! Returns true if the workers may be kept hot.
+        bool hot_workers() const
+        {
+          return hot_workers_enabled;
+        }
+
+        //! Requests the workers to poll their queue instead of blocking on it, until the same number of releases.
+        void request_hot_workers()
+        {
+          ++nb_hot_requests;
+        }
+
+        //! Releases a request made by request_hot_workers.
+        void release_hot_workers()
+        {
+          --nb_hot_requests;
+        }
+
+        //! Posts a task to the workers of a node.
+        template <class handler_t>
+        void post(size_t node, handler_t handler)
+        {
+          assert(node < nb_nodes());
+          v_services[node]->post(handler);
+        }
+      };
+
+
+      /*!@brief Provides the pool of workers of a computation.
+       *
+       * This is the pool set by the caller if any, otherwise a pool created for the computation only.
+       */
+      struct thread_pool_holder : boost::noncopyable
+      {
+      private:
+        boost::scoped_ptr<numa_thread_pool> p_own_pool;
+        numa_thread_pool *p_pool;
+
+      public:
+        thread_pool_holder(numa_thread_pool *p_external_pool, size_t nb_threads, bool numa_placement) :
+          p_own_pool(p_external_pool ? 0 : new numa_thread_pool(nb_threads, numa_placement)),
+          p_pool(p_external_pool ? p_external_pool : p_own_pool.get())
+        {}
+
+        numa_thread_pool& get()
+        {
+          return *p_pool;
+        }
+      };
+
+
+      //! Keeps the workers of a pool hot (polling their queue) during the lifetime of the instance, if the pool allows it.
+      struct hot_workers_scope : boost::noncopyable
+      {
+      private:
+        numa_thread_pool &pool;
+        const bool active;
+
+      public:
+        explicit hot_workers_scope(numa_thread_pool &pool_) : pool(pool_), active(pool_.hot_workers())
+        {
+          if(active)
+          {
+            pool.request_hot_workers();
+          }
+        }
+
+        ~hot_workers_scope()
+        {
+          if(active)
+          {
+            pool.release_hot_workers();
+          }
+        }
+      };
+
+
+      /*!@brief Reduces the partial results of the chunks, without contention between the workers.
+       *
+       * Each chunk publishes its partial result (its own accumulator, which stays valid until the next notification) in its
+       * own slot, and notifies the end of its task. The main thread waits for the notifications (the barrier is a counter
+       * of the tasks), and the partial results are then added by the workers of the pool, in parallel over ranges of
+       * dimensions aligned on the cache lines:
+       * - the partial results of the chunks of each node are first added by the workers of the node,
+       * - the results of the nodes are then added together.
+       *
+       * Within a range, the partial results are added in the order of the chunks, so the result does not depend on the
+       * order in which the tasks finished. As for asynchronous_results_merger, init resets the result while init_notifications
+       * keeps it, the partial results being added to the current result. If the reducer is compensated, the additions to
+       * the current result compensate their rounding errors (Kahan), which bounds the drift of the result over the 
+       * iterations.
+       *
+       * The squared norm of the result is computed by the tasks of the reduction, on the ranges they just added (see 
+       * get_squared_norm), which saves a sweep of the calling thread over the result.
+       *
+       * The slots of the chunks and the results of the nodes are aligned on the cache lines, and padded to a multiple of
+       * the cache line, so that the chunks publishing their results and the workers of different nodes or ranges never
+       * write to the same cache line.
+       *
+       * @note a chunk publishes at most one partial result between two calls to init_notifications.
+       */
+      template <class data_t>
+      struct partial_results_reducer : boost::noncopyable
+      {
+      public:
+        typedef data_t result_type;   //!< The type returned by get_merged_result
+
+      private:
+        typedef typename data_t::value_type scalar_t;
+
+        //! Minimal number of dimensions reduced by a task, below which the reduction is not worth a task.
+        static const size_t min_range_size = 16384;
+
+        //! Size in bytes of the cache lines, on which the slots and the results of the nodes are aligned.
+        static const size_t cache_line_size = 64;
+
+        //! Slot of the partial result of a chunk, 0 if the chunk did not publish any result, on its own cache line.
+        struct partial_slot
+        {
+          data_t const* partial;
+          char padding[cache_line_size - sizeof(data_t const*)];
+        };
+
+        numa_thread_pool &pool;
+        const size_t data_dimension;
+        const size_t nb_chunks;
+        simd::kernels<scalar_t> kernels_op;
+
+        //! Slots of the partial results of the chunks.
+        partial_slot *p_partials;
+
+        //! Number of nodes having their own result, in case there is more than one node.
+        const size_t nb_node_results;
+
+        //! Number of scalars between the results of two consecutive nodes, a multiple of the cache line.
+        const size_t node_results_stride;
+
+        //! Results of each node, in case there is more than one node.
+        scalar_t *p_node_results;
+
+        data_t current_value;
+
+        //! Indicates that the additions to the current result are compensated.
+        const bool compensated;
+
+        //! Compensations of the rounding errors of the current result (if compensated).
+        data_t current_compensation;
+
+        //! Notifications of the tasks of the chunks (barrier).
+        notification_counter nb_updates;
+
+        //! Notifications of the tasks of the reduction.
+        notification_counter nb_tasks_done;
+
+        //! Size of the ranges of the current reduction, and the squared norms of the result on each range.
+        size_t current_range_size;
+        std::vector<double> v_range_squared_norms;
+
+        //! Squared norm of the current result.
+        double squared_norm;
+
+        //! Squared norm of the current result on the dimensions in [begin, end[, after the reduction of this range.
+        void update_squared_norm(size_t begin, size_t end)
+        {
+          scalar_t const * const p_result = &current_value(0) + begin;
+          v_range_squared_norms[begin / current_range_size] = kernels_op.inner_product(p_result, p_result, end - begin);
+        }
+
+        //! Returns true if at least one chunk published its partial result.
+        bool has_published_partials() const
+        {
+          for(size_t chunk = 0; chunk < nb_chunks; chunk++)
+          {
+            if(p_partials[chunk].partial)
+            {
+              return true;
+            }
+          }
+          return false;
+        }
+
+        //! Empties the slots of the chunks.
+        void clear_partials()
+        {
+          for(size_t chunk = 0; chunk < nb_chunks; chunk++)
+          {
+            p_partials[chunk].partial = 0;
+          }
+        }
+
+        //! Adds a partial result to the current result, for the dimensions in [begin, end[.
+        void add_to_current_value(scalar_t const *p_partial, size_t begin, size_t end)
+        {
+          if(compensated)
+          {
+            kernels_op.compensated_add(&current_value(0) + begin, &current_compensation(0) + begin, p_partial + begin, end - begin);
+          }
+          else
+          {
+            kernels_op.add(&current_value(0) + begin, p_partial + begin, end - begin);
+          }
+        }
+
+        //! Adds the partial results of the chunks of a node, for the dimensions in [begin, end[.
+        void reduce_node(size_t node, size_t begin, size_t end)
+        {
+          scalar_t *p_out = 0;
+          if(nb_node_results)
+          {
+            p_out = p_node_results + node * node_results_stride;
+            std::fill(p_out + begin, p_out + end, scalar_t(0));
+          }
+
+          for(size_t chunk = 0; chunk < nb_chunks; chunk++)
+          {
+            data_t const * const partial = p_partials[chunk].partial;
+            if(partial && pool.node_of_chunk(chunk, nb_chunks) == node)
+            {
+              if(p_out)
+              {
+                kernels_op.add(p_out + begin, &(*partial)(0) + begin, end - begin);
+              }
+              else
+              {
+                add_to_current_value(&(*partial)(0), begin, end);
+              }
+            }
+          }
+
+          if(!p_out)
+          {
+            update_squared_norm(begin, end);
+          }
+        }
+
+        //! Adds the results of the nodes, for the dimensions in [begin, end[.
+        void reduce_nodes(size_t begin, size_t end)
+        {
+          for(size_t node = 0; node < nb_node_results; node++)
+          {
+            add_to_current_value(p_node_results + node * node_results_stride, begin, end);
+          }
+          update_squared_norm(begin, end);
+        }
+
+        void reduce_node_task(size_t node, size_t begin, size_t end)
+        {
+          reduce_node(node, begin, end);
+          notify_task();
+        }
+
+        void reduce_nodes_task(size_t begin, size_t end)
+        {
+          reduce_nodes(begin, end);
+          notify_task();
+        }
+
+        void notify_task()
+        {
+          nb_tasks_done.notify();
+        }
+
+        void wait_tasks(size_t nb_tasks)
+        {
+          nb_tasks_done.wait(nb_tasks);
+          nb_tasks_done.reset();
+        }
+
+        //! Reduces the published partial results into the current result.
+        void reduce()
+        {
+          const size_t nb_nodes = std::max(nb_node_results, size_t(1));
+
+          // about two ranges per worker, each range being a multiple of the cache line
+          const size_t line_size = std::max(cache_line_size / sizeof(scalar_t), size_t(1));
+          const size_t nb_workers = std::max(pool.nb_threads(), size_t(1));
+          size_t range_size = std::max((data_dimension + 2*nb_workers - 1) / (2*nb_workers), size_t(min_range_size));
+          range_size = (range_size + line_size - 1) / line_size * line_size;
+          const size_t nb_ranges = (data_dimension + range_size - 1) / range_size;
+
+          if(nb_ranges <= 1 && nb_nodes == 1)
+          {
+            current_range_size = std::max(data_dimension, size_t(1));
+            v_range_squared_norms.assign(1, 0.);
+            reduce_node(0, 0, data_dimension);
+            squared_norm = v_range_squared_norms[0];
+            return;
+          }
+
+          current_range_size = range_size;
+          v_range_squared_norms.assign(nb_ranges, 0.);
+
+          // first level: the chunks of each node, by the workers of the node
+          for(size_t node = 0; node < nb_nodes; node++)
+          {
+            for(size_t range = 0; range < nb_ranges; range++)
+            {
+              pool.post(node,
+                boost::bind(
+                  &partial_results_reducer::reduce_node_task, this, 
+                  node, range * range_size, std::min((range + 1) * range_size, data_dimension)));
+            }
+          }
+          wait_tasks(nb_nodes * nb_ranges);
+
+          // second level: the nodes
+          if(nb_nodes > 1)
+          {
+            for(size_t range = 0; range < nb_ranges; range++)
+            {
+              pool.post(range % nb_nodes,
+                boost::bind(
+                  &partial_results_reducer::reduce_nodes_task, this, 
+                  range * range_size, std::min((range + 1) * range_size, data_dimension)));
+            }
+            wait_tasks(nb_ranges);
+          }
+
+          // the squared norms of the ranges are added in the order of the ranges
+          squared_norm = std::accumulate(v_range_squared_norms.begin(), v_range_squared_norms.end(), 0.);
+        }
+
+      public:
+        /*!Constructor
+         *
+         * @param pool_ the pool running the tasks of the chunks, also used for the reduction.
+         * @param nb_chunks_ the number of chunks.
+         * @param data_dimension_ the dimension of the result.
+         * @param compensated_ if true, the rounding errors of the additions to the result are compensated.
+         */
+        partial_results_reducer(numa_thread_pool &pool_, size_t nb_chunks_, size_t data_dimension_, bool compensated_ = false) :
+          pool(pool_),
+          data_dimension(data_dimension_),
+          nb_chunks(nb_chunks_),
+          kernels_op(simd::get_kernels<scalar_t>()),
+          p_partials(simd::aligned_allocate<partial_slot>(nb_chunks_, cache_line_size)),
+          nb_node_results(pool_.nb_nodes() > 1 ? pool_.nb_nodes() : 0),
+          node_results_stride((data_dimension_ * sizeof(scalar_t) + cache_line_size - 1) / cache_line_size * cache_line_size / sizeof(scalar_t)),
+          p_node_results(simd::aligned_allocate<scalar_t>(nb_node_results * node_results_stride, cache_line_size)),
+          current_value(boost::numeric::ublas::scalar_vector<scalar_t>(data_dimension_, 0)),
+          compensated(compensated_),
+          current_compensation(boost::numeric::ublas::scalar_vector<scalar_t>(compensated_ ? data_dimension_ : 0, 0)),
+          current_range_size(1),
+          squared_norm(0)
+        {
+          clear_partials();
+        }
+
+        ~partial_results_reducer()
+        {
+          simd::aligned_free(p_node_results);
+          simd::aligned_free(p_partials);
+        }
+
+        //! Initializes the current result and the notifications.
+        void init()
+        {
+          std::fill(current_value.begin(), current_value.end(), scalar_t(0));
+          std::fill(current_compensation.begin(), current_compensation.end(), scalar_t(0));
+          squared_norm = 0;
+          init_notifications();
+        }
+
+        //! Initialises the number of notifications and the partial results. Also called by init.
+        void init_notifications()
+        {
+          nb_updates.reset();
+          clear_partials();
+        }
+
+        //! Publishes the partial result of a chunk. 
+        //! @note The call is lock free, each chunk having its own slot.
+        void update(size_t chunk, data_t const* partial)
+        {
+          assert(chunk < nb_chunks && partial->size() == data_dimension);
+          assert(p_partials[chunk].partial == 0);
+          p_partials[chunk].partial = partial;
+        }
+
+        //! Notifies the end of a task of a chunk.
+        void notify()
+        {
+          nb_updates.notify();
+        }
+
+        //! Returns once the number of notifications reaches the number in argument, and reduces the partial results.
+        //!
+        //!@warning if an inappropriate number is given, the method might never return.
+        bool wait_notifications(size_t nb_notifications)
+        {
+          nb_updates.wait(nb_notifications);
+
+          // nothing to reduce for the tasks that do not publish any result (eg. copy of the data)
+          if(has_published_partials())
+          {
+            reduce();
+            clear_partials();
+          }
+          return true;
+        }
+
+        //! Returns the current result.
+        //! @warning the call is not thread safe (intended to be called once wait_notifications returned).
+        result_type const& get_merged_result() const
+        {
+          return current_value;
+        }
+
+        //! Returns the squared @f$\ell_2@f$ norm of the current result, computed by the last reduction.
+        //! @warning the call is not thread safe (intended to be called once wait_notifications returned).
+        double get_squared_norm() const
+        {
+          return squared_norm;
+        }
+      };
+
+
+      /*!@brief Operations on vectors of the dimension of the data, run by ranges of dimensions on the workers of a pool.
+       *
+       * Between two barriers of the iterations, the calling thread normalises @f$\mu@f$, checks the convergence, 
+       * orthogonalises the basis vectors and draws the initial guesses, all in @f$O(D)@f$ or @f$O(kD)@f$. These operations
+       * are run here as tasks over ranges of dimensions aligned on the cache lines, about two ranges per worker as for
+       * partial_results_reducer. The results of the ranges (norms, inner products) are combined in the order of the
+       * ranges, so they do not depend on the order of completion of the tasks. The operations run on the calling thread
+       * if the dimension gives only one range.
+       */
+      template <class data_t>
+      struct dimension_ranges_operations : boost::noncopyable
+      {
+      private:
+        typedef typename data_t::value_type scalar_t;
+
+        //! Minimal number of dimensions of a range, below which the operation is not worth a task.
+        static const size_t min_range_size = 16384;
+
+        //! Number of dimensions of the blocks of the random vectors (see random_vector).
+        static const size_t random_block_size = 65536;
+
+        numa_thread_pool &pool;
+        const size_t data_dimension;
+        size_t range_size;
+        size_t nb_ranges;
+        simd::kernels<scalar_t> kernels_op;
+
+        //! Results of the ranges, @c nb_results_per_range consecutive results per range.
+        std::vector<double> v_range_results;
+
+        //! Notifications of the tasks (barrier).
+        notification_counter counter;
+
+        typedef boost::function<void (size_t, size_t, size_t)> range_operation_t;
+
+        void range_task(range_operation_t const *p_operation, size_t range, size_t begin, size_t end)
+        {
+          (*p_operation)(range, begin, end);
+          counter.notify();
+        }
+
+        //! Runs the operation on the ranges of @c range_size_ dimensions, and returns once all the ranges are processed.
+        void run(range_operation_t const &operation, size_t range_size_)
+        {
+          const size_t nb_operation_ranges = (data_dimension + range_size_ - 1) / range_size_;
+          if(nb_operation_ranges <= 1)
+          {
+            operation(0, 0, data_dimension);
+            return;
+          }
+
+          counter.reset();
+          for(size_t range = 0; range < nb_operation_ranges; range++)
+          {
+            pool.post(range % pool.nb_nodes(),
+              boost::bind(
+                &dimension_ranges_operations::range_task, this, 
+                &operation, range, range * range_size_, std::min((range + 1) * range_size_, data_dimension)));
+          }
+          counter.wait(nb_operation_ranges);
+        }
+
+        //! Sum of the results @c index of all the ranges.
+        double sum_of_results(size_t index, size_t nb_results_per_range) const
+        {
+          double result(0);
+          for(size_t range = 0; range < nb_ranges; range++)
+          {
+            result += v_range_results[range * nb_results_per_range + index];
+          }
+          return result;
+        }
+
+        template <class vector_t>
+        void scaled_copy_range(vector_t const *p_source, scalar_t factor, data_t *p_destination, size_t range, size_t begin, size_t end)
+        {
+          scalar_t * const p_out = &(*p_destination)(0);
+          double change(0);
+          for(size_t d = begin; d < end; d++)
+          {
+            const scalar_t value = scalar_t((*p_source)(d) * factor);
+            change = std::max(change, double(std::abs(value - p_out[d])));
+            p_out[d] = value;
+          }
+          v_range_results[range] = change;
+        }
+
+        void squared_norm_range(data_t const *p_vector, size_t range, size_t begin, size_t end)
+        {
+          scalar_t const * const p_in = &(*p_vector)(0) + begin;
+          v_range_results[range] = kernels_op.inner_product(p_in, p_in, end - begin);
+        }
+
+        void basis_inner_products_range(data_t const *p_vector, std::vector<data_t> const *p_basis, size_t range, size_t begin, size_t end)
+        {
+          const size_t nb_basis_vectors = p_basis->size();
+          scalar_t const * const p_in = &(*p_vector)(0) + begin;
+          for(size_t j = 0; j < nb_basis_vectors; j++)
+          {
+            v_range_results[range * nb_basis_vectors + j] = kernels_op.inner_product(p_in, &(*p_basis)[j](0) + begin, end - begin);
+          }
+        }
+
+        void subtract_basis_range(data_t *p_vector, std::vector<data_t> const *p_basis, std::vector<scalar_t> const *p_coefficients, size_t range, size_t begin, size_t end)
+        {
+          scalar_t * const p_out = &(*p_vector)(0) + begin;
+          for(size_t j = 0; j < p_basis->size(); j++)
+          {
+            kernels_op.axpy(p_out, -(*p_coefficients)[j], &(*p_basis)[j](0) + begin, end - begin);
+          }
+          v_range_results[range] = kernels_op.inner_product(p_out, p_out, end - begin);
+        }
+
+      public:
+        dimension_ranges_operations(numa_thread_pool &pool_, size_t data_dimension_) :
+          pool(pool_),
+          data_dimension(data_dimension_),
+          kernels_op(simd::get_kernels<scalar_t>())
+        {
+          const size_t line_size = std::max(size_t(64) / sizeof(scalar_t), size_t(1));
+          const size_t nb_workers = std::max(pool.nb_threads(), size_t(1));
+          range_size = std::max((data_dimension + 2*nb_workers - 1) / (2*nb_workers), size_t(min_range_size));
+          range_size = (range_size + line_size - 1) / line_size * line_size;
+          nb_ranges = std::max((data_dimension + range_size - 1) / range_size, size_t(1));
+        }
+
+        /*!@brief Copies @c source multiplied by @c factor into @c destination.
+         *
+         * @returns the largest absolute change of the elements of @c destination (the norm of details::convergence_check),
+         *   which is fused with the copy.
+         * @pre @c destination has the dimension of the data. The source may be the destination.
+         */
+        template <class vector_t>
+        double scaled_copy(vector_t const &source, scalar_t factor, data_t &destination)
+        {
+          assert(source.size() == data_dimension && destination.size() == data_dimension);
+          v_range_results.assign(nb_ranges, 0.);
+          run(
+            boost::bind(&dimension_ranges_operations::template scaled_copy_range<vector_t>, this, &source, factor, &destination, _1, _2, _3), 
+            range_size);
+          return *std::max_element(v_range_results.begin(), v_range_results.end());
+        }
+
+        //! Returns the squared @f$\ell_2@f$ norm of a vector of the dimension of the data.
+        double squared_norm(data_t const &v)
+        {
+          v_range_results.assign(nb_ranges, 0.);
+          run(boost::bind(&dimension_ranges_operations::squared_norm_range, this, &v, _1, _2, _3), range_size);
+          return sum_of_results(0, 1);
+        }
+
+        /*!@brief Projects a vector onto the orthogonal subspace of orthonormal basis vectors.
+         *
+         * The inner products with all the basis vectors are computed in one sweep (classical Gram-Schmidt), and the
+         * projections are subtracted in a second sweep, which also computes the squared norm of the result.
+         * @returns the squared @f$\ell_2@f$ norm of the projected vector.
+         */
+        double orthogonalise(data_t &v, std::vector<data_t> const &basis)
+        {
+          if(basis.empty())
+          {
+            return squared_norm(v);
+          }
+
+          const size_t nb_basis_vectors = basis.size();
+          v_range_results.assign(nb_ranges * nb_basis_vectors, 0.);
+          run(boost::bind(&dimension_ranges_operations::basis_inner_products_range, this, &v, &basis, _1, _2, _3), range_size);
+
+          std::vector<scalar_t> coefficients(nb_basis_vectors);
+          for(size_t j = 0; j < nb_basis_vectors; j++)
+          {
+            coefficients[j] = scalar_t(sum_of_results(j, nb_basis_vectors));
+          }
+
+          v_range_results.assign(nb_ranges, 0.);
+          run(boost::bind(&dimension_ranges_operations::subtract_basis_range, this, &v, &basis, &coefficients, _1, _2, _3), range_size);
+          return sum_of_results(0, 1);
+        }
+
+        /*!@brief Draws a random vector of the dimension of the data, by blocks on the workers (see random_data_generator::fill_block).
+         *
+         * The vector depends only on the state of the generator and not on the number of workers. A vector of at most one
+         * block is drawn directly by the generator, as a sequence of draws.
+         */
+        template <class generator_t>
+        void random_vector(generator_t const &generator, data_t &v)
+        {
+          assert(v.size() == data_dimension);
+          if(data_dimension <= random_block_size)
+          {
+            v = generator(v);
+            return;
+          }
+
+          const boost::uint32_t seed = generator.draw_seed();
+          for_each_block(boost::bind(&generator_t::fill_block, &generator, &v(0), seed, _1, _2, _3), random_block_size);
+        }
+
+        /*!@brief Runs an operation on fixed blocks of dimensions, independently of the number of workers.
+         *
+         * @param[in] operation called with the index of the block and the range [begin, end[ of its dimensions.
+         * @param[in] block_size number of dimensions of the blocks.
+         */
+        void for_each_block(boost::function<void (size_t, size_t, size_t)> const &operation, size_t block_size)
+        {
+          run(operation, std::max(block_size, size_t(1)));
+        }
+      };
+
+    } // namespace threading
+  } // namespace details
+
+
+  /*!@brief Pool of workers that may be kept between the computations.
+   *
+   * By default each call to @c batch_process creates its own workers. A pool created by the caller may instead be given to
+   * grassmann_pca, grassmann_pca_with_trimming and em_pca (see their @c set_thread_pool function), in order to remove the creation 
+   * and the destruction of the threads from each call. The same pool may be shared by several instances and by concurrent calls.
+   */
+  typedef details::threading::numa_thread_pool thread_pool;
+
+} // namespace grassmann_averages_pca
+
+#endif /* GRASSMANN_AVERAGES_PCA_NUMA_THREAD_POOL_HPP__ */
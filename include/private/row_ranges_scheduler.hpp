@@ -0,0 +1,195 @@
+// Copyright 2014, Max Planck Society.
+// Distributed under the BSD 3-Clause license.
+// (See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/BSD-3-Clause)
+
+#ifndef GRASSMANN_AVERAGES_PCA_ROW_RANGES_SCHEDULER_HPP__
+#define GRASSMANN_AVERAGES_PCA_ROW_RANGES_SCHEDULER_HPP__
+
+/*!@file
+ * Grassmann averages for robust PCA, distribution of the rows of the chunks between the workers within one iteration.
+ *
+ * The rows of each chunk are processed by ranges of words of 64 rows (the granularity of the packed signs), claimed
+ * from a cursor of the chunk. The task of the chunk (its owner) claims the ranges from the beginning of the chunk, while
+ * the idle workers steal ranges from the busy chunks. The size of the claimed ranges decreases with the number of
+ * remaining rows (guided split), so that the owner takes large ranges at the beginning and the end of the chunk is
+ * shared in small ranges.
+ */
+
+#include <vector>
+#include <algorithm>
+#include <cassert>
+
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_array.hpp>
+
+namespace grassmann_averages_pca
+{
+  namespace details
+  {
+    namespace threading
+    {
+
+      /*!@brief Distributes the words of rows of the chunks between their owner and the stealing workers.
+       *
+       * A chunk is stealable once its owner has prepared its states for the current iteration (see open). The durations
+       * of the owners during the previous iterations give the order in which the chunks should be started (longest first).
+       *
+       * The cursors are reset by the main thread before posting the tasks of an iteration (see reset).
+       */
+      struct row_ranges_scheduler : boost::noncopyable
+      {
+      private:
+        //! State of a chunk.
+        struct chunk_state
+        {
+          boost::atomic<size_t> next_word;  //!< first word not claimed yet
+          boost::atomic<bool> opened;       //!< the chunk may be stolen
+          size_t nb_words;                  //!< number of words of the chunk
+          size_t node;                      //!< node of the chunk
+          double word_duration;             //!< duration of a word measured by the owner, 0 if unknown
+        };
+
+        const size_t nb_chunks;
+        const size_t min_words;
+        boost::scoped_array<chunk_state> v_chunks;
+
+        //! Compares the chunks by decreasing estimated duration.
+        struct longest_first
+        {
+          chunk_state const *p_chunks;
+          longest_first(chunk_state const *p_chunks_) : p_chunks(p_chunks_) {}
+          bool operator()(size_t c1, size_t c2) const
+          {
+            return p_chunks[c1].word_duration * p_chunks[c1].nb_words > p_chunks[c2].word_duration * p_chunks[c2].nb_words;
+          }
+        };
+
+        //! Chunk with the most remaining words among the opened chunks of a node (or all the nodes if @c node is -1).
+        bool select_chunk(size_t node, size_t &chunk) const
+        {
+          size_t max_remaining = 0;
+          for(size_t c = 0; c < nb_chunks; c++)
+          {
+            chunk_state const &current = v_chunks[c];
+            if((node != size_t(-1) && current.node != node) || !current.opened.load(boost::memory_order_acquire))
+            {
+              continue;
+            }
+
+            const size_t next = current.next_word.load(boost::memory_order_relaxed);
+            if(next < current.nb_words && current.nb_words - next > max_remaining)
+            {
+              max_remaining = current.nb_words - next;
+              chunk = c;
+            }
+          }
+          return max_remaining > 0;
+        }
+
+      public:
+        /*!Constructor
+         *
+         * @param nb_chunks_ number of chunks
+         * @param min_words_ minimal number of words of a claimed range
+         */
+        row_ranges_scheduler(size_t nb_chunks_, size_t min_words_ = 4) :
+          nb_chunks(nb_chunks_),
+          min_words(std::max(min_words_, size_t(1))),
+          v_chunks(new chunk_state[nb_chunks_])
+        {
+          for(size_t c = 0; c < nb_chunks; c++)
+          {
+            v_chunks[c].next_word = 0;
+            v_chunks[c].opened = false;
+            v_chunks[c].nb_words = 0;
+            v_chunks[c].node = 0;
+            v_chunks[c].word_duration = 0;
+          }
+        }
+
+        //! Sets the number of words and the node of a chunk.
+        void set_chunk(size_t chunk, size_t nb_words, size_t node)
+        {
+          assert(chunk < nb_chunks);
+          v_chunks[chunk].nb_words = nb_words;
+          v_chunks[chunk].node = node;
+        }
+
+        //! Resets the cursors of all the chunks, before the tasks of an iteration are posted.
+        void reset()
+        {
+          for(size_t c = 0; c < nb_chunks; c++)
+          {
+            v_chunks[c].opened.store(false, boost::memory_order_relaxed);
+            v_chunks[c].next_word.store(0, boost::memory_order_relaxed);
+          }
+        }
+
+        //! Makes the chunk stealable, once its owner prepared the states shared with the stealing workers.
+        void open(size_t chunk)
+        {
+          v_chunks[chunk].opened.store(true, boost::memory_order_release);
+        }
+
+        /*!@brief Claims a range of words of a chunk.
+         *
+         * The size of the range is a quarter of the remaining words, and at least the minimal size given at construction.
+         * @return false if all the words of the chunk were already claimed.
+         */
+        bool claim(size_t chunk, size_t &first_word, size_t &last_word)
+        {
+          chunk_state &current = v_chunks[chunk];
+          size_t next = current.next_word.load(boost::memory_order_relaxed);
+          for(;;)
+          {
+            if(next >= current.nb_words)
+            {
+              return false;
+            }
+
+            const size_t nb_claimed = std::min(current.nb_words - next, std::max(min_words, (current.nb_words - next) / 4));
+            if(current.next_word.compare_exchange_weak(next, next + nb_claimed, boost::memory_order_relaxed))
+            {
+              first_word = next;
+              last_word = next + nb_claimed;
+              return true;
+            }
+          }
+        }
+
+        //! Selects a chunk to steal from, preferably on the node of the worker.
+        //! @return false if there is no word left in the opened chunks.
+        bool select_victim(size_t node, size_t &chunk) const
+        {
+          return select_chunk(node, chunk) || select_chunk(size_t(-1), chunk);
+        }
+
+        //! Records the duration of the words processed by the owner of a chunk.
+        void set_owner_duration(size_t chunk, double seconds, size_t nb_processed_words)
+        {
+          if(nb_processed_words)
+          {
+            v_chunks[chunk].word_duration = seconds / nb_processed_words;
+          }
+        }
+
+        //! Order in which the chunks of each node should be started: the longest chunks of the previous iterations first.
+        std::vector<size_t> chunks_order() const
+        {
+          std::vector<size_t> order(nb_chunks);
+          for(size_t c = 0; c < nb_chunks; c++)
+          {
+            order[c] = c;
+          }
+          std::stable_sort(order.begin(), order.end(), longest_first(v_chunks.get()));
+          return order;
+        }
+      };
+
+    } // namespace threading
+  } // namespace details
+} // namespace grassmann_averages_pca
+
+#endif /* GRASSMANN_AVERAGES_PCA_ROW_RANGES_SCHEDULER_HPP__ */
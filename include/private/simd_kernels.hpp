@@ -0,0 +1,1165 @@
+// Copyright 2014, Max Planck Society.
+// Distributed under the BSD 3-Clause license.
+// (See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/BSD-3-Clause)
+
+#ifndef GRASSMANN_AVERAGES_PCA_SIMD_KERNELS_HPP__
+#define GRASSMANN_AVERAGES_PCA_SIMD_KERNELS_HPP__
+
+/*!@file
+ * Grassmann averages for robust PCA, vectorised kernels.
+ *
+ * This file contains the low level kernels used by the chunk processors (inner products, signed accumulations...).
+ * Each kernel exists in a generic version and, on x86 platforms, in SSE2, AVX2 and AVX-512 versions for @c float and
+ * @c double. The version is selected at runtime from the instruction sets reported by the processor (CPUID), which
+ * means that the same binary runs at full speed on all the machines, without any @c -march compilation flag.
+ *
+ * The specialised versions may be disabled at compilation time by defining @c GRASSMANNPCA_WITHOUT_SIMD_KERNELS.
+ */
+
+#include <cstddef>
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+
+#include <boost/align/aligned_alloc.hpp>
+#include <boost/type_traits/is_same.hpp>
+#include <boost/cstdint.hpp>
+
+
+#if !defined(GRASSMANNPCA_WITHOUT_SIMD_KERNELS) && \
+    (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+  #define GRASSMANNPCA_SIMD_KERNELS_X86
+#endif
+
+
+#ifdef GRASSMANNPCA_SIMD_KERNELS_X86
+  #include <immintrin.h>
+  #if defined(_MSC_VER)
+    #include <intrin.h>
+  #else
+    #include <cpuid.h>
+  #endif
+
+  // The kernels of a specific instruction set are compiled for this instruction set only, whatever the
+  // compilation flags are. This is the reason why they are enclosed in "target" regions.
+  #if defined(__clang__)
+    #define GRASSMANNPCA_SIMD_TARGET_SSE2_BEGIN   _Pragma("clang attribute push (__attribute__((target(\"sse2\"))), apply_to = function)")
+    #define GRASSMANNPCA_SIMD_TARGET_AVX2_BEGIN   _Pragma("clang attribute push (__attribute__((target(\"avx2,fma\"))), apply_to = function)")
+    #define GRASSMANNPCA_SIMD_TARGET_AVX512_BEGIN _Pragma("clang attribute push (__attribute__((target(\"avx512f,avx2,fma\"))), apply_to = function)")
+    #define GRASSMANNPCA_SIMD_TARGET_END          _Pragma("clang attribute pop")
+  #elif defined(__GNUC__)
+    #define GRASSMANNPCA_SIMD_TARGET_SSE2_BEGIN   _Pragma("GCC push_options") _Pragma("GCC target(\"sse2\")")
+    #define GRASSMANNPCA_SIMD_TARGET_AVX2_BEGIN   _Pragma("GCC push_options") _Pragma("GCC target(\"avx2,fma\")")
+    #define GRASSMANNPCA_SIMD_TARGET_AVX512_BEGIN _Pragma("GCC push_options") _Pragma("GCC target(\"avx512f,avx2,fma\")")
+    #define GRASSMANNPCA_SIMD_TARGET_END          _Pragma("GCC pop_options")
+  #else
+    // Visual: the intrinsics are available whatever the /arch flag is
+    #define GRASSMANNPCA_SIMD_TARGET_SSE2_BEGIN
+    #define GRASSMANNPCA_SIMD_TARGET_AVX2_BEGIN
+    #define GRASSMANNPCA_SIMD_TARGET_AVX512_BEGIN
+    #define GRASSMANNPCA_SIMD_TARGET_END
+  #endif
+#endif
+
+
+namespace grassmann_averages_pca
+{
+  namespace details
+  {
+    //! @namespace
+    namespace simd
+    {
+
+      //! Instruction sets for which the kernels are specialised, by increasing order of capabilities.
+      enum instruction_set_t
+      {
+        isa_generic = 0,  //!< Plain C++ implementation
+        isa_sse2,         //!< 128 bits vectors
+        isa_avx2,         //!< 256 bits vectors with fused multiply-add
+        isa_avx512        //!< 512 bits vectors (AVX-512F)
+      };
+
+
+      /*!@brief Returns the best instruction set supported by the processor and the operating system.
+       *
+       * The AVX states should be saved by the operating system for AVX2 and AVX-512 to be usable, which is checked with XGETBV.
+       */
+      inline instruction_set_t detect_instruction_set()
+      {
+#ifdef GRASSMANNPCA_SIMD_KERNELS_X86
+        unsigned int regs[4] = {0, 0, 0, 0};    // eax, ebx, ecx, edx
+
+  #if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        const unsigned int max_leaf = info[0];
+        __cpuid(info, 1);
+        for(int i = 0; i < 4; i++) regs[i] = info[i];
+  #else
+        const unsigned int max_leaf = __get_cpuid_max(0, 0);
+        __cpuid(1, regs[0], regs[1], regs[2], regs[3]);
+  #endif
+
+        instruction_set_t result = isa_generic;
+        if(regs[3] & (1u << 26))
+        {
+          result = isa_sse2;
+        }
+
+        const bool has_osxsave = (regs[2] & (1u << 27)) != 0;
+        const bool has_fma     = (regs[2] & (1u << 12)) != 0;
+        if(!has_osxsave || max_leaf < 7)
+        {
+          return result;
+        }
+
+        // the OS should save the XMM/YMM (bits 1 and 2) and for AVX-512 the opmask/ZMM states (bits 5, 6, 7)
+  #if defined(_MSC_VER)
+        const unsigned long long xcr0 = _xgetbv(0);
+        __cpuidex(info, 7, 0);
+        for(int i = 0; i < 4; i++) regs[i] = info[i];
+  #else
+        unsigned int xcr0_lo, xcr0_hi;
+        __asm__ __volatile__("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+        const unsigned long long xcr0 = (static_cast<unsigned long long>(xcr0_hi) << 32) | xcr0_lo;
+        __cpuid_count(7, 0, regs[0], regs[1], regs[2], regs[3]);
+  #endif
+
+        const bool os_saves_ymm = (xcr0 & 0x6) == 0x6;
+        const bool os_saves_zmm = (xcr0 & 0xe6) == 0xe6;
+
+        if(os_saves_ymm && has_fma && (regs[1] & (1u << 5)))
+        {
+          result = isa_avx2;
+          if(os_saves_zmm && (regs[1] & (1u << 16)))
+          {
+            result = isa_avx512;
+          }
+        }
+        return result;
+#else
+        return isa_generic;
+#endif
+      }
+
+      //!@internal
+      //! Storage for the instruction set in use, initialised with the best detected one.
+      inline instruction_set_t& selected_instruction_set()
+      {
+        static instruction_set_t current = detect_instruction_set();
+        return current;
+      }
+
+      //! Returns the instruction set used by the kernels.
+      inline instruction_set_t current_instruction_set()
+      {
+        return selected_instruction_set();
+      }
+
+      /*!@brief Restricts the instruction set used by the kernels.
+       *
+       * This is mainly intended for testing and benchmarking the different versions of the kernels.
+       * @returns false if the instruction set is not supported by the processor, in which case the current
+       *          selection is not modified.
+       * @warning this function should not be called while an algorithm is running.
+       */
+      inline bool set_instruction_set(instruction_set_t isa)
+      {
+        if(isa > detect_instruction_set())
+        {
+          return false;
+        }
+        selected_instruction_set() = isa;
+        return true;
+      }
+
+      //! Returns the size in bytes of the vector registers of an instruction set.
+      //! This is also the alignment of the data on which the kernels are the most efficient.
+      inline size_t vector_alignment(instruction_set_t isa)
+      {
+        switch(isa)
+        {
+        case isa_avx512:
+          return 64;
+        case isa_avx2:
+          return 32;
+        case isa_sse2:
+          return 16;
+        default:
+          return sizeof(double);
+        }
+      }
+
+      //! Returns the alignment in bytes used for the rows of the data matrices.
+      //! The alignment is never lower than 32 bytes (the alignment that was used before the specialised kernels).
+      inline size_t row_alignment()
+      {
+        const size_t alignment = vector_alignment(current_instruction_set());
+        return alignment < 32 ? 32 : alignment;
+      }
+
+      //! Returns the number of elements of type T of a row of @c nb_elements, after padding
+      //! to the alignment @c alignment (in bytes).
+      template <class T>
+      size_t padded_size(size_t nb_elements, size_t alignment)
+      {
+        const size_t bytes = (nb_elements * sizeof(T) + alignment - 1) & ~(alignment - 1);
+        return bytes / sizeof(T);
+      }
+
+      //! Returns the number of bits set in @c v.
+      inline unsigned int popcount(boost::uint64_t v)
+      {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<unsigned int>(__builtin_popcountll(v));
+#else
+        v = v - ((v >> 1) & 0x5555555555555555ULL);
+        v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+        v = (v + (v >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+        return static_cast<unsigned int>((v * 0x0101010101010101ULL) >> 56);
+#endif
+      }
+
+      //! Returns the @c nb bits starting at the bit @c first of an array of packed words.
+      //! @pre nb <= 32
+      inline unsigned int packed_bits(boost::uint64_t const* words, size_t first, size_t nb)
+      {
+        assert(nb <= 32);
+        const size_t word = first / 64, shift = first % 64;
+        boost::uint64_t bits = words[word] >> shift;
+        if(shift + nb > 64)
+        {
+          bits |= words[word + 1] << (64 - shift);
+        }
+        return static_cast<unsigned int>(bits & ((boost::uint64_t(1) << nb) - 1));
+      }
+
+      //! Returns the index of the lowest bit set in @c v.
+      //! @pre v != 0
+      inline unsigned int count_trailing_zeros(boost::uint64_t v)
+      {
+        assert(v != 0);
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<unsigned int>(__builtin_ctzll(v));
+#elif defined(_MSC_VER) && defined(_M_X64)
+        unsigned long index;
+        _BitScanForward64(&index, v);
+        return static_cast<unsigned int>(index);
+#else
+        unsigned int index = 0;
+        for(; !(v & 1); v >>= 1, index++);
+        return index;
+#endif
+      }
+
+      //! Number of elements of the accumulator processed at once by the kernel @c weighted_rows_sum.
+      //! The corresponding part of the accumulator stays in the L1 cache while all the rows are added.
+      const size_t rows_sum_panel_size = 512;
+
+      //! Allocates an array of @c nb_elements of type T, aligned on @c alignment bytes.
+      //! The array should be released with aligned_free.
+      template <class T>
+      T* aligned_allocate(size_t nb_elements, size_t alignment)
+      {
+        void *p = boost::alignment::aligned_alloc(alignment, nb_elements * sizeof(T) + (nb_elements == 0 ? 1 : 0));
+        if(!p)
+        {
+          throw std::bad_alloc();
+        }
+        return static_cast<T*>(p);
+      }
+
+      //! Releases an array allocated with aligned_allocate.
+      template <class T>
+      void aligned_free(T* p)
+      {
+        boost::alignment::aligned_free(p);
+      }
+
+
+
+      //! Generic versions of the kernels.
+      namespace generic
+      {
+        //! Inner product of two vectors of size n, the first one being possibly stored in a different type.
+        //! The loop is unrolled by blocks of 64 elements, which is more cache/memory bandwidth friendly.
+        template <class T, class U>
+        T inner_product(U const* a, T const* b, size_t n)
+        {
+          U const * const a_end = a + n;
+          const size_t _64_elements = n >> 6;
+          T acc(0);
+
+          for(size_t j = 0; j < _64_elements; j++, a += 64, b += 64)
+          {
+            for(int i = 0; i < 64; i++)
+            {
+              acc += T(a[i]) * b[i];
+            }
+          }
+          for(; a < a_end; a++, b++)
+          {
+            acc += T(*a) * (*b);
+          }
+          return acc;
+        }
+
+        //! Inner products of the vector x with the two vectors a and b, computed in one pass over x.
+        //! The inner product with b is stored in @c *p_ip_b.
+        template <class T, class U>
+        T dual_inner_product(U const* x, T const* a, T const* b, size_t n, T* p_ip_b)
+        {
+          T acc_a(0), acc_b(0);
+          for(size_t i = 0; i < n; i++)
+          {
+            const T v = T(x[i]);
+            acc_a += v * a[i];
+            acc_b += v * b[i];
+          }
+          *p_ip_b = acc_b;
+          return acc_a;
+        }
+
+        //! @f$acc \leftarrow acc + x@f$
+        template <class T>
+        void add(T* acc, T const* x, size_t n)
+        {
+          for(size_t i = 0; i < n; i++)
+          {
+            acc[i] += x[i];
+          }
+        }
+
+        //! @f$acc \leftarrow acc - x@f$
+        template <class T>
+        void sub(T* acc, T const* x, size_t n)
+        {
+          for(size_t i = 0; i < n; i++)
+          {
+            acc[i] -= x[i];
+          }
+        }
+
+        //! @f$acc \leftarrow acc + x@f$ with the compensation of the rounding errors (Kahan), x being possibly of a 
+        //! narrower type. The opposite of the error of each accumulator is kept in @c compensation, the compensated 
+        //! sum being @f$acc - compensation@f$.
+        template <class T, class U>
+        void compensated_add(T* acc, T* compensation, U const* x, size_t n)
+        {
+          for(size_t i = 0; i < n; i++)
+          {
+            const T y = T(x[i]) - compensation[i];
+            const T t = acc[i] + y;
+            compensation[i] = (t - acc[i]) - y;
+            acc[i] = t;
+          }
+        }
+
+        //! @f$acc \leftarrow acc + \alpha x@f$
+        template <class T, class U>
+        void axpy(T* acc, T alpha, U const* x, size_t n)
+        {
+          for(size_t i = 0; i < n; i++)
+          {
+            acc[i] += alpha * T(x[i]);
+          }
+        }
+
+        //! Returns a word in which the bit i is set if @f$values[i] \geq 0@f$.
+        //! @pre n <= 64
+        template <class T>
+        boost::uint64_t positive_mask(T const* values, size_t n)
+        {
+          assert(n <= 64);
+          boost::uint64_t mask = 0;
+          for(size_t i = 0; i < n; i++)
+          {
+            if(values[i] >= 0)
+            {
+              mask |= boost::uint64_t(1) << i;
+            }
+          }
+          return mask;
+        }
+
+        //! Sum of the values strictly between @c low and @c high. The numbers of values below @c low, below or equal 
+        //! to @c low, above @c high and above or equal to @c high are stored in @c p_counts, in this order.
+        template <class T>
+        T bounded_sum(T const* values, size_t n, T low, T high, size_t* p_counts)
+        {
+          T acc(0);
+          size_t nb_below = 0, nb_below_or_equal = 0, nb_above = 0, nb_above_or_equal = 0;
+          for(size_t i = 0; i < n; i++)
+          {
+            const T value = values[i];
+            const T kept[2] = {T(0), value};
+            acc += kept[(value > low) & (value < high)];
+            nb_below += value < low;
+            nb_below_or_equal += value <= low;
+            nb_above += value > high;
+            nb_above_or_equal += value >= high;
+          }
+          p_counts[0] = nb_below;
+          p_counts[1] = nb_below_or_equal;
+          p_counts[2] = nb_above;
+          p_counts[3] = nb_above_or_equal;
+          return acc;
+        }
+
+        //! Copies the values strictly between @c low and @c high to @c p_out, up to @c capacity values, and returns the 
+        //! number of these values (which may exceed @c capacity).
+        template <class T>
+        size_t copy_between(T const* values, size_t n, T low, T high, T* p_out, size_t capacity)
+        {
+          size_t nb_between = 0;
+          for(size_t i = 0; i < n; i++)
+          {
+            const T value = values[i];
+            if((value > low) & (value < high))
+            {
+              if(nb_between < capacity)
+              {
+                p_out[nb_between] = value;
+              }
+              nb_between++;
+            }
+          }
+          return nb_between;
+        }
+
+        //! Copies @c x to @c out, negating the elements whose bit in the packed @c positive_signs is not set. The element 
+        //! i has the bit @c first+i. The stores are not hinted in this version.
+        template <class T>
+        void signed_copy(T* out, T const* x, boost::uint64_t const* positive_signs, size_t first, size_t n, bool /*non_temporal*/)
+        {
+          for(size_t i = 0; i < n; i++)
+          {
+            const bool positive = (positive_signs[(first + i) / 64] >> ((first + i) % 64)) & 1;
+            out[i] = positive ? x[i] : -x[i];
+          }
+        }
+
+        //! @f$acc \leftarrow acc + \sum_r c_r x_r@f$, where the @f$x_r@f$ are @c nb_rows vectors of size n.
+        //! The accumulator is processed by panels, and the rows are added 4 at a time to each panel.
+        template <class T, class U>
+        void weighted_rows_sum(T* acc, U const* const* rows, T const* coefficients, size_t nb_rows, size_t n)
+        {
+          for(size_t panel = 0; panel < n; panel += rows_sum_panel_size)
+          {
+            const size_t panel_end = std::min(n, panel + rows_sum_panel_size);
+
+            size_t r = 0;
+            for(; r + 4 <= nb_rows; r += 4)
+            {
+              U const *x0 = rows[r], *x1 = rows[r+1], *x2 = rows[r+2], *x3 = rows[r+3];
+              const T c0 = coefficients[r], c1 = coefficients[r+1], c2 = coefficients[r+2], c3 = coefficients[r+3];
+              for(size_t i = panel; i < panel_end; i++)
+              {
+                acc[i] += c0 * T(x0[i]) + c1 * T(x1[i]) + c2 * T(x2[i]) + c3 * T(x3[i]);
+              }
+            }
+            for(; r < nb_rows; r++)
+            {
+              U const *x0 = rows[r];
+              const T c0 = coefficients[r];
+              for(size_t i = panel; i < panel_end; i++)
+              {
+                acc[i] += c0 * T(x0[i]);
+              }
+            }
+          }
+        }
+
+        //! @f$out_r \leftarrow out_r + x_r \cdot y@f$, where the @f$x_r@f$ are @c nb_rows vectors of size n.
+        //! The rows are processed 4 at a time, which divides the traffic on y by 4.
+        template <class T>
+        void rows_inner_products(T* out, T const* const* rows, T const* y, size_t nb_rows, size_t n)
+        {
+          size_t r = 0;
+          for(; r + 4 <= nb_rows; r += 4)
+          {
+            T const *x0 = rows[r], *x1 = rows[r+1], *x2 = rows[r+2], *x3 = rows[r+3];
+            T acc0(0), acc1(0), acc2(0), acc3(0);
+            for(size_t i = 0; i < n; i++)
+            {
+              const T v = y[i];
+              acc0 += x0[i] * v;
+              acc1 += x1[i] * v;
+              acc2 += x2[i] * v;
+              acc3 += x3[i] * v;
+            }
+            out[r] += acc0;
+            out[r+1] += acc1;
+            out[r+2] += acc2;
+            out[r+3] += acc3;
+          }
+          for(; r < nb_rows; r++)
+          {
+            out[r] += inner_product(rows[r], y, n);
+          }
+        }
+
+        //! @f$acc \leftarrow acc + \sum_r \pm x_r@f$, where the sign of the row r is negative if @c sign_masks[r] is not 0.
+        //! This kernel is used for computing exact sums of integer data.
+        template <class A, class U>
+        void signed_rows_sum(A* acc, U const* const* rows, A const* sign_masks, size_t nb_rows, size_t n)
+        {
+          for(size_t panel = 0; panel < n; panel += rows_sum_panel_size)
+          {
+            const size_t panel_end = std::min(n, panel + rows_sum_panel_size);
+            for(size_t r = 0; r < nb_rows; r++)
+            {
+              U const *x0 = rows[r];
+              if(sign_masks[r])
+              {
+                for(size_t i = panel; i < panel_end; i++)
+                {
+                  acc[i] -= A(x0[i]);
+                }
+              }
+              else
+              {
+                for(size_t i = panel; i < panel_end; i++)
+                {
+                  acc[i] += A(x0[i]);
+                }
+              }
+            }
+          }
+        }
+      }
+
+
+
+      /*!@brief Table of the kernels for a specific scalar type.
+       *
+       * The table is filled with the versions of the kernels matching the current instruction set.
+       * Copying the table is cheap (a few pointers).
+       */
+      template <class T>
+      struct kernels
+      {
+        //! Inner product of two vectors of size n
+        T (*inner_product)(T const* a, T const* b, size_t n);
+
+        //! @f$acc \leftarrow acc + x@f$ for vectors of size n
+        void (*add)(T* acc, T const* x, size_t n);
+
+        //! @f$acc \leftarrow acc - x@f$ for vectors of size n
+        void (*sub)(T* acc, T const* x, size_t n);
+
+        //! @f$acc \leftarrow acc + x@f$ with the Kahan compensation of the rounding errors, for vectors of size n
+        void (*compensated_add)(T* acc, T* compensation, T const* x, size_t n);
+
+        //! @f$acc \leftarrow acc + \alpha x@f$ for vectors of size n
+        void (*axpy)(T* acc, T alpha, T const* x, size_t n);
+
+        //! @f$acc \leftarrow acc + \sum_r c_r x_r@f$ for @c nb_rows vectors of size n
+        void (*weighted_rows_sum)(T* acc, T const* const* rows, T const* coefficients, size_t nb_rows, size_t n);
+
+        //! @f$out_r \leftarrow out_r + x_r \cdot y@f$ for @c nb_rows vectors of size n (see generic::rows_inner_products)
+        void (*rows_inner_products)(T* out, T const* const* rows, T const* y, size_t nb_rows, size_t n);
+
+        //! Bit i of the returned word is set if @f$values[i] \geq 0@f$, for n <= 64 values
+        boost::uint64_t (*positive_mask)(T const* values, size_t n);
+
+        //! Sum of the values strictly between low and high, with the numbers of values on each side of the bounds (see generic::bounded_sum)
+        T (*bounded_sum)(T const* values, size_t n, T low, T high, size_t* p_counts);
+
+        //! Copies the values strictly between low and high, up to capacity values, and returns their number (see generic::copy_between)
+        size_t (*copy_between)(T const* values, size_t n, T low, T high, T* p_out, size_t capacity);
+
+        //! Copies x to out with the signs of the packed bits, optionally with non-temporal stores (see generic::signed_copy)
+        void (*signed_copy)(T* out, T const* x, boost::uint64_t const* positive_signs, size_t first, size_t n, bool non_temporal);
+      };
+
+      //!@internal
+      //! Returns the table of the generic kernels.
+      template <class T>
+      kernels<T> make_generic_kernels()
+      {
+        kernels<T> k;
+        k.inner_product = &generic::inner_product<T, T>;
+        k.add = &generic::add<T>;
+        k.sub = &generic::sub<T>;
+        k.compensated_add = &generic::compensated_add<T, T>;
+        k.axpy = &generic::axpy<T, T>;
+        k.weighted_rows_sum = &generic::weighted_rows_sum<T, T>;
+        k.rows_inner_products = &generic::rows_inner_products<T>;
+        k.positive_mask = &generic::positive_mask<T>;
+        k.bounded_sum = &generic::bounded_sum<T>;
+        k.copy_between = &generic::copy_between<T>;
+        k.signed_copy = &generic::signed_copy<T>;
+        return k;
+      }
+
+
+      /*!@brief Type of the exact accumulators of the storage type U.
+       *
+       * The sums of 8 bits data are accumulated in 32 bits integers, the sums of 16 bits data in 64 bits integers.
+       * The floating point types accumulate in their own type.
+       */
+      template <class U>
+      struct storage_accumulator
+      {
+        typedef U type;
+      };
+
+      template <>
+      struct storage_accumulator<boost::uint8_t>
+      {
+        typedef boost::int32_t type;
+      };
+
+      template <>
+      struct storage_accumulator<boost::uint16_t>
+      {
+        typedef boost::int64_t type;
+      };
+
+
+      /*!@brief Table of the kernels operating on data stored with type U, with computations performed in type T.
+       *
+       * This is used when the data is kept in a compact type (eg. 8 bits pixels) while the basis vectors are
+       * floating point vectors.
+       */
+      template <class U, class T>
+      struct storage_kernels
+      {
+        //! Type of the exact accumulator for U
+        typedef typename storage_accumulator<U>::type accumulator_t;
+
+        //! Inner product of the stored vector x and the vector y, of size n
+        T (*inner_product)(U const* x, T const* y, size_t n);
+
+        //! Inner products of the stored vector x with a and b in one pass over x, the second one being stored in @c *p_ip_b
+        T (*dual_inner_product)(U const* x, T const* a, T const* b, size_t n, T* p_ip_b);
+
+        //! @f$acc \leftarrow acc + \alpha x@f$ for vectors of size n
+        void (*axpy)(T* acc, T alpha, U const* x, size_t n);
+
+        //! @f$acc \leftarrow acc + \sum_r c_r x_r@f$ for @c nb_rows stored vectors of size n
+        void (*weighted_rows_sum)(T* acc, U const* const* rows, T const* coefficients, size_t nb_rows, size_t n);
+
+        //! Exact @f$acc \leftarrow acc + \sum_r \pm x_r@f$, the sign of the row r being negative if @c sign_masks[r]
+        //! is -1 and positive if it is 0.
+        void (*signed_rows_sum)(accumulator_t* acc, U const* const* rows, accumulator_t const* sign_masks, size_t nb_rows, size_t n);
+      };
+
+      //!@internal
+      //! Returns the table of the generic storage kernels.
+      template <class U, class T>
+      storage_kernels<U, T> make_generic_storage_kernels()
+      {
+        typedef typename storage_accumulator<U>::type accumulator_t;
+        storage_kernels<U, T> k;
+        k.inner_product = &generic::inner_product<T, U>;
+        k.dual_inner_product = &generic::dual_inner_product<T, U>;
+        k.axpy = &generic::axpy<T, U>;
+        k.weighted_rows_sum = &generic::weighted_rows_sum<T, U>;
+        k.signed_rows_sum = &generic::signed_rows_sum<accumulator_t, U>;
+        return k;
+      }
+
+
+
+#ifdef GRASSMANNPCA_SIMD_KERNELS_X86
+
+      //!@internal
+      //! Reads 4 bytes from an unaligned location.
+      inline int load_4_bytes(void const* p)
+      {
+        int v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+      }
+
+      //! SSE2 versions of the kernels
+      GRASSMANNPCA_SIMD_TARGET_SSE2_BEGIN
+      namespace sse2
+      {
+        template <class T> struct vector_traits;
+
+        template <>
+        struct vector_traits<float>
+        {
+          typedef __m128 register_t;
+          static const size_t width = 4;
+          static inline register_t zero()                                           { return _mm_setzero_ps(); }
+          static inline register_t set1(float v)                                    { return _mm_set1_ps(v); }
+          static inline register_t load(float const* p)                             { return _mm_loadu_ps(p); }
+          static inline register_t load(boost::uint8_t const* p)
+          {
+            const __m128i z = _mm_setzero_si128();
+            return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(load_4_bytes(p)), z), z));
+          }
+          static inline register_t load(boost::uint16_t const* p)
+          {
+            return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(p)), _mm_setzero_si128()));
+          }
+          static inline void store(float* p, register_t v)                          { _mm_storeu_ps(p, v); }
+          static inline void stream(float* p, register_t v)                         { _mm_stream_ps(p, v); }
+          static inline register_t negate_lanes(register_t v, unsigned int bits)
+          {
+            const __m128i lanes = _mm_setr_epi32(1, 2, 4, 8);
+            const __m128i selected = _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(static_cast<int>(bits)), lanes), lanes);
+            return _mm_xor_ps(v, _mm_and_ps(_mm_castsi128_ps(selected), _mm_set1_ps(-0.f)));
+          }
+          static inline register_t add(register_t a, register_t b)                  { return _mm_add_ps(a, b); }
+          static inline register_t sub(register_t a, register_t b)                  { return _mm_sub_ps(a, b); }
+          static inline register_t mul(register_t a, register_t b)                  { return _mm_mul_ps(a, b); }
+          static inline register_t fmadd(register_t a, register_t b, register_t c)  { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+          static inline unsigned int positive_mask(register_t v)                    { return _mm_movemask_ps(_mm_cmpge_ps(v, _mm_setzero_ps())); }
+          static inline unsigned int less_mask(register_t a, register_t b)          { return _mm_movemask_ps(_mm_cmplt_ps(a, b)); }
+          static inline unsigned int less_equal_mask(register_t a, register_t b)    { return _mm_movemask_ps(_mm_cmple_ps(a, b)); }
+          static inline register_t keep_between(register_t v, register_t l, register_t h) { return _mm_and_ps(v, _mm_and_ps(_mm_cmpgt_ps(v, l), _mm_cmplt_ps(v, h))); }
+          static inline float reduce_add(register_t v)
+          {
+            v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+            v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+            return _mm_cvtss_f32(v);
+          }
+        };
+
+        template <>
+        struct vector_traits<double>
+        {
+          typedef __m128d register_t;
+          static const size_t width = 2;
+          static inline register_t zero()                                           { return _mm_setzero_pd(); }
+          static inline register_t set1(double v)                                   { return _mm_set1_pd(v); }
+          static inline register_t load(double const* p)                            { return _mm_loadu_pd(p); }
+          static inline register_t load(boost::uint8_t const* p)                    { return _mm_set_pd(p[1], p[0]); }
+          static inline register_t load(boost::uint16_t const* p)                   { return _mm_set_pd(p[1], p[0]); }
+          static inline void store(double* p, register_t v)                         { _mm_storeu_pd(p, v); }
+          static inline void stream(double* p, register_t v)                        { _mm_stream_pd(p, v); }
+          static inline register_t negate_lanes(register_t v, unsigned int bits)
+          {
+            const __m128i lanes = _mm_setr_epi32(1, 1, 2, 2);
+            const __m128i selected = _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(static_cast<int>(bits)), lanes), lanes);
+            return _mm_xor_pd(v, _mm_and_pd(_mm_castsi128_pd(selected), _mm_set1_pd(-0.)));
+          }
+          static inline register_t add(register_t a, register_t b)                  { return _mm_add_pd(a, b); }
+          static inline register_t sub(register_t a, register_t b)                  { return _mm_sub_pd(a, b); }
+          static inline register_t mul(register_t a, register_t b)                  { return _mm_mul_pd(a, b); }
+          static inline register_t fmadd(register_t a, register_t b, register_t c)  { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+          static inline unsigned int positive_mask(register_t v)                    { return _mm_movemask_pd(_mm_cmpge_pd(v, _mm_setzero_pd())); }
+          static inline unsigned int less_mask(register_t a, register_t b)          { return _mm_movemask_pd(_mm_cmplt_pd(a, b)); }
+          static inline unsigned int less_equal_mask(register_t a, register_t b)    { return _mm_movemask_pd(_mm_cmple_pd(a, b)); }
+          static inline register_t keep_between(register_t v, register_t l, register_t h) { return _mm_and_pd(v, _mm_and_pd(_mm_cmpgt_pd(v, l), _mm_cmplt_pd(v, h))); }
+          static inline double reduce_add(register_t v)
+          {
+            return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+          }
+        };
+
+        template <>
+        struct vector_traits<boost::int32_t>
+        {
+          typedef __m128i register_t;
+          static const size_t width = 4;
+          static inline register_t set1(boost::int32_t v)                           { return _mm_set1_epi32(v); }
+          static inline register_t load(boost::int32_t const* p)                    { return _mm_loadu_si128(reinterpret_cast<__m128i const*>(p)); }
+          static inline register_t load(boost::uint8_t const* p)
+          {
+            const __m128i z = _mm_setzero_si128();
+            return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(load_4_bytes(p)), z), z);
+          }
+          static inline void store(boost::int32_t* p, register_t v)                 { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+          static inline register_t add(register_t a, register_t b)                  { return _mm_add_epi32(a, b); }
+          static inline register_t sub(register_t a, register_t b)                  { return _mm_sub_epi32(a, b); }
+          static inline register_t bit_xor(register_t a, register_t b)              { return _mm_xor_si128(a, b); }
+        };
+
+        template <>
+        struct vector_traits<boost::int64_t>
+        {
+          typedef __m128i register_t;
+          static const size_t width = 2;
+          static inline register_t set1(boost::int64_t v)                           { return _mm_set1_epi64x(v); }
+          static inline register_t load(boost::int64_t const* p)                    { return _mm_loadu_si128(reinterpret_cast<__m128i const*>(p)); }
+          static inline register_t load(boost::uint16_t const* p)
+          {
+            const __m128i z = _mm_setzero_si128();
+            return _mm_unpacklo_epi32(_mm_unpacklo_epi16(_mm_cvtsi32_si128(load_4_bytes(p)), z), z);
+          }
+          static inline void store(boost::int64_t* p, register_t v)                 { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+          static inline register_t add(register_t a, register_t b)                  { return _mm_add_epi64(a, b); }
+          static inline register_t sub(register_t a, register_t b)                  { return _mm_sub_epi64(a, b); }
+          static inline register_t bit_xor(register_t a, register_t b)              { return _mm_xor_si128(a, b); }
+        };
+
+        #include <include/private/simd_kernels_body.hpp>
+      }
+      GRASSMANNPCA_SIMD_TARGET_END
+
+
+
+      //! AVX2 versions of the kernels
+      GRASSMANNPCA_SIMD_TARGET_AVX2_BEGIN
+      namespace avx2
+      {
+        template <class T> struct vector_traits;
+
+        template <>
+        struct vector_traits<float>
+        {
+          typedef __m256 register_t;
+          static const size_t width = 8;
+          static inline register_t zero()                                           { return _mm256_setzero_ps(); }
+          static inline register_t set1(float v)                                    { return _mm256_set1_ps(v); }
+          static inline register_t load(float const* p)                             { return _mm256_loadu_ps(p); }
+          static inline register_t load(boost::uint8_t const* p)
+          {
+            return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(p))));
+          }
+          static inline register_t load(boost::uint16_t const* p)
+          {
+            return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(p))));
+          }
+          static inline void store(float* p, register_t v)                          { _mm256_storeu_ps(p, v); }
+          static inline void stream(float* p, register_t v)                         { _mm256_stream_ps(p, v); }
+          static inline register_t negate_lanes(register_t v, unsigned int bits)
+          {
+            const __m256i lanes = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+            const __m256i selected = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(static_cast<int>(bits)), lanes), lanes);
+            return _mm256_xor_ps(v, _mm256_and_ps(_mm256_castsi256_ps(selected), _mm256_set1_ps(-0.f)));
+          }
+          static inline register_t add(register_t a, register_t b)                  { return _mm256_add_ps(a, b); }
+          static inline register_t sub(register_t a, register_t b)                  { return _mm256_sub_ps(a, b); }
+          static inline register_t mul(register_t a, register_t b)                  { return _mm256_mul_ps(a, b); }
+          static inline register_t fmadd(register_t a, register_t b, register_t c)  { return _mm256_fmadd_ps(a, b, c); }
+          static inline unsigned int positive_mask(register_t v)                    { return _mm256_movemask_ps(_mm256_cmp_ps(v, _mm256_setzero_ps(), _CMP_GE_OQ)); }
+          static inline unsigned int less_mask(register_t a, register_t b)          { return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_LT_OQ)); }
+          static inline unsigned int less_equal_mask(register_t a, register_t b)    { return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_LE_OQ)); }
+          static inline register_t keep_between(register_t v, register_t l, register_t h) { return _mm256_and_ps(v, _mm256_and_ps(_mm256_cmp_ps(v, l, _CMP_GT_OQ), _mm256_cmp_ps(v, h, _CMP_LT_OQ))); }
+          static inline float reduce_add(register_t v)
+          {
+            __m128 r = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+            r = _mm_add_ps(r, _mm_movehl_ps(r, r));
+            r = _mm_add_ss(r, _mm_shuffle_ps(r, r, 1));
+            return _mm_cvtss_f32(r);
+          }
+        };
+
+        template <>
+        struct vector_traits<double>
+        {
+          typedef __m256d register_t;
+          static const size_t width = 4;
+          static inline register_t zero()                                           { return _mm256_setzero_pd(); }
+          static inline register_t set1(double v)                                   { return _mm256_set1_pd(v); }
+          static inline register_t load(double const* p)                            { return _mm256_loadu_pd(p); }
+          static inline register_t load(boost::uint8_t const* p)
+          {
+            return _mm256_cvtepi32_pd(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(load_4_bytes(p))));
+          }
+          static inline register_t load(boost::uint16_t const* p)
+          {
+            return _mm256_cvtepi32_pd(_mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(p))));
+          }
+          static inline void store(double* p, register_t v)                         { _mm256_storeu_pd(p, v); }
+          static inline void stream(double* p, register_t v)                        { _mm256_stream_pd(p, v); }
+          static inline register_t negate_lanes(register_t v, unsigned int bits)
+          {
+            const __m256i lanes = _mm256_setr_epi64x(1, 2, 4, 8);
+            const __m256i selected = _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_set1_epi64x(bits), lanes), lanes);
+            return _mm256_xor_pd(v, _mm256_and_pd(_mm256_castsi256_pd(selected), _mm256_set1_pd(-0.)));
+          }
+          static inline register_t add(register_t a, register_t b)                  { return _mm256_add_pd(a, b); }
+          static inline register_t sub(register_t a, register_t b)                  { return _mm256_sub_pd(a, b); }
+          static inline register_t mul(register_t a, register_t b)                  { return _mm256_mul_pd(a, b); }
+          static inline register_t fmadd(register_t a, register_t b, register_t c)  { return _mm256_fmadd_pd(a, b, c); }
+          static inline unsigned int positive_mask(register_t v)                    { return _mm256_movemask_pd(_mm256_cmp_pd(v, _mm256_setzero_pd(), _CMP_GE_OQ)); }
+          static inline unsigned int less_mask(register_t a, register_t b)          { return _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_LT_OQ)); }
+          static inline unsigned int less_equal_mask(register_t a, register_t b)    { return _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_LE_OQ)); }
+          static inline register_t keep_between(register_t v, register_t l, register_t h) { return _mm256_and_pd(v, _mm256_and_pd(_mm256_cmp_pd(v, l, _CMP_GT_OQ), _mm256_cmp_pd(v, h, _CMP_LT_OQ))); }
+          static inline double reduce_add(register_t v)
+          {
+            __m128d r = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+            return _mm_cvtsd_f64(_mm_add_sd(r, _mm_unpackhi_pd(r, r)));
+          }
+        };
+
+        template <>
+        struct vector_traits<boost::int32_t>
+        {
+          typedef __m256i register_t;
+          static const size_t width = 8;
+          static inline register_t set1(boost::int32_t v)                           { return _mm256_set1_epi32(v); }
+          static inline register_t load(boost::int32_t const* p)                    { return _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p)); }
+          static inline register_t load(boost::uint8_t const* p)                    { return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(p))); }
+          static inline void store(boost::int32_t* p, register_t v)                 { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+          static inline register_t add(register_t a, register_t b)                  { return _mm256_add_epi32(a, b); }
+          static inline register_t sub(register_t a, register_t b)                  { return _mm256_sub_epi32(a, b); }
+          static inline register_t bit_xor(register_t a, register_t b)              { return _mm256_xor_si256(a, b); }
+        };
+
+        template <>
+        struct vector_traits<boost::int64_t>
+        {
+          typedef __m256i register_t;
+          static const size_t width = 4;
+          static inline register_t set1(boost::int64_t v)                           { return _mm256_set1_epi64x(v); }
+          static inline register_t load(boost::int64_t const* p)                    { return _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p)); }
+          static inline register_t load(boost::uint16_t const* p)                   { return _mm256_cvtepu16_epi64(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(p))); }
+          static inline void store(boost::int64_t* p, register_t v)                 { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+          static inline register_t add(register_t a, register_t b)                  { return _mm256_add_epi64(a, b); }
+          static inline register_t sub(register_t a, register_t b)                  { return _mm256_sub_epi64(a, b); }
+          static inline register_t bit_xor(register_t a, register_t b)              { return _mm256_xor_si256(a, b); }
+        };
+
+        #include <include/private/simd_kernels_body.hpp>
+      }
+      GRASSMANNPCA_SIMD_TARGET_END
+
+
+
+      //! AVX-512 versions of the kernels
+      GRASSMANNPCA_SIMD_TARGET_AVX512_BEGIN
+      namespace avx512
+      {
+        template <class T> struct vector_traits;
+
+        template <>
+        struct vector_traits<float>
+        {
+          typedef __m512 register_t;
+          static const size_t width = 16;
+          static inline register_t zero()                                           { return _mm512_setzero_ps(); }
+          static inline register_t set1(float v)                                    { return _mm512_set1_ps(v); }
+          static inline register_t load(float const* p)                             { return _mm512_loadu_ps(p); }
+          static inline register_t load(boost::uint8_t const* p)
+          {
+            return _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(p))));
+          }
+          static inline register_t load(boost::uint16_t const* p)
+          {
+            return _mm512_cvtepi32_ps(_mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(p))));
+          }
+          static inline void store(float* p, register_t v)                          { _mm512_storeu_ps(p, v); }
+          static inline void stream(float* p, register_t v)                         { _mm512_stream_ps(p, v); }
+          static inline register_t negate_lanes(register_t v, unsigned int bits)
+          {
+            const __m512i i = _mm512_castps_si512(v);
+            return _mm512_castsi512_ps(_mm512_mask_xor_epi32(i, static_cast<__mmask16>(bits), i, _mm512_set1_epi32(0x80000000)));
+          }
+          static inline register_t add(register_t a, register_t b)                  { return _mm512_add_ps(a, b); }
+          static inline register_t sub(register_t a, register_t b)                  { return _mm512_sub_ps(a, b); }
+          static inline register_t mul(register_t a, register_t b)                  { return _mm512_mul_ps(a, b); }
+          static inline register_t fmadd(register_t a, register_t b, register_t c)  { return _mm512_fmadd_ps(a, b, c); }
+          static inline unsigned int positive_mask(register_t v)                    { return _mm512_cmp_ps_mask(v, _mm512_setzero_ps(), _CMP_GE_OQ); }
+          static inline unsigned int less_mask(register_t a, register_t b)          { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+          static inline unsigned int less_equal_mask(register_t a, register_t b)    { return _mm512_cmp_ps_mask(a, b, _CMP_LE_OQ); }
+          static inline register_t keep_between(register_t v, register_t l, register_t h) { return _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(v, l, _CMP_GT_OQ) & _mm512_cmp_ps_mask(v, h, _CMP_LT_OQ), v); }
+          static inline float reduce_add(register_t v)                              { return _mm512_reduce_add_ps(v); }
+        };
+
+        template <>
+        struct vector_traits<double>
+        {
+          typedef __m512d register_t;
+          static const size_t width = 8;
+          static inline register_t zero()                                           { return _mm512_setzero_pd(); }
+          static inline register_t set1(double v)                                   { return _mm512_set1_pd(v); }
+          static inline register_t load(double const* p)                            { return _mm512_loadu_pd(p); }
+          static inline register_t load(boost::uint8_t const* p)
+          {
+            return _mm512_cvtepi32_pd(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const*>(p))));
+          }
+          static inline register_t load(boost::uint16_t const* p)
+          {
+            return _mm512_cvtepi32_pd(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(p))));
+          }
+          static inline void store(double* p, register_t v)                         { _mm512_storeu_pd(p, v); }
+          static inline void stream(double* p, register_t v)                        { _mm512_stream_pd(p, v); }
+          static inline register_t negate_lanes(register_t v, unsigned int bits)
+          {
+            const __m512i i = _mm512_castpd_si512(v);
+            return _mm512_castsi512_pd(_mm512_mask_xor_epi64(i, static_cast<__mmask8>(bits), i, _mm512_set1_epi64(0x8000000000000000LL)));
+          }
+          static inline register_t add(register_t a, register_t b)                  { return _mm512_add_pd(a, b); }
+          static inline register_t sub(register_t a, register_t b)                  { return _mm512_sub_pd(a, b); }
+          static inline register_t mul(register_t a, register_t b)                  { return _mm512_mul_pd(a, b); }
+          static inline register_t fmadd(register_t a, register_t b, register_t c)  { return _mm512_fmadd_pd(a, b, c); }
+          static inline unsigned int positive_mask(register_t v)                    { return _mm512_cmp_pd_mask(v, _mm512_setzero_pd(), _CMP_GE_OQ); }
+          static inline unsigned int less_mask(register_t a, register_t b)          { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+          static inline unsigned int less_equal_mask(register_t a, register_t b)    { return _mm512_cmp_pd_mask(a, b, _CMP_LE_OQ); }
+          static inline register_t keep_between(register_t v, register_t l, register_t h) { return _mm512_maskz_mov_pd(_mm512_cmp_pd_mask(v, l, _CMP_GT_OQ) & _mm512_cmp_pd_mask(v, h, _CMP_LT_OQ), v); }
+          static inline double reduce_add(register_t v)                             { return _mm512_reduce_add_pd(v); }
+        };
+
+        template <>
+        struct vector_traits<boost::int32_t>
+        {
+          typedef __m512i register_t;
+          static const size_t width = 16;
+          static inline register_t set1(boost::int32_t v)                           { return _mm512_set1_epi32(v); }
+          static inline register_t load(boost::int32_t const* p)                    { return _mm512_loadu_si512(p); }
+          static inline register_t load(boost::uint8_t const* p)                    { return _mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(p))); }
+          static inline void store(boost::int32_t* p, register_t v)                 { _mm512_storeu_si512(p, v); }
+          static inline register_t add(register_t a, register_t b)                  { return _mm512_add_epi32(a, b); }
+          static inline register_t sub(register_t a, register_t b)                  { return _mm512_sub_epi32(a, b); }
+          static inline register_t bit_xor(register_t a, register_t b)              { return _mm512_xor_si512(a, b); }
+        };
+
+        template <>
+        struct vector_traits<boost::int64_t>
+        {
+          typedef __m512i register_t;
+          static const size_t width = 8;
+          static inline register_t set1(boost::int64_t v)                           { return _mm512_set1_epi64(v); }
+          static inline register_t load(boost::int64_t const* p)                    { return _mm512_loadu_si512(p); }
+          static inline register_t load(boost::uint16_t const* p)                   { return _mm512_cvtepu16_epi64(_mm_loadu_si128(reinterpret_cast<__m128i const*>(p))); }
+          static inline void store(boost::int64_t* p, register_t v)                 { _mm512_storeu_si512(p, v); }
+          static inline register_t add(register_t a, register_t b)                  { return _mm512_add_epi64(a, b); }
+          static inline register_t sub(register_t a, register_t b)                  { return _mm512_sub_epi64(a, b); }
+          static inline register_t bit_xor(register_t a, register_t b)              { return _mm512_xor_si512(a, b); }
+        };
+
+        #include <include/private/simd_kernels_body.hpp>
+      }
+      GRASSMANNPCA_SIMD_TARGET_END
+
+#endif /* GRASSMANNPCA_SIMD_KERNELS_X86 */
+
+
+
+      //!@internal
+      //! Selects the kernels of the current instruction set. Only float and double have specialised kernels.
+      template <class T>
+      struct kernels_selector
+      {
+        static kernels<T> get(instruction_set_t)
+        {
+          return make_generic_kernels<T>();
+        }
+      };
+
+#ifdef GRASSMANNPCA_SIMD_KERNELS_X86
+      //!@internal
+      template <class T>
+      struct kernels_selector_floating_point
+      {
+        static kernels<T> get(instruction_set_t isa)
+        {
+          switch(isa)
+          {
+          case isa_avx512:
+            return avx512::make_kernels<T>();
+          case isa_avx2:
+            return avx2::make_kernels<T>();
+          case isa_sse2:
+            return sse2::make_kernels<T>();
+          default:
+            return make_generic_kernels<T>();
+          }
+        }
+      };
+
+      template <>
+      struct kernels_selector<float> : kernels_selector_floating_point<float>
+      {};
+
+      template <>
+      struct kernels_selector<double> : kernels_selector_floating_point<double>
+      {};
+#endif
+
+      //!@internal
+      //! Selects the storage kernels of the current instruction set. Only the compact integer types and the floating point
+      //! types have specialised kernels.
+      template <class U, class T>
+      struct storage_kernels_selector
+      {
+        static storage_kernels<U, T> get(instruction_set_t)
+        {
+          return make_generic_storage_kernels<U, T>();
+        }
+      };
+
+#ifdef GRASSMANNPCA_SIMD_KERNELS_X86
+      //!@internal
+      template <class U, class T>
+      struct storage_kernels_selector_specialised
+      {
+        static storage_kernels<U, T> get(instruction_set_t isa)
+        {
+          switch(isa)
+          {
+          case isa_avx512:
+            return avx512::make_storage_kernels<U, T>();
+          case isa_avx2:
+            return avx2::make_storage_kernels<U, T>();
+          case isa_sse2:
+            return sse2::make_storage_kernels<U, T>();
+          default:
+            return make_generic_storage_kernels<U, T>();
+          }
+        }
+      };
+
+      template <>
+      struct storage_kernels_selector<boost::uint8_t, float> : storage_kernels_selector_specialised<boost::uint8_t, float>
+      {};
+
+      template <>
+      struct storage_kernels_selector<boost::uint8_t, double> : storage_kernels_selector_specialised<boost::uint8_t, double>
+      {};
+
+      template <>
+      struct storage_kernels_selector<boost::uint16_t, float> : storage_kernels_selector_specialised<boost::uint16_t, float>
+      {};
+
+      template <>
+      struct storage_kernels_selector<boost::uint16_t, double> : storage_kernels_selector_specialised<boost::uint16_t, double>
+      {};
+
+      template <>
+      struct storage_kernels_selector<float, float> : storage_kernels_selector_specialised<float, float>
+      {};
+
+      template <>
+      struct storage_kernels_selector<double, double> : storage_kernels_selector_specialised<double, double>
+      {};
+#endif
+
+      //! Returns the kernels for the scalar type T and the current instruction set.
+      template <class T>
+      kernels<T> get_kernels()
+      {
+        return kernels_selector<T>::get(current_instruction_set());
+      }
+
+      //! Returns the kernels for the scalar type T and the specified instruction set.
+      //! @pre the instruction set is supported by the processor.
+      template <class T>
+      kernels<T> get_kernels(instruction_set_t isa)
+      {
+        assert(isa <= detect_instruction_set());
+        return kernels_selector<T>::get(isa);
+      }
+
+      //! Returns the kernels for data stored with type U and computations in type T, for the current instruction set.
+      template <class U, class T>
+      storage_kernels<U, T> get_storage_kernels()
+      {
+        return storage_kernels_selector<U, T>::get(current_instruction_set());
+      }
+
+      //! Returns the kernels for data stored with type U and computations in type T, for the specified instruction set.
+      //! @pre the instruction set is supported by the processor.
+      template <class U, class T>
+      storage_kernels<U, T> get_storage_kernels(instruction_set_t isa)
+      {
+        assert(isa <= detect_instruction_set());
+        return storage_kernels_selector<U, T>::get(isa);
+      }
+
+    } // namespace simd
+  } // namespace details
+} // namespace grassmann_averages_pca
+
+
+#endif /* GRASSMANN_AVERAGES_PCA_SIMD_KERNELS_HPP__ */
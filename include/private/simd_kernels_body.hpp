@@ -0,0 +1,498 @@
+// Copyright 2014, Max Planck Society.
+// Distributed under the BSD 3-Clause license.
+// (See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/BSD-3-Clause)
+
+/*!@file
+ * Body of the vectorised kernels.
+ *
+ * This file is included several times by simd_kernels.hpp (hence no include guard), once in each of the
+ * namespaces dedicated to an instruction set. The including namespace should provide a @c vector_traits
+ * template, specialised for float and double, that abstracts the intrinsics of the instruction set.
+ */
+
+//! Inner product of two vectors of size n, the first one being possibly stored in a compact type U.
+//! Four independent accumulators are used in order to hide the latency of the multiply-add.
+template <class T, class U>
+T inner_product(U const* a, T const* b, size_t n)
+{
+  typedef vector_traits<T> vt;
+  typedef typename vt::register_t register_t;
+  const size_t w = vt::width;
+
+  register_t acc0 = vt::zero(), acc1 = vt::zero(), acc2 = vt::zero(), acc3 = vt::zero();
+
+  size_t i = 0;
+  for(; i + 4*w <= n; i += 4*w)
+  {
+    acc0 = vt::fmadd(vt::load(a + i      ), vt::load(b + i      ), acc0);
+    acc1 = vt::fmadd(vt::load(a + i +   w), vt::load(b + i +   w), acc1);
+    acc2 = vt::fmadd(vt::load(a + i + 2*w), vt::load(b + i + 2*w), acc2);
+    acc3 = vt::fmadd(vt::load(a + i + 3*w), vt::load(b + i + 3*w), acc3);
+  }
+  for(; i + w <= n; i += w)
+  {
+    acc0 = vt::fmadd(vt::load(a + i), vt::load(b + i), acc0);
+  }
+
+  T acc = vt::reduce_add(vt::add(vt::add(acc0, acc1), vt::add(acc2, acc3)));
+  for(; i < n; i++)
+  {
+    acc += T(a[i]) * b[i];
+  }
+  return acc;
+}
+
+//! Inner products of x with a and b in one pass over x (eg. the basis vector being deflated and the next @f$\mu@f$).
+//! The inner product with b is stored in @c *p_ip_b.
+template <class T, class U>
+T dual_inner_product(U const* x, T const* a, T const* b, size_t n, T* p_ip_b)
+{
+  typedef vector_traits<T> vt;
+  typedef typename vt::register_t register_t;
+  const size_t w = vt::width;
+
+  register_t acc_a0 = vt::zero(), acc_a1 = vt::zero(), acc_b0 = vt::zero(), acc_b1 = vt::zero();
+
+  size_t i = 0;
+  for(; i + 2*w <= n; i += 2*w)
+  {
+    const register_t x0 = vt::load(x + i), x1 = vt::load(x + i + w);
+    acc_a0 = vt::fmadd(x0, vt::load(a + i    ), acc_a0);
+    acc_b0 = vt::fmadd(x0, vt::load(b + i    ), acc_b0);
+    acc_a1 = vt::fmadd(x1, vt::load(a + i + w), acc_a1);
+    acc_b1 = vt::fmadd(x1, vt::load(b + i + w), acc_b1);
+  }
+  for(; i + w <= n; i += w)
+  {
+    const register_t x0 = vt::load(x + i);
+    acc_a0 = vt::fmadd(x0, vt::load(a + i), acc_a0);
+    acc_b0 = vt::fmadd(x0, vt::load(b + i), acc_b0);
+  }
+
+  T ip_a = vt::reduce_add(vt::add(acc_a0, acc_a1));
+  T ip_b = vt::reduce_add(vt::add(acc_b0, acc_b1));
+  for(; i < n; i++)
+  {
+    ip_a += T(x[i]) * a[i];
+    ip_b += T(x[i]) * b[i];
+  }
+  *p_ip_b = ip_b;
+  return ip_a;
+}
+
+//! @f$acc \leftarrow acc + x@f$
+template <class T>
+void add(T* acc, T const* x, size_t n)
+{
+  typedef vector_traits<T> vt;
+  const size_t w = vt::width;
+
+  size_t i = 0;
+  for(; i + 2*w <= n; i += 2*w)
+  {
+    vt::store(acc + i,     vt::add(vt::load(acc + i),     vt::load(x + i)));
+    vt::store(acc + i + w, vt::add(vt::load(acc + i + w), vt::load(x + i + w)));
+  }
+  for(; i + w <= n; i += w)
+  {
+    vt::store(acc + i, vt::add(vt::load(acc + i), vt::load(x + i)));
+  }
+  for(; i < n; i++)
+  {
+    acc[i] += x[i];
+  }
+}
+
+//! @f$acc \leftarrow acc - x@f$
+template <class T>
+void sub(T* acc, T const* x, size_t n)
+{
+  typedef vector_traits<T> vt;
+  const size_t w = vt::width;
+
+  size_t i = 0;
+  for(; i + 2*w <= n; i += 2*w)
+  {
+    vt::store(acc + i,     vt::sub(vt::load(acc + i),     vt::load(x + i)));
+    vt::store(acc + i + w, vt::sub(vt::load(acc + i + w), vt::load(x + i + w)));
+  }
+  for(; i + w <= n; i += w)
+  {
+    vt::store(acc + i, vt::sub(vt::load(acc + i), vt::load(x + i)));
+  }
+  for(; i < n; i++)
+  {
+    acc[i] -= x[i];
+  }
+}
+
+//! @f$acc \leftarrow acc + x@f$ with the compensation of the rounding errors (Kahan), see generic::compensated_add.
+template <class T>
+void compensated_add(T* acc, T* compensation, T const* x, size_t n)
+{
+  typedef vector_traits<T> vt;
+  typedef typename vt::register_t register_t;
+  const size_t w = vt::width;
+
+  size_t i = 0;
+  for(; i + w <= n; i += w)
+  {
+    const register_t a = vt::load(acc + i);
+    const register_t y = vt::sub(vt::load(x + i), vt::load(compensation + i));
+    const register_t t = vt::add(a, y);
+    vt::store(compensation + i, vt::sub(vt::sub(t, a), y));
+    vt::store(acc + i, t);
+  }
+  generic::compensated_add(acc + i, compensation + i, x + i, n - i);
+}
+
+//! @f$acc \leftarrow acc + \alpha x@f$
+template <class T, class U>
+void axpy(T* acc, T alpha, U const* x, size_t n)
+{
+  typedef vector_traits<T> vt;
+  typedef typename vt::register_t register_t;
+  const size_t w = vt::width;
+
+  const register_t va = vt::set1(alpha);
+
+  size_t i = 0;
+  for(; i + 2*w <= n; i += 2*w)
+  {
+    vt::store(acc + i,     vt::fmadd(va, vt::load(x + i),     vt::load(acc + i)));
+    vt::store(acc + i + w, vt::fmadd(va, vt::load(x + i + w), vt::load(acc + i + w)));
+  }
+  for(; i + w <= n; i += w)
+  {
+    vt::store(acc + i, vt::fmadd(va, vt::load(x + i), vt::load(acc + i)));
+  }
+  for(; i < n; i++)
+  {
+    acc[i] += alpha * T(x[i]);
+  }
+}
+
+//! @f$acc \leftarrow acc + \sum_r c_r x_r@f$, where the @f$x_r@f$ are @c nb_rows vectors of size n.
+//! The accumulator is processed by panels that stay in the L1 cache, and the rows are added 4 at a time
+//! to each panel, which divides the traffic on the accumulator by 4.
+template <class T, class U>
+void weighted_rows_sum(T* acc, U const* const* rows, T const* coefficients, size_t nb_rows, size_t n)
+{
+  typedef vector_traits<T> vt;
+  typedef typename vt::register_t register_t;
+  const size_t w = vt::width;
+
+  for(size_t panel = 0; panel < n; panel += rows_sum_panel_size)
+  {
+    const size_t panel_end = std::min(n, panel + rows_sum_panel_size);
+
+    size_t r = 0;
+    for(; r + 4 <= nb_rows; r += 4)
+    {
+      U const *x0 = rows[r], *x1 = rows[r+1], *x2 = rows[r+2], *x3 = rows[r+3];
+      const register_t c0 = vt::set1(coefficients[r]), c1 = vt::set1(coefficients[r+1]);
+      const register_t c2 = vt::set1(coefficients[r+2]), c3 = vt::set1(coefficients[r+3]);
+
+      size_t i = panel;
+      for(; i + w <= panel_end; i += w)
+      {
+        register_t a = vt::load(acc + i);
+        a = vt::fmadd(c0, vt::load(x0 + i), a);
+        a = vt::fmadd(c1, vt::load(x1 + i), a);
+        a = vt::fmadd(c2, vt::load(x2 + i), a);
+        a = vt::fmadd(c3, vt::load(x3 + i), a);
+        vt::store(acc + i, a);
+      }
+      for(; i < panel_end; i++)
+      {
+        acc[i] += coefficients[r] * T(x0[i]) + coefficients[r+1] * T(x1[i]) + coefficients[r+2] * T(x2[i]) + coefficients[r+3] * T(x3[i]);
+      }
+    }
+    for(; r < nb_rows; r++)
+    {
+      axpy(acc + panel, coefficients[r], rows[r] + panel, panel_end - panel);
+    }
+  }
+}
+
+//! @f$out_r \leftarrow out_r + x_r \cdot y@f$, where the @f$x_r@f$ are @c nb_rows vectors of size n. The rows are 
+//! processed 4 at a time, each load of y being used by 4 multiply-adds (eg. the blocks of a Gram matrix).
+template <class T>
+void rows_inner_products(T* out, T const* const* rows, T const* y, size_t nb_rows, size_t n)
+{
+  typedef vector_traits<T> vt;
+  typedef typename vt::register_t register_t;
+  const size_t w = vt::width;
+
+  size_t r = 0;
+  for(; r + 4 <= nb_rows; r += 4)
+  {
+    T const *x0 = rows[r], *x1 = rows[r+1], *x2 = rows[r+2], *x3 = rows[r+3];
+    register_t acc0 = vt::zero(), acc1 = vt::zero(), acc2 = vt::zero(), acc3 = vt::zero();
+
+    size_t i = 0;
+    for(; i + w <= n; i += w)
+    {
+      const register_t v = vt::load(y + i);
+      acc0 = vt::fmadd(vt::load(x0 + i), v, acc0);
+      acc1 = vt::fmadd(vt::load(x1 + i), v, acc1);
+      acc2 = vt::fmadd(vt::load(x2 + i), v, acc2);
+      acc3 = vt::fmadd(vt::load(x3 + i), v, acc3);
+    }
+
+    T ip0 = vt::reduce_add(acc0), ip1 = vt::reduce_add(acc1), ip2 = vt::reduce_add(acc2), ip3 = vt::reduce_add(acc3);
+    for(; i < n; i++)
+    {
+      ip0 += x0[i] * y[i];
+      ip1 += x1[i] * y[i];
+      ip2 += x2[i] * y[i];
+      ip3 += x3[i] * y[i];
+    }
+    out[r] += ip0;
+    out[r+1] += ip1;
+    out[r+2] += ip2;
+    out[r+3] += ip3;
+  }
+  for(; r < nb_rows; r++)
+  {
+    out[r] += inner_product(rows[r], y, n);
+  }
+}
+
+//! Exact @f$acc \leftarrow acc + \sum_r \pm x_r@f$ for integer data, where the sign of the row r is negative if
+//! @c sign_masks[r] is -1 and positive if it is 0. The rows are widened to the accumulator type A and negated
+//! with @f$(x \oplus m) - m@f$, which avoids any multiplication.
+template <class A, class U>
+void signed_rows_sum(A* acc, U const* const* rows, A const* sign_masks, size_t nb_rows, size_t n)
+{
+  typedef vector_traits<A> vt;
+  typedef typename vt::register_t register_t;
+  const size_t w = vt::width;
+
+  for(size_t panel = 0; panel < n; panel += rows_sum_panel_size)
+  {
+    const size_t panel_end = std::min(n, panel + rows_sum_panel_size);
+
+    size_t r = 0;
+    for(; r + 4 <= nb_rows; r += 4)
+    {
+      U const *x0 = rows[r], *x1 = rows[r+1], *x2 = rows[r+2], *x3 = rows[r+3];
+      const register_t m0 = vt::set1(sign_masks[r]), m1 = vt::set1(sign_masks[r+1]);
+      const register_t m2 = vt::set1(sign_masks[r+2]), m3 = vt::set1(sign_masks[r+3]);
+
+      size_t i = panel;
+      for(; i + w <= panel_end; i += w)
+      {
+        register_t a = vt::load(acc + i);
+        a = vt::add(a, vt::sub(vt::bit_xor(vt::load(x0 + i), m0), m0));
+        a = vt::add(a, vt::sub(vt::bit_xor(vt::load(x1 + i), m1), m1));
+        a = vt::add(a, vt::sub(vt::bit_xor(vt::load(x2 + i), m2), m2));
+        a = vt::add(a, vt::sub(vt::bit_xor(vt::load(x3 + i), m3), m3));
+        vt::store(acc + i, a);
+      }
+      for(; i < panel_end; i++)
+      {
+        acc[i] += ((A(x0[i]) ^ sign_masks[r])   - sign_masks[r])
+                + ((A(x1[i]) ^ sign_masks[r+1]) - sign_masks[r+1])
+                + ((A(x2[i]) ^ sign_masks[r+2]) - sign_masks[r+2])
+                + ((A(x3[i]) ^ sign_masks[r+3]) - sign_masks[r+3]);
+      }
+    }
+    for(; r < nb_rows; r++)
+    {
+      U const *x0 = rows[r];
+      const A mask = sign_masks[r];
+      const register_t m0 = vt::set1(mask);
+
+      size_t i = panel;
+      for(; i + w <= panel_end; i += w)
+      {
+        vt::store(acc + i, vt::add(vt::load(acc + i), vt::sub(vt::bit_xor(vt::load(x0 + i), m0), m0)));
+      }
+      for(; i < panel_end; i++)
+      {
+        acc[i] += (A(x0[i]) ^ mask) - mask;
+      }
+    }
+  }
+}
+
+//! Returns a word in which the bit i is set if @f$values[i] \geq 0@f$.
+//! The comparisons are performed on full registers and the signs are extracted with a movemask.
+//! @pre n <= 64
+template <class T>
+boost::uint64_t positive_mask(T const* values, size_t n)
+{
+  typedef vector_traits<T> vt;
+  const size_t w = vt::width;
+  assert(n <= 64);
+
+  boost::uint64_t mask = 0;
+  size_t i = 0;
+  for(; i + w <= n; i += w)
+  {
+    mask |= static_cast<boost::uint64_t>(vt::positive_mask(vt::load(values + i))) << i;
+  }
+  for(; i < n; i++)
+  {
+    if(values[i] >= 0)
+    {
+      mask |= boost::uint64_t(1) << i;
+    }
+  }
+  return mask;
+}
+
+//! Sum of the values strictly between @c low and @c high, with the numbers of values on each side of the bounds 
+//! (see generic::bounded_sum). The values are selected by masks and counted by the popcounts of the comparisons.
+template <class T>
+T bounded_sum(T const* values, size_t n, T low, T high, size_t* p_counts)
+{
+  typedef vector_traits<T> vt;
+  typedef typename vt::register_t register_t;
+  const size_t w = vt::width;
+
+  const register_t vlow = vt::set1(low), vhigh = vt::set1(high);
+  register_t acc0 = vt::zero(), acc1 = vt::zero();
+  size_t nb_below = 0, nb_below_or_equal = 0, nb_above = 0, nb_above_or_equal = 0;
+
+  size_t i = 0;
+  for(; i + 2*w <= n; i += 2*w)
+  {
+    const register_t v0 = vt::load(values + i), v1 = vt::load(values + i + w);
+    acc0 = vt::add(acc0, vt::keep_between(v0, vlow, vhigh));
+    acc1 = vt::add(acc1, vt::keep_between(v1, vlow, vhigh));
+    nb_below          += popcount(vt::less_mask(v0, vlow))        + popcount(vt::less_mask(v1, vlow));
+    nb_below_or_equal += popcount(vt::less_equal_mask(v0, vlow))  + popcount(vt::less_equal_mask(v1, vlow));
+    nb_above          += popcount(vt::less_mask(vhigh, v0))       + popcount(vt::less_mask(vhigh, v1));
+    nb_above_or_equal += popcount(vt::less_equal_mask(vhigh, v0)) + popcount(vt::less_equal_mask(vhigh, v1));
+  }
+
+  T acc = vt::reduce_add(vt::add(acc0, acc1));
+  acc += generic::bounded_sum(values + i, n - i, low, high, p_counts);
+  p_counts[0] += nb_below;
+  p_counts[1] += nb_below_or_equal;
+  p_counts[2] += nb_above;
+  p_counts[3] += nb_above_or_equal;
+  return acc;
+}
+
+//! Copies the values strictly between @c low and @c high, up to @c capacity values, and returns their number 
+//! (see generic::copy_between). The window is expected to be narrow: the vectors without any selected value are
+//! skipped after the comparisons.
+template <class T>
+size_t copy_between(T const* values, size_t n, T low, T high, T* p_out, size_t capacity)
+{
+  typedef vector_traits<T> vt;
+  typedef typename vt::register_t register_t;
+  const size_t w = vt::width;
+
+  const register_t vlow = vt::set1(low), vhigh = vt::set1(high);
+  size_t nb_between = 0;
+
+  size_t i = 0;
+  for(; i + w <= n; i += w)
+  {
+    const register_t v = vt::load(values + i);
+    unsigned int mask = vt::less_mask(vlow, v) & vt::less_mask(v, vhigh);
+    for(size_t j = 0; mask; j++, mask >>= 1)
+    {
+      if(mask & 1)
+      {
+        if(nb_between < capacity)
+        {
+          p_out[nb_between] = values[i + j];
+        }
+        nb_between++;
+      }
+    }
+  }
+
+  const size_t nb_copied = std::min(nb_between, capacity);
+  return nb_between + generic::copy_between(values + i, n - i, low, high, p_out + nb_copied, capacity - nb_copied);
+}
+
+//! Copies @c x to @c out, negating the elements whose bit in the packed @c positive_signs is not set, by a XOR of 
+//! their sign bit (see generic::signed_copy). With @c non_temporal, the output is written with streaming stores that 
+//! bypass the caches, for outputs that are not read again soon.
+template <class T>
+void signed_copy(T* out, T const* x, boost::uint64_t const* positive_signs, size_t first, size_t n, bool non_temporal)
+{
+  typedef vector_traits<T> vt;
+  const size_t w = vt::width;
+  const unsigned int lanes = (1u << w) - 1;
+
+  size_t i = 0;
+  const size_t address = reinterpret_cast<size_t>(out);
+  if(non_temporal && address % sizeof(T) == 0)
+  {
+    // the streaming stores are aligned on the size of the registers
+    const size_t misalignment = (address % (w * sizeof(T))) / sizeof(T);
+    i = std::min(n, misalignment ? w - misalignment : 0);
+    generic::signed_copy(out, x, positive_signs, first, i, false);
+    for(; i + w <= n; i += w)
+    {
+      vt::stream(out + i, vt::negate_lanes(vt::load(x + i), ~packed_bits(positive_signs, first + i, w) & lanes));
+    }
+    _mm_sfence();
+  }
+
+  for(; i + w <= n; i += w)
+  {
+    vt::store(out + i, vt::negate_lanes(vt::load(x + i), ~packed_bits(positive_signs, first + i, w) & lanes));
+  }
+  generic::signed_copy(out + i, x + i, positive_signs, first + i, n - i, false);
+}
+
+//! Returns the table of the kernels of this instruction set.
+template <class T>
+kernels<T> make_kernels()
+{
+  kernels<T> k;
+  k.inner_product = &inner_product<T, T>;
+  k.add = &add<T>;
+  k.sub = &sub<T>;
+  k.compensated_add = &compensated_add<T>;
+  k.axpy = &axpy<T, T>;
+  k.weighted_rows_sum = &weighted_rows_sum<T, T>;
+  k.rows_inner_products = &rows_inner_products<T>;
+  k.positive_mask = &positive_mask<T>;
+  k.bounded_sum = &bounded_sum<T>;
+  k.copy_between = &copy_between<T>;
+  k.signed_copy = &signed_copy<T>;
+  return k;
+}
+
+//!@internal
+//! The exact signed sums are vectorised for the compact integer types only.
+template <class U, class T>
+void set_signed_rows_sum(storage_kernels<U, T>& k)
+{
+  k.signed_rows_sum = &generic::signed_rows_sum<typename storage_accumulator<U>::type, U>;
+}
+
+template <class T>
+void set_signed_rows_sum(storage_kernels<boost::uint8_t, T>& k)
+{
+  k.signed_rows_sum = &signed_rows_sum<boost::int32_t, boost::uint8_t>;
+}
+
+template <class T>
+void set_signed_rows_sum(storage_kernels<boost::uint16_t, T>& k)
+{
+  k.signed_rows_sum = &signed_rows_sum<boost::int64_t, boost::uint16_t>;
+}
+
+//! Returns the table of the storage kernels of this instruction set.
+template <class U, class T>
+storage_kernels<U, T> make_storage_kernels()
+{
+  storage_kernels<U, T> k;
+  k.inner_product = &inner_product<T, U>;
+  k.dual_inner_product = &dual_inner_product<T, U>;
+  k.axpy = &axpy<T, U>;
+  k.weighted_rows_sum = &weighted_rows_sum<T, U>;
+  set_signed_rows_sum(k);
+  return k;
+}
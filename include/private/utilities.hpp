@@ -15,11 +15,16 @@
 
 
 #include <boost/numeric/conversion/bounds.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/type_traits/integral_constant.hpp>
 
 
 #include <boost/asio/io_service.hpp>
 #include <boost/thread/thread.hpp>
 #include <boost/thread/recursive_mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/atomic.hpp>
+#include <boost/chrono/system_clocks.hpp>
 
 
 #include <boost/random/uniform_real_distribution.hpp>
@@ -30,6 +35,21 @@
 #include <boost/numeric/ublas/vector.hpp>
 
 #include <numeric>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <cmath>
+#include <cstring>
+
+#include <include/private/simd_kernels.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define GRASSMANNPCA_CPU_RELAX() _mm_pause()
+#else
+  #define GRASSMANNPCA_CPU_RELAX() ((void)0)
+#endif
 
 
 // lock free queue, several producers, one consumer
@@ -123,6 +143,47 @@ namespace grassmann_averages_pca
 
 
 
+    /*!@brief Accumulation of the rows directly in the accumulators of the chunks (default).
+     *
+     * @tparam T scalar type of the accumulators of the chunks and of their merge. If T differs from the scalar type of 
+     *   the data (eg. @c double for @c float vectors), the rows are summed by blocks as for pairwise_accumulation.
+     */
+    template <class T>
+    struct plain_accumulation
+    {
+      typedef T value_type;                     //!< Scalar type of the accumulators
+      static const bool blocked = false;        //!< The rows are summed by blocks before being added to the accumulators
+      static const bool compensated = false;    //!< The rounding errors of the accumulators are compensated
+    };
+
+    /*!@brief Pairwise blocked accumulation of the rows.
+     *
+     * The rows are summed by blocks (of the size of the L2 cache) in the scalar type of the data, and the sum of each 
+     * block is added to the accumulator. The error of the sum of @f$n@f$ rows by blocks of @f$b@f$ rows grows as 
+     * @f$b + n/b@f$ instead of @f$n@f$, for an additional cost of one addition per dimension and per block.
+     */
+    template <class T>
+    struct pairwise_accumulation
+    {
+      typedef T value_type;
+      static const bool blocked = true;
+      static const bool compensated = false;
+    };
+
+    /*!@brief Pairwise blocked accumulation, the sums of the blocks being added with the compensation of the rounding 
+     * errors (Kahan). The merged result is also compensated over the iterations.
+     */
+    template <class T>
+    struct kahan_accumulation
+    {
+      typedef T value_type;
+      static const bool blocked = true;
+      static const bool compensated = true;
+    };
+
+
+
+
     /*!@brief Gram Schmidt orthonormalisation of a collection of vectors.
      * @tparam it_t iterator on the collection of vectors. Should model a forward input iterator.
      * @tparam norm_t type of the norm operator.
@@ -158,29 +219,39 @@ namespace grassmann_averages_pca
     }
 
 
-    /*!@brief Computes the mean of a data set after having removed the lower and upper k first elements.
-     *
-     * This function computes @f[\sum_{k \leq i < N-k} p_{o(i)}@f] where 
-     * - @f$p@f$ is the data set of size @f$N@f$, and @f$p_i@f$ is its ith element
-     * - @f$o@f$ is a function ordering the data set: @f$\forall i, p_{o(i)} \leq p_{o(i+1)}, 0 \leq i < N @f$
+    /*!@brief Bounds of the elements kept by a trimmed mean, used as pivots by the selection of the next trimmed mean of 
+     *        a slightly different data set (see compute_mean_within_bounds_warm_start).
+     */
+    template <class T>
+    struct trimming_bounds
+    {
+      T low;        //!< Element of rank k
+      T high;       //!< Element of rank N-1-k
+      bool valid;   //!< Indicates that the bounds were computed for k < N/2
 
-     * @tparam T type of the data set. All internal accumulations will be performed with this type. T should not be const as
-     *         the data set will be modified in place.
-     *
-     * @param p_data the data set composed of nb_total_elements of type T. 
-     * @param nb_total_elements number of elements of the data set
-     * @param k_first_last number of elements to remove from the lower and upper distributions.
+      trimming_bounds() : low(0), high(0), valid(false)
+      {}
+    };
+
+    /*!@brief Generic version of compute_mean_within_bounds, by two partial sortings of the data set.
      *
-     * @pre @f$ \text{k_first_last} \leq \frac{\text{nb_total_elements}}{2}@f$
+     * The data set is modified in place.
      */
     template <class T>
-    T compute_mean_within_bounds(T *p_data, size_t nb_total_elements, size_t k_first_last)
+    T compute_mean_within_bounds_nth_element(T *p_data, size_t nb_total_elements, size_t k_first_last, trimming_bounds<T> *p_bounds = 0)
     {
       if(k_first_last < nb_total_elements / 2)
       {
         std::nth_element(p_data, p_data + k_first_last, p_data + nb_total_elements);
         std::nth_element(p_data + k_first_last+1, p_data + nb_total_elements - k_first_last-1, p_data + nb_total_elements);
         T acc = std::accumulate(p_data + k_first_last, p_data + nb_total_elements - k_first_last, T(0));
+
+        if(p_bounds)
+        {
+          p_bounds->low = p_data[k_first_last];
+          p_bounds->high = p_data[nb_total_elements - k_first_last - 1];
+          p_bounds->valid = true;
+        }
           
         return acc / (nb_total_elements - 2*k_first_last);
       }
@@ -188,6 +259,10 @@ namespace grassmann_averages_pca
       {
         assert(k_first_last == nb_total_elements / 2);
         std::nth_element(p_data, p_data + k_first_last, p_data + nb_total_elements);
+        if(p_bounds)
+        {
+          p_bounds->valid = false;
+        }
           
         if(nb_total_elements & 1)
         {
@@ -202,6 +277,675 @@ namespace grassmann_averages_pca
 
 
 
+    /*!@brief Key of a floating point value as an unsigned integer of the same size, preserving the order of the values.
+     *
+     * The positive values have their sign bit set, and all the bits of the negative values are flipped. The keys of 
+     * @c -0 and @c +0 differ, but the two values are equal. The NaNs are not supported.
+     */
+    template <class T>
+    struct ordered_key
+    {
+      static const bool is_specialized = false;
+    };
+
+    template <>
+    struct ordered_key<float>
+    {
+      static const bool is_specialized = true;
+      typedef boost::uint32_t type;
+
+      static type get(float value)
+      {
+        type bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits ^ ((type(0) - (bits >> 31)) | (type(1) << 31));
+      }
+
+      static float value(type key)
+      {
+        const type bits = key ^ ((key >> 31) ? (type(1) << 31) : ~type(0));
+        float v;
+        std::memcpy(&v, &bits, sizeof(v));
+        return v;
+      }
+    };
+
+    template <>
+    struct ordered_key<double>
+    {
+      static const bool is_specialized = true;
+      typedef boost::uint64_t type;
+
+      static type get(double value)
+      {
+        type bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits ^ ((type(0) - (bits >> 63)) | (type(1) << 63));
+      }
+
+      static double value(type key)
+      {
+        const type bits = key ^ ((key >> 63) ? (type(1) << 63) : ~type(0));
+        double v;
+        std::memcpy(&v, &bits, sizeof(v));
+        return v;
+      }
+    };
+
+    //! Number of bits of the keys processed by each pass of the radix selection.
+    static const int radix_select_digit_bits = 11;
+
+    //! Number of bits of the keys processed by the first pass of the radix selection, over all the data set. The sign, the 
+    //! exponent and the first bits of the mantissa separate the values more finely than the first 11 bits.
+    static const int radix_select_first_digit_bits = 16;
+
+    /*!@brief Selects the key of a given rank by a most significant digit radix selection.
+     *
+     * Each pass builds the histogram of the next digit of the candidate keys and keeps the candidates of the bucket 
+     * containing the rank.
+     *
+     * @param keys the candidate keys, whose bits above @c shift are equal. The container is modified.
+     * @param rank the rank of the selected key among the candidates.
+     * @param shift number of low bits of the keys that are not yet selected.
+     */
+    template <class key_t>
+    key_t radix_select_key(std::vector<key_t> &keys, size_t rank, int shift)
+    {
+      assert(rank < keys.size());
+      std::vector<size_t> histogram(size_t(1) << radix_select_digit_bits);
+      while(shift > 0 && keys.size() > 1)
+      {
+        const int digit_shift = std::max(shift - radix_select_digit_bits, 0);
+        const key_t mask = (key_t(1) << (shift - digit_shift)) - 1;
+
+        std::fill(histogram.begin(), histogram.end(), 0);
+        for(size_t i = 0; i < keys.size(); i++)
+        {
+          histogram[(keys[i] >> digit_shift) & mask]++;
+        }
+
+        key_t bucket = 0;
+        for(; rank >= histogram[bucket]; bucket++)
+        {
+          rank -= histogram[bucket];
+        }
+
+        size_t nb_kept = 0;
+        for(size_t i = 0; i < keys.size(); i++)
+        {
+          if(((keys[i] >> digit_shift) & mask) == bucket)
+          {
+            keys[nb_kept++] = keys[i];
+          }
+        }
+        keys.resize(nb_kept);
+        shift = digit_shift;
+      }
+
+      // the remaining candidates are all equal
+      return keys[rank];
+    }
+
+    /*!@brief Version of compute_mean_within_bounds for the floating point types, by a radix selection on the keys of the 
+     *        values (see ordered_key).
+     *
+     * The two bounds of the kept ranks are selected together: the first pass builds the histogram of the most significant 
+     * digit of all the keys, and only the keys of the buckets of the two bounds are kept for the following passes. 
+     * The kept values are summed in a last pass, the values equal to the bounds being counted. The data set is not modified.
+     */
+    template <class T>
+    T compute_mean_within_bounds_radix(T const *p_data, size_t nb_total_elements, size_t k_first_last, trimming_bounds<T> *p_bounds = 0)
+    {
+      typedef ordered_key<T> key_op;
+      typedef typename key_op::type key_t;
+
+      assert(2*k_first_last <= nb_total_elements && nb_total_elements > 0);
+
+      // ranks of the bounds of the kept elements. For the median of an even number of elements, the two middle elements
+      const size_t rank_low = std::min(k_first_last, nb_total_elements - 1 - k_first_last);
+      const size_t rank_high = std::max(k_first_last, nb_total_elements - 1 - k_first_last);
+      const size_t nb_kept = rank_high - rank_low + 1;
+      if(p_bounds)
+      {
+        p_bounds->valid = false;
+      }
+      if(nb_kept == nb_total_elements)
+      {
+        return std::accumulate(p_data, p_data + nb_total_elements, T(0)) / nb_total_elements;
+      }
+
+      const int first_shift = int(8 * sizeof(key_t)) - radix_select_first_digit_bits;
+      std::vector<size_t> histogram(size_t(1) << radix_select_first_digit_bits, 0);
+      for(size_t i = 0; i < nb_total_elements; i++)
+      {
+        histogram[key_op::get(p_data[i]) >> first_shift]++;
+      }
+
+      // buckets containing the bounds, and ranks of the bounds within the buckets
+      key_t bucket_low = 0, bucket_high = 0;
+      size_t rank_in_bucket_low = rank_low, rank_in_bucket_high = rank_high;
+      for(; rank_in_bucket_low >= histogram[bucket_low]; bucket_low++)
+      {
+        rank_in_bucket_low -= histogram[bucket_low];
+      }
+      for(; rank_in_bucket_high >= histogram[bucket_high]; bucket_high++)
+      {
+        rank_in_bucket_high -= histogram[bucket_high];
+      }
+
+      std::vector<key_t> keys_low, keys_high;
+      keys_low.reserve(histogram[bucket_low]);
+      keys_high.reserve(histogram[bucket_high]);
+      for(size_t i = 0; i < nb_total_elements; i++)
+      {
+        const key_t key = key_op::get(p_data[i]);
+        const key_t bucket = key >> first_shift;
+        if(bucket == bucket_low)
+        {
+          keys_low.push_back(key);
+        }
+        if(bucket == bucket_high)
+        {
+          keys_high.push_back(key);
+        }
+      }
+
+      const key_t key_low = radix_select_key(keys_low, rank_in_bucket_low, first_shift);
+      const key_t key_high = radix_select_key(keys_high, rank_in_bucket_high, first_shift);
+      const T value_low = key_op::value(key_low);
+      const T value_high = key_op::value(key_high);
+      if(p_bounds && rank_low == k_first_last)
+      {
+        p_bounds->low = value_low;
+        p_bounds->high = value_high;
+        p_bounds->valid = rank_low < rank_high;
+      }
+      if(key_low == key_high)
+      {
+        return value_low;
+      }
+
+      // sum of the values strictly between the bounds, and number of values equal to the bounds within the kept ranks.
+      // The comparisons are made on the values: the keys of -0 and +0 differ, but these values contribute nothing to the sum.
+      size_t counts[4];
+      T acc = simd::get_kernels<T>().bounded_sum(p_data, nb_total_elements, value_low, value_high, counts);
+      const size_t nb_below_or_equal_low = counts[1];
+      const size_t nb_below_high = nb_total_elements - counts[3];
+
+      acc += T(nb_below_or_equal_low - rank_low) * value_low;
+      acc += T(rank_high + 1 - nb_below_high) * value_high;
+      return acc / nb_kept;
+    }
+
+    //! Dispatches to the radix selection for the floating point types.
+    template <class T>
+    T compute_mean_within_bounds(T *p_data, size_t nb_total_elements, size_t k_first_last, trimming_bounds<T> *p_bounds, boost::true_type)
+    {
+      return compute_mean_within_bounds_radix(p_data, nb_total_elements, k_first_last, p_bounds);
+    }
+
+    template <class T>
+    T compute_mean_within_bounds(T *p_data, size_t nb_total_elements, size_t k_first_last, trimming_bounds<T> *p_bounds, boost::false_type)
+    {
+      return compute_mean_within_bounds_nth_element(p_data, nb_total_elements, k_first_last, p_bounds);
+    }
+
+    /*!@brief Computes the mean of a data set after having removed the lower and upper k first elements.
+     *
+     * This function computes @f[\sum_{k \leq i < N-k} p_{o(i)}@f] where 
+     * - @f$p@f$ is the data set of size @f$N@f$, and @f$p_i@f$ is its ith element
+     * - @f$o@f$ is a function ordering the data set: @f$\forall i, p_{o(i)} \leq p_{o(i+1)}, 0 \leq i < N @f$
+
+     * @tparam T type of the data set. All internal accumulations will be performed with this type. T should not be const as
+     *         the data set will be modified in place.
+     *
+     * @param p_data the data set composed of nb_total_elements of type T. 
+     * @param nb_total_elements number of elements of the data set
+     * @param k_first_last number of elements to remove from the lower and upper distributions.
+     * @param p_bounds if not null, receives the bounds of the kept elements.
+     *
+     * @pre @f$ \text{k_first_last} \leq \frac{\text{nb_total_elements}}{2}@f$
+     *
+     * The floating point data sets are processed by a radix selection (see compute_mean_within_bounds_radix), the other 
+     * types by partial sortings (see compute_mean_within_bounds_nth_element).
+     */
+    template <class T>
+    T compute_mean_within_bounds(T *p_data, size_t nb_total_elements, size_t k_first_last, trimming_bounds<T> *p_bounds = 0)
+    {
+      return compute_mean_within_bounds(
+        p_data, 
+        nb_total_elements, 
+        k_first_last, 
+        p_bounds,
+        boost::integral_constant<bool, ordered_key<T>::is_specialized>());
+    }
+
+    /*!@brief Computes the mean of a data set of signed integer values after having removed the lower and upper k first
+     *        elements, from the histograms of the values.
+     *
+     * The data set is composed of the values @f$x - m@f$ and @f$m - x@f$, where @f$x@f$ is an integer in
+     * @f$[\text{first_value}, \text{first_value} + \text{nb_bins})@f$ and @f$m@f$ is the @c offset. The two sequences of
+     * values are sorted by construction, and are merged while the kept ranks are accumulated: the result is exact, without
+     * any selection, and is the same as compute_mean_within_bounds on the values.
+     *
+     * @param p_counts_positive the number of elements @f$x - m@f$ for each @f$x@f$, starting at @c first_value
+     * @param p_counts_negative the number of elements @f$m - x@f$ for each @f$x@f$, starting at @c first_value
+     *
+     * @pre @f$ \text{k_first_last} \leq \frac{N}{2}@f$, where @f$N@f$ is the total count of the histograms
+     */
+    template <class T>
+    T compute_mean_within_bounds_histogram(
+      size_t const *p_counts_positive,
+      size_t const *p_counts_negative,
+      size_t nb_bins,
+      boost::int64_t first_value,
+      T offset,
+      size_t k_first_last)
+    {
+      const size_t nb_total_elements =
+        std::accumulate(p_counts_positive, p_counts_positive + nb_bins, size_t(0)) +
+        std::accumulate(p_counts_negative, p_counts_negative + nb_bins, size_t(0));
+      assert(2*k_first_last <= nb_total_elements);
+
+      // kept ranks, the two middle elements for the median of an even number of elements
+      const size_t first_rank = 2*k_first_last < nb_total_elements ? k_first_last : k_first_last - 1;
+      const size_t last_rank = nb_total_elements - first_rank;
+
+      // the positive values increase with x, the negative ones decrease with x
+      T acc(0);
+      size_t rank = 0;
+      size_t positive = 0, negative = nb_bins;
+      while(rank < last_rank)
+      {
+        assert(positive < nb_bins || negative > 0);
+        const T value_positive = positive < nb_bins ? T(first_value + boost::int64_t(positive)) - offset : T(0);
+        const T value_negative = negative > 0 ? offset - T(first_value + boost::int64_t(negative - 1)) : T(0);
+
+        size_t count;
+        T value;
+        if(negative == 0 || (positive < nb_bins && value_positive < value_negative))
+        {
+          count = p_counts_positive[positive++];
+          value = value_positive;
+        }
+        else
+        {
+          count = p_counts_negative[--negative];
+          value = value_negative;
+        }
+
+        const size_t first = std::max(rank, first_rank);
+        const size_t last = std::min(rank + count, last_rank);
+        if(first < last)
+        {
+          acc += T(last - first) * value;
+        }
+        rank += count;
+      }
+
+      return acc / (last_rank - first_rank);
+    }
+
+    /*!@brief Sums a data set and keeps its k largest and k smallest elements.
+     *
+     * The extremal elements are kept in two heaps of @f$\min(k, N)@f$ elements: the root of @c p_largest is the
+     * smallest of the largest elements, and the root of @c p_smallest is the biggest of the smallest elements. The
+     * mean of several data sets, trimmed from the k lower and upper elements, is then given by their sums and their
+     * extremal elements only (see sum_of_extremal_elements).
+     *
+     * @param p_data the data set composed of nb_elements of type T.
+     * @param nb_elements number of elements of the data set
+     * @param k number of extremal elements to keep on each side.
+     * @param p_largest output heap of the largest elements.
+     * @param p_smallest output heap of the smallest elements.
+     *
+     * @returns the sum of all the elements of the data set.
+     */
+    template <class T>
+    T accumulate_extremal_elements(T const *p_data, size_t nb_elements, size_t k, T *p_largest, T *p_smallest)
+    {
+      const size_t nb_kept = std::min(k, nb_elements);
+      T acc(0);
+      for(size_t i = 0; i < nb_kept; i++)
+      {
+        p_largest[i] = p_smallest[i] = p_data[i];
+        acc += p_data[i];
+      }
+
+      if(nb_kept == 0)
+      {
+        return std::accumulate(p_data, p_data + nb_elements, acc);
+      }
+
+      std::make_heap(p_largest, p_largest + nb_kept, std::greater<T>());
+      std::make_heap(p_smallest, p_smallest + nb_kept, std::less<T>());
+
+      for(size_t i = nb_kept; i < nb_elements; i++)
+      {
+        const T current = p_data[i];
+        acc += current;
+
+        // the elements rarely enter the heaps once they are filled
+        if(current > p_largest[0])
+        {
+          std::pop_heap(p_largest, p_largest + nb_kept, std::greater<T>());
+          p_largest[nb_kept - 1] = current;
+          std::push_heap(p_largest, p_largest + nb_kept, std::greater<T>());
+        }
+        if(current < p_smallest[0])
+        {
+          std::pop_heap(p_smallest, p_smallest + nb_kept, std::less<T>());
+          p_smallest[nb_kept - 1] = current;
+          std::push_heap(p_smallest, p_smallest + nb_kept, std::less<T>());
+        }
+      }
+      return acc;
+    }
+
+    /*!@brief Sums the k first elements of a data set ordered by @c comp. The data set is modified in place.
+     *
+     * With the extremal elements of several data sets (see accumulate_extremal_elements), gives the sum of the k largest
+     * (@c std::greater) or smallest (@c std::less) elements of the union of the data sets.
+     *
+     * @pre @f$ k \leq \text{nb_elements}@f$
+     */
+    template <class T, class compare_t>
+    T sum_of_extremal_elements(T *p_data, size_t nb_elements, size_t k, compare_t comp)
+    {
+      assert(k <= nb_elements);
+      if(k < nb_elements)
+      {
+        std::nth_element(p_data, p_data + k, p_data + nb_elements, comp);
+      }
+      return std::accumulate(p_data, p_data + k, T(0));
+    }
+
+    /*!@brief Sums the @c nb elements of a data set that are the closest to @c bound, among the elements strictly 
+     *        between @c bound and @c limit.
+     *
+     * The elements are selected in a window starting at @c bound, of initial size @c width, which is widened or narrowed
+     * until it contains between @c nb and a few times @c nb elements. The window is scanned by the SIMD kernels, and only 
+     * the elements in the window are copied and partially sorted.
+     *
+     * @param[out] last the element the farthest from @c bound among the summed elements.
+     * @returns false if no window was found, in which case @c acc and @c last are not modified.
+     *
+     * @pre @c nb > 0 and @c width > 0
+     */
+    template <class T>
+    bool sum_of_closest_elements(
+      T const *p_data, 
+      size_t nb_total_elements, 
+      T bound, 
+      T limit, 
+      size_t nb, 
+      T width, 
+      std::vector<T> &buffer,
+      T &acc,
+      T &last)
+    {
+      assert(nb > 0);
+      const bool below = limit < bound;
+      const size_t capacity = 4*nb + 64;
+      buffer.resize(capacity);
+      
+      simd::kernels<T> const &k = simd::get_kernels<T>();
+      for(int attempt = 0; attempt < 16; attempt++)
+      {
+        T edge = below ? bound - width : bound + width;
+        const bool at_limit = below ? !(edge > limit) : !(edge < limit);
+        if(at_limit)
+        {
+          edge = limit;
+        }
+
+        const size_t nb_in_window = below ? 
+          k.copy_between(p_data, nb_total_elements, edge, bound, &buffer[0], capacity) :
+          k.copy_between(p_data, nb_total_elements, bound, edge, &buffer[0], capacity);
+
+        if(nb_in_window < nb)
+        {
+          if(at_limit)
+          {
+            return false;
+          }
+          width *= 4;
+        }
+        else if(nb_in_window > capacity)
+        {
+          width /= 4;
+        }
+        else
+        {
+          if(below)
+          {
+            acc = sum_of_extremal_elements(&buffer[0], nb_in_window, nb, std::greater<T>());
+            last = *std::min_element(buffer.begin(), buffer.begin() + nb);
+          }
+          else
+          {
+            acc = sum_of_extremal_elements(&buffer[0], nb_in_window, nb, std::less<T>());
+            last = *std::max_element(buffer.begin(), buffer.begin() + nb);
+          }
+          return true;
+        }
+      }
+      return false;
+    }
+
+    /*!@brief Computes the mean of a data set after having removed the lower and upper k first elements, using the 
+     *        bounds of the kept elements of a previous data set as pivots.
+     *
+     * If at most @c max_changes elements of the data set changed since the computation of the bounds, the ranks of the 
+     * previous bounds in the new data set move by at most @c max_changes, and the new bounds are among the 
+     * @c max_changes elements on each side of the previous bounds. A first pass over the data set counts the elements 
+     * on each side of the previous bounds and sums the elements between them. If a bound moved, the elements between its 
+     * previous and its new rank are gathered from a narrow window next to the previous bound (see 
+     * sum_of_closest_elements), which is the only selection. 
+     * 
+     * The result is exact whatever @c max_changes: it only disables the warm start if too many elements changed. If the 
+     * bounds moved too far, or if the bounds are not valid, the trimmed mean is computed with compute_mean_within_bounds.
+     *
+     * @param bounds the bounds of the previous data set, updated with the bounds of the current one.
+     *
+     * @pre @f$ \text{k_first_last} \leq \frac{\text{nb_total_elements}}{2}@f$
+     */
+    template <class T>
+    T compute_mean_within_bounds_warm_start(T *p_data, size_t nb_total_elements, size_t k_first_last, size_t max_changes, trimming_bounds<T> &bounds)
+    {
+      const size_t &k = k_first_last;
+      const size_t &N = nb_total_elements;
+
+      // maximal number of elements between the previous and the new ranks of a bound
+      const size_t max_moves = N / 8;
+      if(!bounds.valid || k == 0 || 2*k >= N || !(bounds.low < bounds.high) || max_changes > max_moves)
+      {
+        return compute_mean_within_bounds(p_data, N, k, &bounds);
+      }
+
+      const T low = bounds.low;
+      const T high = bounds.high;
+
+      size_t counts[4];
+      T acc = simd::get_kernels<T>().bounded_sum(p_data, N, low, high, counts);
+      const size_t nb_below_low = counts[0], nb_below_or_equal_low = counts[1];
+      const size_t nb_above_high = counts[2], nb_above_or_equal_high = counts[3];
+
+      // number of elements between the previous and the new rank of each bound, on which side of the bound
+      const size_t nb_middle = N - nb_below_or_equal_low - nb_above_or_equal_high;
+      const size_t nb_low_below = nb_below_low > k ? nb_below_low - k : 0;
+      const size_t nb_low_above = nb_below_or_equal_low <= k ? k - nb_below_or_equal_low + 1 : 0;
+      const size_t nb_high_above = nb_above_high > k ? nb_above_high - k : 0;
+      const size_t nb_high_below = nb_above_or_equal_high <= k ? k - nb_above_or_equal_high + 1 : 0;
+      if(std::max(nb_low_below, nb_low_above) > max_moves || 
+         std::max(nb_high_above, nb_high_below) > max_moves ||
+         nb_low_above + nb_high_below > nb_middle)
+      {
+        return compute_mean_within_bounds(p_data, N, k, &bounds);
+      }
+
+      // initial width of the windows from the mean density of the elements between the previous bounds
+      const T spacing = (high - low) / T(nb_middle + 1);
+      const T infinity = std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() : boost::numeric::bounds<T>::highest();
+      std::vector<T> buffer;
+      T new_low(low), new_high(high);
+      T sum(0);
+
+      // the elements equal to a previous bound are kept if the bound moved outwards
+      if(nb_low_below)
+      {
+        if(!sum_of_closest_elements(p_data, N, low, -infinity, nb_low_below, spacing * T(2*nb_low_below), buffer, sum, new_low))
+        {
+          return compute_mean_within_bounds(p_data, N, k, &bounds);
+        }
+        acc += sum + T(nb_below_or_equal_low - nb_below_low) * low;
+      }
+      else if(nb_low_above)
+      {
+        // the new lower bound is kept
+        if(!sum_of_closest_elements(p_data, N, low, high, nb_low_above, spacing * T(2*nb_low_above), buffer, sum, new_low))
+        {
+          return compute_mean_within_bounds(p_data, N, k, &bounds);
+        }
+        acc -= sum - new_low;
+      }
+      else
+      {
+        acc += T(nb_below_or_equal_low - k) * low;
+      }
+
+      if(nb_high_above)
+      {
+        if(!sum_of_closest_elements(p_data, N, high, infinity, nb_high_above, spacing * T(2*nb_high_above), buffer, sum, new_high))
+        {
+          return compute_mean_within_bounds(p_data, N, k, &bounds);
+        }
+        acc += sum + T(nb_above_or_equal_high - nb_above_high) * high;
+      }
+      else if(nb_high_below)
+      {
+        if(!sum_of_closest_elements(p_data, N, high, low, nb_high_below, spacing * T(2*nb_high_below), buffer, sum, new_high))
+        {
+          return compute_mean_within_bounds(p_data, N, k, &bounds);
+        }
+        acc -= sum - new_high;
+      }
+      else
+      {
+        acc += T(nb_above_or_equal_high - k) * high;
+      }
+
+      bounds.low = new_low;
+      bounds.high = new_high;
+      return acc / (N - 2*k);
+    }
+
+
+    /*!@brief Estimates the bounds of the elements kept by a trimmed mean from a uniform sample of the data set.
+     *
+     * The samples taken at the same rate from several data sets are a sample of their union, which makes the sample a
+     * mergeable quantile sketch of the data set. The rank @c k of the data set is estimated by the rank
+     * @f$k \cdot \text{nb_samples} / N@f$ of the sample. The sample is modified in place. The bounds are infinite if
+     * @c k is null, nothing being trimmed.
+     *
+     * @pre @f$ 2 \cdot \text{k_first_last} \leq \text{nb_total_elements}@f$
+     */
+    template <class T>
+    void estimate_trimming_bounds(T *p_sample, size_t nb_samples, size_t nb_total_elements, size_t k_first_last, T &low, T &high)
+    {
+      assert(2*k_first_last <= nb_total_elements);
+      if(k_first_last == 0 || nb_samples == 0)
+      {
+        high = std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() : boost::numeric::bounds<T>::highest();
+        low = std::numeric_limits<T>::has_infinity ? -std::numeric_limits<T>::infinity() : boost::numeric::bounds<T>::lowest();
+        return;
+      }
+
+      const size_t rank = std::min(nb_samples - 1, static_cast<size_t>(double(k_first_last) * nb_samples / nb_total_elements));
+      std::nth_element(p_sample, p_sample + rank, p_sample + nb_samples);
+      low = p_sample[rank];
+      std::nth_element(p_sample + rank, p_sample + nb_samples - 1 - rank, p_sample + nb_samples);
+      high = p_sample[nb_samples - 1 - rank];
+    }
+
+    /*!@brief Mean of the elements of a data set between two estimated bounds, accumulated over several parts of the data set.
+     *
+     * The accumulation counts the elements on each side of the bounds, which gives the exact rank error of the bounds with 
+     * respect to the bounds of the exact trimmed mean (see rank_error). On a side where the rank error is null, the 
+     * elements equal to the bound are kept only up to the @c k trimmed elements, which gives the exact trimmed mean on data 
+     * with ties. On the other sides, all the elements equal to the bound are kept.
+     */
+    template <class T>
+    struct bounded_accumulation
+    {
+      T low, high;          //!< Bounds of the kept elements
+      T sum;                //!< Sum of the elements strictly between the bounds
+      size_t counts[4];     //!< Number of elements below, below or equal to, above, above or equal to the bounds
+      size_t nb_elements;   //!< Number of accumulated elements
+
+      bounded_accumulation(T low_, T high_) : low(low_), high(high_), sum(0), nb_elements(0)
+      {
+        std::fill(counts, counts + 4, size_t(0));
+      }
+
+      //! Accumulates a part of the data set.
+      void add(T const *p_data, size_t nb)
+      {
+        size_t part_counts[4];
+        sum += simd::get_kernels<T>().bounded_sum(p_data, nb, low, high, part_counts);
+        for(size_t i = 0; i < 4; i++)
+        {
+          counts[i] += part_counts[i];
+        }
+        nb_elements += nb;
+      }
+
+      //! Mean of the kept elements after trimming the @c k first and last elements, or the middle of the bounds if no 
+      //! element is kept.
+      T mean(size_t k) const
+      {
+        if(!(low < high))
+        {
+          return low;
+        }
+
+        // number of trimmed elements on each side
+        const size_t nb_trimmed_low = (k >= counts[0] && k <= counts[1]) ? k : counts[0];
+        const size_t nb_trimmed_high = (k >= counts[2] && k <= counts[3]) ? k : counts[2];
+        const size_t nb_kept = nb_elements - nb_trimmed_low - nb_trimmed_high;
+        if(nb_kept == 0)
+        {
+          return (low + high) / 2;
+        }
+
+        // the bounds may be infinite if no element is equal to them
+        T acc(sum);
+        if(counts[1] > nb_trimmed_low)
+        {
+          acc += T(counts[1] - nb_trimmed_low) * low;
+        }
+        if(counts[3] > nb_trimmed_high)
+        {
+          acc += T(counts[3] - nb_trimmed_high) * high;
+        }
+        return acc / T(nb_kept);
+      }
+
+      /*!@brief Distance between @c k and the ranks of the bounds, on the side of the bound that is the furthest.
+       *
+       * The elements equal to the lower bound have the ranks @c counts[0] to @c counts[1] from below, and the
+       * trimming of the @c k smallest elements is exact if @c k is in this range. The same holds for the upper bound from above.
+       */
+      size_t rank_error(size_t k) const
+      {
+        const size_t error_low = k < counts[0] ? counts[0] - k : (k > counts[1] ? k - counts[1] : 0);
+        const size_t error_high = k < counts[2] ? counts[2] - k : (k > counts[3] ? k - counts[3] : 0);
+        return std::max(error_low, error_high);
+      }
+    };
+
+
+
 
     /*!@brief Checks the convergence of a sequence.
      *
@@ -230,8 +974,14 @@ namespace grassmann_averages_pca
       //! The previous value
       data_t previous_state;
 
+      //! Default amount of change below which the sequence is considered as having reached a steady point.
+      static double default_epsilon()
+      {
+        return 1E-5;
+      }
+
       //! Initialise the instance with the initial state of the vector.
-      convergence_check(data_t const& current_state, double epsilon_ = 1E-5) : 
+      convergence_check(data_t const& current_state, double epsilon_ = default_epsilon()) : 
         epsilon(epsilon_), 
         previous_state(current_state)
       {}
@@ -250,6 +1000,159 @@ namespace grassmann_averages_pca
     };
 
 
+    /*!@brief Hash of a word of 64 packed signs, at a given position of the whole bitmap of signs.
+     *
+     * The hash of a bitmap is the xor of the hashes of its words, so that it can be updated from the words that
+     * changed only (the hash of the old word and the hash of the new one are xored to the hash of the bitmap).
+     */
+    inline boost::uint64_t signs_word_hash(boost::uint64_t position, boost::uint64_t signs)
+    {
+      if(!signs)
+      {
+        return 0;
+      }
+      // splitmix64 finalizer on the word, seeded by its position
+      boost::uint64_t h = signs ^ ((position + 1) * 0x9E3779B97F4A7C15ULL);
+      h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+      return h ^ (h >> 31);
+    }
+
+
+    /*!@brief Checks the convergence of the iterations of the Grassmann averages from the signs of the inner products.
+     *
+     * The next basis vector of an iteration depends only on the signs of the inner products of the points with the 
+     * current one. The iterations reached a steady point as soon as no sign changes, and are periodic as soon as a
+     * pattern of signs repeats (the basis vector would then cycle without ever converging). 
+     *
+     * The functor is called after each update of the signs with the number of flipped signs and the change of the hash
+     * of the signs (see signs_word_hash), and returns true if the iterations should stop:
+     * - when the number of flipped signs is below a fraction of the number of points (0 stops on zero flip only, 
+     *   a negative fraction disables this criterion), 
+     * - when the pattern of signs was already seen during the iterations of the current basis vector, if the detection of
+     *   the cycles is enabled.
+     *
+     * The hash of the signs is relative to the signs of the initial step of the current basis vector (see start): the
+     * changes of the hashes are exact, so two patterns are equal if and only if their relative hashes are (up to the 
+     * collisions of the hashes).
+     */
+    struct sign_flips_convergence_check
+    {
+      //! The fraction of flipped signs below which the iterations are considered as converged.
+      const double max_flips_fraction;
+
+      //! Stops on the repetition of a pattern of signs.
+      const bool detect_cycles;
+
+      //! The number of points.
+      const size_t nb_elements;
+
+      //! The hash of the current signs, relative to the ones of the initial step.
+      boost::uint64_t signs_hash;
+
+      //! The hashes of the patterns of signs of the iterations of the current basis vector.
+      std::vector<boost::uint64_t> v_patterns;
+
+      //! Set to true when the last call stopped on a cycle.
+      bool cycle_detected;
+
+      sign_flips_convergence_check(size_t nb_elements_, double max_flips_fraction_, bool detect_cycles_) :
+        max_flips_fraction(max_flips_fraction_),
+        detect_cycles(detect_cycles_),
+        nb_elements(nb_elements_),
+        signs_hash(0),
+        cycle_detected(false)
+      {}
+
+      //! Returns true if none of the criteria is enabled.
+      bool disabled() const
+      {
+        return max_flips_fraction < 0 && !detect_cycles;
+      }
+
+      //! Starts the iterations of a new basis vector, after the initial step.
+      void start()
+      {
+        signs_hash = 0;
+        v_patterns.clear();
+        v_patterns.push_back(signs_hash);
+        cycle_detected = false;
+      }
+
+      //! Returns true if the iterations should stop.
+      bool operator()(size_t nb_flips, boost::uint64_t hash_change)
+      {
+        signs_hash ^= hash_change;
+        if(max_flips_fraction >= 0 && nb_flips <= max_flips_fraction * nb_elements)
+        {
+          return true;
+        }
+
+        if(detect_cycles)
+        {
+          if(std::find(v_patterns.begin(), v_patterns.end(), signs_hash) != v_patterns.end())
+          {
+            cycle_detected = true;
+            return true;
+          }
+          v_patterns.push_back(signs_hash);
+        }
+        return false;
+      }
+    };
+
+
+    /*!@brief Conversion of the input values to the storage type of the copies of the data.
+     *
+     * The values are cast to the floating point storage types. The integer (compact) storage types should represent 
+     * the values exactly, and their exact accumulators (see simd::storage_accumulator) should not overflow: both are 
+     * checked at runtime, since a cast of an out of range value is undefined.
+     */
+    template <class storage_t, bool is_integer = std::numeric_limits<storage_t>::is_integer>
+    struct storage_conversion
+    {
+      //! Stores the value, and returns true.
+      template <class value_t>
+      static bool convert(value_t const &value, storage_t &stored)
+      {
+        stored = static_cast<storage_t>(value);
+        return true;
+      }
+
+      //! Returns true.
+      static bool exact_accumulation(size_t)
+      {
+        return true;
+      }
+    };
+
+    template <class storage_t>
+    struct storage_conversion<storage_t, true>
+    {
+      typedef typename simd::storage_accumulator<storage_t>::type accumulator_t;
+
+      //! Stores the value, and returns false if the value is not an integer in the range of the storage type.
+      template <class value_t>
+      static bool convert(value_t const &value, storage_t &stored)
+      {
+        const double v = static_cast<double>(value);
+        if(!(v >= double(std::numeric_limits<storage_t>::min()) && v <= double(std::numeric_limits<storage_t>::max()) && v == std::floor(v)))
+        {
+          stored = storage_t(0);
+          return false;
+        }
+        stored = static_cast<storage_t>(v);
+        return true;
+      }
+
+      //! Returns false if the sum of @c nb_values stored values may overflow the exact accumulators.
+      static bool exact_accumulation(size_t nb_values)
+      {
+        return double(nb_values) * std::numeric_limits<storage_t>::max() < double(std::numeric_limits<accumulator_t>::max());
+      }
+    };
+
+
     // some issues with the random number generator
     const double fVeryBigButStillComputable = 1E10;
     const double fVerySmallButStillComputable = -1E10;
@@ -309,6 +1212,27 @@ namespace grassmann_averages_pca
         }
         return out;
       }
+
+      //! Draws the seed of a vector generated by blocks (see fill_block).
+      boost::uint32_t draw_seed() const
+      {
+        return static_cast<boost::uint32_t>(rng());
+      }
+
+      /*!@brief Fills the block @c block, of elements [begin, end[, of a vector generated by blocks.
+       *
+       * Each block is drawn from its own generator, seeded by the seed of the vector and the index of the block. The blocks
+       * may then be drawn in parallel, the vector depending only on the seed and on the size of the blocks.
+       */
+      void fill_block(value_type *p_out, boost::uint32_t seed, size_t block, size_t begin, size_t end) const
+      {
+        random_number_generator_t block_rng(static_cast<boost::uint32_t>(seed ^ ((block + 1) * 0x9E3779B9u)));
+        random_distribution_t dist(min_bound, max_bound);
+        for(size_t i = begin; i < end; i++)
+        {
+          p_out[i] = dist(block_rng);
+        }
+      }
     };
 
 
@@ -336,6 +1260,121 @@ namespace grassmann_averages_pca
       };
 
 
+      //! Hint to the processor that the current thread is spinning.
+      inline void cpu_relax()
+      {
+        GRASSMANNPCA_CPU_RELAX();
+      }
+
+      /*!@brief Counter of notifications, waited by spinning briefly and then sleeping.
+       *
+       * An iteration of the algorithms may last only a few tens of microseconds, which is about the latency of the wake up of
+       * a thread blocked on a condition variable. The waiting thread first spins on the counter, and blocks on the condition
+       * only if the notifications did not arrive during the spin. The notifying threads take the lock only if the waiting
+       * thread is sleeping.
+       *
+       * There is no spin if the machine has only one processor, the notifying threads running on the same processor.
+       */
+      struct notification_counter : boost::noncopyable
+      {
+      private:
+        boost::atomic<size_t> count;
+        boost::atomic<bool> sleeping;
+
+        //! Number of threads inside notify, the instance may be destroyed once wait returned.
+        boost::atomic<int> nb_notifying;
+        boost::mutex internal_mutex;
+        boost::condition_variable condition_;
+        const boost::chrono::microseconds spin_duration;
+
+        //! Waits for the threads still inside notify (they do not touch the instance after).
+        void wait_notifying()
+        {
+          while(nb_notifying.load() > 0)
+          {
+            cpu_relax();
+            boost::this_thread::yield();
+          }
+        }
+
+      public:
+        //! Default duration of the spin in microseconds.
+        static int default_spin_duration()
+        {
+          return boost::thread::hardware_concurrency() > 1 ? 50 : 0;
+        }
+
+        notification_counter(int spin_duration_ = default_spin_duration()) : 
+          count(0), 
+          sleeping(false), 
+          nb_notifying(0),
+          spin_duration(spin_duration_)
+        {}
+
+        //! Resets the number of notifications.
+        void reset()
+        {
+          count.store(0);
+        }
+
+        //! Number of notifications since the last reset.
+        size_t get() const
+        {
+          return count.load();
+        }
+
+        //! Increments the number of notifications, and wakes up the waiting thread if it is sleeping.
+        void notify()
+        {
+          ++nb_notifying;
+          count.fetch_add(1);
+          if(sleeping.load())
+          {
+            boost::lock_guard<boost::mutex> guard(internal_mutex);
+            condition_.notify_all();
+          }
+          --nb_notifying;
+        }
+
+        //! Returns once the number of notifications reaches the number in argument.
+        void wait(size_t nb_notifications)
+        {
+          if(spin_duration.count() > 0)
+          {
+            const boost::chrono::steady_clock::time_point spin_end = boost::chrono::steady_clock::now() + spin_duration;
+            for(size_t i = 1; ; i++)
+            {
+              if(count.load() >= nb_notifications)
+              {
+                wait_notifying();
+                return;
+              }
+              cpu_relax();
+
+              // the clock is read only from time to time
+              if(!(i % 64) && boost::chrono::steady_clock::now() >= spin_end)
+              {
+                break;
+              }
+            }
+          }
+
+          // the flag is set before checking the counter, and the counter is incremented before checking the flag, 
+          // so that either the waiting thread sees the notification or the notifying thread sees the waiting one.
+          {
+            boost::unique_lock<boost::mutex> lock(internal_mutex);
+            sleeping.store(true);
+            while(count.load() < nb_notifications)
+            {
+              condition_.wait(lock);
+            }
+            sleeping.store(false);
+          }
+          wait_notifying();
+        }
+      };
+
+
       //! @brief Helper structure for managing additions on standard uBlas vectors.
       //! 
       //! This class is intended to be used with asynchronous_results_merger. It just adds an update to the current state.
@@ -425,11 +1464,8 @@ namespace grassmann_averages_pca
         //! an initial state (before any merge arrives).
         init_result_type initialisation_instance;
 
-        //! Number of updates after the initialisation
-        volatile int nb_updates;
-
-        //! Thread synchronisation (event sent after an update, for counting).
-        boost::condition_variable_any condition_;
+        //! Number of updates after the initialisation, waited by the main thread.
+        notification_counter nb_updates;
 
         std::list<update_element const*> lf_queue;
         //boost::lockfree::queue<update_element const*> lf_queue;
@@ -442,7 +1478,6 @@ namespace grassmann_averages_pca
          */
         asynchronous_results_merger(init_result_type const &initialisation_instance_) : 
           initialisation_instance(initialisation_instance_),
-          nb_updates(0),
           lf_queue()
         {}
 
@@ -464,7 +1499,7 @@ namespace grassmann_averages_pca
         //! Also called by init.
         void init_notifications()
         {
-          nb_updates = 0;
+          nb_updates.reset();
         }
 
         /*! Receives the update element from each worker.
@@ -501,17 +1536,8 @@ namespace grassmann_averages_pca
          */
         void notify()
         {
-          lock_t guard(internal_mutex);
-          ++nb_updates;
-
-          //
-          // The condition functions are not async-signal safe, and should not be called from a signal handler. 
-          // In particular, calling pthread_cond_signal or pthread_cond_broadcast from a signal handler may
-          // deadlock the calling thread.
-          // 
-          // Raffi: the notification outside the lock above causes a deadlock, apparently it should be protected
-          // from simultaneous access. 
-          condition_.notify_one();
+          // the update of the result is made before, under the lock
+          nb_updates.notify();
         }
      
         //! Returns once the number of updates reaches the number in argument.
@@ -519,30 +1545,11 @@ namespace grassmann_averages_pca
         //!@warning if an inappropriate number is given, the method might never return.
         bool wait_notifications(size_t nb_notifications)
         {
-          boost::unique_lock<mutex_t> lock(internal_mutex);
-          while (nb_updates < nb_notifications)
-          {
-            // when entering wait, the lock is unlocked and made available to other threads.
-            // when awakened, the lock is locked before wait returns. 
-            condition_.wait(lock);
-
-            //assert(nb_updates);           // cannot be awakened if there is no update
-            assert(lock.owns_lock());
-
-            // consumes what was under a collision in the update
-            update_element const* updated_value(0);
-            if(!lf_queue.empty())
-            {
-              updated_value = lf_queue.back();
-              lf_queue.pop_back();
-              merger_instance(current_value, *updated_value);
-            }
-          }
+          nb_updates.wait(nb_notifications);
 
-          assert(lock.owns_lock());
+          lock_t guard(internal_mutex);
 
           // consumes what was under a collision in the update
-          // we might end up here if there was at least one collision, and everything was finished before the line "while (nb_updates < nb_notifications)"
           {
             update_element const* updated_value(0);
             while(!lf_queue.empty())
@@ -13,6 +13,7 @@
 #include <test/test_main.hpp>
 
 #include <include/grassmann_pca.hpp>
+#include <include/grassmann_pca_with_trimming.hpp>
 #include <include/private/boost_ublas_row_iterator.hpp>
 
 // data stored into a matrix
@@ -403,6 +404,670 @@ BOOST_AUTO_TEST_CASE(smoke_and_orthogonality_tests_several_workers)
 
 
 
+BOOST_AUTO_TEST_CASE(sign_flips_statistics)
+{
+  using namespace grassmann_averages_pca;
+  using namespace grassmann_averages_pca::details::ublas_helpers;
+  namespace ub = boost::numeric::ublas;
+
+  typedef ub::vector<double> data_t;
+  typedef grassmann_pca<data_t> grassmann_pca_t;
+  typedef row_iter<const matrix_t> const_row_iter_t;
+
+  grassmann_pca_t instance;
+  BOOST_CHECK(instance.set_nb_processors(3));
+
+  std::vector<data_t> basis_vectors(dimensions);
+  const int max_iterations = 1000;
+
+  BOOST_CHECK(instance.batch_process(
+    max_iterations,
+    dimensions,
+    const_row_iter_t(mat_data, 0),
+    const_row_iter_t(mat_data, mat_data.size1()),
+    basis_vectors.begin()));
+
+  std::vector< std::vector<size_t> > const& v_flips = instance.get_sign_flips_statistics();
+  BOOST_REQUIRE_EQUAL(v_flips.size(), dimensions);
+  for(int i = 0; i < dimensions; i++)
+  {
+    BOOST_TEST_CHECKPOINT("sign flips of basis vector " << i);
+    BOOST_CHECK_LT(v_flips[i].size(), max_iterations);
+    for(size_t j = 0; j < v_flips[i].size(); j++)
+    {
+      BOOST_CHECK_LE(v_flips[i][j], nb_elements);
+    }
+
+    // at convergence, the signs do not change anymore (the list is empty if the initial
+    // accumulation already converged, which is the case for the last basis vector)
+    if(!v_flips[i].empty())
+    {
+      BOOST_CHECK_EQUAL(v_flips[i].back(), 0);
+    }
+  }
+}
+
+
+
+BOOST_AUTO_TEST_CASE(sign_flips_convergence)
+{
+  using namespace grassmann_averages_pca;
+  namespace ub = boost::numeric::ublas;
+
+  typedef ub::vector<double> data_t;
+  typedef grassmann_pca<data_t> grassmann_pca_t;
+
+  // a repeated pattern is detected from the changes of the hashes only
+  {
+    details::sign_flips_convergence_check check(1000, -1, true);
+    check.start();
+    const boost::uint64_t h1 = details::signs_word_hash(3, 0x5) ^ details::signs_word_hash(3, 0x4);
+    const boost::uint64_t h2 = details::signs_word_hash(1, 0x1) ^ details::signs_word_hash(1, 0x3);
+    BOOST_CHECK(!check(1, h1));
+    BOOST_CHECK(!check(1, h2));
+    BOOST_CHECK(!check(1, h1));
+    BOOST_CHECK(!check.cycle_detected);
+    BOOST_CHECK(check(1, h2));     // back to the initial signs
+    BOOST_CHECK(check.cycle_detected);
+
+    details::sign_flips_convergence_check check_flips(1000, 0.01, false);
+    check_flips.start();
+    BOOST_CHECK(!check_flips(11, h1));
+    BOOST_CHECK(check_flips(10, h1));
+    BOOST_CHECK(!check_flips.cycle_detected);
+  }
+
+  const std::vector<data_t> v_init(create_initial_vectors<data_t>(dimensions, dimensions));
+
+  grassmann_pca_t reference_instance;
+  set_common_options(reference_instance);
+  BOOST_CHECK(reference_instance.set_cycle_detection(false));
+  std::vector<data_t> reference(dimensions);
+  run_batch_process(reference_instance, mat_data, reference, &v_init);
+  std::vector< std::vector<size_t> > const& reference_flips = reference_instance.get_sign_flips_statistics();
+
+  BOOST_CHECK(!grassmann_pca_t().set_sign_flips_convergence(1));
+
+  // stopping on zero flip gives the same basis, with at most as many iterations, and a tolerance 
+  // on the flips stops earlier, close to the basis
+  const double v_flips_fractions[] = {0, 0.01};
+  const double v_tolerances[] = {1E-6, 1};
+  for(size_t f = 0; f < sizeof(v_flips_fractions) / sizeof(v_flips_fractions[0]); f++)
+  {
+    BOOST_TEST_CHECKPOINT("fraction of flips " << v_flips_fractions[f]);
+
+    std::vector<data_t> basis_vectors(dimensions);
+    grassmann_pca_t instance;
+    set_common_options(instance);
+    BOOST_CHECK(instance.set_sign_flips_convergence(v_flips_fractions[f]));
+    run_batch_process(instance, mat_data, basis_vectors, &v_init);
+    check_same_basis_vectors(basis_vectors, reference, v_tolerances[f]);
+
+    std::vector< std::vector<size_t> > const& v_flips = instance.get_sign_flips_statistics();
+    BOOST_REQUIRE_EQUAL(v_flips.size(), dimensions);
+    for(int i = 0; i < dimensions; i++)
+    {
+      BOOST_TEST_CHECKPOINT("basis vector " << i);
+      BOOST_CHECK_LE(v_flips[i].size(), reference_flips[i].size());
+      if(v_flips_fractions[f] == 0 && !v_flips[i].empty())
+      {
+        BOOST_CHECK_EQUAL(v_flips[i].back(), 0);
+      }
+    }
+  }
+}
+
+
+BOOST_AUTO_TEST_CASE(margin_pruning_same_results)
+{
+  using namespace grassmann_averages_pca;
+  namespace ub = boost::numeric::ublas;
+
+  typedef ub::vector<double> data_t;
+
+  const std::vector<data_t> v_init(create_initial_vectors<data_t>(dimensions, dimensions));
+
+  grassmann_pca<data_t> reference_instance;
+  set_common_options(reference_instance);
+  std::vector<data_t> reference(dimensions);
+  run_batch_process(reference_instance, mat_data, reference, &v_init);
+  std::vector< std::vector<size_t> > const& reference_flips = reference_instance.get_sign_flips_statistics();
+
+  // nothing skipped without the pruning
+  {
+    std::vector< std::vector<size_t> > const& v_skipped = reference_instance.get_skipped_rows_statistics();
+    for(size_t i = 0; i < v_skipped.size(); i++)
+    {
+      BOOST_CHECK(std::count(v_skipped[i].begin(), v_skipped[i].end(), 0) == v_skipped[i].size());
+    }
+  }
+
+  // explicit and implicit transformations of the data
+  for(int implicit = 0; implicit < 2; implicit++)
+  {
+    BOOST_TEST_CHECKPOINT("implicit " << implicit);
+    std::vector<data_t> basis_vectors(dimensions);
+    grassmann_pca<data_t> instance;
+    set_common_options(instance);
+    BOOST_CHECK(instance.set_implicit_deflation(implicit == 1));
+    BOOST_CHECK(instance.set_margin_pruning(true));
+    run_batch_process(instance, mat_data, basis_vectors, &v_init);
+    check_same_basis_vectors(basis_vectors, reference);
+
+    // same sign flips, and the rows far from the hyperplane are skipped after the first update
+    std::vector< std::vector<size_t> > const& v_flips = instance.get_sign_flips_statistics();
+    std::vector< std::vector<size_t> > const& v_skipped = instance.get_skipped_rows_statistics();
+    BOOST_REQUIRE_EQUAL(v_skipped.size(), dimensions);
+    size_t nb_skipped = 0;
+    for(int i = 0; i < dimensions; i++)
+    {
+      BOOST_CHECK(v_flips[i] == reference_flips[i]);
+      BOOST_REQUIRE_EQUAL(v_skipped[i].size(), v_flips[i].size());
+      for(size_t j = 0; j < v_skipped[i].size(); j++)
+      {
+        BOOST_CHECK_LE(v_skipped[i][j], nb_elements);
+        nb_skipped += v_skipped[i][j];
+      }
+      if(!v_skipped[i].empty())
+      {
+        BOOST_CHECK_EQUAL(v_skipped[i][0], 0);
+      }
+    }
+    BOOST_CHECK_GT(nb_skipped, 0);
+  }
+}
+
+
+
+BOOST_AUTO_TEST_CASE(float_data_accumulation_policies)
+{
+  using namespace grassmann_averages_pca;
+  namespace ub = boost::numeric::ublas;
+
+  typedef ub::vector<double> data_t;
+  typedef ub::vector<float> data_float_t;
+
+  const std::vector<data_t> v_init(create_initial_vectors<data_t>(dimensions, dimensions));
+  const std::vector<data_float_t> v_init_float(create_initial_vectors<data_float_t>(dimensions, dimensions));
+
+  std::vector<data_t> reference(dimensions);
+  grassmann_pca<data_t> reference_instance;
+  set_common_options(reference_instance);
+  run_batch_process(reference_instance, mat_data, reference, &v_init);
+
+  // float data with double accumulators, and float data with compensated float accumulators
+  std::vector<data_float_t> basis_vectors_double(dimensions), basis_vectors_kahan(dimensions);
+  grassmann_pca<data_float_t, grassmann_trivial_callback<data_float_t>, details::norm2, float, 
+                details::pairwise_accumulation<double> > instance_double;
+  grassmann_pca<data_float_t, grassmann_trivial_callback<data_float_t>, details::norm2, float, 
+                details::kahan_accumulation<float> > instance_kahan;
+  set_common_options(instance_double);
+  set_common_options(instance_kahan);
+  BOOST_CHECK(instance_kahan.set_block_size(2));
+  run_batch_process(instance_double, mat_data, basis_vectors_double, &v_init_float);
+  run_batch_process(instance_kahan, mat_data, basis_vectors_kahan, &v_init_float);
+
+  check_same_basis_vectors(basis_vectors_double, reference, 1E-3);
+  check_same_basis_vectors(basis_vectors_kahan, reference, 1E-2);
+}
+
+
+BOOST_AUTO_TEST_CASE(compact_storage_same_results)
+{
+  using namespace grassmann_averages_pca;
+  namespace ub = boost::numeric::ublas;
+
+  typedef ub::vector<double> data_t;
+  typedef grassmann_pca<data_t, grassmann_trivial_callback<data_t>, details::norm2, boost::uint8_t> grassmann_pca_8_t;
+  typedef grassmann_pca<data_t, grassmann_trivial_callback<data_t>, details::norm2, boost::uint16_t> grassmann_pca_16_t;
+  typedef details::ublas_helpers::row_iter<const matrix_t> const_row_iter_t;
+
+  const matrix_t mat_pixels(create_pixel_data());
+  const std::vector<data_t> v_init(create_initial_vectors<data_t>(dimensions, dimensions));
+
+  std::vector<data_t> reference(dimensions);
+  grassmann_pca<data_t> reference_instance;
+  set_common_options(reference_instance);
+  run_batch_process(reference_instance, mat_pixels, reference, &v_init);
+
+  std::vector<data_t> basis_vectors_8(dimensions), basis_vectors_16(dimensions);
+  grassmann_pca_8_t instance_8;
+  grassmann_pca_16_t instance_16;
+  set_common_options(instance_8);
+  set_common_options(instance_16);
+  run_batch_process(instance_8, mat_pixels, basis_vectors_8, &v_init);
+  run_batch_process(instance_16, mat_pixels, basis_vectors_16, &v_init);
+
+  check_same_basis_vectors(basis_vectors_8, reference);
+  check_same_basis_vectors(basis_vectors_16, reference);
+
+  // values that the storage type cannot represent
+  double const invalid_values[] = {256, -1, 0.5};
+  for(size_t k = 0; k < sizeof(invalid_values) / sizeof(invalid_values[0]); k++)
+  {
+    matrix_t mat_invalid(mat_pixels);
+    mat_invalid(nb_elements / 2, 1) = invalid_values[k];
+
+    grassmann_pca_8_t instance;
+    BOOST_CHECK(instance.set_nb_processors(3));
+    BOOST_CHECK(!instance.batch_process(
+      max_iterations, dimensions,
+      const_row_iter_t(mat_invalid, 0), const_row_iter_t(mat_invalid, mat_invalid.size1()),
+      basis_vectors_8.begin(), &v_init));
+  }
+
+  // chunks overflowing the exact accumulators (the data is not read)
+  {
+    boost::uint8_t const value = 1;
+    grassmann_pca_8_t instance;
+    BOOST_CHECK(instance.set_nb_processors(1));
+    BOOST_CHECK(!instance.batch_process_borrowed_data(
+      max_iterations, 1, &value, size_t(1) << 24, 1, 1, basis_vectors_8.begin()));
+  }
+}
+
+
+
+BOOST_AUTO_TEST_CASE(implicit_deflation_same_results)
+{
+  using namespace grassmann_averages_pca;
+  namespace ub = boost::numeric::ublas;
+
+  typedef ub::vector<double> data_t;
+  typedef grassmann_pca<data_t> grassmann_pca_t;
+
+  const std::vector<data_t> v_init(create_initial_vectors<data_t>(dimensions, dimensions));
+
+  std::vector<data_t> reference(dimensions), basis_vectors(dimensions);
+  grassmann_pca_t reference_instance, instance;
+  set_common_options(reference_instance);
+  set_common_options(instance);
+  BOOST_CHECK(instance.set_implicit_deflation(true));
+  run_batch_process(reference_instance, mat_data, reference, &v_init);
+  run_batch_process(instance, mat_data, basis_vectors, &v_init);
+  check_same_basis_vectors(basis_vectors, reference);
+
+  // the data is used in place and should not be modified
+  const matrix_t mat_data_copy(mat_data);
+  std::vector<data_t> basis_vectors_borrowed(dimensions);
+  {
+    grassmann_pca_t instance_borrowed;
+    set_common_options(instance_borrowed);
+    BOOST_CHECK(!instance_borrowed.batch_process_borrowed_data(
+      max_iterations, dimensions,
+      &mat_data.data()[0], nb_elements, dimensions, dimensions - 1,
+      basis_vectors_borrowed.begin(), &v_init));
+    BOOST_REQUIRE(instance_borrowed.batch_process_borrowed_data(
+      max_iterations, dimensions,
+      &mat_data.data()[0], nb_elements, dimensions, dimensions,
+      basis_vectors_borrowed.begin(), &v_init));
+  }
+
+  for(int i = 0; i < nb_elements; i++)
+  {
+    for(int j = 0; j < dimensions; j++)
+    {
+      BOOST_REQUIRE_EQUAL(mat_data(i, j), mat_data_copy(i, j));
+    }
+  }
+
+  check_same_basis_vectors(basis_vectors_borrowed, reference);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(block_computation)
+{
+  using namespace grassmann_averages_pca;
+  namespace ub = boost::numeric::ublas;
+
+  typedef ub::vector<double> data_t;
+  typedef grassmann_pca<data_t> grassmann_pca_t;
+
+  // data with a well separated spread on each dimension
+  matrix_t mat_spread(nb_elements, dimensions);
+  for(int i = 0; i < nb_elements; i++)
+  {
+    for(int j = 0; j < dimensions; j++)
+    {
+      mat_spread(i, j) = dist(rng) / (1 << (2*j));
+    }
+  }
+
+  std::vector<data_t> reference(dimensions);
+  {
+    grassmann_pca_t instance;
+    set_common_options(instance, 3, false);
+    run_batch_process(instance, mat_spread, reference);
+  }
+
+  BOOST_CHECK(!grassmann_pca_t().set_block_size(0));
+
+  for(int implicit = 0; implicit < 2; implicit++)
+  {
+    BOOST_TEST_CHECKPOINT("implicit deflation " << implicit);
+
+    std::vector<data_t> basis_vectors(dimensions);
+    grassmann_pca_t instance;
+    set_common_options(instance, 3, false);
+    BOOST_CHECK(instance.set_block_size(2)); // last block with one vector
+    BOOST_CHECK(instance.set_implicit_deflation(implicit != 0));
+    run_batch_process(instance, mat_spread, basis_vectors);
+
+    BOOST_REQUIRE_EQUAL(instance.get_sign_flips_statistics().size(), dimensions);
+    for(int i = 0; i < dimensions; i++)
+    {
+      BOOST_CHECK_CLOSE(ub::inner_prod(basis_vectors[i], basis_vectors[i]), 1, 1E-6);
+      for(int j = i + 1; j < dimensions; j++)
+      {
+        BOOST_CHECK_SMALL(ub::inner_prod(basis_vectors[i], basis_vectors[j]), 1E-6);
+      }
+    }
+    check_same_basis_vectors(basis_vectors, reference, 1E-3);
+  }
+}
+
+
+BOOST_AUTO_TEST_CASE(numa_placement)
+{
+  using namespace grassmann_averages_pca;
+  using namespace grassmann_averages_pca::details::threading;
+  namespace ub = boost::numeric::ublas;
+
+  typedef ub::vector<double> data_t;
+
+  // sysfs format
+  std::vector<int> const cpus = parse_cpu_list("0-3,8,10-11");
+  int const expected_cpus[] = {0, 1, 2, 3, 8, 10, 11};
+  BOOST_CHECK_EQUAL_COLLECTIONS(cpus.begin(), cpus.end(), expected_cpus, expected_cpus + sizeof(expected_cpus)/sizeof(expected_cpus[0]));
+  BOOST_CHECK(!get_numa_nodes_cpus().empty());
+
+  // the nodes keep only the CPUs the process may use (eg. under taskset)
+  std::vector<int> const allowed_cpus = parse_cpu_list("2-9");
+  std::vector<int> const node_cpus = intersect_cpu_lists(cpus, allowed_cpus);
+  int const expected_node_cpus[] = {2, 3, 8};
+  BOOST_CHECK_EQUAL_COLLECTIONS(node_cpus.begin(), node_cpus.end(), expected_node_cpus, expected_node_cpus + sizeof(expected_node_cpus)/sizeof(expected_node_cpus[0]));
+  BOOST_CHECK(intersect_cpu_lists(parse_cpu_list("12-15"), allowed_cpus).empty());
+
+  std::vector<int> const process_cpus = get_process_cpus();
+  std::vector< std::vector<int> > const nodes_cpus = get_numa_nodes_cpus();
+  for(size_t node = 0; node < nodes_cpus.size(); node++)
+  {
+    BOOST_CHECK(process_cpus.empty() || intersect_cpu_lists(nodes_cpus[node], process_cpus) == nodes_cpus[node]);
+  }
+  BOOST_CHECK_GE(get_nb_process_processors(), 1);
+
+  // chunks assigned to the nodes by contiguous ranges
+  {
+    numa_thread_pool pool(3);
+    BOOST_CHECK(pool.nb_nodes() >= 1 && pool.nb_nodes() <= 3);
+    BOOST_CHECK_EQUAL(pool.node_of_chunk(0, 7), 0);
+    BOOST_CHECK_EQUAL(pool.node_of_chunk(6, 7), pool.nb_nodes() - 1);
+    for(size_t chunk = 1; chunk < 7; chunk++)
+    {
+      BOOST_CHECK(pool.node_of_chunk(chunk - 1, 7) <= pool.node_of_chunk(chunk, 7));
+    }
+  }
+
+  // the partial results of the chunks are added together, inline for small vectors and by the workers
+  // over ranges of dimensions for large ones
+  {
+    numa_thread_pool pool(2);
+    size_t const sizes[] = {3, 100003};
+    for(int k = 0; k < 2; k++)
+    {
+      partial_results_reducer<data_t> reducer(pool, 3, sizes[k]);
+      reducer.init();
+
+      std::vector<data_t> v_partials(3);
+      for(int chunk = 0; chunk < 3; chunk++)
+      {
+        v_partials[chunk] = ub::scalar_vector<double>(sizes[k], chunk + 1);
+        reducer.update(chunk, &v_partials[chunk]);
+        reducer.notify();
+      }
+      BOOST_CHECK(reducer.wait_notifications(3));
+
+      // without init, the next partial results are added to the current result
+      reducer.init_notifications();
+      reducer.update(1, &v_partials[0]);
+      for(int chunk = 0; chunk < 3; chunk++)
+      {
+        reducer.notify();
+      }
+      BOOST_CHECK(reducer.wait_notifications(3));
+
+      BOOST_REQUIRE_EQUAL(reducer.get_merged_result().size(), sizes[k]);
+      for(size_t i = 0; i < sizes[k]; i++)
+      {
+        BOOST_REQUIRE_EQUAL(reducer.get_merged_result()(i), 7);
+      }
+      // the squared norm is computed along with the merge
+      BOOST_CHECK_CLOSE(reducer.get_squared_norm(), 49. * sizes[k], 1E-10);
+    }
+  }
+
+  // same results without the placement
+  const std::vector<data_t> v_init(create_initial_vectors<data_t>(dimensions, dimensions));
+  grassmann_pca<data_t> reference_instance, instance;
+  set_common_options(reference_instance, 3, false);
+  set_common_options(instance, 3, false);
+  BOOST_CHECK(reference_instance.set_numa_placement(false));
+  check_same_results(reference_instance, instance, mat_data, dimensions, &v_init);
+}
+
+
+BOOST_AUTO_TEST_CASE(dimension_ranges_operations_same_results)
+{
+  using namespace grassmann_averages_pca;
+  using namespace grassmann_averages_pca::details::threading;
+  namespace ub = boost::numeric::ublas;
+
+  typedef ub::vector<double> data_t;
+
+  // one range on the calling thread, and several ranges and random blocks on the workers
+  size_t const sizes[] = {1000, 150001};
+  for(int k = 0; k < 2; k++)
+  {
+    const size_t nb_dimensions = sizes[k];
+    std::vector<data_t> v_random(2, data_t(nb_dimensions));
+    for(int i = 0; i < 2; i++)
+    {
+      numa_thread_pool pool(i == 0 ? 1 : 3);
+      dimension_ranges_operations<data_t> ranges_op(pool, nb_dimensions);
+
+      // the random vectors do not depend on the number of workers
+      details::random_data_generator<data_t> generator(-1, 1);
+      ranges_op.random_vector(generator, v_random[i]);
+      BOOST_CHECK_SMALL(ub::norm_inf(v_random[i] - v_random[0]), 1E-20);
+
+      data_t v(v_random[i]);
+      BOOST_CHECK_CLOSE(ranges_op.squared_norm(v), ub::inner_prod(v, v), 1E-8);
+
+      // the change is the one of convergence_check
+      data_t scaled = ub::zero_vector<double>(nb_dimensions);
+      const double change = ranges_op.scaled_copy(v, 0.5, scaled);
+      BOOST_CHECK_EQUAL(change, ub::norm_inf(scaled));
+      BOOST_CHECK_SMALL(ub::norm_inf(scaled - 0.5 * v), 1E-20);
+      BOOST_CHECK_EQUAL(ranges_op.scaled_copy(v, 0.5, scaled), 0);
+
+      // projection onto the orthogonal subspace of two orthonormal vectors
+      std::vector<data_t> basis(2, ub::zero_vector<double>(nb_dimensions));
+      basis[0](0) = 1;
+      basis[1](nb_dimensions - 1) = 1;
+      const double squared_norm = ranges_op.orthogonalise(v, basis);
+      BOOST_CHECK_EQUAL(v(0), 0);
+      BOOST_CHECK_EQUAL(v(nb_dimensions - 1), 0);
+      BOOST_CHECK_CLOSE(squared_norm, ub::inner_prod(v, v), 1E-8);
+    }
+  }
+}
+
+
+BOOST_AUTO_TEST_CASE(shared_thread_pool)
+{
+  using namespace grassmann_averages_pca;
+  namespace ub = boost::numeric::ublas;
+
+  typedef ub::vector<double> data_t;
+
+  const std::vector<data_t> v_init(create_initial_vectors<data_t>(dimensions, dimensions));
+
+  std::vector<data_t> reference(dimensions);
+  {
+    grassmann_pca<data_t> instance;
+    set_common_options(instance, 3, false);
+    run_batch_process(instance, mat_data, reference, &v_init);
+  }
+
+  // the same workers run several computations and instances
+  thread_pool pool(2);
+  BOOST_CHECK_EQUAL(pool.nb_threads(), 2);
+  for(int call = 0; call < 3; call++)
+  {
+    BOOST_TEST_CHECKPOINT("call " << call);
+
+    // the last call keeps the workers hot, even if there is not enough processors
+    pool.set_hot_workers(call == 2);
+
+    std::vector<data_t> basis_vectors(dimensions);
+    grassmann_pca<data_t> instance;
+    set_common_options(instance, 3, false);
+    BOOST_CHECK(instance.set_thread_pool(&pool));
+    run_batch_process(instance, mat_data, basis_vectors, &v_init);
+    check_same_basis_vectors(basis_vectors, reference);
+  }
+
+  {
+    std::vector<data_t> basis_vectors(dimensions);
+    grassmann_pca_with_trimming<data_t> instance(0.1);
+    set_common_options(instance, 3, false);
+    BOOST_CHECK(instance.set_thread_pool(&pool));
+    run_batch_process(instance, mat_data, basis_vectors, &v_init);
+  }
+}
+
+
+
+BOOST_AUTO_TEST_CASE(work_stealing)
+{
+  using namespace grassmann_averages_pca;
+  using namespace grassmann_averages_pca::details::threading;
+  namespace ub = boost::numeric::ublas;
+
+  typedef ub::vector<double> data_t;
+
+  // the ranges claimed by the owner and the stealers cover all the words exactly once
+  {
+    row_ranges_scheduler scheduler(2, 2);
+    scheduler.set_chunk(0, 37, 0);
+    scheduler.set_chunk(1, 5, 0);
+    scheduler.reset();
+
+    size_t chunk;
+    BOOST_CHECK(!scheduler.select_victim(0, chunk));
+    scheduler.open(0);
+    BOOST_REQUIRE(scheduler.select_victim(0, chunk));
+    BOOST_CHECK_EQUAL(chunk, 0);
+
+    size_t first_word, last_word, next_word = 0;
+    while(scheduler.claim(0, first_word, last_word))
+    {
+      BOOST_CHECK_EQUAL(first_word, next_word);
+      BOOST_CHECK_GE(last_word - first_word, std::min<size_t>(2, 37 - first_word));
+      next_word = last_word;
+    }
+    BOOST_CHECK_EQUAL(next_word, 37);
+    BOOST_CHECK(!scheduler.select_victim(0, chunk));
+
+    // the longest chunks are started first
+    scheduler.set_owner_duration(0, 1, 37);
+    scheduler.set_owner_duration(1, 10, 5);
+    BOOST_CHECK_EQUAL(scheduler.chunks_order()[0], 1);
+  }
+
+  const std::vector<data_t> v_init(create_initial_vectors<data_t>(dimensions, dimensions));
+  grassmann_pca<data_t> reference_instance, instance;
+  set_common_options(reference_instance, 4, false);
+  set_common_options(instance, 4, false);
+  BOOST_CHECK(reference_instance.set_work_stealing(false));
+  check_same_results(reference_instance, instance, mat_data, dimensions, &v_init);
+
+  // the flips of the stolen rows are counted as well
+  std::vector< std::vector<size_t> > const& reference_flips = reference_instance.get_sign_flips_statistics();
+  std::vector< std::vector<size_t> > const& v_flips = instance.get_sign_flips_statistics();
+  BOOST_REQUIRE_EQUAL(v_flips.size(), reference_flips.size());
+  for(size_t i = 0; i < v_flips.size(); i++)
+  {
+    BOOST_CHECK_EQUAL(v_flips[i].size(), reference_flips[i].size());
+    BOOST_CHECK(v_flips[i].empty() || v_flips[i].back() == 0);
+  }
+}
+
+
+BOOST_AUTO_TEST_CASE(dimension_tiles)
+{
+  using namespace grassmann_averages_pca;
+  namespace ub = boost::numeric::ublas;
+
+  typedef ub::vector<double> data_t;
+
+  // few high dimensional vectors: the 4 chunks have 10 rows each and the dimension gives 750 dimensions per worker
+  const size_t nb_vectors = 40, nb_dimensions = 3000, nb_basis_vectors = 4;
+  matrix_t data(nb_vectors, nb_dimensions);
+  for(size_t i = 0; i < nb_vectors; i++)
+  {
+    for(size_t j = 0; j < nb_dimensions; j++)
+    {
+      data(i, j) = dist(rng) / (1 + j % 13) + 50;
+    }
+  }
+
+  std::vector<data_t> v_init(nb_basis_vectors, data_t(nb_dimensions));
+  for(size_t k = 0; k < nb_basis_vectors; k++)
+  {
+    for(size_t j = 0; j < nb_dimensions; j++)
+    {
+      v_init[k](j) = dist(rng);
+    }
+  }
+
+  for(size_t nb_steps_pca = 0; nb_steps_pca < 4; nb_steps_pca += 3)
+  {
+    BOOST_TEST_CHECKPOINT("steps of PCA " << nb_steps_pca);
+
+    grassmann_pca<data_t> reference_instance, instance;
+    set_common_options(reference_instance, 4);
+    set_common_options(instance, 4);
+    BOOST_CHECK(reference_instance.set_nb_steps_pca(nb_steps_pca));
+    BOOST_CHECK(instance.set_nb_steps_pca(nb_steps_pca));
+    BOOST_CHECK(reference_instance.set_dimension_tiling(false));
+
+    std::vector<data_t> reference(nb_basis_vectors), basis_vectors(nb_basis_vectors);
+    run_batch_process(reference_instance, data, reference, &v_init);
+    run_batch_process(instance, data, basis_vectors, &v_init);
+    check_same_basis_vectors(basis_vectors, reference);
+
+    // the tiles follow the same iterations
+    std::vector< std::vector<size_t> > const& reference_flips = reference_instance.get_sign_flips_statistics();
+    std::vector< std::vector<size_t> > const& v_flips = instance.get_sign_flips_statistics();
+    BOOST_REQUIRE_EQUAL(v_flips.size(), reference_flips.size());
+    for(size_t i = 0; i < v_flips.size(); i++)
+    {
+      BOOST_CHECK_EQUAL_COLLECTIONS(v_flips[i].begin(), v_flips[i].end(), reference_flips[i].begin(), reference_flips[i].end());
+    }
+
+    for(size_t i = 0; i < nb_basis_vectors; i++)
+    {
+      for(size_t j = 0; j < i; j++)
+      {
+        BOOST_CHECK_SMALL(ub::inner_prod(basis_vectors[i], basis_vectors[j]), 1E-6);
+      }
+    }
+  }
+}
+
+
 #if 0
 BOOST_AUTO_TEST_CASE(checking_against_matlab)
 {
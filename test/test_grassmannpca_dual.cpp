@@ -0,0 +1,204 @@
+// Copyright 2014, Max Planck Society.
+// Distributed under the BSD 3-Clause license.
+// (See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/BSD-3-Clause)
+
+/*!@file
+ * This file includes the tests for the dual version of the grassmann pca, on the Gram matrix of the data
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <test/test_main.hpp>
+
+#include <include/grassmann_pca.hpp>
+#include <include/grassmann_pca_dual.hpp>
+#include <include/private/boost_ublas_row_iterator.hpp>
+
+// data stored into a matrix
+#include <boost/numeric/ublas/matrix.hpp>
+
+// generating data randomly
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_real_distribution.hpp>
+
+
+
+BOOST_FIXTURE_TEST_SUITE(grassmann_pca_dual_test_suite, fixture_simple_matrix_creation)
+
+
+namespace
+{
+  typedef boost::numeric::ublas::vector<double> data_t;
+  typedef boost::numeric::ublas::matrix<double> matrix_t;
+
+  //! Observer counting the logged errors.
+  struct error_counting_observer : grassmann_averages_pca::grassmann_trivial_callback<data_t>
+  {
+    mutable size_t nb_errors;
+    error_counting_observer() : nb_errors(0) {}
+    void log_error_message(const char*) const
+    {
+      nb_errors++;
+    }
+  };
+
+  //! Creates a dataset with fewer vectors than dimensions, the amplitude of the dimensions decreasing.
+  matrix_t create_wide_data(size_t nb_vectors, size_t nb_dimensions, boost::random::uniform_real_distribution<double>& dist)
+  {
+    matrix_t data(nb_vectors, nb_dimensions);
+    for(size_t i = 0; i < nb_vectors; i++)
+    {
+      for(size_t j = 0; j < nb_dimensions; j++)
+      {
+        data(i, j) = dist(rng) / (1 + j % 17) + 100;
+      }
+    }
+    return data;
+  }
+
+  //! Runs the primal and the dual algorithms with the same settings and initial guesses, and compares the basis vectors.
+  void compare_to_primal(matrix_t const& data, size_t nb_basis_vectors, size_t nb_processors, size_t max_chunk_size)
+  {
+    using namespace grassmann_averages_pca;
+    using namespace grassmann_averages_pca::details::ublas_helpers;
+    typedef row_iter<const matrix_t> const_row_iter_t;
+
+    const size_t nb_dimensions = data.size2();
+    const int max_iterations = 1000;
+
+    boost::random::uniform_real_distribution<double> init_dist(-1, 1);
+    std::vector<data_t> v_init_points(nb_basis_vectors, data_t(nb_dimensions));
+    for(size_t k = 0; k < nb_basis_vectors; k++)
+    {
+      for(size_t j = 0; j < nb_dimensions; j++)
+      {
+        v_init_points[k](j) = init_dist(rng);
+      }
+    }
+
+    grassmann_pca<data_t> primal;
+    primal.set_nb_processors(nb_processors);
+    primal.set_centering(true);
+    std::vector<data_t> primal_basis(nb_basis_vectors);
+    BOOST_REQUIRE(primal.batch_process(
+      max_iterations,
+      nb_basis_vectors,
+      const_row_iter_t(data, 0),
+      const_row_iter_t(data, data.size1()),
+      primal_basis.begin(),
+      &v_init_points));
+
+    grassmann_pca_dual<data_t> dual;
+    dual.set_nb_processors(nb_processors);
+    dual.set_max_chunk_size(max_chunk_size);
+    dual.set_centering(true);
+    std::vector<data_t> dual_basis(nb_basis_vectors);
+    BOOST_REQUIRE(dual.batch_process(
+      max_iterations,
+      nb_basis_vectors,
+      const_row_iter_t(data, 0),
+      const_row_iter_t(data, data.size1()),
+      dual_basis.begin(),
+      &v_init_points));
+
+    for(size_t k = 0; k < nb_basis_vectors; k++)
+    {
+      BOOST_CHECK_CLOSE(boost::numeric::ublas::norm_2(dual_basis[k]), 1, 1E-6);
+      BOOST_CHECK_CLOSE(std::abs(boost::numeric::ublas::inner_prod(dual_basis[k], primal_basis[k])), 1, 1E-6);
+      for(size_t j = 0; j < k; j++)
+      {
+        BOOST_CHECK_SMALL(boost::numeric::ublas::inner_prod(dual_basis[k], dual_basis[j]), 1E-6);
+      }
+    }
+
+    // the iterations stop on the same signs, the last count of sign flips being recorded by both
+    std::vector< std::vector<size_t> > const& primal_flips = primal.get_sign_flips_statistics();
+    std::vector< std::vector<size_t> > const& dual_flips = dual.get_sign_flips_statistics();
+    BOOST_REQUIRE_EQUAL(dual_flips.size(), nb_basis_vectors);
+    for(size_t k = 0; k < nb_basis_vectors; k++)
+    {
+      BOOST_TEST_CHECKPOINT("basis vector " << k);
+      BOOST_REQUIRE(!dual_flips[k].empty());
+      BOOST_CHECK_EQUAL(dual_flips[k].back(), 0);
+      BOOST_CHECK_EQUAL(dual_flips[k].size(), primal_flips[k].size());
+    }
+  }
+}
+
+
+BOOST_AUTO_TEST_CASE(returns_false_for_inapropriate_inputs)
+{
+  using namespace grassmann_averages_pca;
+  using namespace grassmann_averages_pca::details::ublas_helpers;
+
+  typedef row_iter<const matrix_t> const_row_iter_t;
+
+  grassmann_pca_dual<data_t, error_counting_observer> instance;
+  error_counting_observer observer;
+  BOOST_CHECK(instance.set_observer(&observer));
+  std::vector<data_t> basis_vectors(dimensions);
+
+  BOOST_CHECK(!instance.batch_process(
+    1000,
+    dimensions,
+    const_row_iter_t(mat_data, 2),
+    const_row_iter_t(mat_data, 0),
+    basis_vectors.begin()));
+  BOOST_CHECK_EQUAL(observer.nb_errors, 1);
+
+  // the Gram matrix of 2 vectors gives at most 2 basis vectors
+  BOOST_CHECK(!instance.batch_process(
+    1000,
+    3,
+    const_row_iter_t(mat_data, 0),
+    const_row_iter_t(mat_data, 2),
+    basis_vectors.begin()));
+  BOOST_CHECK_EQUAL(observer.nb_errors, 2);
+
+  // the Gram matrix of 3 vectors exceeds the maximum size
+  BOOST_CHECK(instance.set_max_gram_size(2));
+  BOOST_CHECK(!instance.batch_process(
+    1000,
+    1,
+    const_row_iter_t(mat_data, 0),
+    const_row_iter_t(mat_data, 3),
+    basis_vectors.begin()));
+  BOOST_CHECK_EQUAL(observer.nb_errors, 3);
+
+  BOOST_CHECK(!instance.set_max_chunk_size(0));
+  BOOST_CHECK(!instance.set_max_gram_size(0));
+  BOOST_CHECK(!instance.set_max_gram_size(std::numeric_limits<size_t>::max()));
+}
+
+
+BOOST_AUTO_TEST_CASE(same_results_as_primal)
+{
+  // fewer vectors than the rows of a block of the Gram matrix and than the dimensions of a panel
+  compare_to_primal(create_wide_data(50, 200, dist), 4, 1, std::numeric_limits<size_t>::max());
+}
+
+
+BOOST_AUTO_TEST_CASE(same_results_as_primal_several_workers)
+{
+  // several blocks of the Gram matrix, several panels and several chunks of uneven sizes
+  compare_to_primal(create_wide_data(150, 1100, dist), 5, 3, 40);
+}
+
+
+BOOST_AUTO_TEST_CASE(same_results_as_primal_on_low_dimensional_data)
+{
+  // more vectors than dimensions: the Gram matrix is singular
+  using namespace grassmann_averages_pca::details::ublas_helpers;
+  matrix_t data(300, dimensions);
+  for(size_t i = 0; i < data.size1(); i++)
+  {
+    for(int j = 0; j < dimensions; j++)
+    {
+      data(i, j) = mat_data(i, j) / (1 + j);
+    }
+  }
+  compare_to_primal(data, dimensions - 1, 2, std::numeric_limits<size_t>::max());
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -21,6 +21,10 @@
 #include <boost/random/mersenne_twister.hpp>
 #include <boost/random/uniform_real_distribution.hpp>
 
+// repeating a row
+#include <boost/iterator/counting_iterator.hpp>
+#include <boost/iterator/transform_iterator.hpp>
+
 
 // boost chrono
 #include <boost/chrono/include.hpp>
@@ -32,6 +36,25 @@
 BOOST_FIXTURE_TEST_SUITE(grassmann_pca_with_trimming_test_suite, fixture_simple_matrix_creation)
 
 
+namespace
+{
+  //! Returns the same vector for any index, for ranges of data that are never read.
+  template <class data_t>
+  struct repeated_vector
+  {
+    typedef data_t const& result_type;
+    data_t const *p_vector;
+
+    repeated_vector() : p_vector(0) {}
+    explicit repeated_vector(data_t const &vector) : p_vector(&vector) {}
+    result_type operator()(size_t) const
+    {
+      return *p_vector;
+    }
+  };
+}
+
+
 
 BOOST_AUTO_TEST_CASE(returns_false_for_inapropriate_inputs)
 {
@@ -440,6 +463,496 @@ BOOST_AUTO_TEST_CASE(smoke_and_orthogonality_tests_several_workers)
 
 
 
+BOOST_AUTO_TEST_CASE(compact_storage_same_results)
+{
+  using namespace grassmann_averages_pca;
+  namespace ub = boost::numeric::ublas;
+
+  typedef ub::vector<double> data_t;
+  typedef grassmann_pca_with_trimming<data_t, grassmann_trivial_callback<data_t>, details::norm2, boost::uint8_t> grassmann_pca_8_t;
+  typedef details::ublas_helpers::row_iter<const matrix_t> const_row_iter_t;
+
+  const matrix_t mat_pixels(create_pixel_data());
+  const std::vector<data_t> v_init(create_initial_vectors<data_t>(dimensions, dimensions));
+
+  grassmann_pca_with_trimming<data_t> reference_instance(0.1);
+  grassmann_pca_8_t instance(0.1);
+  set_common_options(reference_instance);
+  set_common_options(instance);
+  check_same_results(reference_instance, instance, mat_pixels, dimensions, &v_init);
+
+  // values that the storage type cannot represent
+  std::vector<data_t> basis_vectors(dimensions);
+  double const invalid_values[] = {256, -1, 0.5};
+  for(size_t k = 0; k < sizeof(invalid_values) / sizeof(invalid_values[0]); k++)
+  {
+    matrix_t mat_invalid(mat_pixels);
+    mat_invalid(nb_elements / 2, 1) = invalid_values[k];
+
+    grassmann_pca_8_t invalid_instance(0.1);
+    BOOST_CHECK(invalid_instance.set_nb_processors(3));
+    BOOST_CHECK(!invalid_instance.batch_process(
+      max_iterations, dimensions,
+      const_row_iter_t(mat_invalid, 0), const_row_iter_t(mat_invalid, mat_invalid.size1()),
+      basis_vectors.begin(), &v_init));
+  }
+
+  // chunks overflowing the exact accumulators (the data is not read)
+  {
+    typedef boost::transform_iterator<repeated_vector<data_t>, boost::counting_iterator<size_t> > repeated_iter_t;
+    const data_t value(1, 1);
+    grassmann_pca_8_t invalid_instance(0.1);
+    BOOST_CHECK(invalid_instance.set_nb_processors(1));
+    BOOST_CHECK(!invalid_instance.batch_process(
+      max_iterations, 1,
+      repeated_iter_t(boost::counting_iterator<size_t>(0), repeated_vector<data_t>(value)), 
+      repeated_iter_t(boost::counting_iterator<size_t>(size_t(1) << 24), repeated_vector<data_t>(value)),
+      basis_vectors.begin()));
+  }
+}
+
+
+
+BOOST_AUTO_TEST_CASE(histogram_trimming)
+{
+  using namespace grassmann_averages_pca;
+  namespace ub = boost::numeric::ublas;
+
+  typedef ub::vector<double> data_t;
+  typedef grassmann_pca_with_trimming<data_t, grassmann_trivial_callback<data_t>, details::norm2, boost::uint8_t> grassmann_pca_t;
+
+  // trimmed mean of signed and centered integers from their histograms
+  {
+    const size_t nb_bins = 256;
+    const double v_offsets[] = {0, 100.37};
+    const size_t v_sizes[] = {1000, 1001};
+    for(size_t o = 0; o < sizeof(v_offsets) / sizeof(v_offsets[0]); o++)
+    {
+      for(size_t s = 0; s < sizeof(v_sizes) / sizeof(v_sizes[0]); s++)
+      {
+        const size_t size = v_sizes[s];
+        std::vector<size_t> counts(2 * nb_bins, 0);
+        std::vector<double> data(size);
+        for(size_t i = 0; i < size; i++)
+        {
+          const int value = static_cast<int>((dist(rng) + 1000) * 255 / 2000);
+          const bool negative = dist(rng) < 0;
+          counts[negative * nb_bins + value]++;
+          data[i] = negative ? v_offsets[o] - value : value - v_offsets[o];
+        }
+
+        const size_t v_k[] = {0, 1, 100, size/2};
+        for(size_t i = 0; i < sizeof(v_k) / sizeof(v_k[0]); i++)
+        {
+          BOOST_TEST_CHECKPOINT("offset " << v_offsets[o] << " size " << size << " k " << v_k[i]);
+          std::vector<double> data_copy(data);
+          BOOST_CHECK_CLOSE(
+            details::compute_mean_within_bounds_histogram(&counts[0], &counts[nb_bins], nb_bins, 0, v_offsets[o], v_k[i]),
+            details::compute_mean_within_bounds_nth_element(&data_copy[0], data_copy.size(), v_k[i]),
+            1E-8);
+        }
+      }
+    }
+  }
+
+  // pixel like data, with and without the signed copy of the data for the next basis vectors
+  const matrix_t mat_pixels(create_pixel_data());
+  const std::vector<data_t> v_init(create_initial_vectors<data_t>(dimensions, dimensions));
+
+  const double v_trimming[] = {0.1, 0.5};
+  const int v_nb_basis_vectors[] = {1, dimensions};
+  for(size_t t = 0; t < sizeof(v_trimming) / sizeof(v_trimming[0]); t++)
+  {
+    for(size_t b = 0; b < sizeof(v_nb_basis_vectors) / sizeof(v_nb_basis_vectors[0]); b++)
+    {
+      BOOST_TEST_CHECKPOINT("trimming " << v_trimming[t] << " basis vectors " << v_nb_basis_vectors[b]);
+
+      grassmann_pca_t reference_instance(v_trimming[t]), instance(v_trimming[t]);
+      set_common_options(reference_instance);
+      set_common_options(instance);
+      BOOST_CHECK(reference_instance.set_histogram_trimming(0));
+      check_same_results(reference_instance, instance, mat_pixels, v_nb_basis_vectors[b], &v_init);
+    }
+  }
+
+  // the histograms apply to the first basis vector only, the next ones using the approximate trimming when enabled
+  {
+    grassmann_pca_t instance(0.1);
+    set_common_options(instance);
+    BOOST_CHECK(instance.set_approximate_trimming(nb_elements));
+    std::vector<data_t> basis_vectors(dimensions);
+    run_batch_process(instance, mat_pixels, basis_vectors, &v_init);
+
+    std::vector< std::vector<size_t> > const& rank_errors = instance.get_trimming_rank_errors();
+    BOOST_REQUIRE_EQUAL(rank_errors.size(), dimensions);
+    BOOST_CHECK(rank_errors[0].empty());
+    for(int i = 1; i < dimensions; i++)
+    {
+      BOOST_TEST_CHECKPOINT("basis vector " << i);
+      BOOST_CHECK(!rank_errors[i].empty());
+    }
+  }
+}
+
+
+
+BOOST_AUTO_TEST_CASE(dimension_ranges)
+{
+  using namespace grassmann_averages_pca;
+  namespace ub = boost::numeric::ublas;
+
+  typedef ub::vector<double> data_t;
+  typedef grassmann_pca_with_trimming<data_t> grassmann_pca_t;
+
+  // merge of a range of dimensions
+  {
+    data_t state(ub::scalar_vector<double>(10, 1));
+    const double values[] = {1, 2, 3};
+    details::s_dimension_range_update<double> update;
+    update.first_dimension = 6;
+    update.nb_dimensions = 3;
+    update.values = values;
+    BOOST_CHECK(details::merger_update_dimension_range<data_t>()(state, update));
+    for(size_t i = 0; i < state.size(); i++)
+    {
+      BOOST_CHECK_EQUAL(state(i), i >= 6 && i < 9 ? 1 + values[i - 6] : 1);
+    }
+  }
+
+  // the tasks of the trimmed averages span several dimensions, with a different number of dimensions per task
+  // for each number of processors
+  const size_t nb_dimensions = 100;
+  const size_t nb_vectors = 2000;
+  matrix_t mat_high_dimensional(nb_vectors, nb_dimensions);
+  for(size_t i = 0; i < nb_vectors; i++)
+  {
+    for(size_t j = 0; j < nb_dimensions; j++)
+    {
+      mat_high_dimensional(i, j) = dist(rng) / (j + 1);
+    }
+  }
+
+  const std::vector<data_t> v_init(create_initial_vectors<data_t>(3, nb_dimensions));
+  for(int streaming = 0; streaming < 2; streaming++)
+  {
+    BOOST_TEST_CHECKPOINT("streaming " << streaming);
+
+    grassmann_pca_t reference_instance(0.2), instance(0.2);
+    set_common_options(reference_instance, 1, false);
+    set_common_options(instance, 3, false);
+    BOOST_CHECK(instance.set_max_chunk_size(nb_vectors));
+    BOOST_CHECK(reference_instance.set_streaming_trimming(streaming != 0));
+    BOOST_CHECK(instance.set_streaming_trimming(streaming != 0));
+    check_same_results(reference_instance, instance, mat_high_dimensional, v_init.size(), &v_init);
+  }
+}
+
+
+
+BOOST_AUTO_TEST_CASE(block_computation)
+{
+  using namespace grassmann_averages_pca;
+  namespace ub = boost::numeric::ublas;
+
+  typedef ub::vector<double> data_t;
+  typedef grassmann_pca_with_trimming<data_t> grassmann_pca_t;
+  typedef grassmann_pca_with_trimming<data_t, grassmann_trivial_callback<data_t>, details::norm2, boost::uint8_t> grassmann_pca_8_t;
+
+  const matrix_t mat_spread(create_pixel_data());
+  const std::vector<data_t> v_init(create_initial_vectors<data_t>(dimensions, dimensions));
+
+  BOOST_CHECK(!grassmann_pca_t().set_block_size(0));
+
+  // the compact storage applies the transformations implicitly
+  grassmann_pca_t reference_instance(0.1), instance(0.1);
+  grassmann_pca_8_t instance_compact(0.1);
+  set_common_options(reference_instance);
+  set_common_options(instance);
+  set_common_options(instance_compact);
+  BOOST_CHECK(instance.set_block_size(2)); // last block with one vector
+  BOOST_CHECK(instance_compact.set_block_size(2));
+
+  std::vector<data_t> reference(dimensions), basis_vectors(dimensions), basis_vectors_compact(dimensions);
+  run_batch_process(reference_instance, mat_spread, reference, &v_init);
+  run_batch_process(instance, mat_spread, basis_vectors, &v_init);
+  run_batch_process(instance_compact, mat_spread, basis_vectors_compact, &v_init);
+
+  for(int i = 0; i < dimensions; i++)
+  {
+    BOOST_TEST_CHECKPOINT("basis vector " << i);
+    BOOST_CHECK_CLOSE(ub::inner_prod(basis_vectors[i], basis_vectors[i]), 1, 1E-6);
+    for(int j = i + 1; j < dimensions; j++)
+    {
+      BOOST_CHECK_SMALL(ub::inner_prod(basis_vectors[i], basis_vectors[j]), 1E-6);
+    }
+  }
+
+  check_same_basis_vectors(basis_vectors, reference, 1E-3);
+  check_same_basis_vectors(basis_vectors_compact, basis_vectors);
+}
+
+
+BOOST_AUTO_TEST_CASE(sign_flips_convergence)
+{
+  using namespace grassmann_averages_pca;
+  namespace ub = boost::numeric::ublas;
+
+  typedef ub::vector<double> data_t;
+  typedef grassmann_pca_with_trimming<data_t> grassmann_pca_t;
+
+  const std::vector<data_t> v_init(create_initial_vectors<data_t>(dimensions, dimensions));
+
+  BOOST_CHECK(!grassmann_pca_t(0.1).set_sign_flips_convergence(1));
+
+  // the trimmed averages of the last iteration are skipped when no sign changed
+  grassmann_pca_t reference_instance(0.1), instance(0.1);
+  set_common_options(reference_instance);
+  set_common_options(instance);
+  BOOST_CHECK(reference_instance.set_cycle_detection(false));
+  BOOST_CHECK(instance.set_sign_flips_convergence(0));
+  check_same_results(reference_instance, instance, mat_data, dimensions, &v_init);
+
+  std::vector< std::vector<size_t> > const& reference_flips = reference_instance.get_sign_flips_statistics();
+  std::vector< std::vector<size_t> > const& v_flips = instance.get_sign_flips_statistics();
+  BOOST_REQUIRE_EQUAL(v_flips.size(), dimensions);
+  for(int i = 0; i < dimensions; i++)
+  {
+    BOOST_TEST_CHECKPOINT("basis vector " << i);
+    BOOST_CHECK_LE(v_flips[i].size(), reference_flips[i].size());
+    for(size_t j = 0; j < v_flips[i].size(); j++)
+    {
+      BOOST_CHECK_LE(v_flips[i][j], nb_elements);
+    }
+  }
+
+  // a tolerance on the flips stops after the trimmed averages of the last signs, close to the basis
+  grassmann_pca_t instance_tolerance(0.1);
+  set_common_options(instance_tolerance);
+  BOOST_CHECK(instance_tolerance.set_sign_flips_convergence(0.01));
+  check_same_results(reference_instance, instance_tolerance, mat_data, dimensions, &v_init, 1);
+}
+
+
+BOOST_AUTO_TEST_CASE(streaming_trimming)
+{
+  using namespace grassmann_averages_pca;
+  namespace ub = boost::numeric::ublas;
+
+  typedef ub::vector<double> data_t;
+  typedef grassmann_pca_with_trimming<data_t> grassmann_pca_t;
+
+  // trimmed mean from the extremal elements of several parts of a data set
+  {
+    const size_t nb_parts = 3;
+    const size_t k = 20;
+    std::vector<double> data(nb_elements);
+    for(size_t i = 0; i < data.size(); i++)
+    {
+      data[i] = dist(rng);
+    }
+
+    double acc = 0;
+    std::vector<double> v_largest(nb_parts * k), v_smallest(nb_parts * k);
+    const size_t part_size = data.size() / nb_parts;
+    for(size_t part = 0; part < nb_parts; part++)
+    {
+      const size_t part_end = part == nb_parts - 1 ? data.size() : (part + 1) * part_size;
+      acc += details::accumulate_extremal_elements(
+        &data[part * part_size], part_end - part * part_size, k, &v_largest[part * k], &v_smallest[part * k]);
+    }
+    acc -= details::sum_of_extremal_elements(&v_largest[0], v_largest.size(), k, std::greater<double>());
+    acc -= details::sum_of_extremal_elements(&v_smallest[0], v_smallest.size(), k, std::less<double>());
+
+    BOOST_CHECK_CLOSE(acc / (data.size() - 2*k), details::compute_mean_within_bounds(&data[0], data.size(), k), 1E-8);
+
+    // fewer elements than the number of extremal elements
+    double v_small_largest[3], v_small_smallest[3];
+    BOOST_CHECK_CLOSE(details::accumulate_extremal_elements(&data[0], 2, 3, v_small_largest, v_small_smallest), data[0] + data[1], 1E-8);
+    BOOST_CHECK_CLOSE(details::sum_of_extremal_elements(v_small_largest, 2, 1, std::greater<double>()), std::max(data[0], data[1]), 1E-8);
+  }
+
+  const std::vector<data_t> v_init(create_initial_vectors<data_t>(dimensions, dimensions));
+  for(size_t block_size = 1; block_size <= 2; block_size++)
+  {
+    BOOST_TEST_CHECKPOINT("block size " << block_size);
+
+    // signed copy of the data against the extremal elements of the chunks
+    grassmann_pca_t reference_instance(0.1), instance(0.1);
+    set_common_options(reference_instance);
+    set_common_options(instance);
+    BOOST_CHECK(reference_instance.set_block_size(block_size));
+    BOOST_CHECK(instance.set_block_size(block_size));
+    BOOST_CHECK(reference_instance.set_streaming_trimming(false));
+    check_same_results(reference_instance, instance, mat_data, dimensions, &v_init);
+  }
+}
+
+
+BOOST_AUTO_TEST_CASE(approximate_trimming)
+{
+  using namespace grassmann_averages_pca;
+  namespace ub = boost::numeric::ublas;
+
+  typedef ub::vector<double> data_t;
+  typedef grassmann_pca_with_trimming<data_t> grassmann_pca_t;
+
+  // trimmed mean between the bounds estimated from a sample, accumulated over several parts of a data set
+  {
+    const size_t nb_parts = 3;
+    std::vector<double> data(nb_elements);
+    for(size_t i = 0; i < data.size(); i++)
+    {
+      data[i] = dist(rng);
+    }
+    std::vector<double> sorted_data(data);
+    std::sort(sorted_data.begin(), sorted_data.end());
+
+    const size_t v_k[] = {0, 20, 1000, size_t(nb_elements/2 - 1)};
+    const size_t v_strides[] = {1, 10};
+    for(size_t i = 0; i < sizeof(v_k) / sizeof(v_k[0]); i++)
+    {
+      for(size_t s = 0; s < sizeof(v_strides) / sizeof(v_strides[0]); s++)
+      {
+        const size_t k = v_k[i], stride = v_strides[s];
+        BOOST_TEST_CHECKPOINT("k " << k << " stride " << stride);
+
+        std::vector<double> sample;
+        for(size_t j = stride / 2; j < data.size(); j += stride)
+        {
+          sample.push_back(data[j]);
+        }
+
+        double low, high;
+        details::estimate_trimming_bounds(&sample[0], sample.size(), data.size(), k, low, high);
+        BOOST_CHECK_LE(low, high);
+
+        details::bounded_accumulation<double> accumulation(low, high);
+        const size_t part_size = data.size() / nb_parts;
+        for(size_t part = 0; part < nb_parts; part++)
+        {
+          const size_t part_end = part == nb_parts - 1 ? data.size() : (part + 1) * part_size;
+          accumulation.add(&data[part * part_size], part_end - part * part_size);
+        }
+
+        // rank error from the sorted data, without ties
+        const size_t nb_below = std::lower_bound(sorted_data.begin(), sorted_data.end(), low) - sorted_data.begin();
+        const size_t nb_above = sorted_data.end() - std::upper_bound(sorted_data.begin(), sorted_data.end(), high);
+        const size_t error = std::max<size_t>(
+          nb_below > k ? nb_below - k : (k > nb_below + 1 ? k - nb_below - 1 : 0),
+          nb_above > k ? nb_above - k : (k > nb_above + 1 ? k - nb_above - 1 : 0));
+        BOOST_CHECK_EQUAL(accumulation.rank_error(k), error);
+
+        // the bounds are elements of the data set, which are trimmed on the sides without rank error
+        const size_t nb_trimmed_low = k >= nb_below && k <= nb_below + 1 ? k : nb_below;
+        const size_t nb_trimmed_high = k >= nb_above && k <= nb_above + 1 ? k : nb_above;
+        const double expected = 
+          std::accumulate(sorted_data.begin() + nb_trimmed_low, sorted_data.end() - nb_trimmed_high, 0.) / 
+          (data.size() - nb_trimmed_low - nb_trimmed_high);
+        BOOST_CHECK_CLOSE(accumulation.mean(k), expected, 1E-8);
+
+        // the full sample gives the exact bounds
+        if(stride == 1)
+        {
+          BOOST_CHECK_EQUAL(accumulation.rank_error(k), 0);
+          std::vector<double> data_copy(data);
+          BOOST_CHECK_CLOSE(accumulation.mean(k), details::compute_mean_within_bounds(&data_copy[0], data_copy.size(), k), 1E-8);
+        }
+      }
+    }
+
+    // integer data with many ties: the full sample gives the exact trimmed mean
+    for(size_t i = 0; i < data.size(); i++)
+    {
+      data[i] = std::floor(dist(rng) / 100);
+    }
+    for(size_t i = 0; i < sizeof(v_k) / sizeof(v_k[0]); i++)
+    {
+      const size_t k = v_k[i];
+      BOOST_TEST_CHECKPOINT("ties k " << k);
+
+      std::vector<double> sample(data);
+      double low, high;
+      details::estimate_trimming_bounds(&sample[0], sample.size(), data.size(), k, low, high);
+
+      details::bounded_accumulation<double> accumulation(low, high);
+      accumulation.add(&data[0], data.size());
+      BOOST_CHECK_EQUAL(accumulation.rank_error(k), 0);
+
+      std::vector<double> data_copy(data);
+      BOOST_CHECK_CLOSE(accumulation.mean(k), details::compute_mean_within_bounds(&data_copy[0], data_copy.size(), k), 1E-8);
+    }
+  }
+
+  // data with a decreasing variance along the dimensions
+  matrix_t mat_scaled(mat_data);
+  for(int j = 0; j < dimensions; j++)
+  {
+    ub::column(mat_scaled, j) /= (j + 1);
+  }
+
+  const std::vector<data_t> v_init(create_initial_vectors<data_t>(dimensions, dimensions));
+
+  std::vector<data_t> reference(dimensions);
+  {
+    grassmann_pca_t instance(0.1);
+    set_common_options(instance);
+    BOOST_CHECK(instance.set_streaming_trimming(false));
+    run_batch_process(instance, mat_scaled, reference, &v_init);
+    BOOST_CHECK(instance.get_trimming_rank_errors()[0].empty());
+  }
+
+  // sampling all the elements gives the exact trimmed averages, a smaller sample approximates them
+  const size_t v_sample_sizes[] = {size_t(nb_elements), 2000};
+  for(size_t s = 0; s < sizeof(v_sample_sizes) / sizeof(v_sample_sizes[0]); s++)
+  {
+    BOOST_TEST_CHECKPOINT("sample size " << v_sample_sizes[s]);
+    const bool exact = v_sample_sizes[s] == size_t(nb_elements);
+
+    std::vector<data_t> basis_vectors(dimensions);
+    grassmann_pca_t instance(0.1);
+    set_common_options(instance);
+    BOOST_CHECK(instance.set_approximate_trimming(v_sample_sizes[s]));
+    run_batch_process(instance, mat_scaled, basis_vectors, &v_init);
+    if(exact)
+    {
+      check_same_basis_vectors(basis_vectors, reference);
+    }
+
+    std::vector< std::vector<size_t> > const &rank_errors = instance.get_trimming_rank_errors();
+    BOOST_REQUIRE_EQUAL(rank_errors.size(), dimensions);
+    for(int i = 0; i < dimensions; i++)
+    {
+      BOOST_TEST_CHECKPOINT("basis vector " << i);
+      BOOST_REQUIRE(!rank_errors[i].empty());
+      if(exact)
+      {
+        BOOST_CHECK_EQUAL(*std::max_element(rank_errors[i].begin(), rank_errors[i].end()), 0);
+      }
+      else
+      {
+        BOOST_CHECK_LT(*std::max_element(rank_errors[i].begin(), rank_errors[i].end()), nb_elements / 20);
+        BOOST_CHECK_GT(std::abs(ub::inner_prod(basis_vectors[i], reference[i])), 0.99);
+      }
+    }
+  }
+
+  // integer data with many ties (the first basis vector is computed on the integers, without centering): 
+  // sampling all the elements gives the exact trimmed averages
+  {
+    const matrix_t mat_integers(create_pixel_data() - ub::scalar_matrix<double>(nb_elements, dimensions, 64));
+    grassmann_pca_t reference_instance(0.1), instance(0.1);
+    set_common_options(reference_instance, 3, false);
+    set_common_options(instance, 3, false);
+    BOOST_CHECK(instance.set_approximate_trimming(nb_elements));
+    check_same_results(reference_instance, instance, mat_integers, 1, &v_init);
+
+    std::vector<size_t> const &rank_errors = instance.get_trimming_rank_errors()[0];
+    BOOST_REQUIRE(!rank_errors.empty());
+    BOOST_CHECK_EQUAL(*std::max_element(rank_errors.begin(), rank_errors.end()), 0);
+  }
+}
+
+
 BOOST_AUTO_TEST_CASE(simple_median_with_nth_element)
 {
   // basically this test is for the correctness of the computation of the median using nth_element
@@ -471,7 +984,70 @@ BOOST_AUTO_TEST_CASE(simple_median_with_nth_element)
   BOOST_CHECK_CLOSE(details::compute_mean_within_bounds(&data_even_copy[0], nb_elements, 0), 4.5, 0.001);
   BOOST_CHECK_CLOSE(details::compute_mean_within_bounds(&data_odd_copy[0],  nb_elements+1, 0), 5, 0.001);
 
+  // the radix selection of the floating point types gives the same results as the partial sortings, also with 
+  // ties, negative values and signed zeros
+  std::vector<double> data_random(1001);
+  for(size_t i = 0; i < data_random.size(); i++)
+  {
+    data_random[i] = i % 7 == 0 ? 0. : (i % 11 == 0 ? -0. : std::floor(dist(rng) / 10));
+  }
+  std::vector<float> data_random_float(data_random.begin(), data_random.end());
+  for(size_t size = data_random.size() - 1; size <= data_random.size(); size++)
+  {
+    const size_t v_k[] = {0, 1, 10, 100, size/2 - 1, size/2};
+    for(size_t i = 0; i < sizeof(v_k) / sizeof(v_k[0]); i++)
+    {
+      BOOST_TEST_CHECKPOINT("size " << size << " k " << v_k[i]);
+      std::vector<double> data_copy(data_random.begin(), data_random.begin() + size);
+      std::vector<float> data_copy_float(data_random_float.begin(), data_random_float.begin() + size);
+
+      const double radix = details::compute_mean_within_bounds_radix(&data_random[0], size, v_k[i]);
+      const float radix_float = details::compute_mean_within_bounds_radix(&data_random_float[0], size, v_k[i]);
+      BOOST_CHECK_CLOSE(radix, details::compute_mean_within_bounds_nth_element(&data_copy[0], size, v_k[i]), 1E-10);
+      BOOST_CHECK_CLOSE(radix_float, details::compute_mean_within_bounds_nth_element(&data_copy_float[0], size, v_k[i]), 1E-3);
+    }
+  }
+
+
+}
+
+BOOST_AUTO_TEST_CASE(warm_started_trimmed_mean)
+{
+  using namespace grassmann_averages_pca;
 
+  // the elements of a few vectors change sign between the iterations, with and without ties
+  for(int ties = 0; ties < 2; ties++)
+  {
+    std::vector<double> data(nb_elements);
+    for(size_t i = 0; i < data.size(); i++)
+    {
+      data[i] = ties ? std::floor(dist(rng)) : dist(rng);
+    }
+
+    const size_t v_k[] = {1, 100, 1000, size_t(nb_elements)/2 - 1};
+    const size_t v_changes[] = {0, 1, 10, 200, size_t(nb_elements)};
+    for(size_t i = 0; i < sizeof(v_k) / sizeof(v_k[0]); i++)
+    {
+      details::trimming_bounds<double> bounds;
+      std::vector<double> data_copy(data);
+      for(size_t j = 0; j < sizeof(v_changes) / sizeof(v_changes[0]); j++)
+      {
+        BOOST_TEST_CHECKPOINT("ties " << ties << " k " << v_k[i] << " changes " << v_changes[j]);
+        for(size_t l = 0; l < std::min(v_changes[j], data_copy.size()); l++)
+        {
+          data_copy[(l * 7919) % data_copy.size()] *= -1;
+        }
+
+        std::vector<double> data_reference(data_copy);
+        const double reference = details::compute_mean_within_bounds_nth_element(&data_reference[0], data_reference.size(), v_k[i]);
+        BOOST_CHECK_CLOSE(
+          details::compute_mean_within_bounds_warm_start(&data_copy[0], data_copy.size(), v_k[i], std::max<size_t>(v_changes[j], 1), bounds), 
+          reference, 
+          1E-8);
+        BOOST_CHECK(bounds.valid);
+      }
+    }
+  }
 }
 
 BOOST_AUTO_TEST_SUITE_END();
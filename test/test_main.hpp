@@ -15,6 +15,7 @@
 #include <fstream>
 
 #include <include/private/utilities.hpp>
+#include <include/private/boost_ublas_row_iterator.hpp>
 
 
 // random number generator
@@ -69,6 +70,92 @@ struct fixture_simple_matrix_creation
 
 
 
+  }
+
+  //! Maximum number of iterations of the computations compared by check_same_results.
+  static const int max_iterations = 1000;
+
+  //! Creates pixel like data (integers in [0, 255]), with a different range on each dimension.
+  matrix_t create_pixel_data()
+  {
+    matrix_t mat_pixels(nb_elements, dimensions);
+    for(int i = 0; i < nb_elements; i++)
+    {
+      for(int j = 0; j < dimensions; j++)
+      {
+        mat_pixels(i, j) = static_cast<int>((dist(rng) + 1000) * 255 / (2000 * (j + 1)));
+      }
+    }
+    return mat_pixels;
+  }
+
+  //! Creates the initial vectors of the computations compared by check_same_results, the i-th one 
+  //! being close to the i-th dimension.
+  template <class data_t>
+  static std::vector<data_t> create_initial_vectors(size_t nb_vectors, size_t nb_dimensions)
+  {
+    std::vector<data_t> v_init(nb_vectors);
+    for(size_t i = 0; i < nb_vectors; i++)
+    {
+      v_init[i] = boost::numeric::ublas::scalar_vector<typename data_t::value_type>(nb_dimensions, 1);
+      v_init[i](i) = 2;
+    }
+    return v_init;
+  }
+
+  //! Sets the options shared by most of the tests on an instance of an algorithm.
+  template <class algorithm_t>
+  static void set_common_options(algorithm_t &instance, size_t nb_processors = 3, bool centering = true)
+  {
+    BOOST_CHECK(instance.set_nb_processors(nb_processors));
+    BOOST_CHECK(instance.set_centering(centering));
+  }
+
+  //! Computes as many basis vectors as the size of basis_vectors on the rows of data.
+  template <class algorithm_t, class vector_t>
+  static void run_batch_process(
+    algorithm_t &instance, 
+    matrix_t const &data, 
+    std::vector<vector_t> &basis_vectors, 
+    std::vector<vector_t> const *v_init = 0)
+  {
+    typedef grassmann_averages_pca::details::ublas_helpers::row_iter<const matrix_t> const_row_iter_t;
+    BOOST_REQUIRE(instance.batch_process(
+      max_iterations, basis_vectors.size(),
+      const_row_iter_t(data, 0), const_row_iter_t(data, data.size1()),
+      basis_vectors.begin(), v_init));
+  }
+
+  //! Checks that the basis vectors are the reference ones, up to their sign.
+  template <class vector_t, class reference_vector_t>
+  static void check_same_basis_vectors(
+    std::vector<vector_t> const &basis_vectors, 
+    std::vector<reference_vector_t> const &reference, 
+    double tolerance = 1E-6)
+  {
+    BOOST_REQUIRE_LE(basis_vectors.size(), reference.size());
+    for(size_t i = 0; i < basis_vectors.size(); i++)
+    {
+      BOOST_TEST_CHECKPOINT("basis vector " << i);
+      BOOST_CHECK_CLOSE(std::abs(boost::numeric::ublas::inner_prod(basis_vectors[i], reference[i])), 1., tolerance);
+    }
+  }
+
+  //! Runs the reference and the tested instances on the same data and initial vectors, and checks that they give the
+  //! same nb_basis_vectors basis vectors. The instances are kept by the caller for checking their statistics.
+  template <class reference_algorithm_t, class algorithm_t, class vector_t>
+  static void check_same_results(
+    reference_algorithm_t &reference_instance, 
+    algorithm_t &instance, 
+    matrix_t const &data, 
+    size_t nb_basis_vectors,
+    std::vector<vector_t> const *v_init = 0,
+    double tolerance = 1E-6)
+  {
+    std::vector<vector_t> reference(nb_basis_vectors), basis_vectors(nb_basis_vectors);
+    run_batch_process(reference_instance, data, reference, v_init);
+    run_batch_process(instance, data, basis_vectors, v_init);
+    check_same_basis_vectors(basis_vectors, reference, tolerance);
   }
 };
 
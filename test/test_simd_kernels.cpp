@@ -0,0 +1,398 @@
+// Copyright 2014, Max Planck Society.
+// Distributed under the BSD 3-Clause license.
+// (See accompanying file LICENSE.txt or copy at
+// http://opensource.org/licenses/BSD-3-Clause)
+
+
+/*!@file
+ * This file contains tests for the vectorised kernels. Each instruction set supported by the current
+ * processor is checked against the generic implementation.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <test/test_main.hpp>
+
+#include <include/private/simd_kernels.hpp>
+#include <include/grassmann_pca.hpp>
+
+#include <boost/numeric/ublas/matrix.hpp>
+#include <boost/numeric/ublas/vector.hpp>
+#include <include/private/boost_ublas_row_iterator.hpp>
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+
+
+namespace
+{
+  namespace simd = grassmann_averages_pca::details::simd;
+
+  //! Restores the instruction set on destruction
+  struct s_instruction_set_guard
+  {
+    simd::instruction_set_t isa;
+    s_instruction_set_guard() : isa(simd::current_instruction_set())
+    {}
+    ~s_instruction_set_guard()
+    {
+      simd::set_instruction_set(isa);
+    }
+  };
+
+  //! Number of elements greater than or equal to the threshold.
+  template <class T>
+  size_t count_greater_equal(std::vector<T> const &v, T threshold)
+  {
+    size_t count(0);
+    for(size_t i = 0; i < v.size(); i++)
+    {
+      if(v[i] >= threshold)
+      {
+        count++;
+      }
+    }
+    return count;
+  }
+
+  //! Number of elements strictly less than the threshold.
+  template <class T>
+  size_t count_less(std::vector<T> const &v, T threshold)
+  {
+    return v.size() - count_greater_equal(v, threshold);
+  }
+
+  template <class T>
+  void check_kernels(simd::instruction_set_t isa, T tolerance)
+  {
+    boost::random::uniform_real_distribution<T> dist(-10, 10);
+    rng.seed();
+
+    simd::kernels<T> const ref = simd::make_generic_kernels<T>();
+    simd::kernels<T> const k = simd::get_kernels<T>(isa);
+
+    // sizes covering the tails of all the vector widths and unrolling
+    const size_t sizes[] = {1, 3, 7, 15, 16, 17, 31, 64, 65, 100, 1023};
+    for(size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+      const size_t n = sizes[s];
+      std::vector<T> a(n), b(n);
+      for(size_t i = 0; i < n; i++)
+      {
+        a[i] = dist(rng);
+        b[i] = dist(rng);
+      }
+
+      const T ip_ref = ref.inner_product(&a[0], &b[0], n);
+      const T ip = k.inner_product(&a[0], &b[0], n);
+      BOOST_CHECK_SMALL(ip - ip_ref, tolerance * (1 + std::abs(ip_ref)));
+
+      std::vector<T> acc_ref(b), acc(b);
+      ref.add(&acc_ref[0], &a[0], n);
+      k.add(&acc[0], &a[0], n);
+      for(size_t i = 0; i < n; i++)
+      {
+        BOOST_CHECK_EQUAL(acc[i], acc_ref[i]);
+      }
+
+      ref.sub(&acc_ref[0], &a[0], n);
+      ref.sub(&acc_ref[0], &a[0], n);
+      k.sub(&acc[0], &a[0], n);
+      k.sub(&acc[0], &a[0], n);
+      for(size_t i = 0; i < n; i++)
+      {
+        BOOST_CHECK_EQUAL(acc[i], acc_ref[i]);
+      }
+
+      // same operations as the generic compensated sum, hence exactly the same results
+      std::vector<T> comp_ref(n, T(0)), comp(n, T(0));
+      for(int repeat = 0; repeat < 3; repeat++)
+      {
+        ref.compensated_add(&acc_ref[0], &comp_ref[0], &a[0], n);
+        k.compensated_add(&acc[0], &comp[0], &a[0], n);
+      }
+      for(size_t i = 0; i < n; i++)
+      {
+        BOOST_CHECK_EQUAL(acc[i], acc_ref[i]);
+        BOOST_CHECK_EQUAL(comp[i], comp_ref[i]);
+      }
+
+      ref.axpy(&acc_ref[0], T(-0.3), &a[0], n);
+      k.axpy(&acc[0], T(-0.3), &a[0], n);
+      for(size_t i = 0; i < n; i++)
+      {
+        // fused multiply-add rounds differently
+        BOOST_CHECK_SMALL(acc[i] - acc_ref[i], tolerance * (1 + std::abs(acc_ref[i])));
+      }
+
+      // signs of the first (at most) 64 elements, with some exact zeros
+      const size_t nb_signs = std::min<size_t>(n, 64);
+      std::vector<T> values(a.begin(), a.begin() + nb_signs);
+      for(size_t i = 0; i < nb_signs; i += 5)
+      {
+        values[i] = 0;
+      }
+      BOOST_CHECK_EQUAL(k.positive_mask(&values[0], nb_signs), ref.positive_mask(&values[0], nb_signs));
+      BOOST_CHECK_EQUAL(simd::popcount(ref.positive_mask(&values[0], nb_signs)),
+                        count_greater_equal(values, T(0)));
+
+      // bounded sum, with some elements equal to the bounds
+      std::vector<T> bounded(a);
+      const T low = a[0] < a[n-1] ? a[0] : a[n-1];
+      const T high = a[0] < a[n-1] ? a[n-1] : a[0];
+      for(size_t i = 0; i < n; i += 7)
+      {
+        bounded[i] = i % 2 ? low : high;
+      }
+      size_t counts_ref[4], counts[4];
+      const T bounded_ref = ref.bounded_sum(&bounded[0], n, low, high, counts_ref);
+      BOOST_CHECK_SMALL(k.bounded_sum(&bounded[0], n, low, high, counts) - bounded_ref, tolerance * (1 + std::abs(bounded_ref)));
+      BOOST_CHECK_EQUAL_COLLECTIONS(counts, counts + 4, counts_ref, counts_ref + 4);
+      BOOST_CHECK_EQUAL(counts_ref[0], count_less(bounded, low));
+      BOOST_CHECK_EQUAL(counts_ref[3], count_greater_equal(bounded, high));
+
+      // signed copies, with a misaligned output and the signs starting in the middle of a word
+      {
+        const size_t first = 37;
+        std::vector<boost::uint64_t> signs((first + n + 63) / 64 + 1);
+        for(size_t i = 0; i < signs.size(); i++)
+        {
+          signs[i] = (boost::uint64_t(rng()) << 32) ^ rng();
+        }
+        std::vector<T> copy_ref(n + 1), copy(n + 1), copy_nt(n + 1);
+        ref.signed_copy(&copy_ref[1], &a[0], &signs[0], first, n, false);
+        k.signed_copy(&copy[1], &a[0], &signs[0], first, n, false);
+        k.signed_copy(&copy_nt[1], &a[0], &signs[0], first, n, true);
+        BOOST_CHECK_EQUAL_COLLECTIONS(copy.begin(), copy.end(), copy_ref.begin(), copy_ref.end());
+        BOOST_CHECK_EQUAL_COLLECTIONS(copy_nt.begin(), copy_nt.end(), copy_ref.begin(), copy_ref.end());
+        for(size_t i = 0; i < n; i++)
+        {
+          const bool positive = (signs[(first + i) / 64] >> ((first + i) % 64)) & 1;
+          BOOST_CHECK_EQUAL(copy_ref[i + 1], positive ? a[i] : -a[i]);
+        }
+      }
+
+      // copy of the values between the bounds, the capacity being smaller than the number of values
+      const size_t capacity = n / 3;
+      std::vector<T> between_ref(capacity + 1), between(capacity + 1);
+      const size_t nb_between = ref.copy_between(&bounded[0], n, low, high, &between_ref[0], capacity);
+      BOOST_CHECK_EQUAL(nb_between, counts_ref[1] < n - counts_ref[3] ? n - counts_ref[3] - counts_ref[1] : 0);
+      BOOST_CHECK_EQUAL(k.copy_between(&bounded[0], n, low, high, &between[0], capacity), nb_between);
+      BOOST_CHECK_EQUAL_COLLECTIONS(between.begin(), between.end(), between_ref.begin(), between_ref.end());
+
+      // weighted sum of rows, checked against successive axpy (number of rows not multiple of 4)
+      const size_t nb_rows = 7;
+      std::vector<T> matrix(nb_rows * n), coefficients(nb_rows);
+      std::vector<T const*> rows(nb_rows);
+      for(size_t r = 0; r < nb_rows; r++)
+      {
+        for(size_t i = 0; i < n; i++)
+        {
+          matrix[r * n + i] = dist(rng);
+        }
+        rows[r] = &matrix[r * n];
+        coefficients[r] = r % 2 ? T(2) : T(-2);
+      }
+
+      acc_ref = b;
+      acc = b;
+      for(size_t r = 0; r < nb_rows; r++)
+      {
+        ref.axpy(&acc_ref[0], coefficients[r], rows[r], n);
+      }
+      k.weighted_rows_sum(&acc[0], &rows[0], &coefficients[0], nb_rows, n);
+      for(size_t i = 0; i < n; i++)
+      {
+        BOOST_CHECK_SMALL(acc[i] - acc_ref[i], tolerance * (1 + std::abs(acc_ref[i])));
+      }
+
+      // inner products of the rows with a vector, added to the output
+      std::vector<T> products(nb_rows, T(1));
+      k.rows_inner_products(&products[0], &rows[0], &a[0], nb_rows, n);
+      for(size_t r = 0; r < nb_rows; r++)
+      {
+        const T expected = T(1) + ref.inner_product(rows[r], &a[0], n);
+        BOOST_CHECK_SMALL(products[r] - expected, tolerance * (1 + std::abs(expected)));
+      }
+    }
+  }
+
+  //! Checks the kernels on the compact storage U against their generic version.
+  template <class U, class T>
+  void check_storage_kernels(simd::instruction_set_t isa, T tolerance)
+  {
+    typedef typename simd::storage_kernels<U, T>::accumulator_t accumulator_t;
+    boost::random::uniform_real_distribution<T> dist(-10, 10);
+    rng.seed();
+
+    simd::storage_kernels<U, T> const ref = simd::make_generic_storage_kernels<U, T>();
+    simd::storage_kernels<U, T> const k = simd::get_storage_kernels<U, T>(isa);
+
+    const size_t sizes[] = {1, 3, 7, 15, 16, 17, 31, 64, 65, 100, 1023};
+    for(size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+      const size_t n = sizes[s];
+
+      // rows covering the full range of the storage type
+      const size_t nb_rows = 7;
+      std::vector<U> matrix(nb_rows * n);
+      std::vector<U const*> rows(nb_rows);
+      std::vector<T> coefficients(nb_rows), b(n);
+      std::vector<accumulator_t> sign_masks(nb_rows);
+      for(size_t r = 0; r < nb_rows; r++)
+      {
+        for(size_t i = 0; i < n; i++)
+        {
+          matrix[r * n + i] = static_cast<U>(std::numeric_limits<U>::max() - (r * 7919 + i * 104729) % (std::numeric_limits<U>::max() + size_t(1)));
+        }
+        rows[r] = &matrix[r * n];
+        coefficients[r] = dist(rng);
+        sign_masks[r] = r % 3 ? accumulator_t(-1) : accumulator_t(0);
+      }
+      for(size_t i = 0; i < n; i++)
+      {
+        b[i] = dist(rng);
+      }
+
+      const T ip_ref = ref.inner_product(rows[0], &b[0], n);
+      const T ip = k.inner_product(rows[0], &b[0], n);
+      BOOST_CHECK_SMALL(ip - ip_ref, tolerance * (1 + std::abs(ip_ref)));
+
+      // one pass inner products, checked against two separate inner products
+      T ip_b_dual(0);
+      const T ip_a_dual = k.dual_inner_product(rows[0], &b[0], &coefficients[0], std::min(n, nb_rows), &ip_b_dual);
+      const T ip_b_ref = ref.inner_product(rows[0], &coefficients[0], std::min(n, nb_rows));
+      const T ip_a_ref = ref.inner_product(rows[0], &b[0], std::min(n, nb_rows));
+      BOOST_CHECK_SMALL(ip_a_dual - ip_a_ref, tolerance * (1 + std::abs(ip_a_ref)));
+      BOOST_CHECK_SMALL(ip_b_dual - ip_b_ref, tolerance * (1 + std::abs(ip_b_ref)));
+
+      const T ip_full_dual = k.dual_inner_product(rows[0], &b[0], &b[0], n, &ip_b_dual);
+      BOOST_CHECK_SMALL(ip_full_dual - ip_ref, tolerance * (1 + std::abs(ip_ref)));
+      BOOST_CHECK_SMALL(ip_b_dual - ip_ref, tolerance * (1 + std::abs(ip_ref)));
+
+      std::vector<T> acc_ref(b), acc(b);
+      ref.axpy(&acc_ref[0], T(-0.3), rows[1], n);
+      k.axpy(&acc[0], T(-0.3), rows[1], n);
+      for(size_t i = 0; i < n; i++)
+      {
+        BOOST_CHECK_SMALL(acc[i] - acc_ref[i], tolerance * (1 + std::abs(acc_ref[i])));
+      }
+
+      ref.weighted_rows_sum(&acc_ref[0], &rows[0], &coefficients[0], nb_rows, n);
+      k.weighted_rows_sum(&acc[0], &rows[0], &coefficients[0], nb_rows, n);
+      for(size_t i = 0; i < n; i++)
+      {
+        BOOST_CHECK_SMALL(acc[i] - acc_ref[i], tolerance * (1 + std::abs(acc_ref[i])));
+      }
+
+      // the signed sums are exact
+      std::vector<accumulator_t> int_acc_ref(n, accumulator_t(3)), int_acc(n, accumulator_t(3));
+      ref.signed_rows_sum(&int_acc_ref[0], &rows[0], &sign_masks[0], nb_rows, n);
+      k.signed_rows_sum(&int_acc[0], &rows[0], &sign_masks[0], nb_rows, n);
+      for(size_t i = 0; i < n; i++)
+      {
+        accumulator_t expected(3);
+        for(size_t r = 0; r < nb_rows; r++)
+        {
+          expected += sign_masks[r] ? -accumulator_t(rows[r][i]) : accumulator_t(rows[r][i]);
+        }
+        BOOST_CHECK_EQUAL(int_acc_ref[i], expected);
+        BOOST_CHECK_EQUAL(int_acc[i], expected);
+      }
+    }
+  }
+}
+
+
+BOOST_AUTO_TEST_CASE(test_simd_instruction_set_detection)
+{
+  s_instruction_set_guard guard;
+  const simd::instruction_set_t detected = simd::detect_instruction_set();
+
+  BOOST_CHECK(simd::current_instruction_set() <= detected);
+  BOOST_CHECK(simd::set_instruction_set(simd::isa_generic));
+  BOOST_CHECK_EQUAL(simd::current_instruction_set(), simd::isa_generic);
+
+  if(detected < simd::isa_avx512)
+  {
+    BOOST_CHECK(!simd::set_instruction_set(simd::isa_avx512));
+    BOOST_CHECK_EQUAL(simd::current_instruction_set(), simd::isa_generic);
+  }
+
+  BOOST_CHECK(simd::set_instruction_set(detected));
+  BOOST_CHECK(simd::row_alignment() >= 32);
+  BOOST_CHECK_EQUAL(simd::row_alignment() % simd::vector_alignment(detected), 0);
+}
+
+
+BOOST_AUTO_TEST_CASE(test_simd_kernels_against_generic)
+{
+  const simd::instruction_set_t detected = simd::detect_instruction_set();
+  for(int isa = simd::isa_generic; isa <= detected; isa++)
+  {
+    BOOST_TEST_MESSAGE("Checking instruction set " << isa);
+    check_kernels<float>(static_cast<simd::instruction_set_t>(isa), 1E-4f);
+    check_kernels<double>(static_cast<simd::instruction_set_t>(isa), 1E-12);
+    check_storage_kernels<boost::uint8_t, float>(static_cast<simd::instruction_set_t>(isa), 1E-4f);
+    check_storage_kernels<boost::uint8_t, double>(static_cast<simd::instruction_set_t>(isa), 1E-12);
+    check_storage_kernels<boost::uint16_t, float>(static_cast<simd::instruction_set_t>(isa), 1E-4f);
+    check_storage_kernels<boost::uint16_t, double>(static_cast<simd::instruction_set_t>(isa), 1E-12);
+  }
+}
+
+
+BOOST_FIXTURE_TEST_CASE(test_simd_grassmann_pca_same_results_all_instruction_sets, fixture_simple_matrix_creation)
+{
+  namespace ub = boost::numeric::ublas;
+  using namespace grassmann_averages_pca;
+  using namespace grassmann_averages_pca::details::ublas_helpers;
+
+  typedef ub::vector<double> data_t;
+  typedef grassmann_pca<data_t> grassmann_pca_t;
+  typedef row_iter<const matrix_t> const_row_iter_t;
+
+  s_instruction_set_guard guard;
+
+  std::vector<data_t> v_init(dimensions);
+  for(int i = 0; i < dimensions; i++)
+  {
+    v_init[i] = ub::scalar_vector<double>(dimensions, 0);
+    v_init[i](i) = 1;
+  }
+
+  std::vector<data_t> reference(dimensions);
+  BOOST_REQUIRE(simd::set_instruction_set(simd::isa_generic));
+  {
+    grassmann_pca_t instance;
+    instance.set_nb_processors(2);
+    instance.set_centering(true);
+    BOOST_REQUIRE(instance.batch_process(
+      1000, dimensions,
+      const_row_iter_t(mat_data, 0), const_row_iter_t(mat_data, mat_data.size1()),
+      reference.begin(), &v_init));
+  }
+
+  const simd::instruction_set_t detected = simd::detect_instruction_set();
+  for(int isa = simd::isa_sse2; isa <= detected; isa++)
+  {
+    BOOST_REQUIRE(simd::set_instruction_set(static_cast<simd::instruction_set_t>(isa)));
+
+    std::vector<data_t> basis_vectors(dimensions);
+    grassmann_pca_t instance;
+    instance.set_nb_processors(2);
+    instance.set_centering(true);
+    BOOST_REQUIRE(instance.batch_process(
+      1000, dimensions,
+      const_row_iter_t(mat_data, 0), const_row_iter_t(mat_data, mat_data.size1()),
+      basis_vectors.begin(), &v_init));
+
+    for(int i = 0; i < dimensions; i++)
+    {
+      // the sign of the basis vectors is arbitrary
+      const double ip = std::abs(ub::inner_prod(basis_vectors[i], reference[i]));
+      BOOST_CHECK_CLOSE(ip, 1., 1E-3);
+    }
+  }
+}